@@ -86,6 +86,7 @@ module fstarpu_mod
         type(c_ptr), bind(C) :: FSTARPU_SCHED_CTX_AWAKE_WORKERS
         type(c_ptr), bind(C) :: FSTARPU_SCHED_CTX_POLICY_INIT
         type(c_ptr), bind(C) :: FSTARPU_SCHED_CTX_USER_DATA
+        type(c_ptr), bind(C) :: FSTARPU_SCHED_CTX_ELASTIC
 
         type(c_ptr), bind(C) :: FSTARPU_NOWHERE
         type(c_ptr), bind(C) :: FSTARPU_CPU
@@ -608,6 +609,12 @@ module fstarpu_mod
                 subroutine fstarpu_do_schedule () bind(C,name="starpu_do_schedule")
                 end subroutine fstarpu_do_schedule
 
+                ! int starpu_task_yield(void);
+                function fstarpu_task_yield () bind(C,name="starpu_task_yield")
+                        use iso_c_binding, only: c_int
+                        integer(c_int) :: fstarpu_task_yield
+                end function fstarpu_task_yield
+
                 ! starpu_codelet_init
                 subroutine fstarpu_codelet_init (codelet) bind(C,name="starpu_codelet_init")
                         use iso_c_binding, only: c_ptr
@@ -2577,6 +2584,8 @@ module fstarpu_mod
                             fstarpu_get_constant(C_CHAR_"FSTARPU_SCHED_CTX_POLICY_INIT"//C_NULL_CHAR)
                         FSTARPU_SCHED_CTX_USER_DATA    = &
                             fstarpu_get_constant(C_CHAR_"FSTARPU_SCHED_CTX_USER_DATA"//C_NULL_CHAR)
+                        FSTARPU_SCHED_CTX_ELASTIC    = &
+                            fstarpu_get_constant(C_CHAR_"FSTARPU_SCHED_CTX_ELASTIC"//C_NULL_CHAR)
 
                         FSTARPU_NOWHERE = &
                             fstarpu_get_constant(C_CHAR_"FSTARPU_NOWHERE"//C_NULL_CHAR)
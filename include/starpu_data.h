@@ -437,6 +437,17 @@ typedef struct starpu_arbiter *starpu_arbiter_t;
 */
 starpu_arbiter_t starpu_arbiter_create(void) STARPU_ATTRIBUTE_MALLOC;
 
+/**
+   Create a data access arbiter split into \p nshards independent
+   shards, the data being spread over them. This reduces contention on
+   the arbiter when many workers submit and terminate tasks, but a task
+   accessing data from several shards keeps the data of the first
+   shards while waiting for the data of the next shards. starpu_arbiter_create()
+   uses the number of shards given by \ref STARPU_ARBITER_SHARDS. See
+   \ref ConcurrentDataAccess for the details.
+*/
+starpu_arbiter_t starpu_arbiter_create_sharded(unsigned nshards) STARPU_ATTRIBUTE_MALLOC;
+
 /**
    Make access to \p handle managed by \p arbiter, see \ref
    ConcurrentDataAccess for the details.
@@ -611,6 +622,38 @@ void starpu_data_set_ooc_flag(starpu_data_handle_t handle, unsigned flag);
 */
 unsigned starpu_data_get_ooc_flag(starpu_data_handle_t handle);
 
+/**
+   Placement policies for the buffers that StarPU allocates in CPU
+   memory nodes for a data handle, see \ref NUMAPlacement.
+*/
+enum starpu_data_numa_policy
+{
+	STARPU_DATA_NUMA_DEFAULT,	/**< Use the global policy, set by \ref STARPU_NUMA_POLICY */
+	STARPU_DATA_NUMA_BIND,		/**< Bind the pages to a NUMA node, by default the one of the memory node */
+	STARPU_DATA_NUMA_INTERLEAVE,	/**< Interleave the pages over all NUMA nodes */
+	STARPU_DATA_NUMA_FIRST_TOUCH	/**< Let the pages be placed on the NUMA node of the worker which first writes them */
+};
+
+/**
+   Set the NUMA placement policy of the CPU buffers which StarPU will
+   allocate for \p handle. For ::STARPU_DATA_NUMA_BIND, \p numa_node is
+   the logical hwloc index of the NUMA node to bind to, or -1 to bind to
+   the NUMA node of the memory node, which is the default behaviour.
+   \p numa_node is ignored for the other policies. This has to be called
+   before the data is allocated, buffers already allocated are not
+   moved. See \ref NUMAPlacement for more details.
+*/
+void starpu_data_set_numa_policy(starpu_data_handle_t handle, enum starpu_data_numa_policy policy, int numa_node);
+
+/**
+   Return the home node of \p handle if it has one. Otherwise, return
+   the memory node chosen by the NUMA placement policy of \p handle, or
+   -1 if the policy did not choose any yet. Contrary to
+   starpu_data_get_home_node(), this thus tells where StarPU placed data
+   registered without a home node. See \ref NUMAPlacement for more details.
+*/
+int starpu_data_get_numa_home_node(starpu_data_handle_t handle);
+
 /**
    Query the status of \p handle on the specified \p memory_node.
 
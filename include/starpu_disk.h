@@ -26,6 +26,8 @@
    @{
 */
 
+struct iovec;
+
 /**
    Set of functions to manipulate datas on disk. See \ref DiskFunctions for more details.
 */
@@ -133,7 +135,23 @@ struct starpu_disk_ops
 	*/
 	void (*free_request)(void *async_channel);
 
-	/* TODO: readv, writev, read2d, write2d, etc. */
+	/**
+	   Read contiguous data from \p obj in \p base, at offset \p offset,
+	   and scatter it into the \p iovcnt buffers described by \p iov, as
+	   done by \c preadv. This is used to transfer non-contiguous data
+	   (e.g. a matrix tile with an \c ld) in one call. This method is
+	   optional, and is used synchronously. Return 0 on success.
+	*/
+	int (*readv)(void *base, void *obj, const struct iovec *iov, int iovcnt, off_t offset);
+	/**
+	   Gather the \p iovcnt buffers described by \p iov and write them
+	   contiguously to \p obj in \p base, at offset \p offset, as done by
+	   \c pwritev. This method is optional, and is used synchronously.
+	   Return 0 on success.
+	*/
+	int (*writev)(void *base, void *obj, const struct iovec *iov, int iovcnt, off_t offset);
+
+	/* TODO: read2d, write2d, etc. */
 };
 
 /**
@@ -211,6 +229,18 @@ int starpu_disk_register(struct starpu_disk_ops *func, void *parameter, starpu_s
 */
 #define STARPU_DISK_SIZE_MIN (16 * 1024 * 1024)
 
+/**
+   Get statistics about the compression of the data stored on disk node
+   \p node, enabled by \ref STARPU_DISK_COMPRESS. \p raw_bytes is set to the
+   amount of data which was written to the disk, and \p stored_bytes to the
+   amount which was actually stored after compression. \p bandwidth_write
+   and \p bandwidth_read are set to the achieved effective bandwidths (in
+   MB/s), including the time to compress and decompress.
+   Return -ENODEV if compression is not enabled on \p node.
+   See \ref DiskCompression for more details.
+*/
+int starpu_disk_get_compression_stats(unsigned node, size_t *raw_bytes, size_t *stored_bytes, double *bandwidth_write, double *bandwidth_read);
+
 /**
    Contain the node number of the disk swap, if set up through the
    \ref STARPU_DISK_SWAP variable.
@@ -112,6 +112,24 @@ struct starpu_fxt_options
 	   of dumped codelets.
 	*/
 	long dumped_codelets_count;
+
+	/**
+	   Path of the compact binary task output, NULL to disable it. See
+	   \ref CompactBinaryTaskOutput for the format.
+	*/
+	char *tasks_bin_path;
+
+	/**
+	   Dump tasks as soon as they terminate instead of keeping them all in
+	   memory until the end of the trace.
+	*/
+	unsigned stream_tasks;
+
+	/**
+	   Number of threads used to parse the trace files, 0 means the
+	   number of online CPUs.
+	*/
+	unsigned nthreads;
 };
 
 void starpu_fxt_options_init(struct starpu_fxt_options *options);
@@ -68,6 +68,9 @@ struct starpu_perfmodel_history_entry
 	double duration;
 	starpu_tag_t tag;
 	double *parameters;
+
+	double cusum_high; /**< change-point detection of increases, for adaptive models */
+	double cusum_low;  /**< change-point detection of decreases, for adaptive models */
 };
 
 struct starpu_perfmodel_history_list
@@ -153,6 +156,29 @@ struct starpu_perfmodel_per_arch
 	struct starpu_perfmodel_regression_model regression;
 
 	char debug_path[256];
+
+	/**
+	   \private
+	   Used by ::STARPU_HISTORY_BASED when starpu_perfmodel::size_fallback
+	   is set: non-linear regression a * size ^ b + c over the calibrated
+	   history entries, used to predict footprints which do not have a
+	   calibrated history entry yet.
+	*/
+	double fallback_a;
+	double fallback_b;
+	double fallback_c;
+	size_t fallback_minx;
+	size_t fallback_maxx;
+	double fallback_fit_error; /**< root mean square of the relative error of the regression over the entries */
+	unsigned fallback_valid; /**< whether the regression could be computed */
+	unsigned fallback_dirty; /**< whether the regression has to be computed again */
+	/**
+	   \private
+	   Relative error of the fallback predictions, checked when the
+	   corresponding entries get calibrated.
+	*/
+	unsigned fallback_nchecks;
+	double fallback_cumul_error;
 };
 
 /**
@@ -305,6 +331,26 @@ struct starpu_perfmodel
 	   \private
 	*/
 	starpu_perfmodel_state_t state;
+
+	/**
+	   Used by ::STARPU_HISTORY_BASED, ::STARPU_REGRESSION_BASED and
+	   ::STARPU_NL_REGRESSION_BASED. If not 0, make the history entries
+	   adaptive: once this number of samples has been measured, the mean
+	   and deviation are exponentially-weighted with a decay equivalent to
+	   a window of this number of samples, and a change in the execution
+	   time triggers the recalibration of the entry. The default is given
+	   by \ref STARPU_PERFMODEL_ADAPTIVE_WINDOW. See \ref AdaptivePerformanceModels.
+	*/
+	unsigned adaptive_window;
+
+	/**
+	   Used by ::STARPU_HISTORY_BASED. If not 0, when the footprint of a
+	   task has no calibrated history entry yet, predict its duration from
+	   a non-linear regression over the sizes of the calibrated history
+	   entries, instead of forcing calibration. The default is given by
+	   \ref STARPU_HISTORY_SIZE_FALLBACK. See \ref SizeFallback.
+	*/
+	unsigned size_fallback;
 };
 
 /**
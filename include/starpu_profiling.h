@@ -179,6 +179,14 @@ struct starpu_profiling_bus_info
 	int long long transferred_bytes;
 	/** Number of transfers during profiling. */
 	int transfer_count;
+	/** Number of bytes of the transfers which are currently queued or in
+	    progress on the bus. This is not reset by
+	    starpu_bus_get_profiling_info(). */
+	int long long queued_bytes;
+	/** Number of bytes which were prefetched through the bus during
+	    profiling, but were invalidated or evicted from the destination
+	    before any task or acquisition used them. */
+	int long long wasted_prefetch_bytes;
 };
 
 /**
@@ -100,6 +100,14 @@ extern "C" {
 */
 #define STARPU_SCHED_CTX_SUB_CTXS (11 << 16)
 
+/**
+   Used when calling starpu_sched_ctx_create() to let StarPU move CPU
+   workers between this context and the other elastic contexts,
+   according to their ready tasks and throughput. See also \ref
+   STARPU_SCHED_CTX_ELASTIC.
+*/
+#define STARPU_SCHED_CTX_ELASTIC (12 << 16)
+
 /**
    Create a scheduling context with the given parameters
    (see below) and assign the workers in \p workerids_ctx to execute the
@@ -1831,6 +1831,20 @@ void starpu_iteration_pop(void);
 */
 void starpu_do_schedule(void);
 
+/**
+   Let StarPU make progress from within a long-running codelet: run
+   one round of data request processing for the memory nodes driven by
+   the calling worker, and give the scheduler of the current task the
+   opportunity to push tasks. The round never waits and never evicts
+   data to make room for transfers, its cost is thus bounded (of the
+   order of a microsecond when there is nothing to do), but it is worth
+   calling it only every few hundred microseconds. When called from a
+   thread which is not a worker, only the main memory requests are
+   processed. Return 1 if some progress was made, 0 otherwise.
+   See \ref YieldingFromLongTasks for more details.
+*/
+int starpu_task_yield(void);
+
 /**
    Initialize \p cl with default values. Codelets should preferably be
    initialized statically as shown in \ref DefiningACodelet. However
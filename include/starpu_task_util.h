@@ -483,6 +483,75 @@ int starpu_insert_task(struct starpu_codelet *cl, ...);
 #define starpu_insert_task(cl, ...) starpu_insert_task((cl), STARPU_TASK_FILE, __FILE__, STARPU_TASK_LINE, __LINE__, ##__VA_ARGS__)
 #endif
 
+/**
+   Opaque structure describing a precompiled signature of
+   starpu_task_insert() calls, see \ref CompiledTaskInsert
+*/
+struct starpu_task_insert_desc;
+
+/**
+   Compile the signature of starpu_task_insert() calls for the codelet
+   \p cl, to be used with starpu_task_insert_compiled() and
+   starpu_task_set_compiled(). The argument list must be
+   zero-terminated. Access modes (::STARPU_R, ::STARPU_W, ...) are
+   given without data handle, and ::STARPU_VALUE is only followed by
+   the size of the value. The layout of the data handles and of
+   starpu_task::cl_arg is thus computed once for all.
+
+   Only arguments which can be shared by all tasks are accepted, and
+   are followed by their value as for starpu_task_insert():
+   ::STARPU_PRIORITY, ::STARPU_EXECUTE_WHERE,
+   ::STARPU_EXECUTE_ON_WORKER, ::STARPU_WORKER_ORDER,
+   ::STARPU_SCHED_CTX, ::STARPU_HYPERVISOR_TAG,
+   ::STARPU_POSSIBLY_PARALLEL, ::STARPU_FLOPS, ::STARPU_NAME,
+   ::STARPU_TASK_COLOR, ::STARPU_TASK_SYNCHRONOUS,
+   ::STARPU_SEQUENTIAL_CONSISTENCY, ::STARPU_TASK_NO_SUBMITORDER,
+   ::STARPU_CALLBACK, ::STARPU_CALLBACK_WITH_ARG_NFREE,
+   ::STARPU_CALLBACK_ARG_NFREE, ::STARPU_PROLOGUE_CALLBACK,
+   ::STARPU_PROLOGUE_CALLBACK_ARG_NFREE. Other arguments (tags,
+   dependencies, ...) have to be set by hand on the task, or
+   starpu_task_insert() has to be used.
+
+   The result has to be freed with starpu_task_insert_desc_free().
+*/
+struct starpu_task_insert_desc *starpu_task_insert_compile(struct starpu_codelet *cl, ...);
+#ifdef STARPU_USE_FXT
+#define starpu_task_insert_compile(cl, ...) starpu_task_insert_compile((cl), STARPU_TASK_FILE, __FILE__, STARPU_TASK_LINE, __LINE__, ##__VA_ARGS__)
+#endif
+
+/**
+   Free a signature compiled with starpu_task_insert_compile(). The
+   tasks which were created from it do not depend on it.
+*/
+void starpu_task_insert_desc_free(struct starpu_task_insert_desc *desc);
+
+/**
+   Create and submit a task following the signature \p desc. The
+   arguments following \p desc are the data handles, in the order of
+   the access modes of the signature, and then the pointers to the
+   values, in the order of the ::STARPU_VALUE of the signature. No
+   parsing is involved, and starpu_task::cl_arg is allocated with its
+   final size and filled in one pass.
+*/
+int starpu_task_insert_compiled(struct starpu_task_insert_desc *desc, ...);
+
+/**
+   Fill the already allocated and initialized \p task following the
+   signature \p desc, without submitting it. The arguments following
+   \p desc are the same as for starpu_task_insert_compiled(). If
+   starpu_task::cl_arg was allocated by StarPU (starpu_task::cl_arg_free
+   is set) and already has the size required by \p desc, for instance
+   because \p task was already filled with \p desc before being waited
+   for, it is reused, so that filling a task does not involve any
+   allocation as long as there are at most \ref STARPU_NMAXBUFS data
+   handles. A starpu_task::cl_arg buffer owned by the application is
+   neither written to nor freed, a new one is allocated instead. The fields of \p task which can be
+   given in a signature are all overwritten. When \p task is not
+   destroyed by StarPU, the application has to free
+   starpu_task::cl_arg after the last use of \p task.
+*/
+int starpu_task_set_compiled(struct starpu_task *task, struct starpu_task_insert_desc *desc, ...);
+
 /**
    Assuming that there are already \p current_buffer data handles
    passed to the task, and if *allocated_buffers is not 0, the
@@ -156,3 +156,16 @@ AC_DEFUN([STARPU_CHECK_SYNC_SYNCHRONIZE], [
     AC_DEFINE(STARPU_HAVE_SYNC_SYNCHRONIZE, 1,
 	      [Define to 1 if the target supports __sync_synchronize])
   fi])
+
+# Check whether the target supports __thread.
+AC_DEFUN([STARPU_CHECK_THREAD_LOCAL], [
+  AC_CACHE_CHECK([whether the target supports __thread],
+		 ac_cv_have_thread_local, [
+  AC_LINK_IFELSE([AC_LANG_PROGRAM([static __thread int foo;],
+			[foo = 1; return foo;])],
+			[ac_cv_have_thread_local=yes],
+			[ac_cv_have_thread_local=no])])
+  if test $ac_cv_have_thread_local = yes; then
+    AC_DEFINE(STARPU_HAVE_THREAD_LOCAL, 1,
+	      [Define to 1 if the target supports __thread])
+  fi])
@@ -25,10 +25,7 @@
 /* we need to identify each task to generate the DAG. */
 unsigned long _starpu_job_cnt = 0;
 
-#ifdef STARPU_USE_FXT
 #include <common/fxt.h>
-#include <starpu_fxt.h>
-#include <sys/stat.h>
 
 #ifdef STARPU_HAVE_WINDOWS
 #include <windows.h>
@@ -40,6 +37,37 @@ unsigned long _starpu_job_cnt = 0;
 #include <sys/thr.h>       /* for thr_self() */
 #endif
 
+long _starpu_gettid(void)
+{
+	/* TODO: test at configure whether __thread is available, and use that
+	 * to cache the value.
+	 * Don't use the TSD, this is getting called before we would have the
+	 * time to allocate it.  */
+#ifdef STARPU_SIMGRID
+#  ifdef HAVE_SG_ACTOR_SELF
+	return (uintptr_t) sg_actor_self();
+#  else
+	return (uintptr_t) MSG_process_self();
+#  endif
+#else
+#if defined(__linux__)
+	return syscall(SYS_gettid);
+#elif defined(__FreeBSD__)
+	long tid;
+	thr_self(&tid);
+	return tid;
+#elif defined(_WIN32) && !defined(__CYGWIN__)
+	return (long) GetCurrentThreadId();
+#else
+	return (long) starpu_pthread_self();
+#endif
+#endif
+}
+
+#ifdef STARPU_USE_FXT
+#include <starpu_fxt.h>
+#include <sys/stat.h>
+
 /* By default, record all events but the VERBOSE_EXTRA ones, which are very costly: */
 #define KEYMASKALL_DEFAULT FUT_KEYMASKALL & (~_STARPU_FUT_KEYMASK_TASK_VERBOSE_EXTRA) & (~_STARPU_FUT_KEYMASK_MPI_VERBOSE_EXTRA)
 
@@ -80,33 +108,6 @@ uint64_t fut_getstamp(void)
 }
 #endif
 
-long _starpu_gettid(void)
-{
-	/* TODO: test at configure whether __thread is available, and use that
-	 * to cache the value.
-	 * Don't use the TSD, this is getting called before we would have the
-	 * time to allocate it.  */
-#ifdef STARPU_SIMGRID
-#  ifdef HAVE_SG_ACTOR_SELF
-	return (uintptr_t) sg_actor_self();
-#  else
-	return (uintptr_t) MSG_process_self();
-#  endif
-#else
-#if defined(__linux__)
-	return syscall(SYS_gettid);
-#elif defined(__FreeBSD__)
-	long tid;
-	thr_self(&tid);
-	return tid;
-#elif defined(_WIN32) && !defined(__CYGWIN__)
-	return (long) GetCurrentThreadId();
-#else
-	return (long) starpu_pthread_self();
-#endif
-#endif
-}
-
 static void _starpu_profile_set_tracefile(void)
 {
 	char *user;
@@ -374,6 +375,15 @@ int _starpu_generate_paje_trace_read_option(const char *option, struct starpu_fx
 	{
 		options->number_events_path = strdup("number_events.data");
 	}
+	else if (strcmp(option, "-binary") == 0)
+	{
+		free(options->tasks_bin_path);
+		options->tasks_bin_path = strdup("tasks.bin");
+	}
+	else if (strcmp(option, "-stream") == 0)
+	{
+		options->stream_tasks = 1;
+	}
 	else
 	{
 		return 1;
@@ -480,6 +490,7 @@ void starpu_fxt_trace_user_event(unsigned long code STARPU_ATTRIBUTE_UNUSED)
 #ifdef STARPU_USE_FXT
 	_STARPU_TRACE_USER_EVENT(code);
 #endif
+	_STARPU_TRACEBUF_USER_EVENT(code);
 }
 
 void starpu_fxt_trace_user_event_string(const char *s STARPU_ATTRIBUTE_UNUSED)
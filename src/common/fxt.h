@@ -34,6 +34,7 @@
 #include <unistd.h>
 #endif
 #include <common/utils.h>
+#include <common/tracebuf.h>
 #include <starpu.h>
 
 #ifdef STARPU_USE_FXT
@@ -285,6 +286,8 @@ static inline unsigned long _starpu_fxt_get_job_id(void)
 	return ret;
 }
 
+long _starpu_gettid(void) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
+
 #ifdef STARPU_USE_FXT
 
 /* Some versions of FxT do not include the declaration of the function */
@@ -324,8 +327,6 @@ static inline unsigned long _starpu_fxt_get_submit_order(void)
 	return ret;
 }
 
-long _starpu_gettid(void) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
-
 int _starpu_generate_paje_trace_read_option(const char *option, struct starpu_fxt_options *options) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 
 /** Initialize the FxT library. */
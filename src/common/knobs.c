@@ -83,6 +83,9 @@ void _starpu_perf_counter_init(struct _starpu_machine_config *pconfig)
 
 	/* call counter registration routines in each modules */
 	_starpu__task_c__register_counters();
+	_starpu__analysis_c__register_counters();
+	_starpu__perfmodel_history_c__register_counters();
+	_starpu__numa_migration_c__register_counters();
 }
 
 void _starpu_perf_counter_exit(void)
@@ -179,6 +179,10 @@ struct starpu_perf_counter_sample_cl_values
 		int64_t total_executed;
 		double cumul_execution_time;
 	} task;
+	struct
+	{
+		int64_t drift_events;
+	} perfmodel;
 };
 
 typedef void (*starpu_perf_counter_sample_updater)(struct starpu_perf_counter_sample *sample, void *context);
@@ -258,6 +262,9 @@ extern int64_t _starpu_task__g_current_ready__value;
 
 /* performance counter registration routines per modules */
 void _starpu__task_c__register_counters(void);	/* module: task.c */
+void _starpu__analysis_c__register_counters(void);	/* module: analysis.c */
+void _starpu__perfmodel_history_c__register_counters(void);	/* module: perfmodel_history.c */
+void _starpu__numa_migration_c__register_counters(void);	/* module: numa_migration.c */
 
 
 /* -------------------------------------------------------------------- */
@@ -0,0 +1,384 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <starpu.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/timing.h>
+#include <common/fxt.h>
+#include <common/tracebuf.h>
+#include <core/workers.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+/* Whether recording is enabled */
+int _starpu_tracebuf_enabled;
+
+/* Each thread gets its own ring buffer, found through this key */
+static starpu_pthread_key_t tracebuf_key;
+
+/* Protects the list of buffers, only taken when a thread records its first
+ * event and on dump */
+static starpu_pthread_mutex_t tracebuf_mutex;
+static struct _starpu_tracebuf *tracebuf_list;
+
+/* Number of events in each ring, a power of two */
+static uint64_t tracebuf_nevents;
+/* Whether to dump in Chrome/Perfetto JSON format rather than binary */
+static int tracebuf_json;
+
+static struct timespec tracebuf_start;
+
+void _starpu_tracebuf_init(void)
+{
+	uint64_t nevents;
+	char *format;
+
+	_starpu_tracebuf_enabled = 0;
+	if (!starpu_getenv_number_default("STARPU_TRACEBUF", 0))
+		return;
+
+	nevents = starpu_getenv_number_default("STARPU_TRACEBUF_NEVENTS", 65536);
+	if (nevents < 2)
+		nevents = 2;
+	/* Round up to a power of two, to be able to use a mask */
+	tracebuf_nevents = 1;
+	while (tracebuf_nevents < nevents)
+		tracebuf_nevents <<= 1;
+
+	format = starpu_getenv("STARPU_TRACEBUF_FORMAT");
+	tracebuf_json = 0;
+	if (format)
+	{
+		if (!strcasecmp(format, "json"))
+			tracebuf_json = 1;
+		else if (strcasecmp(format, "binary"))
+			_STARPU_MSG("Unknown STARPU_TRACEBUF_FORMAT '%s', using binary\n", format);
+	}
+
+	STARPU_PTHREAD_KEY_CREATE(&tracebuf_key, NULL);
+	STARPU_PTHREAD_MUTEX_INIT(&tracebuf_mutex, NULL);
+	tracebuf_list = NULL;
+	_starpu_clock_gettime(&tracebuf_start);
+
+	_starpu_tracebuf_enabled = 1;
+}
+
+static struct _starpu_tracebuf *tracebuf_get(void)
+{
+	struct _starpu_tracebuf *buf = STARPU_PTHREAD_GETSPECIFIC(tracebuf_key);
+	if (STARPU_LIKELY(buf != NULL))
+		return buf;
+
+	/* First event of this thread */
+	_STARPU_CALLOC(buf, 1, sizeof(*buf));
+	_STARPU_MALLOC(buf->events, tracebuf_nevents * sizeof(buf->events[0]));
+	buf->mask = tracebuf_nevents - 1;
+	buf->workerid = starpu_worker_get_id();
+	buf->tid = _starpu_gettid();
+	if (buf->workerid >= 0)
+		starpu_worker_get_name(buf->workerid, buf->name, sizeof(buf->name));
+	else
+		snprintf(buf->name, sizeof(buf->name), "thread %ld", buf->tid);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&tracebuf_mutex);
+	buf->next = tracebuf_list;
+	tracebuf_list = buf;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&tracebuf_mutex);
+
+	STARPU_PTHREAD_SETSPECIFIC(tracebuf_key, buf);
+	return buf;
+}
+
+void __starpu_tracebuf_record(enum _starpu_tracebuf_event_type type, uint32_t arg32, uint64_t arg0, uint64_t arg1)
+{
+	struct _starpu_tracebuf *buf = tracebuf_get();
+	struct _starpu_tracebuf_event *ev = &buf->events[buf->head & buf->mask];
+	struct timespec now;
+
+	_starpu_clock_gettime(&now);
+	ev->date = (uint64_t) (now.tv_sec - tracebuf_start.tv_sec) * 1000000000ULL
+		 + (now.tv_nsec - tracebuf_start.tv_nsec);
+	ev->type = type;
+	ev->arg32 = arg32;
+	ev->arg[0] = arg0;
+	ev->arg[1] = arg1;
+	/* Only this thread writes head, we just need the event to be
+	 * written before it, for readers */
+	STARPU_WMB();
+	buf->head++;
+}
+
+uint32_t __starpu_tracebuf_intern(const char *name)
+{
+	struct _starpu_tracebuf *buf;
+	unsigned slot, i;
+
+	if (!name)
+		return 0;
+
+	buf = tracebuf_get();
+	/* Open addressing on the pointer value, names are usually static
+	 * strings so that the pointer is enough to identify them */
+	slot = ((uintptr_t) name >> 3) % _STARPU_TRACEBUF_MAXNAMES;
+	for (i = 0; i < _STARPU_TRACEBUF_MAXNAMES; i++)
+	{
+		if (buf->names_ptr[slot] == name)
+			return slot + 1;
+		if (!buf->names_ptr[slot])
+		{
+			buf->names_ptr[slot] = name;
+			buf->names[slot] = strdup(name);
+			buf->nnames++;
+			return slot + 1;
+		}
+		slot = (slot + 1) % _STARPU_TRACEBUF_MAXNAMES;
+	}
+	/* Table is full */
+	return 0;
+}
+
+static void tracebuf_fprint_string(FILE *f, const char *s)
+{
+	fputc('"', f);
+	for ( ; *s; s++)
+	{
+		if (*s == '"' || *s == '\\')
+			fprintf(f, "\\%c", *s);
+		else if ((unsigned char) *s < 0x20)
+			fprintf(f, "\\u%04x", (unsigned char) *s);
+		else
+			fputc(*s, f);
+	}
+	fputc('"', f);
+}
+
+static const char *tracebuf_name(struct _starpu_tracebuf *buf, uint32_t idx)
+{
+	if (idx == 0 || idx > _STARPU_TRACEBUF_MAXNAMES || !buf->names[idx-1])
+		return "unknown";
+	return buf->names[idx-1];
+}
+
+static void tracebuf_dump_json_event(FILE *f, int pid, struct _starpu_tracebuf *buf, struct _starpu_tracebuf_event *ev)
+{
+	const char *name = NULL;
+	const char *cat = NULL;
+	char ph = 0;
+	char copy_name[32];
+
+	switch (ev->type)
+	{
+		case _STARPU_TRACEBUF_CODELET_START:
+		case _STARPU_TRACEBUF_CODELET_END:
+			name = tracebuf_name(buf, ev->arg32);
+			cat = "task";
+			ph = ev->type == _STARPU_TRACEBUF_CODELET_START ? 'B' : 'E';
+			break;
+		case _STARPU_TRACEBUF_CALLBACK_START:
+		case _STARPU_TRACEBUF_CALLBACK_END:
+			name = "callback";
+			cat = "task";
+			ph = ev->type == _STARPU_TRACEBUF_CALLBACK_START ? 'B' : 'E';
+			break;
+		case _STARPU_TRACEBUF_FETCH_INPUT_START:
+		case _STARPU_TRACEBUF_FETCH_INPUT_END:
+			name = "fetch_input";
+			cat = "data";
+			ph = ev->type == _STARPU_TRACEBUF_FETCH_INPUT_START ? 'B' : 'E';
+			break;
+		case _STARPU_TRACEBUF_SLEEP_START:
+		case _STARPU_TRACEBUF_SLEEP_END:
+			name = "sleeping";
+			cat = "worker";
+			ph = ev->type == _STARPU_TRACEBUF_SLEEP_START ? 'B' : 'E';
+			break;
+		case _STARPU_TRACEBUF_MEMRECLAIM_START:
+		case _STARPU_TRACEBUF_MEMRECLAIM_END:
+			name = "memreclaim";
+			cat = "data";
+			ph = ev->type == _STARPU_TRACEBUF_MEMRECLAIM_START ? 'B' : 'E';
+			break;
+		case _STARPU_TRACEBUF_DRIVER_COPY_START:
+		case _STARPU_TRACEBUF_DRIVER_COPY_END:
+			/* Transfers may end in another thread, use async events */
+			snprintf(copy_name, sizeof(copy_name), "copy %u->%u", ev->arg32 >> 16, ev->arg32 & 0xffff);
+			fprintf(f, ",\n{\"name\":\"%s\",\"cat\":\"transfer\",\"ph\":\"%c\",\"id\":%llu,\"pid\":%d,\"tid\":%ld,\"ts\":%.3f,\"args\":{\"size\":%llu}}",
+				copy_name, ev->type == _STARPU_TRACEBUF_DRIVER_COPY_START ? 'b' : 'e',
+				(unsigned long long) ev->arg[1], pid, buf->tid, ev->date / 1000.,
+				(unsigned long long) ev->arg[0]);
+			return;
+		case _STARPU_TRACEBUF_JOB_PUSH:
+			name = "push";
+			cat = "sched";
+			ph = 'i';
+			break;
+		case _STARPU_TRACEBUF_JOB_POP:
+			name = "pop";
+			cat = "sched";
+			ph = 'i';
+			break;
+		case _STARPU_TRACEBUF_TASK_SUBMIT:
+			name = tracebuf_name(buf, ev->arg32);
+			cat = "submit";
+			ph = 'i';
+			break;
+		case _STARPU_TRACEBUF_USER_EVENT:
+			name = "user_event";
+			cat = "user";
+			ph = 'i';
+			break;
+		default:
+			return;
+	}
+
+	fprintf(f, ",\n{\"name\":");
+	tracebuf_fprint_string(f, name);
+	fprintf(f, ",\"cat\":\"%s\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%ld,\"ts\":%.3f", cat, ph, pid, buf->tid, ev->date / 1000.);
+	if (ph == 'i')
+		fprintf(f, ",\"s\":\"t\"");
+	fprintf(f, ",\"args\":{\"arg0\":%llu,\"arg1\":%lld}}", (unsigned long long) ev->arg[0], (long long) ev->arg[1]);
+}
+
+static void tracebuf_dump_json(FILE *f)
+{
+	struct _starpu_tracebuf *buf;
+	int pid = 0;
+#ifdef HAVE_UNISTD_H
+	pid = getpid();
+#endif
+
+	fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"StarPU\"}}", pid);
+	for (buf = tracebuf_list; buf; buf = buf->next)
+	{
+		uint64_t i, first = buf->head > buf->mask ? buf->head - buf->mask - 1 : 0;
+
+		fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%ld,\"args\":{\"name\":", pid, buf->tid);
+		tracebuf_fprint_string(f, buf->name);
+		fprintf(f, "}}");
+		for (i = first; i < buf->head; i++)
+			tracebuf_dump_json_event(f, pid, buf, &buf->events[i & buf->mask]);
+	}
+	fprintf(f, "\n]}\n");
+}
+
+static void tracebuf_dump_binary(FILE *f)
+{
+	struct _starpu_tracebuf *buf;
+	char magic[8] = _STARPU_TRACEBUF_MAGIC;
+	uint32_t version = _STARPU_TRACEBUF_VERSION, nbufs = 0, evsize = sizeof(struct _starpu_tracebuf_event);
+
+	for (buf = tracebuf_list; buf; buf = buf->next)
+		nbufs++;
+
+	fwrite(magic, sizeof(magic), 1, f);
+	fwrite(&version, sizeof(version), 1, f);
+	fwrite(&evsize, sizeof(evsize), 1, f);
+	fwrite(&nbufs, sizeof(nbufs), 1, f);
+
+	for (buf = tracebuf_list; buf; buf = buf->next)
+	{
+		uint64_t i, first = buf->head > buf->mask ? buf->head - buf->mask - 1 : 0;
+		int32_t workerid = buf->workerid;
+		int64_t tid = buf->tid;
+		uint64_t nevents = buf->head - first;
+		uint64_t lost = first;
+		uint32_t nnames = buf->nnames;
+
+		fwrite(&workerid, sizeof(workerid), 1, f);
+		fwrite(&tid, sizeof(tid), 1, f);
+		fwrite(buf->name, sizeof(buf->name), 1, f);
+		fwrite(&nevents, sizeof(nevents), 1, f);
+		fwrite(&lost, sizeof(lost), 1, f);
+
+		fwrite(&nnames, sizeof(nnames), 1, f);
+		for (i = 0; i < _STARPU_TRACEBUF_MAXNAMES; i++)
+		{
+			if (buf->names[i])
+			{
+				uint32_t idx = i + 1;
+				uint32_t len = strlen(buf->names[i]);
+				fwrite(&idx, sizeof(idx), 1, f);
+				fwrite(&len, sizeof(len), 1, f);
+				fwrite(buf->names[i], len, 1, f);
+			}
+		}
+
+		for (i = first; i < buf->head; i++)
+			fwrite(&buf->events[i & buf->mask], sizeof(buf->events[0]), 1, f);
+	}
+}
+
+void _starpu_tracebuf_exit(void)
+{
+	struct _starpu_tracebuf *buf, *next;
+	char path[256];
+	char *prefix, *user;
+	FILE *f;
+	int pid = 0;
+
+	if (!_starpu_tracebuf_enabled)
+		return;
+	_starpu_tracebuf_enabled = 0;
+
+#ifdef HAVE_UNISTD_H
+	pid = getpid();
+#endif
+	prefix = starpu_getenv("STARPU_TRACEBUF_PREFIX");
+	if (!prefix)
+		prefix = "/tmp";
+	else
+		_starpu_mkpath_and_check(prefix, S_IRWXU);
+	user = starpu_getenv("USER");
+	if (!user)
+		user = "";
+	snprintf(path, sizeof(path), "%s/starpu_tracebuf_%s_%d.%s", prefix, user, pid, tracebuf_json ? "json" : "bin");
+
+	STARPU_PTHREAD_MUTEX_LOCK(&tracebuf_mutex);
+	f = fopen(path, "w");
+	if (!f)
+		_STARPU_MSG("Could not open tracebuf file %s: %s\n", path, strerror(errno));
+	else
+	{
+		if (tracebuf_json)
+			tracebuf_dump_json(f);
+		else
+			tracebuf_dump_binary(f);
+		fclose(f);
+		_STARPU_MSG("Writing tracebuf trace into file %s\n", path);
+	}
+
+	for (buf = tracebuf_list; buf; buf = next)
+	{
+		unsigned i;
+		next = buf->next;
+		for (i = 0; i < _STARPU_TRACEBUF_MAXNAMES; i++)
+			free(buf->names[i]);
+		free(buf->events);
+		free(buf);
+	}
+	tracebuf_list = NULL;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&tracebuf_mutex);
+
+	STARPU_PTHREAD_MUTEX_DESTROY(&tracebuf_mutex);
+	STARPU_PTHREAD_KEY_DELETE(tracebuf_key);
+}
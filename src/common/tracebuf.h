@@ -0,0 +1,154 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __TRACEBUF_H__
+#define __TRACEBUF_H__
+
+/** @file */
+
+/*
+ * Low-overhead in-memory tracing, available whether FxT is enabled or not.
+ *
+ * Each thread records fixed-size binary events in its own ring buffer, so
+ * recording an event takes neither a lock nor an atomic operation. When the
+ * ring is full, the oldest events get overwritten, so that only the latest
+ * events of each thread are kept (flight-recorder mode). Buffers are dumped
+ * at starpu_shutdown() either in the binary format documented in
+ * doc/doxygen/chapters/starpu_performances/offline_performance_tools.doxy or
+ * as a Chrome/Perfetto JSON trace.
+ */
+
+#include <stdint.h>
+#include <common/config.h>
+#include <starpu.h>
+
+#pragma GCC visibility push(hidden)
+
+#define _STARPU_TRACEBUF_MAGIC		"STPUTRB"
+#define _STARPU_TRACEBUF_VERSION	1
+
+enum _starpu_tracebuf_event_type
+{
+	_STARPU_TRACEBUF_CODELET_START = 1,
+	_STARPU_TRACEBUF_CODELET_END,
+	_STARPU_TRACEBUF_CALLBACK_START,
+	_STARPU_TRACEBUF_CALLBACK_END,
+	_STARPU_TRACEBUF_DRIVER_COPY_START,
+	_STARPU_TRACEBUF_DRIVER_COPY_END,
+	_STARPU_TRACEBUF_FETCH_INPUT_START,
+	_STARPU_TRACEBUF_FETCH_INPUT_END,
+	_STARPU_TRACEBUF_SLEEP_START,
+	_STARPU_TRACEBUF_SLEEP_END,
+	_STARPU_TRACEBUF_MEMRECLAIM_START,
+	_STARPU_TRACEBUF_MEMRECLAIM_END,
+	_STARPU_TRACEBUF_JOB_PUSH,
+	_STARPU_TRACEBUF_JOB_POP,
+	_STARPU_TRACEBUF_TASK_SUBMIT,
+	_STARPU_TRACEBUF_USER_EVENT,
+};
+
+/** One trace event, 32 bytes. This is also the on-disk layout. */
+struct _starpu_tracebuf_event
+{
+	/** date in ns since _starpu_tracebuf_init() */
+	uint64_t date;
+	/** enum _starpu_tracebuf_event_type */
+	uint32_t type;
+	/** event-specific small argument, e.g. name index or memory nodes */
+	uint32_t arg32;
+	/** event-specific arguments, e.g. job id, size */
+	uint64_t arg[2];
+};
+
+/** Maximum number of distinct names interned by a thread */
+#define _STARPU_TRACEBUF_MAXNAMES	256
+
+/** Per-thread ring buffer */
+struct _starpu_tracebuf
+{
+	/** Number of events ever recorded, the ring holds the last ones */
+	uint64_t head;
+	/** Ring size minus one, the ring size being a power of two */
+	uint64_t mask;
+	struct _starpu_tracebuf_event *events;
+
+	/** Worker running this thread, -1 for application threads */
+	int workerid;
+	long tid;
+	char name[64];
+
+	/** Name interning table, index 0 means "no name" */
+	const char *names_ptr[_STARPU_TRACEBUF_MAXNAMES];
+	char *names[_STARPU_TRACEBUF_MAXNAMES];
+	unsigned nnames;
+
+	/** Chaining of all buffers, for dumping them */
+	struct _starpu_tracebuf *next;
+};
+
+/** Whether tracebuf is enabled, set by STARPU_TRACEBUF */
+extern int _starpu_tracebuf_enabled;
+
+void _starpu_tracebuf_init(void);
+void _starpu_tracebuf_exit(void);
+
+void __starpu_tracebuf_record(enum _starpu_tracebuf_event_type type, uint32_t arg32, uint64_t arg0, uint64_t arg1);
+uint32_t __starpu_tracebuf_intern(const char *name);
+
+/** Arguments are only evaluated when tracing is enabled */
+#define _STARPU_TRACEBUF_RECORD(type, arg32, arg0, arg1) do { \
+	if (STARPU_UNLIKELY(_starpu_tracebuf_enabled)) \
+		__starpu_tracebuf_record((type), (arg32), (arg0), (arg1)); \
+} while (0)
+
+#define _STARPU_TRACEBUF_NODES(src_node, dst_node) ((((uint32_t) (src_node)) << 16) | ((uint32_t) (dst_node) & 0xffff))
+
+#define _STARPU_TRACEBUF_START_CODELET_BODY(job, nimpl) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_CODELET_START, __starpu_tracebuf_intern(_starpu_job_get_task_name(job)), (job)->job_id, (nimpl))
+#define _STARPU_TRACEBUF_END_CODELET_BODY(job, nimpl) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_CODELET_END, __starpu_tracebuf_intern(_starpu_job_get_task_name(job)), (job)->job_id, (nimpl))
+#define _STARPU_TRACEBUF_TASK_SUBMIT(job) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_TASK_SUBMIT, __starpu_tracebuf_intern(_starpu_job_get_task_name(job)), (job)->job_id, 0)
+#define _STARPU_TRACEBUF_START_CALLBACK(job) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_CALLBACK_START, 0, (job)->job_id, 0)
+#define _STARPU_TRACEBUF_END_CALLBACK(job) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_CALLBACK_END, 0, (job)->job_id, 0)
+#define _STARPU_TRACEBUF_START_DRIVER_COPY(src_node, dst_node, size, com_id) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_DRIVER_COPY_START, _STARPU_TRACEBUF_NODES(src_node, dst_node), (size), (com_id))
+#define _STARPU_TRACEBUF_END_DRIVER_COPY(src_node, dst_node, size, com_id) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_DRIVER_COPY_END, _STARPU_TRACEBUF_NODES(src_node, dst_node), (size), (com_id))
+#define _STARPU_TRACEBUF_START_FETCH_INPUT() \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_FETCH_INPUT_START, 0, 0, 0)
+#define _STARPU_TRACEBUF_END_FETCH_INPUT() \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_FETCH_INPUT_END, 0, 0, 0)
+#define _STARPU_TRACEBUF_WORKER_SLEEP_START() \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_SLEEP_START, 0, 0, 0)
+#define _STARPU_TRACEBUF_WORKER_SLEEP_END() \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_SLEEP_END, 0, 0, 0)
+#define _STARPU_TRACEBUF_START_MEMRECLAIM(memnode, is_prefetch) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_MEMRECLAIM_START, (memnode), (is_prefetch), 0)
+#define _STARPU_TRACEBUF_END_MEMRECLAIM(memnode, is_prefetch) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_MEMRECLAIM_END, (memnode), (is_prefetch), 0)
+#define _STARPU_TRACEBUF_JOB_PUSH(task, prio) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_JOB_PUSH, 0, starpu_task_get_job_id(task), (int64_t) (prio))
+#define _STARPU_TRACEBUF_JOB_POP(task, prio) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_JOB_POP, 0, starpu_task_get_job_id(task), (int64_t) (prio))
+#define _STARPU_TRACEBUF_USER_EVENT(code) \
+	_STARPU_TRACEBUF_RECORD(_STARPU_TRACEBUF_USER_EVENT, 0, (code), 0)
+
+#pragma GCC visibility pop
+
+#endif /* __TRACEBUF_H__ */
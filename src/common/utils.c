@@ -25,6 +25,9 @@
 #endif
 #include <fcntl.h>
 #include <ctype.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #if defined(_WIN32) && !defined(__CYGWIN__)
 #include <io.h>
@@ -355,6 +358,25 @@ int _starpu_fftruncate(FILE *file, size_t length)
 	return ftruncate(fileno(file), length);
 }
 
+#ifdef HAVE_SYS_UIO_H
+void _starpu_iovec_advance(struct iovec **iov, int *iovcnt, size_t size)
+{
+	/* Skip the buffers which were completely transferred */
+	while (*iovcnt > 0 && size >= (*iov)->iov_len)
+	{
+		size -= (*iov)->iov_len;
+		(*iov)++;
+		(*iovcnt)--;
+	}
+	if (size)
+	{
+		STARPU_ASSERT(*iovcnt > 0);
+		(*iov)->iov_base = (char *) (*iov)->iov_base + size;
+		(*iov)->iov_len -= size;
+	}
+}
+#endif
+
 static int _starpu_warn_nolock(int err)
 {
 	if (0
@@ -181,6 +181,11 @@ void _starpu_rmtemp_many(char *path, int depth);
 void _starpu_rmdir_many(char *path, int depth);
 int _starpu_fftruncate(FILE *file, size_t length);
 int _starpu_ftruncate(int fd, size_t length);
+struct iovec;
+/** Skip the first \p size bytes of the \p *iovcnt buffers described by \p
+ * *iov, typically after a partial readv or writev. The buffer which contains
+ * the next byte to be transferred gets modified. */
+void _starpu_iovec_advance(struct iovec **iov, int *iovcnt, size_t size);
 int _starpu_frdlock(FILE *file);
 int _starpu_frdunlock(FILE *file);
 int _starpu_fwrlock(FILE *file);
@@ -91,6 +91,17 @@
  *   - on failure, record as waiting on h
  * - mutex_unlock(&arbiter);
  * - return 0 if succeeded, 1 if failed;
+ *
+ *
+ * Since all arbitered submissions and terminations are serialized by the
+ * arbiter mutex, an arbiter can be split into shards (STARPU_ARBITER_SHARDS),
+ * each handle being assigned to one of them according to a hash of the
+ * handle. Each shard is an arbiter on its own: handles are sorted by arbiter
+ * address (see _starpu_compar_handles), so a task first takes all its
+ * handles of the first shard as described above, then proceeds with the
+ * handles of the next shard, etc. This global ordering prevents deadlocks,
+ * at the price of keeping the handles of the first shards while waiting for
+ * the handles of the next shards.
  */
 
 static int _starpu_arbiter_filter_modes(int mode)
@@ -107,6 +118,12 @@ static int _starpu_arbiter_filter_modes(int mode)
 
 struct starpu_arbiter
 {
+	/** Arbiter created by the application, or itself if not sharded */
+	struct starpu_arbiter *parent;
+	/** Number of shards, 0 if not sharded */
+	unsigned nshards;
+	struct starpu_arbiter *shards;
+
 #ifdef LOCK_OR_DELEGATE
 /* The list of task to perform */
 	struct LockOrDelegateListNode* dlTaskListHead;
@@ -759,45 +776,79 @@ void _starpu_notify_arbitered_dependencies(starpu_data_handle_t handle, enum sta
 	return;
 }
 
-starpu_arbiter_t starpu_arbiter_create(void)
+static void _starpu_arbiter_init(starpu_arbiter_t arbiter, starpu_arbiter_t parent)
 {
-	starpu_arbiter_t res;
-	_STARPU_MALLOC(res, sizeof(*res));
+	arbiter->parent = parent;
+	arbiter->nshards = 0;
+	arbiter->shards = NULL;
+#ifdef LOCK_OR_DELEGATE
+	arbiter->dlTaskListHead = NULL;
+	_starpu_spin_init(&arbiter->dlListLock);
+	arbiter->working = 0;
+#else /* LOCK_OR_DELEGATE */
+	STARPU_PTHREAD_MUTEX_INIT(&arbiter->mutex, NULL);
+#endif /* LOCK_OR_DELEGATE */
+}
 
+static void _starpu_arbiter_deinit(starpu_arbiter_t arbiter)
+{
 #ifdef LOCK_OR_DELEGATE
-	res->dlTaskListHead = NULL;
-	_starpu_spin_init(&res->dlListLock);
-	res->working = 0;
+	_starpu_spin_lock(&arbiter->dlListLock);
+	STARPU_ASSERT(!arbiter->dlTaskListHead);
+	STARPU_ASSERT(!arbiter->working);
+	_starpu_spin_unlock(&arbiter->dlListLock);
+	_starpu_spin_destroy(&arbiter->dlListLock);
 #else /* LOCK_OR_DELEGATE */
-	STARPU_PTHREAD_MUTEX_INIT(&res->mutex, NULL);
+	STARPU_PTHREAD_MUTEX_LOCK(&arbiter->mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&arbiter->mutex);
+	STARPU_PTHREAD_MUTEX_DESTROY(&arbiter->mutex);
 #endif /* LOCK_OR_DELEGATE */
+}
+
+starpu_arbiter_t starpu_arbiter_create_sharded(unsigned nshards)
+{
+	starpu_arbiter_t res;
+	_STARPU_MALLOC(res, sizeof(*res));
+	_starpu_arbiter_init(res, res);
+
+	if (nshards > 1)
+	{
+		unsigned i;
+		res->nshards = nshards;
+		_STARPU_MALLOC(res->shards, nshards * sizeof(*res->shards));
+		for (i = 0; i < nshards; i++)
+			_starpu_arbiter_init(&res->shards[i], res);
+	}
 
 	return res;
 }
 
+starpu_arbiter_t starpu_arbiter_create(void)
+{
+	/* This may be called before starpu_init, e.g. by the OpenMP support */
+	return starpu_arbiter_create_sharded(starpu_getenv_number_default("STARPU_ARBITER_SHARDS", 1));
+}
+
 void starpu_data_assign_arbiter(starpu_data_handle_t handle, starpu_arbiter_t arbiter)
 {
-	if (handle->arbiter && handle->arbiter == _starpu_global_arbiter)
+	if (handle->arbiter && handle->arbiter->parent == _starpu_global_arbiter)
 		/* Just for testing purpose */
 		return;
 	STARPU_ASSERT_MSG(!handle->arbiter, "handle can only be assigned one arbiter");
 	STARPU_ASSERT_MSG(!handle->refcnt, "arbiter can be assigned to handle only right after initialization");
 	STARPU_ASSERT_MSG(!handle->busy_count, "arbiter can be assigned to handle only right after initialization");
+	if (arbiter->nshards)
+		/* Spread the handles over the shards */
+		arbiter = &arbiter->shards[starpu_hash_crc32c_be_ptr(handle, 0) % arbiter->nshards];
 	handle->arbiter = arbiter;
 }
 
 void starpu_arbiter_destroy(starpu_arbiter_t arbiter)
 {
-#ifdef LOCK_OR_DELEGATE
-	_starpu_spin_lock(&arbiter->dlListLock);
-	STARPU_ASSERT(!arbiter->dlTaskListHead);
-	STARPU_ASSERT(!arbiter->working);
-	_starpu_spin_unlock(&arbiter->dlListLock);
-	_starpu_spin_destroy(&arbiter->dlListLock);
-#else /* LOCK_OR_DELEGATE */
-	STARPU_PTHREAD_MUTEX_LOCK(&arbiter->mutex);
-	STARPU_PTHREAD_MUTEX_UNLOCK(&arbiter->mutex);
-	STARPU_PTHREAD_MUTEX_DESTROY(&arbiter->mutex);
-#endif /* LOCK_OR_DELEGATE */
+	unsigned i;
+	for (i = 0; i < arbiter->nshards; i++)
+		_starpu_arbiter_deinit(&arbiter->shards[i]);
+	free(arbiter->shards);
+	_starpu_arbiter_deinit(arbiter);
 	free(arbiter);
 }
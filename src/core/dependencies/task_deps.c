@@ -24,6 +24,7 @@
 #include <core/sched_policy.h>
 #include <core/dependencies/data_concurrency.h>
 #include <profiling/bound.h>
+#include <profiling/analysis.h>
 #include <core/debug.h>
 
 static struct _starpu_cg *create_cg_task(unsigned ntags, struct _starpu_job *j)
@@ -63,6 +64,8 @@ static void _starpu_task_add_succ(struct _starpu_job *j, struct _starpu_cg *cg)
 
 void _starpu_notify_task_dependencies(struct _starpu_job *j)
 {
+	if (_starpu_analysis_enabled)
+		_starpu_analysis_job_terminated(j);
 	_starpu_notify_cg_list(j, &j->job_successors);
 }
 
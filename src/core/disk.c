@@ -22,10 +22,14 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#ifdef HAVE_SYS_UIO_H
+#include <sys/uio.h>
+#endif
 
 #include <common/config.h>
 #include <core/debug.h>
 #include <core/disk.h>
+#include <core/disk_compress.h>
 #include <core/workers.h>
 #include <core/perfmodel/perfmodel.h>
 #include <core/topology.h>
@@ -54,7 +58,7 @@ static int disk_number = 0;
 
 int starpu_disk_swap_node = -1;
 
-static void add_async_event(struct _starpu_async_channel * channel, void * event)
+static void add_async_event(struct _starpu_async_channel * channel, void * event, int compress)
 {
 	if (!event)
 		return;
@@ -67,6 +71,7 @@ static void add_async_event(struct _starpu_async_channel * channel, void * event
 
 	struct _starpu_disk_backend_event * backend_event = _starpu_disk_backend_event_new();
 	backend_event->backend_event = event;
+	backend_event->compress = compress;
 
 	/* Store event at the end of the list */
 	_starpu_disk_backend_event_list_push_back(disk_event->requests, backend_event);
@@ -150,6 +155,8 @@ int starpu_disk_register(struct starpu_disk_ops *func, void *parameter, starpu_s
 
 	_starpu_mem_chunk_disk_register(disk_memnode);
 
+	_starpu_disk_compress_register(disk_memnode, func, base);
+
 	return disk_memnode;
 }
 
@@ -166,6 +173,8 @@ void _starpu_disk_unregister(void)
 		_starpu_set_disk_flag(i, STARPU_DISK_NO_RECLAIM);
 		_starpu_free_all_automatically_allocated_buffers(i);
 
+		_starpu_disk_compress_unregister(i);
+
 		/* don't forget to unplug */
 		disk_register_list[i]->functions->unplug(disk_register_list[i]->base);
 		free(disk_register_list[i]);
@@ -183,19 +192,38 @@ void _starpu_disk_unregister(void)
 
 void *_starpu_disk_alloc(unsigned node, size_t size)
 {
-	return disk_register_list[node]->functions->alloc(disk_register_list[node]->base, size);
+	void *obj = disk_register_list[node]->functions->alloc(disk_register_list[node]->base, size);
+	if (obj && _starpu_disk_compress_enabled(node))
+		_starpu_disk_compress_new_obj(node, obj, size);
+	return obj;
 }
 
 void _starpu_disk_free(unsigned node, void *obj, size_t size)
 {
+	if (_starpu_disk_compress_enabled(node))
+		_starpu_disk_compress_free_obj(node, obj);
 	disk_register_list[node]->functions->free(disk_register_list[node]->base, obj, size);
 }
 
+/* Operations on the objects allocated on a node with compression enabled go
+ * through the compression threads, whose jobs are recorded as events */
+static int disk_compress_event(unsigned node, struct _starpu_async_channel *channel, void *event)
+{
+	if (!event)
+		return 0;
+	_starpu_disk_get_event(&channel->event)->memory_node = node;
+	add_async_event(channel, event, 1);
+	return -EAGAIN;
+}
+
 /* src_node == disk node and dst_node == STARPU_MAIN_RAM */
 int _starpu_disk_read(unsigned src_node, unsigned dst_node STARPU_ATTRIBUTE_UNUSED, void *obj, void *buf, off_t offset, size_t size, struct _starpu_async_channel *channel)
 {
 	void *event = NULL;
 
+	if (_starpu_disk_compress_obj(src_node, obj))
+		return disk_compress_event(src_node, channel, _starpu_disk_compress_read(src_node, obj, buf, offset, size, channel != NULL));
+
 	if (channel != NULL)
 	{
 		if (disk_register_list[src_node]->functions->async_read == NULL)
@@ -209,7 +237,7 @@ int _starpu_disk_read(unsigned src_node, unsigned dst_node STARPU_ATTRIBUTE_UNUS
 			event = disk_register_list[src_node]->functions->async_read(disk_register_list[src_node]->base, obj, buf, offset, size);
 			starpu_interface_end_driver_copy_async(src_node, dst_node, start);
 
-			add_async_event(channel, event);
+			add_async_event(channel, event, 0);
 		}
 	}
 	/* asynchronous request failed or synchronous request is asked */
@@ -226,6 +254,9 @@ int _starpu_disk_write(unsigned src_node STARPU_ATTRIBUTE_UNUSED, unsigned dst_n
 {
 	void *event = NULL;
 
+	if (_starpu_disk_compress_obj(dst_node, obj))
+		return disk_compress_event(dst_node, channel, _starpu_disk_compress_write(dst_node, obj, buf, offset, size, channel != NULL));
+
 	if (channel != NULL)
 	{
 		if (disk_register_list[dst_node]->functions->async_write == NULL)
@@ -239,7 +270,7 @@ int _starpu_disk_write(unsigned src_node STARPU_ATTRIBUTE_UNUSED, unsigned dst_n
 			event = disk_register_list[dst_node]->functions->async_write(disk_register_list[dst_node]->base, obj, buf, offset, size);
 			starpu_interface_end_driver_copy_async(src_node, dst_node, start);
 
-			add_async_event(channel, event);
+			add_async_event(channel, event, 0);
 		}
 	}
 	/* asynchronous request failed or synchronous request is asked */
@@ -251,25 +282,118 @@ int _starpu_disk_write(unsigned src_node STARPU_ATTRIBUTE_UNUSED, unsigned dst_n
 	return -EAGAIN;
 }
 
+/* src_node == disk node and dst_node == STARPU_MAIN_RAM */
+int _starpu_disk_readv(unsigned src_node, unsigned dst_node, void *obj, uintptr_t dst, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *channel)
+{
+	struct starpu_disk_ops *functions = disk_register_list[src_node]->functions;
+	int ret = 0;
+	unsigned i, n;
+#ifdef HAVE_SYS_UIO_H
+	struct iovec *iov = NULL;
+	unsigned j;
+#endif
+
+	if (_starpu_disk_compress_obj(src_node, obj))
+		return disk_compress_event(src_node, channel, _starpu_disk_compress_readv(src_node, obj, dst, vec, nvec, channel != NULL));
+
+	for (i = 0; i < nvec; i += n)
+	{
+		n = 1;
+#ifdef HAVE_SYS_UIO_H
+		if (functions->readv)
+			n = _starpu_copy_vec_src_run(vec + i, nvec - i, _STARPU_IOV_MAX);
+		if (n > 1)
+		{
+			/* Contiguous on the disk, read it at once, synchronously
+			 * since there is no asynchronous vectored I/O */
+			if (!iov)
+				_STARPU_MALLOC(iov, STARPU_MIN(nvec, _STARPU_IOV_MAX) * sizeof(*iov));
+			for (j = 0; j < n; j++)
+			{
+				iov[j].iov_base = (void *) (dst + vec[i+j].dst_offset);
+				iov[j].iov_len = vec[i+j].size;
+			}
+			functions->readv(disk_register_list[src_node]->base, obj, iov, n, vec[i].src_offset);
+			continue;
+		}
+#endif
+		if (_starpu_disk_read(src_node, dst_node, obj, (void *) (dst + vec[i].dst_offset), vec[i].src_offset, vec[i].size, channel))
+			ret = -EAGAIN;
+	}
+
+#ifdef HAVE_SYS_UIO_H
+	free(iov);
+#endif
+	return ret;
+}
+
+/* src_node == STARPU_MAIN_RAM and dst_node == disk node */
+int _starpu_disk_writev(unsigned src_node, unsigned dst_node, void *obj, uintptr_t src, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *channel)
+{
+	struct starpu_disk_ops *functions = disk_register_list[dst_node]->functions;
+	int ret = 0;
+	unsigned i, n;
+#ifdef HAVE_SYS_UIO_H
+	struct iovec *iov = NULL;
+	unsigned j;
+#endif
+
+	if (_starpu_disk_compress_obj(dst_node, obj))
+		return disk_compress_event(dst_node, channel, _starpu_disk_compress_writev(dst_node, obj, src, vec, nvec, channel != NULL));
+
+	for (i = 0; i < nvec; i += n)
+	{
+		n = 1;
+#ifdef HAVE_SYS_UIO_H
+		if (functions->writev)
+			n = _starpu_copy_vec_dst_run(vec + i, nvec - i, _STARPU_IOV_MAX);
+		if (n > 1)
+		{
+			/* Contiguous on the disk, write it at once, synchronously
+			 * since there is no asynchronous vectored I/O */
+			if (!iov)
+				_STARPU_MALLOC(iov, STARPU_MIN(nvec, _STARPU_IOV_MAX) * sizeof(*iov));
+			for (j = 0; j < n; j++)
+			{
+				iov[j].iov_base = (void *) (src + vec[i+j].src_offset);
+				iov[j].iov_len = vec[i+j].size;
+			}
+			functions->writev(disk_register_list[dst_node]->base, obj, iov, n, vec[i].dst_offset);
+			continue;
+		}
+#endif
+		if (_starpu_disk_write(src_node, dst_node, obj, (void *) (src + vec[i].src_offset), vec[i].dst_offset, vec[i].size, channel))
+			ret = -EAGAIN;
+	}
+
+#ifdef HAVE_SYS_UIO_H
+	free(iov);
+#endif
+	return ret;
+}
+
 int _starpu_disk_copy(unsigned node_src, void *obj_src, off_t offset_src, unsigned node_dst, void *obj_dst, off_t offset_dst, size_t size, struct _starpu_async_channel *channel)
 {
 	/* both nodes have same copy function */
 	void * event = NULL;
+	/* The backend would copy the data as it is stored, without the
+	 * compression metadata */
+	int compressed = _starpu_disk_compress_obj(node_src, obj_src) || _starpu_disk_compress_obj(node_dst, obj_dst);
 
-	if (channel)
+	if (channel && !compressed)
 	{
 		_starpu_disk_get_event(&channel->event)->memory_node = node_src;
 		event = disk_register_list[node_src]->functions->copy(disk_register_list[node_src]->base,
 								      obj_src, offset_src,
 								      disk_register_list[node_dst]->base,
 								      obj_dst, offset_dst, size);
-		add_async_event(channel, event);
+		add_async_event(channel, event, 0);
 	}
 
 	/* Something goes wrong with copy disk to disk... */
 	if (!event)
 	{
-		if (channel || starpu_asynchronous_copy_disabled())
+		if (!compressed && (channel || starpu_asynchronous_copy_disabled()))
 			disk_register_list[node_src]->functions->copy = NULL;
 
 		/* perform a read, and after a write... */
@@ -295,6 +419,9 @@ int _starpu_disk_full_read(unsigned src_node, unsigned dst_node, void *obj, void
 {
 	void *event = NULL;
 
+	if (_starpu_disk_compress_obj(src_node, obj))
+		return disk_compress_event(src_node, channel, _starpu_disk_compress_full_read(src_node, dst_node, obj, ptr, size, channel != NULL));
+
 	if (channel != NULL)
 	{
 		if (disk_register_list[src_node]->functions->async_full_read == NULL)
@@ -308,7 +435,7 @@ int _starpu_disk_full_read(unsigned src_node, unsigned dst_node, void *obj, void
 			event = disk_register_list[src_node]->functions->async_full_read(disk_register_list[src_node]->base, obj, ptr, size, dst_node);
 			starpu_interface_end_driver_copy_async(src_node, dst_node, start);
 
-			add_async_event(channel, event);
+			add_async_event(channel, event, 0);
 		}
 	}
 	/* asynchronous request failed or synchronous request is asked */
@@ -324,6 +451,9 @@ int _starpu_disk_full_write(unsigned src_node STARPU_ATTRIBUTE_UNUSED, unsigned
 {
 	void *event = NULL;
 
+	if (_starpu_disk_compress_obj(dst_node, obj))
+		return disk_compress_event(dst_node, channel, _starpu_disk_compress_full_write(dst_node, obj, ptr, size, channel != NULL));
+
 	if (channel != NULL)
 	{
 		if (disk_register_list[dst_node]->functions->async_full_write == NULL)
@@ -337,7 +467,7 @@ int _starpu_disk_full_write(unsigned src_node STARPU_ATTRIBUTE_UNUSED, unsigned
 			event = disk_register_list[dst_node]->functions->async_full_write(disk_register_list[dst_node]->base, obj, ptr, size);
 			starpu_interface_end_driver_copy_async(src_node, dst_node, start);
 
-			add_async_event(channel, event);
+			add_async_event(channel, event, 0);
 		}
 	}
 	/* asynchronous request failed or synchronous request is asked */
@@ -351,6 +481,7 @@ int _starpu_disk_full_write(unsigned src_node STARPU_ATTRIBUTE_UNUSED, unsigned
 
 void *starpu_disk_open(unsigned node, void *pos, size_t size)
 {
+	/* The file has to keep its format, so it is not compressed */
 	return disk_register_list[node]->functions->open(disk_register_list[node]->base, pos, size);
 }
 
@@ -374,9 +505,16 @@ void starpu_disk_wait_request(struct _starpu_async_channel *async_channel)
 		{
 			next = _starpu_disk_backend_event_list_next(event);
 
-			disk_register_list[node]->functions->wait_request(event->backend_event);
-
-			disk_register_list[node]->functions->free_request(event->backend_event);
+			if (event->compress)
+			{
+				_starpu_disk_compress_wait_request(event->backend_event);
+				_starpu_disk_compress_free_request(event->backend_event);
+			}
+			else
+			{
+				disk_register_list[node]->functions->wait_request(event->backend_event);
+				disk_register_list[node]->functions->free_request(event->backend_event);
+			}
 
 			_starpu_disk_backend_event_list_erase(disk_event->requests, event);
 
@@ -406,11 +544,14 @@ int starpu_disk_test_request(struct _starpu_async_channel *async_channel)
 		{
 			next = _starpu_disk_backend_event_list_next(event);
 
-			int res = disk_register_list[node]->functions->test_request(event->backend_event);
+			int res = event->compress ? _starpu_disk_compress_test_request(event->backend_event) : disk_register_list[node]->functions->test_request(event->backend_event);
 
 				if (res)
 				{
-					disk_register_list[node]->functions->free_request(event->backend_event);
+					if (event->compress)
+						_starpu_disk_compress_free_request(event->backend_event);
+					else
+						disk_register_list[node]->functions->free_request(event->backend_event);
 
 					_starpu_disk_backend_event_list_erase(disk_event->requests, event);
 
@@ -33,6 +33,8 @@ extern "C"
 
 #pragma GCC visibility push(hidden)
 
+struct _starpu_copy_vec;
+
 /** interface to manipulate memory disk */
 void * _starpu_disk_alloc (unsigned node, size_t size) STARPU_ATTRIBUTE_MALLOC;
 
@@ -41,6 +43,14 @@ void _starpu_disk_free (unsigned node, void *obj, size_t size);
 int _starpu_disk_read(unsigned src_node, unsigned dst_node, void *obj, void *buf, off_t offset, size_t size, struct _starpu_async_channel * async_channel);
 /** src_node is for the moment the STARU_MAIN_RAM, dst_node is a disk node */
 int _starpu_disk_write(unsigned src_node, unsigned dst_node, void *obj, void *buf, off_t offset, size_t size, struct _starpu_async_channel * async_channel);
+/** Like _starpu_disk_read, but for the \p nvec pieces described by \p vec.
+ * The pieces which are contiguous on the disk are read with a single
+ * starpu_disk_ops::readv call when available */
+int _starpu_disk_readv(unsigned src_node, unsigned dst_node, void *obj, uintptr_t dst, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel * async_channel);
+/** Like _starpu_disk_write, but for the \p nvec pieces described by \p vec.
+ * The pieces which are contiguous on the disk are written with a single
+ * starpu_disk_ops::writev call when available */
+int _starpu_disk_writev(unsigned src_node, unsigned dst_node, void *obj, uintptr_t src, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel * async_channel);
 
 int _starpu_disk_full_read(unsigned src_node, unsigned dst_node, void * obj, void ** ptr, size_t * size, struct _starpu_async_channel * async_channel);
 int _starpu_disk_full_write(unsigned src_node, unsigned dst_node, void * obj, void * ptr, size_t size, struct _starpu_async_channel * async_channel);
@@ -0,0 +1,777 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Transparent compression of the data stored on disk memory nodes.
+ *
+ * When STARPU_DISK_COMPRESS is set, the data written to a disk node is
+ * compressed before being given to the backend, and decompressed after being
+ * read back, so that less bytes go through the disk, whose bandwidth is
+ * usually much lower than the compression speed. Objects are compressed as a
+ * whole: only writes of a whole object get compressed, a partial write to a
+ * compressed object decompresses it and stores it raw again. We thus keep, for
+ * each object of the disk, whether and how much it is compressed.
+ *
+ * The compression is performed by a small pool of threads, so that the
+ * workers which handle the data requests are not blocked. The completion is
+ * tested or waited for through the disk events of the async channel.
+ *
+ * The achieved effective bandwidth, i.e. the amount of uncompressed data
+ * divided by the time to compress and write it, or read and decompress it, is
+ * fed back to the bus performance model, so that schedulers take the
+ * compression into account.
+ */
+
+#include <common/config.h>
+#include <common/list.h>
+#include <common/uthash.h>
+#include <common/utils.h>
+#include <core/disk.h>
+#include <core/disk_compress.h>
+#include <core/perfmodel/perfmodel.h>
+#include <datawizard/malloc.h>
+#include <datawizard/node_ops.h>
+
+#if defined(HAVE_LZ4_H) && defined(HAVE_LIBLZ4)
+#define STARPU_DISK_COMPRESS_LZ4
+#include <lz4.h>
+#endif
+
+/* Update the bus performance model every that many operations */
+#define UPDATE_PERIOD 16
+
+struct _starpu_disk_codec
+{
+	const char *name;
+	/* Compress size bytes from src to dst, which can hold size bytes.
+	 * Return the compressed size, or 0 if it would not be smaller than
+	 * size */
+	size_t (*compress)(const void *src, size_t size, void *dst);
+	void (*decompress)(const void *src, size_t csize, void *dst, size_t size);
+};
+
+/*
+ * Zero suppression: numerical data often contains a lot of zeroes (sparse or
+ * padded matrices, freshly initialized data, etc.), which are exactly 32bit
+ * zero words for floats. Words are processed by groups of 32, each group is
+ * stored as a bitmap of its non-zero words, followed by these words. This
+ * runs at memory speed, contrary to general-purpose compressors.
+ */
+#define ZERO_GROUP 32
+
+static size_t zero_compress(const void *_src, size_t size, void *_dst)
+{
+	const char *src = _src;
+	char *dst = _dst;
+	size_t nwords = size / sizeof(uint32_t);
+	size_t tail = size - nwords * sizeof(uint32_t);
+	size_t i, out = 0;
+
+	for (i = 0; i < nwords; i += ZERO_GROUP)
+	{
+		unsigned n = STARPU_MIN(ZERO_GROUP, nwords - i), j;
+		size_t mask_pos = out;
+		uint32_t mask = 0, word;
+
+		if (out + sizeof(mask) >= size)
+			return 0;
+		out += sizeof(mask);
+
+		for (j = 0; j < n; j++)
+		{
+			memcpy(&word, src + (i + j) * sizeof(word), sizeof(word));
+			if (word)
+			{
+				if (out + sizeof(word) >= size)
+					return 0;
+				memcpy(dst + out, &word, sizeof(word));
+				out += sizeof(word);
+				mask |= 1U << j;
+			}
+		}
+		memcpy(dst + mask_pos, &mask, sizeof(mask));
+	}
+
+	/* The last bytes which do not make a whole word are kept as they are */
+	if (out + tail >= size)
+		return 0;
+	memcpy(dst + out, src + nwords * sizeof(uint32_t), tail);
+	return out + tail;
+}
+
+static void zero_decompress(const void *_src, size_t csize, void *_dst, size_t size)
+{
+	const char *src = _src;
+	char *dst = _dst;
+	size_t nwords = size / sizeof(uint32_t);
+	size_t tail = size - nwords * sizeof(uint32_t);
+	size_t i, in = 0;
+
+	for (i = 0; i < nwords; i += ZERO_GROUP)
+	{
+		unsigned n = STARPU_MIN(ZERO_GROUP, nwords - i), j;
+		uint32_t mask, word;
+
+		memcpy(&mask, src + in, sizeof(mask));
+		in += sizeof(mask);
+
+		for (j = 0; j < n; j++)
+		{
+			if (mask & (1U << j))
+			{
+				memcpy(&word, src + in, sizeof(word));
+				in += sizeof(word);
+			}
+			else
+				word = 0;
+			memcpy(dst + (i + j) * sizeof(word), &word, sizeof(word));
+		}
+	}
+
+	STARPU_ASSERT(in + tail == csize);
+	memcpy(dst + nwords * sizeof(uint32_t), src + in, tail);
+}
+
+#ifdef STARPU_DISK_COMPRESS_LZ4
+static size_t lz4_compress(const void *src, size_t size, void *dst)
+{
+	int ret;
+
+	if (size > LZ4_MAX_INPUT_SIZE)
+		return 0;
+	/* Fails, i.e. returns 0, if the result does not fit in size */
+	ret = LZ4_compress_default(src, dst, size, size);
+	return ret > 0 ? (size_t) ret : 0;
+}
+
+static void lz4_decompress(const void *src, size_t csize, void *dst, size_t size)
+{
+	int ret = LZ4_decompress_safe(src, dst, csize, size);
+	STARPU_ASSERT_MSG(ret == (int) size, "corrupted compressed data on disk");
+}
+#endif
+
+static const struct _starpu_disk_codec codecs[] =
+{
+	{ .name = "zero", .compress = zero_compress, .decompress = zero_decompress },
+#ifdef STARPU_DISK_COMPRESS_LZ4
+	{ .name = "lz4", .compress = lz4_compress, .decompress = lz4_decompress },
+#endif
+};
+
+struct _starpu_disk_compress_node
+{
+	unsigned node;
+	const struct _starpu_disk_codec *codec;
+	struct starpu_disk_ops *functions;
+	void *base;
+
+	/* Protects the statistics below */
+	starpu_pthread_mutex_t mutex;
+	/* Amount of data written to and read from the disk, before
+	 * compression and as actually stored */
+	size_t raw_written, stored_written;
+	size_t raw_read, stored_read;
+	/* Time spent in writes and reads, including (de)compression, in us */
+	double write_time, read_time;
+	/* Number of operations since the last update of the performance model */
+	unsigned nops;
+};
+
+struct _starpu_disk_compress_node *_starpu_disk_compress_nodes[STARPU_MAXNODES];
+
+/* How an object of a disk is currently stored */
+struct disk_compress_obj
+{
+	void *obj;
+	/* Size of the uncompressed data */
+	size_t size;
+	/* Size of the compressed data, 0 if it is stored raw */
+	size_t csize;
+	/* Serializes the operations on the object */
+	starpu_pthread_mutex_t mutex;
+	UT_hash_handle hh;
+};
+
+static struct disk_compress_obj *objs;
+static starpu_pthread_mutex_t objs_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+
+/* A piece of a transfer between main memory and the disk */
+struct disk_compress_piece
+{
+	off_t disk_offset;
+	size_t ram_offset;
+	size_t size;
+};
+
+LIST_TYPE(_starpu_disk_compress_job,
+	struct _starpu_disk_compress_node *cnode;
+	struct disk_compress_obj *cobj;
+	int write;
+	/* Whether this is a full_read or full_write */
+	int full;
+	uintptr_t ram;
+	struct disk_compress_piece *pieces;
+	unsigned npieces;
+	/* For the common case of a single piece, to avoid an allocation */
+	struct disk_compress_piece piece;
+	int done;
+);
+
+static starpu_pthread_t *threads;
+static unsigned nthreads;
+static unsigned nnodes;
+static starpu_pthread_mutex_t pool_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when jobs are queued */
+static starpu_pthread_cond_t pool_cond = STARPU_PTHREAD_COND_INITIALIZER;
+/* Signaled when jobs are done */
+static starpu_pthread_cond_t done_cond = STARPU_PTHREAD_COND_INITIALIZER;
+static struct _starpu_disk_compress_job_list jobs;
+static int running;
+
+static struct disk_compress_obj *get_obj(void *obj)
+{
+	struct disk_compress_obj *cobj;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&objs_mutex);
+	HASH_FIND_PTR(objs, &obj, cobj);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&objs_mutex);
+	STARPU_ASSERT_MSG(cobj, "unknown disk object %p", obj);
+	return cobj;
+}
+
+/* Load and decompress the whole object into buf */
+static void load(struct _starpu_disk_compress_node *cnode, struct disk_compress_obj *cobj, void *buf)
+{
+	void *cbuf;
+
+	_STARPU_MALLOC(cbuf, cobj->csize);
+	cnode->functions->read(cnode->base, cobj->obj, cbuf, 0, cobj->csize);
+	cnode->codec->decompress(cbuf, cobj->csize, buf, cobj->size);
+	free(cbuf);
+}
+
+/* Whether the pieces cover the whole object, in order */
+static int covers(struct disk_compress_obj *cobj, const struct disk_compress_piece *pieces, unsigned npieces)
+{
+	off_t offset = 0;
+	unsigned i;
+
+	for (i = 0; i < npieces; i++)
+	{
+		if (pieces[i].disk_offset != offset)
+			return 0;
+		offset += pieces[i].size;
+	}
+	return (size_t) offset == cobj->size;
+}
+
+/* Returns the amount of bytes actually written */
+static size_t do_write(struct _starpu_disk_compress_job *job)
+{
+	struct _starpu_disk_compress_node *cnode = job->cnode;
+	struct disk_compress_obj *cobj = job->cobj;
+	struct starpu_disk_ops *functions = cnode->functions;
+	size_t stored = 0;
+	unsigned i;
+
+	if (job->full || covers(cobj, job->pieces, job->npieces))
+	{
+		/* We are overwriting the whole object, compress it */
+		size_t size = job->full ? job->piece.size : cobj->size;
+		char *buf, *cbuf;
+		size_t csize;
+
+		if (job->npieces == 1)
+			buf = (char *) job->ram + job->pieces[0].ram_offset;
+		else
+		{
+			/* Gather the pieces */
+			_STARPU_MALLOC(buf, size);
+			for (i = 0; i < job->npieces; i++)
+				memcpy(buf + job->pieces[i].disk_offset, (char *) job->ram + job->pieces[i].ram_offset, job->pieces[i].size);
+		}
+
+		_STARPU_MALLOC(cbuf, size);
+		csize = cnode->codec->compress(buf, size, cbuf);
+		if (csize)
+			stored = csize;
+		else
+			/* Not compressible, store it raw */
+			stored = size;
+
+		if (job->full)
+			functions->full_write(cnode->base, cobj->obj, csize ? cbuf : buf, stored);
+		else
+			functions->write(cnode->base, cobj->obj, csize ? cbuf : buf, 0, stored);
+		cobj->size = size;
+		cobj->csize = csize;
+
+		free(cbuf);
+		if (job->npieces > 1)
+			free(buf);
+	}
+	else if (cobj->csize)
+	{
+		/* Partial write to a compressed object, patch it and store it
+		 * raw */
+		char *buf;
+
+		_STARPU_MALLOC(buf, cobj->size);
+		load(cnode, cobj, buf);
+		for (i = 0; i < job->npieces; i++)
+			memcpy(buf + job->pieces[i].disk_offset, (char *) job->ram + job->pieces[i].ram_offset, job->pieces[i].size);
+		functions->write(cnode->base, cobj->obj, buf, 0, cobj->size);
+		cobj->csize = 0;
+		stored = cobj->size;
+		free(buf);
+	}
+	else
+	{
+		for (i = 0; i < job->npieces; i++)
+		{
+			functions->write(cnode->base, cobj->obj, (char *) job->ram + job->pieces[i].ram_offset, job->pieces[i].disk_offset, job->pieces[i].size);
+			stored += job->pieces[i].size;
+		}
+	}
+
+	return stored;
+}
+
+/* Returns the amount of bytes actually read */
+static size_t do_read(struct _starpu_disk_compress_job *job)
+{
+	struct _starpu_disk_compress_node *cnode = job->cnode;
+	struct disk_compress_obj *cobj = job->cobj;
+	size_t stored = 0;
+	unsigned i;
+
+	if (!cobj->csize)
+	{
+		for (i = 0; i < job->npieces; i++)
+		{
+			cnode->functions->read(cnode->base, cobj->obj, (char *) job->ram + job->pieces[i].ram_offset, job->pieces[i].disk_offset, job->pieces[i].size);
+			stored += job->pieces[i].size;
+		}
+	}
+	else if (job->npieces == 1 && (job->full || covers(cobj, job->pieces, 1)))
+		load(cnode, cobj, (char *) job->ram + job->pieces[0].ram_offset);
+	else
+	{
+		/* Decompress it all and only keep the requested pieces */
+		char *buf;
+
+		_STARPU_MALLOC(buf, cobj->size);
+		load(cnode, cobj, buf);
+		for (i = 0; i < job->npieces; i++)
+			memcpy((char *) job->ram + job->pieces[i].ram_offset, buf + job->pieces[i].disk_offset, job->pieces[i].size);
+		free(buf);
+	}
+
+	if (cobj->csize)
+		stored = cobj->csize;
+	return stored;
+}
+
+static void execute(struct _starpu_disk_compress_job *job)
+{
+	struct _starpu_disk_compress_node *cnode = job->cnode;
+	size_t raw = 0, stored;
+	double start, end;
+	unsigned i;
+
+	if (job->full)
+		raw = job->piece.size;
+	else
+		for (i = 0; i < job->npieces; i++)
+			raw += job->pieces[i].size;
+
+	start = starpu_timing_now();
+	STARPU_PTHREAD_MUTEX_LOCK(&job->cobj->mutex);
+	if (job->write)
+		stored = do_write(job);
+	else
+		stored = do_read(job);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&job->cobj->mutex);
+	end = starpu_timing_now();
+
+	STARPU_PTHREAD_MUTEX_LOCK(&cnode->mutex);
+	if (job->write)
+	{
+		cnode->raw_written += raw;
+		cnode->stored_written += stored;
+		cnode->write_time += end - start;
+	}
+	else
+	{
+		cnode->raw_read += raw;
+		cnode->stored_read += stored;
+		cnode->read_time += end - start;
+	}
+	if (++cnode->nops >= UPDATE_PERIOD)
+	{
+		/* Bytes per us, i.e. MB/s */
+		_starpu_update_bandwidth_disk(cnode->write_time > 0. ? cnode->raw_written / cnode->write_time : 0.,
+					      cnode->read_time > 0. ? cnode->raw_read / cnode->read_time : 0.,
+					      cnode->node);
+		cnode->nops = 0;
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cnode->mutex);
+}
+
+static void *disk_compress_func(void *arg STARPU_ATTRIBUTE_UNUSED)
+{
+	starpu_pthread_setname("disk compress");
+
+	STARPU_PTHREAD_MUTEX_LOCK(&pool_mutex);
+	while (1)
+	{
+		struct _starpu_disk_compress_job *job;
+
+		while (running && _starpu_disk_compress_job_list_empty(&jobs))
+			STARPU_PTHREAD_COND_WAIT(&pool_cond, &pool_mutex);
+		if (_starpu_disk_compress_job_list_empty(&jobs))
+			/* Not running any more, and nothing left to do */
+			break;
+
+		job = _starpu_disk_compress_job_list_pop_front(&jobs);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&pool_mutex);
+
+		execute(job);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&pool_mutex);
+		job->done = 1;
+		STARPU_PTHREAD_COND_BROADCAST(&done_cond);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pool_mutex);
+
+	return NULL;
+}
+
+static void delete_job(struct _starpu_disk_compress_job *job)
+{
+	if (job->pieces != &job->piece)
+		free(job->pieces);
+	_starpu_disk_compress_job_delete(job);
+}
+
+static struct _starpu_disk_compress_job *new_job(unsigned node, void *obj, int write, uintptr_t ram)
+{
+	struct _starpu_disk_compress_job *job = _starpu_disk_compress_job_new();
+
+	job->cnode = _starpu_disk_compress_nodes[node];
+	job->cobj = get_obj(obj);
+	job->write = write;
+	job->full = 0;
+	job->ram = ram;
+	job->pieces = &job->piece;
+	job->npieces = 1;
+	job->done = 0;
+	return job;
+}
+
+/* Queue the job to the compression threads, or execute it right away */
+static void *submit(struct _starpu_disk_compress_job *job, int async)
+{
+	if (async && nthreads)
+	{
+		STARPU_PTHREAD_MUTEX_LOCK(&pool_mutex);
+		_starpu_disk_compress_job_list_push_back(&jobs, job);
+		STARPU_PTHREAD_COND_SIGNAL(&pool_cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&pool_mutex);
+		return job;
+	}
+
+	execute(job);
+	delete_job(job);
+	return NULL;
+}
+
+void *_starpu_disk_compress_read(unsigned node, void *obj, void *buf, off_t offset, size_t size, int async)
+{
+	struct _starpu_disk_compress_job *job = new_job(node, obj, 0, (uintptr_t) buf);
+
+	job->piece.disk_offset = offset;
+	job->piece.ram_offset = 0;
+	job->piece.size = size;
+	return submit(job, async);
+}
+
+void *_starpu_disk_compress_write(unsigned node, void *obj, void *buf, off_t offset, size_t size, int async)
+{
+	struct _starpu_disk_compress_job *job = new_job(node, obj, 1, (uintptr_t) buf);
+
+	job->piece.disk_offset = offset;
+	job->piece.ram_offset = 0;
+	job->piece.size = size;
+	return submit(job, async);
+}
+
+void *_starpu_disk_compress_readv(unsigned node, void *obj, uintptr_t dst, const struct _starpu_copy_vec *vec, unsigned nvec, int async)
+{
+	struct _starpu_disk_compress_job *job = new_job(node, obj, 0, dst);
+	unsigned i;
+
+	if (nvec > 1)
+		_STARPU_MALLOC(job->pieces, nvec * sizeof(*job->pieces));
+	job->npieces = nvec;
+	for (i = 0; i < nvec; i++)
+	{
+		job->pieces[i].disk_offset = vec[i].src_offset;
+		job->pieces[i].ram_offset = vec[i].dst_offset;
+		job->pieces[i].size = vec[i].size;
+	}
+	return submit(job, async);
+}
+
+void *_starpu_disk_compress_writev(unsigned node, void *obj, uintptr_t src, const struct _starpu_copy_vec *vec, unsigned nvec, int async)
+{
+	struct _starpu_disk_compress_job *job = new_job(node, obj, 1, src);
+	unsigned i;
+
+	if (nvec > 1)
+		_STARPU_MALLOC(job->pieces, nvec * sizeof(*job->pieces));
+	job->npieces = nvec;
+	for (i = 0; i < nvec; i++)
+	{
+		job->pieces[i].disk_offset = vec[i].dst_offset;
+		job->pieces[i].ram_offset = vec[i].src_offset;
+		job->pieces[i].size = vec[i].size;
+	}
+	return submit(job, async);
+}
+
+void *_starpu_disk_compress_full_read(unsigned node, unsigned dst_node, void *obj, void **ptr, size_t *size, int async)
+{
+	struct _starpu_disk_compress_job *job;
+	struct disk_compress_obj *cobj = get_obj(obj);
+
+	/* The size is known beforehand, so we can allocate the buffer right
+	 * away, as the backends do */
+	STARPU_PTHREAD_MUTEX_LOCK(&cobj->mutex);
+	*size = cobj->size;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cobj->mutex);
+	_starpu_malloc_flags_on_node(dst_node, ptr, *size, 0);
+
+	job = new_job(node, obj, 0, (uintptr_t) *ptr);
+	job->full = 1;
+	job->piece.disk_offset = 0;
+	job->piece.ram_offset = 0;
+	job->piece.size = *size;
+	return submit(job, async);
+}
+
+void *_starpu_disk_compress_full_write(unsigned node, void *obj, void *ptr, size_t size, int async)
+{
+	struct _starpu_disk_compress_job *job = new_job(node, obj, 1, (uintptr_t) ptr);
+
+	job->full = 1;
+	job->piece.disk_offset = 0;
+	job->piece.ram_offset = 0;
+	job->piece.size = size;
+	return submit(job, async);
+}
+
+int _starpu_disk_compress_test_request(void *_job)
+{
+	struct _starpu_disk_compress_job *job = _job;
+	int done;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&pool_mutex);
+	done = job->done;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pool_mutex);
+	return done;
+}
+
+void _starpu_disk_compress_wait_request(void *_job)
+{
+	struct _starpu_disk_compress_job *job = _job;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&pool_mutex);
+	while (!job->done)
+		STARPU_PTHREAD_COND_WAIT(&done_cond, &pool_mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pool_mutex);
+}
+
+void _starpu_disk_compress_free_request(void *job)
+{
+	delete_job(job);
+}
+
+void _starpu_disk_compress_new_obj(unsigned node STARPU_ATTRIBUTE_UNUSED, void *obj, size_t size)
+{
+	struct disk_compress_obj *cobj;
+
+	_STARPU_MALLOC(cobj, sizeof(*cobj));
+	cobj->obj = obj;
+	cobj->size = size;
+	/* Whatever is already there is raw */
+	cobj->csize = 0;
+	STARPU_PTHREAD_MUTEX_INIT(&cobj->mutex, NULL);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&objs_mutex);
+	HASH_ADD_PTR(objs, obj, cobj);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&objs_mutex);
+}
+
+void _starpu_disk_compress_free_obj(unsigned node STARPU_ATTRIBUTE_UNUSED, void *obj)
+{
+	struct disk_compress_obj *cobj;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&objs_mutex);
+	HASH_FIND_PTR(objs, &obj, cobj);
+	STARPU_ASSERT_MSG(cobj, "unknown disk object %p", obj);
+	HASH_DEL(objs, cobj);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&objs_mutex);
+
+	STARPU_PTHREAD_MUTEX_DESTROY(&cobj->mutex);
+	free(cobj);
+}
+
+int _starpu_disk_compress_known_obj(void *obj)
+{
+	struct disk_compress_obj *cobj;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&objs_mutex);
+	HASH_FIND_PTR(objs, &obj, cobj);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&objs_mutex);
+	return cobj != NULL;
+}
+
+static const struct _starpu_disk_codec *get_codec(void)
+{
+	const char *name = starpu_getenv("STARPU_DISK_COMPRESS");
+	unsigned i;
+
+	if (!name || !name[0] || !strcmp(name, "0") || !strcasecmp(name, "none"))
+		return NULL;
+
+	if (!strcmp(name, "1"))
+		/* The best one available */
+		return &codecs[sizeof(codecs)/sizeof(codecs[0]) - 1];
+
+	for (i = 0; i < sizeof(codecs)/sizeof(codecs[0]); i++)
+		if (!strcasecmp(name, codecs[i].name))
+			return &codecs[i];
+
+	_STARPU_DISP("Warning: unknown or unavailable disk compression '%s', data will not be compressed\n", name);
+	return NULL;
+}
+
+void _starpu_disk_compress_register(unsigned node, struct starpu_disk_ops *functions, void *base)
+{
+#ifndef STARPU_SIMGRID
+	const struct _starpu_disk_codec *codec = get_codec();
+	struct _starpu_disk_compress_node *cnode;
+
+	if (!codec)
+		return;
+
+#ifdef STARPU_LINUX_SYS
+	if (functions == &starpu_disk_unistd_o_direct_ops)
+	{
+		/* Compressed data is not a multiple of the page size */
+		_STARPU_DISP("Warning: disk compression is not supported with the unistd_o_direct backend\n");
+		return;
+	}
+#endif
+
+	_STARPU_CALLOC(cnode, 1, sizeof(*cnode));
+	cnode->node = node;
+	cnode->codec = codec;
+	cnode->functions = functions;
+	cnode->base = base;
+	STARPU_PTHREAD_MUTEX_INIT(&cnode->mutex, NULL);
+
+	if (nnodes++ == 0)
+	{
+		int n = starpu_getenv_number_default("STARPU_DISK_COMPRESS_THREADS", 1);
+		unsigned i;
+
+		nthreads = n > 0 ? n : 0;
+		_starpu_disk_compress_job_list_init(&jobs);
+		running = 1;
+		if (nthreads)
+			_STARPU_MALLOC(threads, nthreads * sizeof(*threads));
+		for (i = 0; i < nthreads; i++)
+			STARPU_PTHREAD_CREATE(&threads[i], NULL, disk_compress_func, NULL);
+	}
+
+	_starpu_disk_compress_nodes[node] = cnode;
+#else
+	(void) node;
+	(void) functions;
+	(void) base;
+#endif
+}
+
+void _starpu_disk_compress_unregister(unsigned node)
+{
+	struct _starpu_disk_compress_node *cnode = _starpu_disk_compress_nodes[node];
+
+	if (!cnode)
+		return;
+
+	if (starpu_getenv_number_default("STARPU_BUS_STATS", 0))
+	{
+		fprintf(stderr, "\n#---------------------\n");
+		fprintf(stderr, "Compression of disk node %u (%s):\n", node, cnode->codec->name);
+		fprintf(stderr, "written %.1f MB as %.1f MB (ratio %.2f), effective bandwidth %.0f MB/s\n",
+			cnode->raw_written / 1000000., cnode->stored_written / 1000000.,
+			cnode->stored_written ? (double) cnode->raw_written / cnode->stored_written : 1.,
+			cnode->write_time > 0. ? cnode->raw_written / cnode->write_time : 0.);
+		fprintf(stderr, "read %.1f MB as %.1f MB (ratio %.2f), effective bandwidth %.0f MB/s\n",
+			cnode->raw_read / 1000000., cnode->stored_read / 1000000.,
+			cnode->stored_read ? (double) cnode->raw_read / cnode->stored_read : 1.,
+			cnode->read_time > 0. ? cnode->raw_read / cnode->read_time : 0.);
+		fprintf(stderr, "#---------------------\n");
+	}
+
+	_starpu_disk_compress_nodes[node] = NULL;
+	STARPU_PTHREAD_MUTEX_DESTROY(&cnode->mutex);
+	free(cnode);
+
+	if (--nnodes == 0)
+	{
+		unsigned i;
+
+		STARPU_PTHREAD_MUTEX_LOCK(&pool_mutex);
+		running = 0;
+		STARPU_PTHREAD_COND_BROADCAST(&pool_cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&pool_mutex);
+		for (i = 0; i < nthreads; i++)
+			STARPU_PTHREAD_JOIN(threads[i], NULL);
+		free(threads);
+		threads = NULL;
+		nthreads = 0;
+	}
+}
+
+int starpu_disk_get_compression_stats(unsigned node, size_t *raw_bytes, size_t *stored_bytes, double *bandwidth_write, double *bandwidth_read)
+{
+	struct _starpu_disk_compress_node *cnode = _starpu_disk_compress_nodes[node];
+
+	if (!cnode)
+		return -ENODEV;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&cnode->mutex);
+	*raw_bytes = cnode->raw_written;
+	*stored_bytes = cnode->stored_written;
+	*bandwidth_write = cnode->write_time > 0. ? cnode->raw_written / cnode->write_time : 0.;
+	*bandwidth_read = cnode->read_time > 0. ? cnode->raw_read / cnode->read_time : 0.;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&cnode->mutex);
+	return 0;
+}
@@ -0,0 +1,76 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __DISK_COMPRESS_H__
+#define __DISK_COMPRESS_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <common/config.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_copy_vec;
+
+/** Enable compression on disk node \p node if requested by
+ * STARPU_DISK_COMPRESS */
+void _starpu_disk_compress_register(unsigned node, struct starpu_disk_ops *functions, void *base);
+void _starpu_disk_compress_unregister(unsigned node);
+
+struct _starpu_disk_compress_node;
+extern struct _starpu_disk_compress_node *_starpu_disk_compress_nodes[STARPU_MAXNODES];
+
+/** Whether compression is enabled on disk node \p node */
+static inline int _starpu_disk_compress_enabled(unsigned node)
+{
+	return _starpu_disk_compress_nodes[node] != NULL;
+}
+
+/** Keep track of the objects allocated on the disk node, to know how they are
+ * stored. The files opened with starpu_disk_open are not tracked, and thus
+ * never compressed, since the application expects to find their content as
+ * is after closing them. */
+void _starpu_disk_compress_new_obj(unsigned node, void *obj, size_t size);
+void _starpu_disk_compress_free_obj(unsigned node, void *obj);
+/** Whether \p obj is a tracked object */
+int _starpu_disk_compress_known_obj(void *obj);
+
+/** Whether the operations on object \p obj of disk node \p node go through
+ * compression */
+static inline int _starpu_disk_compress_obj(unsigned node, void *obj)
+{
+	return _starpu_disk_compress_enabled(node) && _starpu_disk_compress_known_obj(obj);
+}
+
+/** These mimic the corresponding _starpu_disk_* functions. When \p async is
+ * set, the operation may be queued to the compression threads, in which case
+ * the job is returned, to be tested or waited for with the functions below.
+ * Otherwise the operation is performed synchronously and NULL is returned. */
+void *_starpu_disk_compress_read(unsigned node, void *obj, void *buf, off_t offset, size_t size, int async);
+void *_starpu_disk_compress_write(unsigned node, void *obj, void *buf, off_t offset, size_t size, int async);
+void *_starpu_disk_compress_readv(unsigned node, void *obj, uintptr_t dst, const struct _starpu_copy_vec *vec, unsigned nvec, int async);
+void *_starpu_disk_compress_writev(unsigned node, void *obj, uintptr_t src, const struct _starpu_copy_vec *vec, unsigned nvec, int async);
+void *_starpu_disk_compress_full_read(unsigned node, unsigned dst_node, void *obj, void **ptr, size_t *size, int async);
+void *_starpu_disk_compress_full_write(unsigned node, void *obj, void *ptr, size_t size, int async);
+
+int _starpu_disk_compress_test_request(void *job);
+void _starpu_disk_compress_wait_request(void *job);
+void _starpu_disk_compress_free_request(void *job);
+
+#pragma GCC visibility pop
+
+#endif // __DISK_COMPRESS_H__
@@ -77,5 +77,9 @@ struct starpu_disk_ops starpu_disk_unistd_ops =
 	.free_request = starpu_unistd_global_free_request,
 #endif
 	.full_read = starpu_unistd_global_full_read,
-	.full_write = starpu_unistd_global_full_write
+	.full_write = starpu_unistd_global_full_write,
+#ifdef STARPU_UNISTD_USE_VECTORED
+	.readv = starpu_unistd_global_readv,
+	.writev = starpu_unistd_global_writev,
+#endif
 };
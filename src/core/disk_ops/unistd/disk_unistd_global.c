@@ -30,6 +30,9 @@
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
+#ifdef HAVE_SYS_UIO_H
+#  include <sys/uio.h>
+#endif
 #include <starpu.h>
 #include <core/disk.h>
 #include <core/perfmodel/perfmodel.h>
@@ -473,6 +476,70 @@ int starpu_unistd_global_write(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, co
 	return 0;
 }
 
+#ifdef STARPU_UNISTD_USE_VECTORED
+/* read the memory disk into several buffers */
+int starpu_unistd_global_readv(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	struct starpu_unistd_global_obj *tmp = (struct starpu_unistd_global_obj *) obj;
+	int fd = tmp->descriptor;
+	struct iovec *cur, *toread;
+	starpu_ssize_t nb;
+
+	/* We need to modify the iovec on partial reads */
+	_STARPU_MALLOC(cur, iovcnt * sizeof(*cur));
+	memcpy(cur, iov, iovcnt * sizeof(*cur));
+	toread = cur;
+
+	if (fd < 0)
+		fd = _starpu_unistd_reopen(obj);
+
+	while (iovcnt > 0)
+	{
+		nb = preadv(fd, toread, iovcnt, offset);
+		STARPU_ASSERT_MSG(nb > 0, "Starpu Disk unistd preadv failed: offset %lu got errno %d", (unsigned long) offset, errno);
+		offset += nb;
+		_starpu_iovec_advance(&toread, &iovcnt, nb);
+	}
+
+	if (tmp->descriptor < 0)
+		_starpu_unistd_reclose(fd);
+	free(cur);
+
+	return 0;
+}
+
+/* write several buffers on the memory disk */
+int starpu_unistd_global_writev(void *base STARPU_ATTRIBUTE_UNUSED, void *obj, const struct iovec *iov, int iovcnt, off_t offset)
+{
+	struct starpu_unistd_global_obj *tmp = (struct starpu_unistd_global_obj *) obj;
+	int fd = tmp->descriptor;
+	struct iovec *cur, *towrite;
+	starpu_ssize_t res;
+
+	/* We need to modify the iovec on partial writes */
+	_STARPU_MALLOC(cur, iovcnt * sizeof(*cur));
+	memcpy(cur, iov, iovcnt * sizeof(*cur));
+	towrite = cur;
+
+	if (fd < 0)
+		fd = _starpu_unistd_reopen(obj);
+
+	while (iovcnt > 0)
+	{
+		res = pwritev(fd, towrite, iovcnt, offset);
+		STARPU_ASSERT_MSG(res >= 0, "Starpu Disk unistd pwritev failed: offset %lu got errno %d", (unsigned long) offset, errno);
+		offset += res;
+		_starpu_iovec_advance(&towrite, &iovcnt, res);
+	}
+
+	if (tmp->descriptor < 0)
+		_starpu_unistd_reclose(fd);
+	free(cur);
+
+	return 0;
+}
+#endif
+
 #if defined(HAVE_LIBAIO_H)
 void *starpu_unistd_global_async_write(void *base, void *obj, void *buf, off_t offset, size_t size)
 {
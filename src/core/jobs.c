@@ -104,9 +104,9 @@ struct _starpu_job* STARPU_ATTRIBUTE_MALLOC _starpu_job_create(struct starpu_tas
 #if defined(STARPU_DEBUG)
 	    1
 #elif defined(STARPU_USE_FXT)
-	    fut_active
+	    fut_active || _starpu_tracebuf_enabled
 #else
-	    _starpu_bound_recording || _starpu_task_break_on_push != -1 || _starpu_task_break_on_sched != -1 || _starpu_task_break_on_pop != -1 || _starpu_task_break_on_exec != -1 || STARPU_AYU_EVENT
+	    _starpu_bound_recording || _starpu_task_break_on_push != -1 || _starpu_task_break_on_sched != -1 || _starpu_task_break_on_pop != -1 || _starpu_task_break_on_exec != -1 || STARPU_AYU_EVENT || _starpu_tracebuf_enabled
 #endif
 	   )
 	{
@@ -392,7 +392,9 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 			_starpu_set_current_task(task);
 
 			_STARPU_TRACE_START_CALLBACK(j);
+			_STARPU_TRACEBUF_START_CALLBACK(j);
 			epilogue_callback(task->epilogue_callback_arg);
+			_STARPU_TRACEBUF_END_CALLBACK(j);
 			_STARPU_TRACE_END_CALLBACK(j);
 
 			_starpu_set_current_task(current_task);
@@ -570,7 +572,9 @@ void _starpu_handle_job_termination(struct _starpu_job *j)
 			_starpu_set_current_task(task);
 
 			_STARPU_TRACE_START_CALLBACK(j);
+			_STARPU_TRACEBUF_START_CALLBACK(j);
 			callback(task->callback_arg);
+			_STARPU_TRACEBUF_END_CALLBACK(j);
 			_STARPU_TRACE_END_CALLBACK(j);
 
 			_starpu_set_current_task(current_task);
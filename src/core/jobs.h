@@ -205,6 +205,12 @@ struct _starpu_job
 
 	struct _starpu_graph_node *graph_node;
 
+	/** Online critical path analysis, in microseconds: length of the
+	 * longest chain of executed predecessors, and execution time of this
+	 * job. */
+	double cp_start;
+	double cp_duration;
+
 #ifdef STARPU_DEBUG
 	/** Linked-list of all jobs, for debugging */
 	struct _starpu_job_multilist_all_submitted all_submitted;
@@ -0,0 +1,379 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Machine cache: a single file per machine configuration in the bus
+ * performance model directory, which records the hwloc topology (as XML) and
+ * the bus performance figures, so that later initializations can skip the
+ * hwloc discovery and the parsing of the bus files.
+ *
+ * The file is named after a fingerprint of the machine which is cheap to
+ * compute: the StarPU and hwloc versions, the hostname, the boot id, the
+ * online CPUs and NUMA nodes, the CPUs and memory nodes allowed to the
+ * process, and the PCI devices. Whatever changes in these gets another file.
+ * The bus figures are additionally tied to the hash of the topology XML and to
+ * the modification times and sizes of the bus files, so that a recalibration
+ * is noticed.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <common/config.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <dirent.h>
+
+#include <starpu.h>
+#include <common/utils.h>
+#include <core/perfmodel/perfmodel.h>
+
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID)
+#include <hwloc.h>
+#endif
+
+#define MACHINE_CACHE_MAGIC "STARPUMC"
+#define MACHINE_CACHE_VERSION 1
+
+struct machine_cache_header
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t fingerprint;
+	uint32_t xml_len;
+	uint32_t xml_hash;
+	uint32_t bus_size;
+	uint32_t bus_hash;
+	int64_t bus_stamp;
+};
+
+/* -1: not checked yet */
+static int machine_cache_enabled = -1;
+static uint32_t machine_fingerprint;
+
+/* What was found in the cache file */
+static struct machine_cache_header cached_header;
+static char *cached_contents;
+static int cached_loaded;
+
+/* The topology XML to be saved */
+static char *topology_xml;
+static uint32_t topology_xml_len;
+static int topology_xml_from_cache;
+
+static uint32_t hash_file(const char *path, uint32_t crc)
+{
+	char buf[1024];
+	size_t n;
+	FILE *f = fopen(path, "r");
+	if (!f)
+		return crc;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		crc = starpu_hash_crc32c_be_n(buf, n, crc);
+	fclose(f);
+	return crc;
+}
+
+static uint32_t hash_status_line(const char *field, uint32_t crc)
+{
+	char line[4096];
+	size_t len = strlen(field);
+	FILE *f = fopen("/proc/self/status", "r");
+	if (!f)
+		return crc;
+	while (fgets(line, sizeof(line), f))
+		if (!strncmp(line, field, len))
+		{
+			crc = starpu_hash_crc32c_string(line, crc);
+			break;
+		}
+	fclose(f);
+	return crc;
+}
+
+static uint32_t hash_dir_entries(const char *path, uint32_t crc)
+{
+	/* Combine the entry hashes independently from their order */
+	uint32_t combined = 0, n = 0;
+	struct dirent *entry;
+	DIR *dir = opendir(path);
+	if (!dir)
+		return crc;
+	while ((entry = readdir(dir)))
+	{
+		combined ^= starpu_hash_crc32c_string(entry->d_name, 0);
+		n++;
+	}
+	closedir(dir);
+	crc = starpu_hash_crc32c_be(combined, crc);
+	return starpu_hash_crc32c_be(n, crc);
+}
+
+static uint32_t compute_fingerprint(void)
+{
+	char hostname[65];
+	uint32_t crc;
+
+	crc = starpu_hash_crc32c_string(PACKAGE_VERSION, MACHINE_CACHE_VERSION);
+	crc = starpu_hash_crc32c_be(STARPU_MAXNODES, crc);
+	crc = starpu_hash_crc32c_be(STARPU_MAXNUMANODES, crc);
+	crc = starpu_hash_crc32c_be(STARPU_NMAXDEVS, crc);
+#ifdef STARPU_USE_CUDA
+	crc = starpu_hash_crc32c_string("cuda", crc);
+#endif
+#ifdef STARPU_USE_HIP
+	crc = starpu_hash_crc32c_string("hip", crc);
+#endif
+#ifdef STARPU_USE_OPENCL
+	crc = starpu_hash_crc32c_string("opencl", crc);
+#endif
+#ifdef STARPU_USE_MAX_FPGA
+	crc = starpu_hash_crc32c_string("max_fpga", crc);
+#endif
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID)
+	crc = starpu_hash_crc32c_be(HWLOC_API_VERSION, crc);
+	crc = starpu_hash_crc32c_be(hwloc_get_api_version(), crc);
+#endif
+
+	_starpu_gethostname(hostname, sizeof(hostname));
+	crc = starpu_hash_crc32c_string(hostname, crc);
+
+#ifdef __linux__
+	crc = hash_file("/proc/sys/kernel/random/boot_id", crc);
+	crc = hash_file("/sys/devices/system/cpu/online", crc);
+	crc = hash_file("/sys/devices/system/node/online", crc);
+	crc = hash_status_line("Cpus_allowed:", crc);
+	crc = hash_status_line("Mems_allowed:", crc);
+	crc = hash_dir_entries("/sys/bus/pci/devices", crc);
+#elif defined(HAVE_SYSCONF)
+	crc = starpu_hash_crc32c_be(sysconf(_SC_NPROCESSORS_CONF), crc);
+#endif
+
+	return crc;
+}
+
+static int get_machine_cache_path(char *path, size_t maxlen)
+{
+	char hostname[65];
+	char *bus;
+
+	if (_starpu_get_perf_model_bus() < 0)
+		return 0;
+	bus = _starpu_get_perf_model_dir_bus();
+	if (!bus)
+		return 0;
+	_starpu_gethostname(hostname, sizeof(hostname));
+	snprintf(path, maxlen, "%s%s.machine.%08x", bus, hostname, machine_fingerprint);
+	return 1;
+}
+
+static int machine_cache_is_enabled(void)
+{
+	if (machine_cache_enabled == -1)
+	{
+		char *hwloc_input = starpu_getenv("STARPU_HWLOC_INPUT");
+		machine_cache_enabled = starpu_getenv_number_default("STARPU_MACHINE_CACHE", 1)
+			&& !(hwloc_input && hwloc_input[0])
+			/* hwloc itself was told to load another topology */
+			&& !starpu_getenv("HWLOC_XMLFILE")
+			&& !starpu_getenv("HWLOC_SYNTHETIC")
+			&& !starpu_getenv("HWLOC_FSROOT");
+		if (machine_cache_enabled)
+			machine_fingerprint = compute_fingerprint();
+	}
+	return machine_cache_enabled;
+}
+
+/* Load the cache file, if any, once */
+static void load_machine_cache(void)
+{
+	char path[PATH_LENGTH];
+	struct machine_cache_header header;
+	size_t size;
+	char *contents;
+	FILE *f;
+
+	if (cached_loaded)
+		return;
+	cached_loaded = 1;
+
+	if (!get_machine_cache_path(path, sizeof(path)))
+		return;
+
+	f = fopen(path, "r");
+	if (!f)
+		return;
+
+	if (fread(&header, sizeof(header), 1, f) != 1
+		|| memcmp(header.magic, MACHINE_CACHE_MAGIC, sizeof(header.magic))
+		|| header.version != MACHINE_CACHE_VERSION
+		|| header.fingerprint != machine_fingerprint)
+	{
+		_STARPU_DEBUG("machine cache %s is invalid, ignoring it\n", path);
+		fclose(f);
+		return;
+	}
+
+	size = (size_t) header.xml_len + header.bus_size;
+	_STARPU_MALLOC(contents, size + 1);
+	if (fread(contents, 1, size, f) != size
+		|| (header.xml_len && starpu_hash_crc32c_be_n(contents, header.xml_len, 0) != header.xml_hash)
+		|| (header.bus_size && starpu_hash_crc32c_be_n(contents + header.xml_len, header.bus_size, 0) != header.bus_hash))
+	{
+		_STARPU_DEBUG("machine cache %s is truncated or corrupted, ignoring it\n", path);
+		free(contents);
+		fclose(f);
+		return;
+	}
+	fclose(f);
+
+	contents[size] = 0;
+	cached_header = header;
+	cached_contents = contents;
+	_STARPU_DEBUG("loaded machine cache %s\n", path);
+}
+
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID)
+int _starpu_machine_cache_set_topology(hwloc_topology_t topology)
+{
+#if HWLOC_API_VERSION >= 0x20000
+	if (!machine_cache_is_enabled())
+		return 0;
+
+	load_machine_cache();
+	if (!cached_contents || !cached_header.xml_len)
+		return 0;
+
+	if (hwloc_topology_set_xmlbuffer(topology, cached_contents, cached_header.xml_len) < 0)
+		return 0;
+
+	topology_xml = cached_contents;
+	topology_xml_len = cached_header.xml_len;
+	topology_xml_from_cache = 1;
+	return 1;
+#else
+	(void) topology;
+	return 0;
+#endif
+}
+
+void _starpu_machine_cache_topology_loaded(hwloc_topology_t topology)
+{
+#if HWLOC_API_VERSION >= 0x20000
+	char *xml;
+	int len;
+
+	if (!machine_cache_is_enabled() || topology_xml_from_cache)
+		return;
+
+	/* Remember it for _starpu_machine_cache_save */
+	if (hwloc_topology_export_xmlbuffer(topology, &xml, &len, 0) < 0)
+		return;
+	free(topology_xml);
+	_STARPU_MALLOC(topology_xml, len);
+	memcpy(topology_xml, xml, len);
+	topology_xml_len = len;
+	hwloc_free_xmlbuffer(topology, xml);
+#else
+	(void) topology;
+#endif
+}
+#endif
+
+int _starpu_machine_cache_get_bus(void *bus, size_t size, int64_t bus_stamp)
+{
+	if (!machine_cache_is_enabled())
+		return 0;
+
+	load_machine_cache();
+	if (!cached_contents
+		/* The topology has to be the one the bus was measured with */
+		|| !topology_xml_from_cache
+		|| cached_header.bus_size != size
+		|| cached_header.bus_stamp != bus_stamp)
+		return 0;
+
+	memcpy(bus, cached_contents + cached_header.xml_len, size);
+	return 1;
+}
+
+void _starpu_machine_cache_save(const void *bus, size_t size, int64_t bus_stamp)
+{
+	char path[PATH_LENGTH];
+	char tmp[PATH_LENGTH+16];
+	struct machine_cache_header header;
+	FILE *f;
+
+	if (!machine_cache_is_enabled() || !topology_xml)
+		return;
+
+	if (topology_xml_from_cache && cached_header.bus_size == size && cached_header.bus_stamp == bus_stamp
+		&& starpu_hash_crc32c_be_n(bus, size, 0) == cached_header.bus_hash)
+		/* Already up to date */
+		return;
+
+	if (!get_machine_cache_path(path, sizeof(path)))
+		return;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, MACHINE_CACHE_MAGIC, sizeof(header.magic));
+	header.version = MACHINE_CACHE_VERSION;
+	header.fingerprint = machine_fingerprint;
+	header.xml_len = topology_xml_len;
+	header.xml_hash = starpu_hash_crc32c_be_n(topology_xml, topology_xml_len, 0);
+	header.bus_size = size;
+	header.bus_hash = starpu_hash_crc32c_be_n(bus, size, 0);
+	header.bus_stamp = bus_stamp;
+
+	/* Write to a temporary file and rename it, so that concurrent
+	 * initializations never see a partial file */
+	snprintf(tmp, sizeof(tmp), "%s.%d", path, (int) getpid());
+	f = fopen(tmp, "w");
+	if (!f)
+	{
+		_STARPU_DEBUG("could not write machine cache %s: %s\n", tmp, strerror(errno));
+		return;
+	}
+	if (fwrite(&header, sizeof(header), 1, f) != 1
+		|| fwrite(topology_xml, 1, topology_xml_len, f) != topology_xml_len
+		|| fwrite(bus, 1, size, f) != size)
+	{
+		fclose(f);
+		unlink(tmp);
+		return;
+	}
+	if (fclose(f) || rename(tmp, path))
+	{
+		unlink(tmp);
+		return;
+	}
+	_STARPU_DEBUG("saved machine cache %s\n", path);
+}
+
+void _starpu_machine_cache_deinit(void)
+{
+	if (!topology_xml_from_cache)
+		free(topology_xml);
+	topology_xml = NULL;
+	topology_xml_len = 0;
+	topology_xml_from_cache = 0;
+	free(cached_contents);
+	cached_contents = NULL;
+	cached_loaded = 0;
+	machine_cache_enabled = -1;
+}
@@ -29,6 +29,7 @@
 #include <core/jobs.h>
 #include <core/workers.h>
 #include <datawizard/datawizard.h>
+#include <profiling/profiling.h>
 #include <core/task.h>
 #include <float.h>
 #include <dirent.h>
@@ -38,10 +39,12 @@
 #endif
 
 static int _starpu_expected_transfer_time_writeback;
+static int _starpu_expected_transfer_time_queue;
 
 void _starpu_init_perfmodel(void)
 {
 	_starpu_expected_transfer_time_writeback = starpu_getenv_number_default("STARPU_EXPECTED_TRANSFER_TIME_WRITEBACK", 0);
+	_starpu_expected_transfer_time_queue = starpu_getenv_number_default("STARPU_EXPECTED_TRANSFER_TIME_QUEUE", 0);
 }
 
 /* This flag indicates whether performance models should be calibrated or not.
@@ -418,7 +421,19 @@ static double _starpu_data_expected_transfer_time(starpu_data_handle_t handle, u
 	int i;
 
 	for (i = 0; i < nhops; i++)
-		duration += starpu_transfer_predict(src_nodes[i], dst_nodes[i], size);
+	{
+		size_t hop_size = size;
+		if (_starpu_expected_transfer_time_queue)
+		{
+			/* The transfer will have to wait for those already
+			 * queued on the link */
+			if (handle->per_node[dst_nodes[i]].queued_request)
+				/* It is already queued itself */
+				hop_size = 0;
+			hop_size += _starpu_bus_get_queued_bytes(src_nodes[i], dst_nodes[i]);
+		}
+		duration += starpu_transfer_predict(src_nodes[i], dst_nodes[i], hop_size);
+	}
 
 	return duration;
 }
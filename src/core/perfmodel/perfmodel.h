@@ -111,6 +111,10 @@ unsigned *_starpu_get_opencl_affinity_vector(unsigned gpuid);
 #endif
 
 void _starpu_save_bandwidth_and_latency_disk(double bandwidth_write, double bandwidth_read, double latency_write, double latency_read, unsigned node, const char *name);
+/** Update the bandwidth between disk node \p node and the other nodes with
+ * newly measured bandwidths between the disk and main memory. A zero
+ * bandwidth leaves that direction unchanged. */
+void _starpu_update_bandwidth_disk(double bandwidth_write, double bandwidth_read, unsigned node);
 
 void _starpu_write_double(FILE *f, const char *format, double val) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 int _starpu_read_double(FILE *f, char *format, double *val) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
@@ -124,6 +128,23 @@ void _starpu_free_arch_combs(void);
 hwloc_topology_t _starpu_perfmodel_get_hwtopology();
 #endif
 
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID)
+/** Make \p topology load the topology recorded in the machine cache, if it is
+ * valid for this machine. Returns 1 if it was set, 0 otherwise. */
+int _starpu_machine_cache_set_topology(hwloc_topology_t topology);
+/** Record the topology which was just loaded, to be saved in the machine
+ * cache along the bus figures */
+void _starpu_machine_cache_topology_loaded(hwloc_topology_t topology);
+#endif
+/** Copy the \p size bytes of bus figures recorded in the machine cache into
+ * \p bus, if they were measured with the cached topology and if the bus files
+ * still have the \p bus_stamp modification stamp. Returns 1 on success, 0
+ * otherwise. */
+int _starpu_machine_cache_get_bus(void *bus, size_t size, int64_t bus_stamp);
+/** Save the topology and the bus figures into the machine cache */
+void _starpu_machine_cache_save(const void *bus, size_t size, int64_t bus_stamp);
+void _starpu_machine_cache_deinit(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -23,6 +23,7 @@
 #endif
 #include <stdlib.h>
 #include <math.h>
+#include <sys/stat.h>
 
 #include <starpu.h>
 #include <starpu_cuda.h>
@@ -3095,6 +3096,107 @@ static void check_bus_platform_file(void)
  *	Generic
  */
 
+/*
+ *	Machine cache
+ */
+
+/* The bus figures recorded in the machine cache */
+struct bus_cache
+{
+	unsigned ncpus;
+	unsigned nmem[STARPU_NRAM];
+	double bandwidth_matrix[STARPU_MAXNODES][STARPU_MAXNODES];
+	double latency_matrix[STARPU_MAXNODES][STARPU_MAXNODES];
+	unsigned affinity_matrix[STARPU_NRAM][STARPU_NMAXDEVS][STARPU_MAXNUMANODES];
+};
+
+/* Combine the modification times and sizes of the bus files, to notice when
+ * they get recalibrated */
+static int64_t get_bus_files_stamp(void)
+{
+	static const char *types[] = { "config", "affinity", "latency", "bandwidth" };
+	char path[PATH_LENGTH];
+	struct stat st;
+	int64_t stamp = 0;
+	unsigned i;
+
+	for (i = 0; i < sizeof(types)/sizeof(types[0]); i++)
+	{
+		get_bus_path(types[i], path, sizeof(path));
+		if (stat(path, &st))
+			return -1;
+		stamp = stamp * 31 + st.st_mtime;
+		stamp = stamp * 31 + st.st_size;
+	}
+	return stamp;
+}
+
+static int bus_cache_usable(void)
+{
+	struct _starpu_machine_config *config = _starpu_get_machine_config();
+
+	if (_starpu_get_perf_model_bus() < 0 || config->conf.bus_calibrate > 0)
+		return 0;
+#ifdef STARPU_USE_MPI_MASTER_SLAVE
+	/* The master and slaves have to agree on recalibration */
+	if (_starpu_config.conf.nmpi_ms != 0)
+		return 0;
+#endif
+	return 1;
+}
+
+/* Take the bus figures from the machine cache, if it is valid. This replaces
+ * check_bus_config_file and loading the bus files. */
+static int load_bus_cache(void)
+{
+	struct bus_cache *cache;
+	int64_t stamp;
+	int ret = 0;
+
+	if (!bus_cache_usable())
+		return 0;
+
+	stamp = get_bus_files_stamp();
+	if (stamp == -1)
+		return 0;
+
+	_STARPU_MALLOC(cache, sizeof(*cache));
+	if (_starpu_machine_cache_get_bus(cache, sizeof(*cache), stamp)
+		&& cache->ncpus == ncpus
+		&& !memcmp(cache->nmem, nmem, sizeof(nmem)))
+	{
+		memcpy(bandwidth_matrix, cache->bandwidth_matrix, sizeof(bandwidth_matrix));
+		memcpy(latency_matrix, cache->latency_matrix, sizeof(latency_matrix));
+		memcpy(affinity_matrix, cache->affinity_matrix, sizeof(affinity_matrix));
+		_STARPU_DEBUG("bus performance taken from the machine cache\n");
+		ret = 1;
+	}
+	free(cache);
+	return ret;
+}
+
+static void save_bus_cache(void)
+{
+	struct bus_cache *cache;
+	int64_t stamp;
+
+	if (!bus_cache_usable())
+		return;
+
+	stamp = get_bus_files_stamp();
+	if (stamp == -1)
+		return;
+
+	_STARPU_CALLOC(cache, 1, sizeof(*cache));
+	cache->ncpus = ncpus;
+	memcpy(cache->nmem, nmem, sizeof(nmem));
+	memcpy(cache->bandwidth_matrix, bandwidth_matrix, sizeof(bandwidth_matrix));
+	memcpy(cache->latency_matrix, latency_matrix, sizeof(latency_matrix));
+	memcpy(cache->affinity_matrix, affinity_matrix, sizeof(affinity_matrix));
+	_starpu_machine_cache_save(cache, sizeof(*cache), stamp);
+	free(cache);
+}
+
 static void _starpu_bus_force_sampling(int location)
 {
 	_STARPU_DEBUG("Force bus sampling ...\n");
@@ -3137,6 +3239,9 @@ void _starpu_load_bus_performance_files(void)
 #endif
 
 #ifndef STARPU_SIMGRID
+	if (load_bus_cache())
+		return;
+
 	check_bus_config_file();
 #endif
 
@@ -3153,6 +3258,7 @@ void _starpu_load_bus_performance_files(void)
 	load_bus_bandwidth_file();
 #ifndef STARPU_SIMGRID
 	check_bus_platform_file();
+	save_bus_cache();
 #endif
 }
 
@@ -3302,3 +3408,36 @@ void _starpu_save_bandwidth_and_latency_disk(double bandwidth_write, double band
 	if (print_stats)
 		fprintf(stderr, "\n#---------------------\n");
 }
+
+void _starpu_update_bandwidth_disk(double bandwidth_write, double bandwidth_read, unsigned node)
+{
+	unsigned i;
+
+	for (i = 0; i < STARPU_MAXNODES; i++)
+	{
+		double slowness_main_ram_between_node;
+
+		if (i == node)
+			continue;
+
+		/* source == disk */
+		if (bandwidth_read != 0 && !isnan(bandwidth_matrix[node][i]))
+		{
+			if (bandwidth_matrix[STARPU_MAIN_RAM][i] != 0)
+				slowness_main_ram_between_node = 1/bandwidth_matrix[STARPU_MAIN_RAM][i];
+			else
+				slowness_main_ram_between_node = 0;
+			bandwidth_matrix[node][i] = 1/(1/bandwidth_read+slowness_main_ram_between_node);
+		}
+
+		/* destination == disk */
+		if (bandwidth_write != 0 && !isnan(bandwidth_matrix[i][node]))
+		{
+			if (bandwidth_matrix[i][STARPU_MAIN_RAM] != 0)
+				slowness_main_ram_between_node = 1/bandwidth_matrix[i][STARPU_MAIN_RAM];
+			else
+				slowness_main_ram_between_node = 0;
+			bandwidth_matrix[i][node] = 1/(1/bandwidth_write+slowness_main_ram_between_node);
+		}
+	}
+}
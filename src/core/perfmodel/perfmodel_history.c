@@ -34,6 +34,7 @@
 #include <core/perfmodel/multiple_regression.h>
 #include <common/config.h>
 #include <common/uthash.h>
+#include <common/knobs.h>
 #include <limits.h>
 #include <core/task.h>
 
@@ -51,6 +52,73 @@ static starpu_pthread_rwlock_t arch_combs_mutex = STARPU_PTHREAD_RWLOCK_INITIALI
 static int historymaxerror;
 static char ignore_devid[STARPU_NARCH];
 
+/* Default window of adaptive history entries, 0 means not adaptive */
+static unsigned adaptive_window;
+/* CUSUM threshold, in deviations, beyond which we consider that the execution
+ * time has changed */
+static double drift_threshold;
+/* CUSUM slack, in deviations, i.e. half the smallest shift we want to detect */
+#define DRIFT_SLACK 0.5
+/* Minimum deviation, relative to the mean, considered by drift detection, to
+ * avoid detecting noise on very regular kernels */
+#define DRIFT_MIN_DEVIATION 0.05
+
+static int64_t drift_events;
+
+/* Default for starpu_perfmodel::size_fallback */
+static unsigned size_fallback;
+/* Only use the size fallback within this factor of the sizes it was fitted on */
+#define SIZE_FALLBACK_EXTRAPOLATION 2
+
+static int64_t size_fallback_predictions;
+static int64_t size_fallback_nchecks;
+static double size_fallback_cumul_error;
+
+/* global counters */
+static int __g_drift_events;
+static int __g_size_fallback_predictions;
+static int __g_size_fallback_error;
+
+/* per-codelet counters */
+static int __c_drift_events;
+
+static void global_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context == NULL); /* no context for the global updater */
+	(void)context;
+
+	_starpu_perf_counter_sample_set_int64_value(sample, __g_drift_events, drift_events);
+	_starpu_perf_counter_sample_set_int64_value(sample, __g_size_fallback_predictions, size_fallback_predictions);
+	_starpu_perf_counter_sample_set_double_value(sample, __g_size_fallback_error, size_fallback_nchecks ? 100. * size_fallback_cumul_error / size_fallback_nchecks : 0.);
+}
+
+static void per_codelet_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context != NULL);
+	struct starpu_codelet *cl = context;
+
+	_starpu_perf_counter_sample_set_int64_value(sample, __c_drift_events, cl->perf_counter_values->perfmodel.drift_events);
+}
+
+void _starpu__perfmodel_history_c__register_counters(void)
+{
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+		__STARPU_PERF_COUNTER_REG("starpu.perfmodel", scope, g_drift_events, int64, "number of execution time changes detected by adaptive performance models, globally (since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.perfmodel", scope, g_size_fallback_predictions, int64, "number of predictions made by history-based performance models from the size regression, for footprints without history (since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.perfmodel", scope, g_size_fallback_error, double, "average relative error of the size regression predictions, checked when the corresponding history entries get calibrated (percent, since StarPU initialization)");
+
+		_starpu_perf_counter_register_updater(scope, global_sample_updater);
+	}
+
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_per_codelet;
+		__STARPU_PERF_COUNTER_REG("starpu.perfmodel", scope, c_drift_events, int64, "number of execution time changes detected by the adaptive performance model of this codelet (since enabled)");
+
+		_starpu_perf_counter_register_updater(scope, per_codelet_sample_updater);
+	}
+}
+
 /* How many executions a codelet will have to be measured before we
  * consider that calibration will provide a value good enough for scheduling */
 unsigned _starpu_calibration_minimum;
@@ -120,6 +188,9 @@ void _starpu_initialize_registered_performance_models(void)
 	_STARPU_MALLOC(arch_combs, nb_arch_combs*sizeof(struct starpu_perfmodel_arch*));
 	current_arch_comb = 0;
 	historymaxerror = starpu_getenv_number_default("STARPU_HISTORY_MAX_ERROR", STARPU_HISTORYMAXERROR);
+	adaptive_window = starpu_getenv_number_default("STARPU_PERFMODEL_ADAPTIVE_WINDOW", 0);
+	drift_threshold = starpu_getenv_float_default("STARPU_PERFMODEL_DRIFT_THRESHOLD", 8.);
+	size_fallback = starpu_getenv_number_default("STARPU_HISTORY_SIZE_FALLBACK", 0);
 	_starpu_calibration_minimum = starpu_getenv_number_default("STARPU_CALIBRATE_MINIMUM", 10);
 
 	for (archtype = 0; archtype < STARPU_NARCH; archtype++)
@@ -666,6 +737,8 @@ static void parse_per_arch_model_file(FILE *f, const char *path, struct starpu_p
 		if (scan_history)
 			insert_history_entry(entry, &per_arch_model->list, &per_arch_model->history);
 	}
+	if (scan_history && nentries)
+		per_arch_model->fallback_dirty = 1;
 
 	if (model && model->type == STARPU_PERFMODEL_INVALID)
 	{
@@ -1747,6 +1820,109 @@ docal:
 	return expected_duration;
 }
 
+static unsigned history_size_fallback(struct starpu_perfmodel *model)
+{
+	return model->type == STARPU_HISTORY_BASED && (model->size_fallback || size_fallback);
+}
+
+/* Fit the size regression over the history entries, to be called with the
+ * model write-locked */
+static void fit_size_fallback(struct starpu_perfmodel_per_arch *per_arch_model)
+{
+	struct starpu_perfmodel_history_list *ptr;
+	unsigned ncalibrated = 0;
+	size_t minx = 0, maxx = 0;
+	double a, b, c, err;
+
+	per_arch_model->fallback_valid = 0;
+
+	for (ptr = per_arch_model->list; ptr; ptr = ptr->next)
+	{
+		struct starpu_perfmodel_history_entry *entry = ptr->entry;
+		if (entry->nsample < _starpu_calibration_minimum)
+			continue;
+		ncalibrated++;
+		if (minx == 0 || entry->size < minx)
+			minx = entry->size;
+		if (entry->size > maxx)
+			maxx = entry->size;
+	}
+
+	/* We need a few points with enough size variance to trust a regression */
+	if (ncalibrated < 3 || minx >= (9*maxx)/10)
+		return;
+
+	if (_starpu_regression_non_linear_power_relative(per_arch_model->list, _starpu_calibration_minimum, &a, &b, &c, &err) != 0
+		|| isnan(a) || isnan(c) || isinf(a) || isinf(c))
+		return;
+
+	per_arch_model->fallback_a = a;
+	per_arch_model->fallback_b = b;
+	per_arch_model->fallback_c = c;
+	per_arch_model->fallback_minx = minx;
+	per_arch_model->fallback_maxx = maxx;
+	per_arch_model->fallback_fit_error = err;
+	per_arch_model->fallback_valid = 1;
+}
+
+static double predict_size_fallback(struct starpu_perfmodel_per_arch *per_arch_model, size_t size)
+{
+	if (!per_arch_model->fallback_valid
+		|| size * SIZE_FALLBACK_EXTRAPOLATION < per_arch_model->fallback_minx
+		|| size > per_arch_model->fallback_maxx * SIZE_FALLBACK_EXTRAPOLATION)
+		return NAN;
+
+	double exp = per_arch_model->fallback_a * pow((double) size, per_arch_model->fallback_b) + per_arch_model->fallback_c;
+	return exp < 0. ? NAN : exp;
+}
+
+/* Predict from the size regression a footprint which has no calibrated entry */
+static double history_based_size_fallback(struct starpu_perfmodel *model, struct starpu_perfmodel_per_arch *per_arch_model, size_t size)
+{
+	double exp;
+
+	STARPU_HG_DISABLE_CHECKING(per_arch_model->fallback_dirty);
+	if (per_arch_model->fallback_dirty)
+	{
+		STARPU_PTHREAD_RWLOCK_WRLOCK(&model->state->model_rwlock);
+		if (per_arch_model->fallback_dirty)
+		{
+			fit_size_fallback(per_arch_model);
+			per_arch_model->fallback_dirty = 0;
+		}
+		STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
+	}
+
+	STARPU_PTHREAD_RWLOCK_RDLOCK(&model->state->model_rwlock);
+	exp = predict_size_fallback(per_arch_model, size);
+	STARPU_PTHREAD_RWLOCK_UNLOCK(&model->state->model_rwlock);
+
+	if (!isnan(exp))
+		(void) STARPU_ATOMIC_ADD64(&size_fallback_predictions, 1);
+	return exp;
+}
+
+/* An entry just got calibrated, check what the size regression would have
+ * predicted for it, and get the regression refitted with it */
+static void check_size_fallback(struct starpu_perfmodel *model STARPU_ATTRIBUTE_UNUSED, struct starpu_perfmodel_per_arch *per_arch_model, struct starpu_perfmodel_history_entry *entry)
+{
+	double predicted = predict_size_fallback(per_arch_model, entry->size);
+
+	if (!isnan(predicted) && entry->mean > 0.)
+	{
+		double error = fabs(predicted - entry->mean) / entry->mean;
+		_STARPU_DEBUG("Size regression of model %s predicted %fus for size %lu, measured %fus (%+f%%)\n", model->symbol, predicted, (unsigned long) entry->size, entry->mean, 100. * (predicted - entry->mean) / entry->mean);
+
+		per_arch_model->fallback_nchecks++;
+		per_arch_model->fallback_cumul_error += error;
+		(void) STARPU_ATOMIC_ADD64(&size_fallback_nchecks, 1);
+		_starpu_perf_counter_update_acc_double(&size_fallback_cumul_error, error);
+		if (!_starpu_perf_counter_paused())
+			_starpu_perf_counter_update_global_sample();
+	}
+	per_arch_model->fallback_dirty = 1;
+}
+
 double _starpu_history_based_job_expected_perf(struct starpu_perfmodel *model, struct starpu_perfmodel_arch* arch, struct _starpu_job *j,unsigned nimpl)
 {
 	int comb;
@@ -1804,6 +1980,11 @@ double _starpu_history_based_job_expected_perf(struct starpu_perfmodel *model, s
 		}
 	}
 
+	if (isnan(exp) && j->task && history_size_fallback(model))
+		/* The entry will still get calibrated when calibration is
+		 * enabled */
+		exp = history_based_size_fallback(model, per_arch_model, _starpu_job_get_data_size(model, arch, nimpl, j));
+
 docal:
 #ifdef STARPU_SIMGRID
 	if (isnan(exp))
@@ -1849,6 +2030,75 @@ int _starpu_perfmodel_create_comb_if_needed(struct starpu_perfmodel_arch* arch)
 	return comb;
 }
 
+/* Update an adaptive history entry: the first window samples are accumulated
+ * as usual, then the mean and deviation are exponentially-weighted. A
+ * two-sided CUSUM on the normalized error detects changes of the execution
+ * time, in which case the entry is restarted from the new measurement, and
+ * will thus get recalibrated. */
+static void update_adaptive_history_entry(struct starpu_perfmodel *model STARPU_ATTRIBUTE_UNUSED, struct starpu_perfmodel_arch *arch STARPU_ATTRIBUTE_UNUSED, unsigned impl STARPU_ATTRIBUTE_UNUSED, struct _starpu_job *j, struct starpu_perfmodel_history_entry *entry, double measured, unsigned number, unsigned window)
+{
+	if (entry->nsample >= 2)
+	{
+		double deviation = STARPU_MAX(entry->deviation, entry->mean * DRIFT_MIN_DEVIATION);
+		double z = deviation > 0. ? (measured - entry->mean) / deviation : 0.;
+
+		entry->cusum_high = STARPU_MAX(0., entry->cusum_high + z - DRIFT_SLACK);
+		entry->cusum_low = STARPU_MAX(0., entry->cusum_low - z - DRIFT_SLACK);
+
+		if (entry->cusum_high > drift_threshold || entry->cusum_low > drift_threshold)
+		{
+#ifdef STARPU_VERBOSE
+			char archname[STR_SHORT_LENGTH];
+			starpu_perfmodel_get_arch_name(arch, archname, sizeof(archname), impl);
+			_STARPU_DEBUG("Execution time of model %s on %s for footprint %08x changed: %fus vs average %fus, recalibrating\n", model->symbol, archname, entry->footprint, measured, entry->mean);
+#endif
+
+			(void) STARPU_ATOMIC_ADD64(&drift_events, 1);
+			struct starpu_codelet *cl = j->task->cl;
+			if (cl && cl->perf_counter_values)
+			{
+				(void) STARPU_ATOMIC_ADD64(&cl->perf_counter_values->perfmodel.drift_events, 1);
+				if (!_starpu_perf_counter_paused())
+					_starpu_perf_counter_update_per_codelet_sample(cl);
+			}
+			if (!_starpu_perf_counter_paused())
+				_starpu_perf_counter_update_global_sample();
+
+			/* Restart from this measurement */
+			entry->sum = 0.0;
+			entry->sum2 = 0.0;
+			entry->nsample = 0;
+			entry->nerror = 0;
+			entry->mean = 0.0;
+			entry->deviation = 0.0;
+			entry->cusum_high = 0.0;
+			entry->cusum_low = 0.0;
+		}
+	}
+
+	entry->sum += measured * number;
+	entry->sum2 += measured*measured * number;
+	entry->nsample += number;
+
+	unsigned n = entry->nsample;
+	if (n <= window)
+	{
+		entry->mean = entry->sum / n;
+		entry->deviation = sqrt((fabs(entry->sum2 - (entry->sum*entry->sum)/n))/n);
+	}
+	else
+	{
+		/* Same center of mass as a window of the last window samples */
+		double alpha = 1. - pow(1. - 2. / (window + 1), number);
+		double diff = measured - entry->mean;
+		double variance = entry->deviation * entry->deviation;
+
+		entry->mean += alpha * diff;
+		variance = (1. - alpha) * (variance + alpha * diff * diff);
+		entry->deviation = sqrt(variance);
+	}
+}
+
 void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfmodel *model, struct starpu_perfmodel_arch* arch, unsigned cpuid STARPU_ATTRIBUTE_UNUSED, double measured, unsigned impl, unsigned number)
 {
 	STARPU_ASSERT_MSG(measured >= 0, "measured=%lf\n", measured);
@@ -1901,6 +2151,7 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 			struct starpu_perfmodel_history_table *elt;
 			struct starpu_perfmodel_history_list **list;
 			uint32_t key = _starpu_compute_buffers_footprint(model, arch, impl, j);
+			unsigned window = model->adaptive_window ? model->adaptive_window : adaptive_window;
 
 			list = &per_arch_model->list;
 
@@ -1940,8 +2191,11 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 				/* There is already an entry with the same footprint */
 
 				double local_deviation = measured/entry->mean;
+				unsigned old_nsample = entry->nsample;
 
-				if (entry->nsample &&
+				if (window)
+					update_adaptive_history_entry(model, arch, impl, j, entry, measured, number, window);
+				else if (entry->nsample &&
 					(100 * local_deviation > (100 + historymaxerror)
 					 || (100 / local_deviation > (100 + historymaxerror))))
 				{
@@ -1972,6 +2226,9 @@ void _starpu_update_perfmodel_history(struct _starpu_job *j, struct starpu_perfm
 					entry->deviation = sqrt((fabs(entry->sum2 - (entry->sum*entry->sum)/n))/n);
 				}
 
+				if (history_size_fallback(model) && old_nsample < _starpu_calibration_minimum && entry->nsample >= _starpu_calibration_minimum)
+					check_size_fallback(model, per_arch_model, entry);
+
 				if (j->task->flops != 0. && !isnan(entry->flops))
 				{
 					if (entry->flops == 0.)
@@ -109,6 +109,17 @@ void starpu_perfmodel_print(struct starpu_perfmodel *model, struct starpu_perfmo
 			//fprintf(output, "\tNon-Linear model is INVALID\n");
 		}
 
+		if (arch_model->fallback_valid)
+		{
+			fprintf(output, "\tSize fallback: y = a size ^b + c\n");
+			fprintf(output, "\t\ta = %e\n", arch_model->fallback_a);
+			fprintf(output, "\t\tb = %e\n", arch_model->fallback_b);
+			fprintf(output, "\t\tc = %e\n", arch_model->fallback_c);
+			fprintf(output, "\t\tfit error = %.2f%%\n", 100. * arch_model->fallback_fit_error);
+			if (arch_model->fallback_nchecks)
+				fprintf(output, "\t\taverage prediction error = %.2f%% over %u entries\n", 100. * arch_model->fallback_cumul_error / arch_model->fallback_nchecks, arch_model->fallback_nchecks);
+		}
+
 		_starpu_perfmodel_print_history_based(arch_model, parameter, footprint, output);
 
 #if 0
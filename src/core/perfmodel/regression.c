@@ -303,3 +303,101 @@ int _starpu_regression_non_linear_power(struct starpu_perfmodel_history_list *pt
 
 	return 0;
 }
+
+/* Range and step of the exponent search */
+#define REL_BMIN 0.1
+#define REL_BMAX 4.0
+#define REL_BSTEP 0.01
+
+/* y = ax^b + c, minimizing the relative error sum ((ax^b + c - y) / y)^2
+ *
+ * For a given b, this is a linear least squares problem in a and c, so we only
+ * have to search for b. This is more robust than the correlation-based fit
+ * above when c is small compared to the measurements, and provides the
+ * residual error, to know whether the model can be trusted.
+ *
+ * 	return 0 if success, -1 otherwise
+ * 	if success, a, b, c and err (root mean square of the relative error) are
+ * 	modified
+ */
+int _starpu_regression_non_linear_power_relative(struct starpu_perfmodel_history_list *ptr, unsigned min_nsample, double *a, double *b, double *c, double *err)
+{
+	struct starpu_perfmodel_history_list *p;
+	unsigned n = 0, i;
+	double maxx = 0.;
+
+	for (p = ptr; p; p = p->next)
+		if (p->entry->nsample >= min_nsample && p->entry->nsample && p->entry->mean > 0.)
+		{
+			n++;
+			if (p->entry->size > maxx)
+				maxx = p->entry->size;
+		}
+	if (n < 3 || maxx == 0.)
+		return -1;
+
+	double *x, *y;
+	_STARPU_MALLOC(x, n*sizeof(double));
+	_STARPU_MALLOC(y, n*sizeof(double));
+
+	i = 0;
+	for (p = ptr; p; p = p->next)
+		if (p->entry->nsample >= min_nsample && p->entry->nsample && p->entry->mean > 0.)
+		{
+			/* Normalize sizes to keep x^b within range */
+			x[i] = p->entry->size / maxx;
+			y[i] = p->entry->mean;
+			i++;
+		}
+
+	double best_err = INFINITY, best_a = NAN, best_b = NAN, best_c = NAN;
+	double bi;
+	for (bi = REL_BMIN; bi <= REL_BMAX; bi += REL_BSTEP)
+	{
+		double s1 = 0., sx = 0., sxx = 0., sy = 0., sxy = 0.;
+		for (i = 0; i < n; i++)
+		{
+			double v = 1. / (y[i] * y[i]);
+			double xb = pow(x[i], bi);
+			s1 += v;
+			sx += v * xb;
+			sxx += v * xb * xb;
+			sy += v * y[i];
+			sxy += v * xb * y[i];
+		}
+
+		double det = sxx * s1 - sx * sx;
+		if (fabs(det) < EPS * sxx * s1)
+			continue;
+		double ai = (sxy * s1 - sx * sy) / det;
+		double ci = (sxx * sy - sx * sxy) / det;
+		if (ai <= 0.)
+			continue;
+
+		double e = 0.;
+		for (i = 0; i < n; i++)
+		{
+			double r = (ai * pow(x[i], bi) + ci - y[i]) / y[i];
+			e += r * r;
+		}
+		if (e < best_err)
+		{
+			best_err = e;
+			best_a = ai;
+			best_b = bi;
+			best_c = ci;
+		}
+	}
+
+	free(x);
+	free(y);
+
+	if (isinf(best_err))
+		return -1;
+
+	*a = best_a / pow(maxx, best_b);
+	*b = best_b;
+	*c = best_c;
+	*err = sqrt(best_err / n);
+	return 0;
+}
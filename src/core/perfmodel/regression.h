@@ -28,6 +28,9 @@
 #pragma GCC visibility push(hidden)
 
 int _starpu_regression_non_linear_power(struct starpu_perfmodel_history_list *ptr, double *a, double *b, double *c);
+/** Fit y = a x ^ b + c over the entries which have at least \p min_nsample
+ * samples, minimizing the relative error, which is returned in \p err */
+int _starpu_regression_non_linear_power_relative(struct starpu_perfmodel_history_list *ptr, unsigned min_nsample, double *a, double *b, double *c, double *err);
 
 #pragma GCC visibility pop
 
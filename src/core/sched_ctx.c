@@ -20,6 +20,7 @@
 #include <core/sched_ctx.h>
 #include <common/utils.h>
 #include <stdarg.h>
+#include <math.h>
 #include <core/task.h>
 #include <core/workers.h>
 
@@ -55,6 +56,8 @@ static void set_priority_on_notified_workers(int *workers, int nworkers, unsigne
 static void set_priority_hierarchically_on_notified_workers(int* workers_to_add, unsigned nworkers_to_add, unsigned sched_ctx, unsigned priority);
 static void fetch_tasks_from_empty_ctx_list(struct _starpu_sched_ctx *sched_ctx);
 static void add_notified_workers(int *workers_to_add, int nworkers_to_add, unsigned sched_ctx_id);
+static unsigned _starpu_sched_ctx_elastic_default(void);
+static void _starpu_sched_ctx_elastic_start(struct _starpu_sched_ctx *sched_ctx);
 
 /* reused from combined_workers.c */
 static int compar_int(const void *pa, const void *pb)
@@ -583,6 +586,13 @@ struct _starpu_sched_ctx* _starpu_create_sched_ctx(struct starpu_sched_policy *p
 	_starpu_barrier_counter_init(&sched_ctx->ready_tasks_barrier, 0);
 
 	sched_ctx->ready_flops = 0.0;
+	sched_ctx->elastic = 0;
+	sched_ctx->done_tasks = 0;
+	sched_ctx->done_flops = 0.0;
+	sched_ctx->min_ncpus = 0;
+	sched_ctx->max_ncpus = 0;
+	sched_ctx->min_ngpus = 0;
+	sched_ctx->max_ngpus = 0;
 	for (i = 0; i < (int) (sizeof(sched_ctx->iterations)/sizeof(sched_ctx->iterations[0])); i++)
 		sched_ctx->iterations[i] = -1;
 	sched_ctx->iteration_level = 0;
@@ -719,6 +729,7 @@ unsigned starpu_sched_ctx_create(int *workerids, int nworkers, const char *sched
 	unsigned hierarchy_level = 0;
 	unsigned nesting_sched_ctx = STARPU_NMAX_SCHED_CTXS;
 	unsigned awake_workers = 0;
+	unsigned elastic = _starpu_sched_ctx_elastic_default();
 	void (*init_sched)(unsigned) = NULL;
 
 	va_start(varg_list, sched_ctx_name);
@@ -756,6 +767,10 @@ unsigned starpu_sched_ctx_create(int *workerids, int nworkers, const char *sched
 		{
 			awake_workers = 1;
 		}
+		else if (arg_type == STARPU_SCHED_CTX_ELASTIC)
+		{
+			elastic = 1;
+		}
 		else if (arg_type == STARPU_SCHED_CTX_POLICY_INIT)
 		{
 #ifdef __NVCOMPILER
@@ -802,6 +817,8 @@ unsigned starpu_sched_ctx_create(int *workerids, int nworkers, const char *sched
 	sched_ctx = _starpu_create_sched_ctx(sched_policy, workerids, nworkers, 0, sched_ctx_name, min_prio_set, min_prio, max_prio_set, max_prio, awake_workers, init_sched, user_data, nsub_ctxs, sub_ctxs, nsms);
 	sched_ctx->hierarchy_level = hierarchy_level;
 	sched_ctx->nesting_sched_ctx = nesting_sched_ctx;
+	if (elastic && sched_ctx->sched_policy && nesting_sched_ctx == STARPU_NMAX_SCHED_CTXS && nsub_ctxs == 0)
+		_starpu_sched_ctx_elastic_start(sched_ctx);
 
 	int *added_workerids;
 	unsigned nw_ctx = starpu_sched_ctx_get_workers_list(sched_ctx->id, &added_workerids);
@@ -835,6 +852,7 @@ int fstarpu_sched_ctx_create(int *workerids, int nworkers, const char *sched_ctx
 	unsigned hierarchy_level = 0;
 	unsigned nesting_sched_ctx = STARPU_NMAX_SCHED_CTXS;
 	unsigned awake_workers = 0;
+	unsigned elastic = _starpu_sched_ctx_elastic_default();
 	void (*init_sched)(unsigned) = NULL;
 
 	while (arglist[arg_i] != NULL)
@@ -882,6 +900,10 @@ int fstarpu_sched_ctx_create(int *workerids, int nworkers, const char *sched_ctx
 		{
 			awake_workers = 1;
 		}
+		else if (arg_type == STARPU_SCHED_CTX_ELASTIC)
+		{
+			elastic = 1;
+		}
 		else if (arg_type == STARPU_SCHED_CTX_POLICY_INIT)
 		{
 			arg_i++;
@@ -932,6 +954,8 @@ int fstarpu_sched_ctx_create(int *workerids, int nworkers, const char *sched_ctx
 	sched_ctx = _starpu_create_sched_ctx(sched_policy, workerids, nworkers, 0, sched_ctx_name, min_prio_set, min_prio, max_prio_set, max_prio, awake_workers, init_sched, user_data, nsub_ctxs, sub_ctxs, nsms);
 	sched_ctx->hierarchy_level = hierarchy_level;
 	sched_ctx->nesting_sched_ctx = nesting_sched_ctx;
+	if (elastic && sched_ctx->sched_policy && nesting_sched_ctx == STARPU_NMAX_SCHED_CTXS && nsub_ctxs == 0)
+		_starpu_sched_ctx_elastic_start(sched_ctx);
 
 	int *added_workerids;
 	unsigned nw_ctx = starpu_sched_ctx_get_workers_list(sched_ctx->id, &added_workerids);
@@ -995,6 +1019,7 @@ static void _starpu_delete_sched_ctx(struct _starpu_sched_ctx *sched_ctx)
 
 	sched_ctx->min_priority_is_set = 0;
 	sched_ctx->max_priority_is_set = 0;
+	sched_ctx->elastic = 0;
 	sched_ctx->id = STARPU_NMAX_SCHED_CTXS;
 #ifdef STARPU_HAVE_HWLOC
 	hwloc_bitmap_free(sched_ctx->hwloc_workers_set);
@@ -1630,7 +1655,9 @@ void _starpu_decrement_nready_tasks_of_sched_ctx_locked(unsigned sched_ctx_id, d
 	_starpu_barrier_counter_decrement_until_empty_counter(&sched_ctx->ready_tasks_barrier, ready_flops);
 }
 
-void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops)
+/* done tells whether the task was actually executed, and should thus be
+ * accounted in the throughput of the context */
+static void decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops, unsigned done)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
 
@@ -1644,12 +1671,22 @@ void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double r
 
 	if(!sched_ctx->is_initial_sched)
 	{
+		if (done)
+		{
+			sched_ctx->done_tasks++;
+			sched_ctx->done_flops += ready_flops;
+		}
 		_starpu_fetch_task_from_waiting_list(sched_ctx);
 		_starpu_sched_ctx_unlock_write(sched_ctx->id);
 	}
 
 }
 
+void _starpu_decrement_nready_tasks_of_sched_ctx(unsigned sched_ctx_id, double ready_flops)
+{
+	decrement_nready_tasks_of_sched_ctx(sched_ctx_id, ready_flops, 1);
+}
+
 int starpu_sched_ctx_get_nready_tasks(unsigned sched_ctx_id)
 {
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(sched_ctx_id);
@@ -2300,7 +2337,8 @@ void starpu_sched_ctx_revert_task_counters_ctx_locked(unsigned sched_ctx_id, dou
 void starpu_sched_ctx_revert_task_counters(unsigned sched_ctx_id, double ready_flops)
 {
 	_starpu_decrement_nsubmitted_tasks_of_sched_ctx(sched_ctx_id);
-	_starpu_decrement_nready_tasks_of_sched_ctx(sched_ctx_id, ready_flops);
+	/* The task was not executed */
+	decrement_nready_tasks_of_sched_ctx(sched_ctx_id, ready_flops, 0);
 }
 
 void starpu_sched_ctx_move_task_to_ctx_locked(struct starpu_task *task, unsigned sched_ctx, unsigned with_repush)
@@ -2776,6 +2814,292 @@ void _starpu_worker_apply_deferred_ctx_changes(void)
 
 }
 
+/*
+ * Elastic resizing of the contexts created with STARPU_SCHED_CTX_ELASTIC (or
+ * all of them with STARPU_SCHED_CTX_ELASTIC=1): a controller thread
+ * periodically estimates for each context the time needed to drain its ready
+ * tasks at its current completion rate, and moves a CPU worker from the
+ * context which would drain first to the one which would drain last, when
+ * that reduces the largest drain time. The same move has to be advised
+ * several periods in a row, and contexts are not resized again for a while
+ * afterwards, to avoid moving workers back and forth.
+ */
+
+struct _starpu_sched_ctx_elastic_state
+{
+	/** tasks and flops completed at the previous period */
+	unsigned long last_tasks;
+	double last_flops;
+	/** smoothed completion rates, per second */
+	double task_rate;
+	double flops_rate;
+	/** smoothed fraction of idle CPU workers */
+	double idle;
+	/** periods left before the context may be resized again */
+	unsigned cooldown;
+};
+
+/* Weight of the new measurement in the smoothed values */
+#define ELASTIC_SMOOTHING 0.5
+/* Gain on the largest drain time that a move must bring */
+#define ELASTIC_MARGIN 0.1
+
+static struct _starpu_sched_ctx_elastic_state elastic_states[STARPU_NMAX_SCHED_CTXS];
+static int elastic_all = -1;
+static unsigned elastic_period;
+static unsigned elastic_hysteresis;
+static unsigned elastic_started;
+static volatile unsigned elastic_running;
+static starpu_pthread_t elastic_thread;
+/* Move advised by the previous periods, and for how many periods in a row */
+static unsigned elastic_advised_from = STARPU_NMAX_SCHED_CTXS;
+static unsigned elastic_advised_to = STARPU_NMAX_SCHED_CTXS;
+static unsigned elastic_advised_count;
+
+static unsigned _starpu_sched_ctx_elastic_default(void)
+{
+	if (elastic_all == -1)
+		elastic_all = starpu_getenv_number_default("STARPU_SCHED_CTX_ELASTIC", 0);
+	return elastic_all;
+}
+
+/* Pick a CPU worker of \p from which does not belong to \p to, preferably an idle one */
+static int _starpu_sched_ctx_elastic_pick_worker(unsigned from, unsigned to, unsigned *ncpus)
+{
+	int *workerids = NULL, *to_workerids = NULL;
+	unsigned nworkers, to_nworkers;
+	unsigned i, j;
+	int picked = -1;
+
+	_starpu_sched_ctx_lock_read(to);
+	to_nworkers = starpu_sched_ctx_get_workers_list(to, &to_workerids);
+	_starpu_sched_ctx_unlock_read(to);
+	_starpu_sched_ctx_lock_read(from);
+	nworkers = starpu_sched_ctx_get_workers_list(from, &workerids);
+	_starpu_sched_ctx_unlock_read(from);
+
+	*ncpus = 0;
+	for (i = 0; i < nworkers; i++)
+	{
+		int workerid = workerids[i];
+		if (starpu_worker_get_type(workerid) != STARPU_CPU_WORKER)
+			continue;
+		(*ncpus)++;
+		for (j = 0; j < to_nworkers; j++)
+			if (to_workerids[j] == workerid)
+				break;
+		if (j < to_nworkers)
+			continue;
+		if (picked == -1 || !(_starpu_worker_get_status(workerid) & (STATUS_EXECUTING|STATUS_WAITING|STATUS_CALLBACK)))
+			picked = workerid;
+	}
+	free(workerids);
+	free(to_workerids);
+	return picked;
+}
+
+static void _starpu_sched_ctx_elastic_period(double elapsed)
+{
+	unsigned ids[STARPU_NMAX_SCHED_CTXS];
+	unsigned ncpus[STARPU_NMAX_SCHED_CTXS];
+	int nready[STARPU_NMAX_SCHED_CTXS];
+	double drain[STARPU_NMAX_SCHED_CTXS];
+	unsigned n = 0, i, j;
+
+	for (i = 0; i < STARPU_NMAX_SCHED_CTXS; i++)
+	{
+		struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(i);
+		struct _starpu_sched_ctx_elastic_state *state = &elastic_states[i];
+		unsigned long tasks;
+		double done_flops, ready_flops;
+		int *workerids = NULL;
+		unsigned nworkers, nidle = 0;
+
+		if (sched_ctx->id == STARPU_NMAX_SCHED_CTXS || !sched_ctx->elastic)
+			continue;
+
+		_starpu_sched_ctx_lock_read(i);
+		tasks = sched_ctx->done_tasks;
+		done_flops = sched_ctx->done_flops;
+		nworkers = starpu_sched_ctx_get_workers_list(i, &workerids);
+		_starpu_sched_ctx_unlock_read(i);
+
+		state->task_rate = ELASTIC_SMOOTHING * (tasks - state->last_tasks) / elapsed + (1. - ELASTIC_SMOOTHING) * state->task_rate;
+		state->flops_rate = ELASTIC_SMOOTHING * (done_flops - state->last_flops) / elapsed + (1. - ELASTIC_SMOOTHING) * state->flops_rate;
+		state->last_tasks = tasks;
+		state->last_flops = done_flops;
+
+		ncpus[n] = 0;
+		for (j = 0; j < nworkers; j++)
+		{
+			if (starpu_worker_get_type(workerids[j]) != STARPU_CPU_WORKER)
+				continue;
+			ncpus[n]++;
+			if (!(_starpu_worker_get_status(workerids[j]) & (STATUS_EXECUTING|STATUS_WAITING|STATUS_CALLBACK)))
+				nidle++;
+		}
+		free(workerids);
+		if (ncpus[n])
+			state->idle = ELASTIC_SMOOTHING * nidle / ncpus[n] + (1. - ELASTIC_SMOOTHING) * state->idle;
+		if (state->cooldown)
+			state->cooldown--;
+
+		/* Time to drain the ready tasks at the current rate, in flops
+		 * if the tasks tell them, in number of tasks otherwise */
+		nready[n] = starpu_sched_ctx_get_nready_tasks(i);
+		ready_flops = starpu_sched_ctx_get_nready_flops(i);
+		if (nready[n] == 0)
+			drain[n] = 0.;
+		else if (ready_flops > 0. && state->flops_rate > 0.)
+			drain[n] = ready_flops / state->flops_rate;
+		else if (state->task_rate > 0.)
+			drain[n] = nready[n] / state->task_rate;
+		else
+			drain[n] = INFINITY;
+
+		_STARPU_DEBUG("context %u: %u cpus, %d ready, %.0f tasks/s, idle %.2f, drain %fs\n", i, ncpus[n], nready[n], state->task_rate, state->idle, drain[n]);
+		ids[n++] = i;
+	}
+
+	if (n < 2)
+		return;
+
+	/* The context which would drain last, and still has more ready tasks than workers */
+	unsigned to = n;
+	for (i = 0; i < n; i++)
+	{
+		struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(ids[i]);
+		if ((unsigned) nready[i] <= ncpus[i] || elastic_states[ids[i]].idle > 0.5)
+			continue;
+		if (sched_ctx->max_ncpus > 0 && ncpus[i] >= (unsigned) sched_ctx->max_ncpus)
+			continue;
+		if (to == n || drain[i] > drain[to])
+			to = i;
+	}
+	if (to == n)
+	{
+		elastic_advised_count = 0;
+		return;
+	}
+
+	/* The context which would drain first without one of its CPU workers */
+	unsigned from = n;
+	double from_drain = 0.;
+	for (i = 0; i < n; i++)
+	{
+		struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(ids[i]);
+		double projected;
+		if (i == to || ncpus[i] <= 1 || ncpus[i] <= (unsigned) sched_ctx->min_ncpus)
+			continue;
+		projected = drain[i] * ncpus[i] / (ncpus[i] - 1);
+		if (from == n || projected < from_drain)
+		{
+			from = i;
+			from_drain = projected;
+		}
+	}
+	if (from == n)
+	{
+		elastic_advised_count = 0;
+		return;
+	}
+
+	/* Only move if this reduces the largest drain time enough */
+	double to_drain = drain[to] * ncpus[to] / (ncpus[to] + 1);
+	int worth;
+	if (isinf(drain[to]))
+		worth = !isinf(from_drain);
+	else
+		worth = STARPU_MAX(from_drain, to_drain) * (1. + ELASTIC_MARGIN) < drain[to];
+	if (!worth)
+	{
+		elastic_advised_count = 0;
+		return;
+	}
+
+	if (elastic_advised_from == ids[from] && elastic_advised_to == ids[to])
+		elastic_advised_count++;
+	else
+	{
+		elastic_advised_from = ids[from];
+		elastic_advised_to = ids[to];
+		elastic_advised_count = 1;
+	}
+
+	if (elastic_advised_count < elastic_hysteresis
+		|| elastic_states[ids[from]].cooldown || elastic_states[ids[to]].cooldown)
+		return;
+
+	unsigned from_ncpus;
+	int workerid = _starpu_sched_ctx_elastic_pick_worker(ids[from], ids[to], &from_ncpus);
+	if (workerid == -1 || from_ncpus <= 1)
+		return;
+
+	_STARPU_DEBUG("moving worker %d from context %u to context %u\n", workerid, ids[from], ids[to]);
+	/* Add first, so that the worker always has something to do */
+	starpu_sched_ctx_add_workers(&workerid, 1, ids[to]);
+	starpu_sched_ctx_remove_workers(&workerid, 1, ids[from]);
+
+	elastic_states[ids[from]].cooldown = elastic_hysteresis;
+	elastic_states[ids[to]].cooldown = elastic_hysteresis;
+	elastic_advised_count = 0;
+}
+
+static void *_starpu_sched_ctx_elastic_func(void *arg)
+{
+	double last, now;
+	(void) arg;
+
+	starpu_pthread_setname("elastic");
+	last = starpu_timing_now();
+	while (elastic_running)
+	{
+		starpu_usleep(elastic_period);
+		if (!elastic_running)
+			break;
+
+		/* Context creation or deletion in progress, try again later */
+		if (STARPU_PTHREAD_MUTEX_TRYLOCK(&sched_ctx_manag))
+			continue;
+		now = starpu_timing_now();
+		_starpu_sched_ctx_elastic_period((now - last) / 1000000.);
+		last = now;
+		STARPU_PTHREAD_MUTEX_UNLOCK(&sched_ctx_manag);
+	}
+	return NULL;
+}
+
+/* Must be called with sched_ctx_manag held */
+static void _starpu_sched_ctx_elastic_start(struct _starpu_sched_ctx *sched_ctx)
+{
+	memset(&elastic_states[sched_ctx->id], 0, sizeof(elastic_states[sched_ctx->id]));
+	sched_ctx->elastic = 1;
+
+	if (elastic_started)
+		return;
+
+	elastic_period = starpu_getenv_number_default("STARPU_SCHED_CTX_ELASTIC_PERIOD", 100) * 1000;
+	elastic_hysteresis = starpu_getenv_number_default("STARPU_SCHED_CTX_ELASTIC_HYSTERESIS", 3);
+	if (elastic_hysteresis == 0)
+		elastic_hysteresis = 1;
+	elastic_advised_count = 0;
+	elastic_running = 1;
+	elastic_started = 1;
+	STARPU_PTHREAD_CREATE(&elastic_thread, NULL, _starpu_sched_ctx_elastic_func, NULL);
+}
+
+void _starpu_sched_ctx_elastic_shutdown(void)
+{
+	if (!elastic_started)
+		return;
+
+	elastic_running = 0;
+	STARPU_WMB();
+	STARPU_PTHREAD_JOIN(elastic_thread, NULL);
+	elastic_started = 0;
+	elastic_all = -1;
+}
+
 /*
  * TODO: verify starpu_sched_ctx_create_inside_interval correctness before re-enabling the functions below
  */
@@ -78,6 +78,12 @@ struct _starpu_sched_ctx
 	/** amount of ready flops in a context */
 	double ready_flops;
 
+	/** whether the elastic controller may move workers from and to this context */
+	unsigned elastic;
+	/** number of tasks and amount of flops completed in this context */
+	unsigned long done_tasks;
+	double done_flops;
+
 	/** Iteration number, as advertised by application */
 	long iterations[2];
 	int iteration_level;
@@ -192,6 +198,9 @@ struct _starpu_sched_ctx*  _starpu_create_sched_ctx(struct starpu_sched_policy *
 /** delete all sched_ctx */
 void _starpu_delete_all_sched_ctxs();
 
+/** Stop the controller of the contexts created with STARPU_SCHED_CTX_ELASTIC */
+void _starpu_sched_ctx_elastic_shutdown(void);
+
 /** This function waits until all the tasks that were already submitted to a specific
  * context have been executed. */
 int _starpu_wait_for_all_tasks_of_sched_ctx(unsigned sched_ctx_id);
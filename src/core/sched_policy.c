@@ -82,6 +82,7 @@ static struct starpu_sched_policy *predefined_policies[] =
 	&_starpu_sched_prio_policy,
 	&_starpu_sched_random_policy,
 	&_starpu_sched_lws_policy,
+	&_starpu_sched_lws_locality_policy,
 	&_starpu_sched_ws_policy,
 	&_starpu_sched_dm_policy,
 	&_starpu_sched_dmda_policy,
@@ -659,6 +660,7 @@ int _starpu_push_task_to_workers(struct starpu_task *task)
 	struct _starpu_sched_ctx *sched_ctx = _starpu_get_sched_ctx_struct(task->sched_ctx);
 
 	_STARPU_TRACE_JOB_PUSH(task, task->priority);
+	_STARPU_TRACEBUF_JOB_PUSH(task, task->priority);
 
 	/* if the contexts still does not have workers put the task back to its place in
 	   the empty ctx list */
@@ -817,6 +819,7 @@ int _starpu_pop_task_end(struct starpu_task *task)
 	if (!task)
 		return 0;
 	_STARPU_TRACE_JOB_POP(task, task->priority);
+	_STARPU_TRACEBUF_JOB_POP(task, task->priority);
 	return 0;
 }
 
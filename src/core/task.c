@@ -1046,6 +1046,7 @@ int _starpu_task_submit(struct starpu_task *task, int nodeps)
 		_STARPU_TRACE_TASK_SUBMIT(j,
 			_starpu_get_sched_ctx_struct(task->sched_ctx)->iterations[0],
 			_starpu_get_sched_ctx_struct(task->sched_ctx)->iterations[1]);
+		_STARPU_TRACEBUF_TASK_SUBMIT(j);
 	}
 
 	/* If this is a continuation, we don't modify the implicit data dependencies detected earlier. */
@@ -1490,6 +1491,22 @@ void starpu_do_schedule(void)
 	}
 }
 
+int starpu_task_yield(void)
+{
+	struct _starpu_worker *worker = _starpu_get_local_worker_key();
+	struct starpu_task *task;
+	int ret;
+
+	/* Do not let reclaiming memory delay the codelet, only push requests
+	 * for which room is readily available */
+	ret = __starpu_datawizard_progress(_STARPU_DATAWIZARD_ONLY_FAST_ALLOC, 1);
+
+	if (worker && (task = worker->current_task) && !worker->state_sched_op_pending)
+		_starpu_sched_do_schedule(task->sched_ctx);
+
+	return ret;
+}
+
 void
 starpu_drivers_request_termination(void)
 {
@@ -565,10 +565,14 @@ static void _starpu_init_topology(struct _starpu_machine_config *config)
 		err = hwloc_topology_set_xml(topology->hwtopology, hwloc_input);
 		if (err < 0) _STARPU_DISP("Could not load hwloc input %s\n", hwloc_input);
 	}
+	else
+		/* Avoid the discovery if the machine cache already knows the topology */
+		_starpu_machine_cache_set_topology(topology->hwtopology);
 
 	_starpu_topology_filter(topology->hwtopology);
 	err = hwloc_topology_load(topology->hwtopology);
 	STARPU_ASSERT_MSG(err == 0, "Could not load Hwloc topology (%s)%s%s%s\n", strerror(errno), hwloc_input ? " (input " : "", hwloc_input ? hwloc_input : "", hwloc_input ? ")" : "");
+	_starpu_machine_cache_topology_loaded(topology->hwtopology);
 
 #ifdef HAVE_HWLOC_CPUKINDS_GET_NR
 	int nr_kinds = hwloc_cpukinds_get_nr(topology->hwtopology, 0);
@@ -1408,6 +1412,7 @@ void _starpu_destroy_machine_config(struct _starpu_machine_config *config, int n
 	hwloc_bitmap_free(config->topology.log_coreset);
 	hwloc_topology_destroy(config->topology.hwtopology);
 #endif
+	_starpu_machine_cache_deinit();
 
 	topology_is_initialized = 0;
 
@@ -35,8 +35,11 @@
 #include <core/task.h>
 #include <core/detect_combined_workers.h>
 #include <datawizard/malloc.h>
+#include <datawizard/numa_migration.h>
+#include <drivers/cpu/numa_copy.h>
 #include <profiling/profiling.h>
 #include <profiling/callbacks.h>
+#include <profiling/analysis.h>
 #include <drivers/max/driver_max_fpga.h>
 #include <profiling/bound.h>
 #include <sched_policies/sched_component.h>
@@ -894,6 +897,11 @@ void _starpu_worker_init(struct _starpu_worker *workerarg, struct _starpu_machin
 	workerarg->state_unblock_in_parallel_ack = 0;
 	workerarg->block_in_parallel_ref_count = 0;
 	_starpu_perf_counter_sample_init(&workerarg->perf_counter_sample, starpu_perf_counter_scope_per_worker);
+	workerarg->__w_busy_time__value = 0.;
+	workerarg->__w_idle_no_task_time__value = 0.;
+	workerarg->__w_idle_dependency_time__value = 0.;
+	workerarg->__w_idle_data_time__value = 0.;
+	workerarg->__w_idle_sleeping_time__value = 0.;
 	workerarg->enable_knob = 1;
 	workerarg->bindid_requested = -1;
 
@@ -1820,6 +1828,8 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 
 	_starpu_timing_init();
 
+	_starpu_tracebuf_init();
+
 	_starpu_load_bus_performance_files();
 
 	/* Note: nothing before here should be allocating anything, in case we
@@ -1854,6 +1864,7 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 #ifdef STARPU_USE_FXT
 		_starpu_stop_fxt_profiling();
 #endif
+		_starpu_tracebuf_exit();
 		return ret;
 	}
 
@@ -1902,11 +1913,15 @@ int starpu_initialize(struct starpu_conf *user_conf, int *argc, char ***argv)
 		_starpu_launch_drivers(&_starpu_config);
 		/* Allocate swap, if any */
 		_starpu_swap_init();
+		_starpu_numa_migration_init();
+		_starpu_numa_copy_init();
 	}
 
 	_starpu_watchdog_init();
 
+	_starpu_analysis_init();
 	_starpu_profiling_start();
+	_starpu_analysis_start();
 
 	STARPU_PTHREAD_MUTEX_LOCK(&init_mutex);
 	initialized = INITIALIZED;
@@ -2156,6 +2171,8 @@ void starpu_shutdown(void)
 
 	starpu_worker_wait_for_initialisation();
 
+	_starpu_sched_ctx_elastic_shutdown();
+
 	/* tell all workers to shutdown */
 	_starpu_kill_all_workers(&_starpu_config);
 
@@ -2182,10 +2199,14 @@ void starpu_shutdown(void)
 	_starpu_deinitialize_registered_performance_models();
 
 	_starpu_watchdog_shutdown();
+	_starpu_analysis_shutdown();
 
 	/* wait for their termination */
 	_starpu_terminate_workers(&_starpu_config);
 
+	_starpu_numa_migration_shutdown();
+	_starpu_numa_copy_shutdown();
+
 	{
 	     int stats = starpu_getenv_number("STARPU_MEMORY_STATS");
 	     if (stats != 0)
@@ -2215,6 +2236,7 @@ void starpu_shutdown(void)
 #ifdef STARPU_USE_FXT
 	_starpu_stop_fxt_profiling();
 #endif
+	_starpu_tracebuf_exit();
 
 	_starpu_data_interface_shutdown();
 
@@ -117,6 +117,9 @@ struct _starpu_node
 	/** requests that are not terminated (eg. async transfers) */
 	struct _starpu_data_request_prio_list data_requests_pending[STARPU_MAXNODES][2];
 	unsigned data_requests_npending[STARPU_MAXNODES][2];
+	/** Number of bytes of the prefetches to this node which are currently
+	 * being transferred */
+	unsigned long prefetch_inflight_bytes;
 	starpu_pthread_mutex_t data_requests_pending_list_mutex[STARPU_MAXNODES][2];
 
 	/*
@@ -298,6 +301,12 @@ LIST_TYPE(_starpu_worker,
 	struct starpu_perf_counter_sample perf_counter_sample;
 	int64_t __w_total_executed__value;
 	double __w_cumul_execution_time__value;
+	/** Online analysis of the worker time, in microseconds */
+	double __w_busy_time__value;
+	double __w_idle_no_task_time__value;
+	double __w_idle_dependency_time__value;
+	double __w_idle_data_time__value;
+	double __w_idle_sleeping_time__value;
 
 	int enable_knob;
 	int bindid_requested;
@@ -23,6 +23,7 @@
 #include <datawizard/copy_driver.h>
 #include <datawizard/write_back.h>
 #include <datawizard/memory_nodes.h>
+#include <datawizard/numa_migration.h>
 #include <core/dependencies/data_concurrency.h>
 #include <core/disk.h>
 #include <profiling/profiling.h>
@@ -166,6 +167,101 @@ int _starpu_select_src_node(starpu_data_handle_t handle, unsigned destination)
 	return src_node;
 }
 
+/* Weight of src_node as a source for the transfer of handle to dst_node: its
+ * throughput for this transfer, which will have to wait for the bytes already
+ * queued on the link, as in _starpu_data_expected_transfer_time */
+static double stripe_weight(starpu_data_handle_t handle, unsigned src_node, unsigned dst_node)
+{
+	struct _starpu_data_request *queued_request = handle->per_node[dst_node].queued_request;
+	double bandwidth = starpu_transfer_bandwidth(src_node, dst_node);
+	size_t size = _starpu_data_get_size(handle);
+	size_t queued = _starpu_bus_get_queued_bytes(src_node, dst_node);
+
+	if (queued_request && (unsigned) queued_request->src_replicate->memory_node == src_node)
+		/* Do not count the transfer itself */
+		queued -= STARPU_MIN(queued, queued_request->queued_bytes);
+
+	if (isnan(bandwidth) || bandwidth <= 0.)
+		/* Not calibrated, consider all sources alike */
+		bandwidth = 1.;
+	if (!queued)
+		return bandwidth;
+	return bandwidth * size / (size + queued);
+}
+
+/* Select the valid replicates which can provide a part of a transfer of
+ * handle from src_node to dst_node, handled by handling_node, in parallel.
+ * src_nodes[0] is set to src_node, and the other ones to the best other
+ * sources, at most max_src in total. Their weights are set to their expected
+ * throughput. Return the number of sources. */
+unsigned _starpu_select_stripe_src_nodes(starpu_data_handle_t handle, unsigned src_node, unsigned dst_node, unsigned handling_node, unsigned max_src, unsigned *src_nodes, double *weights)
+{
+	unsigned nnodes = starpu_memory_nodes_get_count();
+	unsigned nsrc = 1;
+	unsigned node, i;
+
+	_starpu_spin_checklocked(&handle->header_lock);
+
+	src_nodes[0] = src_node;
+	weights[0] = stripe_weight(handle, src_node, dst_node);
+
+	if (handle->per_node[src_node].mapped != STARPU_UNMAPPED)
+		return nsrc;
+
+	for (node = 0; node < nnodes; node++)
+	{
+		struct _starpu_data_replicate *replicate = &handle->per_node[node];
+		unsigned link_handling_node;
+		double weight;
+
+		if (node == src_node || node == dst_node)
+			continue;
+		if (replicate->state == STARPU_INVALID || !replicate->allocated
+		 || !replicate->initialized || replicate->mapped != STARPU_UNMAPPED)
+			continue;
+		/* This is only worth it with asynchronous copies */
+		if (starpu_asynchronous_copy_disabled_for(starpu_node_get_kind(node)))
+			continue;
+		/* The copy has to be possible from the thread which handles
+		 * the request */
+		if (!link_supports_direct_transfers(handle, node, dst_node, &link_handling_node)
+		 || link_handling_node != handling_node)
+			continue;
+
+		weight = stripe_weight(handle, node, dst_node);
+
+		/* Keep the sources sorted by decreasing weight, after src_node */
+		for (i = nsrc; i > 1 && weights[i-1] < weight; i--)
+		{
+			if (i < max_src)
+			{
+				src_nodes[i] = src_nodes[i-1];
+				weights[i] = weights[i-1];
+			}
+		}
+		if (i < max_src)
+		{
+			src_nodes[i] = node;
+			weights[i] = weight;
+			if (nsrc < max_src)
+				nsrc++;
+		}
+	}
+
+	return nsrc;
+}
+
+void _starpu_data_replicate_drop_prefetch(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate)
+{
+	_starpu_spin_checklocked(&handle->header_lock);
+	if (replicate->prefetched)
+	{
+		if (replicate->state != STARPU_INVALID)
+			_starpu_bus_waste_prefetch_bytes(replicate->prefetched_from, replicate->memory_node, _starpu_data_get_size(handle));
+		replicate->prefetched = 0;
+	}
+}
+
 /* this may be called once the data is fetched with header and STARPU_RW-lock hold */
 void _starpu_update_data_state(starpu_data_handle_t handle,
 			       struct _starpu_data_replicate *requesting_replicate,
@@ -204,6 +300,8 @@ void _starpu_update_data_state(starpu_data_handle_t handle,
 				continue;
 			if (handle->per_node[node].state != STARPU_INVALID)
 			       _STARPU_TRACE_DATA_STATE_INVALID(handle, node);
+			if (node != requesting_node)
+				_starpu_data_replicate_drop_prefetch(handle, &handle->per_node[node]);
 			handle->per_node[node].state = STARPU_INVALID;
 		}
 		if (requesting_replicate->state != STARPU_OWNER)
@@ -468,8 +566,16 @@ static struct _starpu_data_request *_starpu_search_existing_data_request(struct
 			continue;
 
 		if (task && r->task && task != r->task)
-			/* Do not collapse requests for different tasks */
-			continue;
+		{
+			if (is_prefetch == STARPU_FETCH || r->prefetch == STARPU_FETCH)
+				/* Do not collapse requests for different tasks */
+				continue;
+			/* But let prefetches for different tasks share the
+			 * same transfer. It then does not belong to any of
+			 * them, so that it does not get canceled when one of
+			 * them gets executed elsewhere. */
+			r->task = NULL;
+		}
 
 		_starpu_spin_lock(&r->lock);
 
@@ -507,6 +613,27 @@ static struct _starpu_data_request *_starpu_search_existing_data_request(struct
 
 
 
+/* The task is fetching the data on requesting_node, cancel the prefetches which
+ * were made for it on other nodes and not started yet, e.g. because it was
+ * stolen by a worker of another node. Requests which other requests are
+ * chained to, or which got upgraded to a fetch, are still needed. */
+static void cancel_task_prefetches(starpu_data_handle_t handle, struct starpu_task *task, int requesting_node)
+{
+	unsigned nnodes = starpu_memory_nodes_get_count();
+	unsigned i, j;
+	struct _starpu_data_request *r;
+
+	for (i = 0; i < nnodes; i++)
+	{
+		if ((int) i == requesting_node)
+			continue;
+		for (j = 0; j < nnodes; j++)
+			for (r = handle->per_node[i].request[j]; r; r = r->next_same_req)
+				if (r->task == task && r->prefetch > STARPU_FETCH && !r->next_req_count)
+					r->canceled = 1;
+	}
+}
+
 /*
  * This function is called when the data is needed on the local node, this
  * returns a pointer to the local copy
@@ -546,6 +673,10 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 	int requesting_node = dst_replicate ? dst_replicate->memory_node : -1;
 	unsigned nwait = 0;
 
+	if (dst_replicate && is_prefetch == STARPU_FETCH)
+		/* The value is getting used */
+		dst_replicate->prefetched = 0;
+
 	if (mode & STARPU_W)
 	{
 		/* We will write to the buffer. We will have to wait for all
@@ -616,6 +747,8 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 						}
 					}
 				}
+				if (is_prefetch == STARPU_FETCH)
+					cancel_task_prefetches(handle, task, requesting_node);
 			}
 		}
 
@@ -815,6 +948,11 @@ struct _starpu_data_request *_starpu_create_request_to_fetch_data(starpu_data_ha
 	}
 	STARPU_ASSERT(nhops);
 
+	if (task && dst_replicate && is_prefetch == STARPU_FETCH)
+		/* The requests we reused have been upgraded to fetches, and
+		 * are thus kept */
+		cancel_task_prefetches(handle, task, requesting_node);
+
 	if (!async)
 		requests[nhops - 1]->refcnt++;
 
@@ -1143,6 +1281,7 @@ int _starpu_fetch_task_input(struct starpu_task *task, struct _starpu_job *j, in
 {
 	struct _starpu_worker *worker = _starpu_get_local_worker_key();
 	int workerid = worker->workerid;
+	_STARPU_TRACEBUF_START_FETCH_INPUT();
 	if (async)
 	{
 		worker->task_transferring = task;
@@ -1232,6 +1371,7 @@ int _starpu_fetch_task_input(struct starpu_task *task, struct _starpu_job *j, in
 
 enomem:
 	_STARPU_TRACE_END_FETCH_INPUT(NULL);
+	_STARPU_TRACEBUF_END_FETCH_INPUT();
 	_STARPU_DISP("something went wrong with buffer %u\n", index);
 
 	/* try to unreference all the input that were successfully taken */
@@ -1303,6 +1443,7 @@ void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job
 			}
 		}
 		needs_init = !local_replicate->initialized;
+		_starpu_numa_migration_record(handle, local_replicate, node, workerid);
 		_starpu_spin_unlock(&handle->header_lock);
 
 		_STARPU_TASK_SET_INTERFACE(task , local_replicate->data_interface, descrs[index].index);
@@ -1322,6 +1463,7 @@ void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job
 		_starpu_clock_gettime(&task->profiling_info->acquire_data_end_time);
 
 	_STARPU_TRACE_END_FETCH_INPUT(NULL);
+	_STARPU_TRACEBUF_END_FETCH_INPUT();
 
 	_starpu_clear_worker_status(worker, STATUS_INDEX_WAITING, NULL);
 }
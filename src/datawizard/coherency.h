@@ -103,12 +103,23 @@ struct _starpu_data_replicate
 	/* Which request is loading data here */
 	struct _starpu_data_request *load_request;
 
+	/** Which request has its transfer to here accounted in the queue of
+	 * its bus, see _starpu_bus_queue_bytes */
+	struct _starpu_data_request *queued_request;
+
 	/** The number of prefetches that we made for this replicate for various tasks
 	 * This is also the number of tasks that we will wait to see use the mc before
 	 * we attempt to evict it.
 	 */
 	unsigned nb_tasks_prefetch;
 
+	/** Whether the value was brought here by a prefetch, and not used by
+	 * any task or acquisition yet. It is accounted as wasted in the
+	 * profiling of the bus it came from if it gets invalidated or evicted
+	 * before being used. */
+	unsigned prefetched:1;
+	char prefetched_from;
+
 	/** Pointer to memchunk for LRU strategy */
 	struct _starpu_mem_chunk * mc;
 };
@@ -234,6 +245,23 @@ struct _starpu_data_state
 	/** where is the data home, i.e. which node it was registered from ? -1 if none yet */
 	int home_node;
 
+	/** NUMA placement of the CPU buffers allocated for this handle, see starpu_data_set_numa_policy */
+	enum starpu_data_numa_policy numa_policy;
+	/** NUMA node (hwloc logical index) for STARPU_DATA_NUMA_BIND, -1 for the one of the memory node */
+	int numa_node;
+	/** For data without a home node, the memory node which the placement
+	 * policy settled on, reported by starpu_data_get_numa_home_node. -1 if none */
+	int numa_home_node;
+	/** Per hwloc NUMA node number of accesses by CPU workers in the current
+	 * window of the page migrator, NULL until it records one */
+	unsigned *numa_accesses;
+	/** Total number of accesses in the current window */
+	unsigned numa_naccesses;
+	/** hwloc NUMA node which the page migrator last moved the data to, -1 if none */
+	int numa_current;
+	/** Whether the handle is queued for the page migrator */
+	unsigned numa_migration_pending;
+
 	/** what is the default write-through mask for that data ? */
 	uint32_t wt_mask;
 
@@ -367,6 +395,9 @@ void _starpu_release_data_on_node(struct _starpu_data_state *state, uint32_t def
 void _starpu_update_data_state(starpu_data_handle_t handle,
 			       struct _starpu_data_replicate *requesting_replicate,
 			       enum starpu_data_access_mode mode);
+/** The value of \p replicate is getting dropped, account it as wasted if it
+ * was prefetched and not used. This is called with the header lock held. */
+void _starpu_data_replicate_drop_prefetch(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate);
 
 uint32_t _starpu_get_data_refcnt(struct _starpu_data_state *state, unsigned node);
 
@@ -390,6 +421,10 @@ void _starpu_fetch_task_input_tail(struct starpu_task *task, struct _starpu_job
 void _starpu_fetch_nowhere_task_input(struct _starpu_job *j);
 
 int _starpu_select_src_node(struct _starpu_data_state *state, unsigned destination);
+/** Select up to \p max_src valid replicates to stripe a transfer of \p state
+ * from \p src_node to \p dst_node handled by \p handling_node from, along with
+ * their weights, \p src_node first. Return the number of sources. */
+unsigned _starpu_select_stripe_src_nodes(struct _starpu_data_state *state, unsigned src_node, unsigned dst_node, unsigned handling_node, unsigned max_src, unsigned *src_nodes, double *weights);
 int _starpu_determine_request_path(starpu_data_handle_t handle,
 				  int src_node, int dst_node,
 				  enum starpu_data_access_mode mode, int max_len,
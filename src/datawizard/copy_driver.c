@@ -18,6 +18,7 @@
 #include <starpu.h>
 #include <common/config.h>
 #include <common/utils.h>
+#include <common/starpu_spinlock.h>
 #include <core/sched_policy.h>
 #include <datawizard/datastats.h>
 #include <datawizard/memory_nodes.h>
@@ -133,12 +134,10 @@ void starpu_wake_all_blocked_workers(void)
 #endif
 }
 
-#ifdef STARPU_USE_FXT
 /* we need to identify each communication so that we can match the beginning
  * and the end of a communication in the trace, so we use a unique identifier
  * per communication */
 static unsigned long communication_cnt = 0;
-#endif
 
 int _starpu_copy_interface_any_to_any(starpu_data_handle_t handle, void *src_interface, unsigned src_node, void *dst_interface, unsigned dst_node, struct _starpu_data_request *req)
 {
@@ -169,6 +168,196 @@ int _starpu_copy_interface_any_to_any(starpu_data_handle_t handle, void *src_int
 	return ret;
 }
 
+/* A large transfer is split into contiguous ranges, each of which is copied
+ * from a different valid replicate, see _starpu_select_stripe_src_nodes. */
+struct _starpu_copy_stripe
+{
+	unsigned src_node;
+	double weight;
+	unsigned done;
+	struct _starpu_async_channel async_channel;
+};
+
+struct _starpu_copy_stripes
+{
+	unsigned nsrc;
+	struct _starpu_copy_stripe stripe[];
+};
+
+struct _starpu_copy_stripes *_starpu_copy_stripes_new(starpu_data_handle_t handle, const unsigned *src_nodes, const double *weights, unsigned nsrc)
+{
+	struct _starpu_copy_stripes *stripes;
+	unsigned i;
+
+	_starpu_spin_checklocked(&handle->header_lock);
+	STARPU_ASSERT(nsrc >= 2);
+
+	if (handle->ops->interfaceid != STARPU_VECTOR_INTERFACE_ID
+	 && handle->ops->interfaceid != STARPU_MATRIX_INTERFACE_ID)
+		return NULL;
+
+	_STARPU_CALLOC(stripes, 1, sizeof(*stripes) + nsrc * sizeof(stripes->stripe[0]));
+	stripes->nsrc = nsrc;
+	for (i = 0; i < nsrc; i++)
+	{
+		struct _starpu_copy_stripe *stripe = &stripes->stripe[i];
+		stripe->src_node = src_nodes[i];
+		stripe->weight = weights[i];
+		if (i > 0)
+		{
+			/* Keep the additional sources there until the end of
+			 * the transfer, the request holds the first one */
+			handle->per_node[src_nodes[i]].refcnt++;
+			handle->busy_count++;
+		}
+	}
+	return stripes;
+}
+
+void _starpu_copy_stripes_free(starpu_data_handle_t handle, struct _starpu_copy_stripes *stripes)
+{
+	unsigned i;
+
+	_starpu_spin_checklocked(&handle->header_lock);
+	for (i = 1; i < stripes->nsrc; i++)
+	{
+		struct _starpu_data_replicate *replicate = &handle->per_node[stripes->stripe[i].src_node];
+		STARPU_ASSERT(replicate->refcnt > 0);
+		replicate->refcnt--;
+		STARPU_ASSERT(handle->busy_count > 0);
+		handle->busy_count--;
+	}
+	free(stripes);
+}
+
+#ifndef STARPU_SIMGRID
+/* Ranges are aligned on this, to keep the copies efficient */
+#define STRIPE_ALIGN 4096
+
+/* Get the base and offset of the single contiguous buffer of data_interface,
+ * return -1 if the data is not stored in such a buffer */
+static int stripe_layout(starpu_data_handle_t handle, void *data_interface, uintptr_t *ptr, size_t *offset)
+{
+	switch (handle->ops->interfaceid)
+	{
+		case STARPU_VECTOR_INTERFACE_ID:
+		{
+			struct starpu_vector_interface *vector = data_interface;
+			*ptr = vector->dev_handle;
+			*offset = vector->offset;
+			return 0;
+		}
+		case STARPU_MATRIX_INTERFACE_ID:
+		{
+			struct starpu_matrix_interface *matrix = data_interface;
+			if (matrix->ld != matrix->nx)
+				return -1;
+			*ptr = matrix->dev_handle;
+			*offset = matrix->offset;
+			return 0;
+		}
+		default:
+			return -1;
+	}
+}
+
+/* Copy the data of dst_replicate from the sources of stripes, each of them
+ * providing a range proportional to its weight. Return -EAGAIN if some copies
+ * are still pending, -ENOTSUP if the replicates can not be striped. */
+static int copy_stripes(starpu_data_handle_t handle, struct _starpu_copy_stripes *stripes, struct _starpu_data_replicate *dst_replicate)
+{
+	unsigned dst_node = dst_replicate->memory_node;
+	enum starpu_node_kind dst_kind = starpu_node_get_kind(dst_node);
+	size_t size = _starpu_data_get_size(handle);
+	uintptr_t src_ptr[stripes->nsrc], dst_ptr;
+	size_t src_offset[stripes->nsrc], dst_offset;
+	size_t copied = 0;
+	double total = 0.;
+	unsigned i;
+	int ret = 0;
+
+	/* Check the layout of all replicates before copying anything */
+	if (stripe_layout(handle, dst_replicate->data_interface, &dst_ptr, &dst_offset))
+		return -ENOTSUP;
+	for (i = 0; i < stripes->nsrc; i++)
+	{
+		if (stripe_layout(handle, handle->per_node[stripes->stripe[i].src_node].data_interface, &src_ptr[i], &src_offset[i]))
+			return -ENOTSUP;
+		total += stripes->stripe[i].weight;
+	}
+
+	for (i = 0; i < stripes->nsrc; i++)
+	{
+		struct _starpu_copy_stripe *stripe = &stripes->stripe[i];
+		unsigned src_node = stripe->src_node;
+		size_t len;
+
+		if (i == stripes->nsrc - 1)
+			len = size - copied;
+		else
+		{
+			len = (size_t) (size * (stripe->weight / total));
+			len -= len % STRIPE_ALIGN;
+			if (len > size - copied)
+				len = size - copied;
+		}
+
+		if (!len)
+		{
+			stripe->done = 1;
+			continue;
+		}
+
+		/* Same as _starpu_copy_interface_any_to_any */
+		if (dst_kind == STARPU_CPU_RAM)
+			stripe->async_channel.node_ops = starpu_memory_driver_info[starpu_node_get_kind(src_node)].ops;
+		else
+			stripe->async_channel.node_ops = starpu_memory_driver_info[dst_kind].ops;
+
+		_starpu_bus_update_profiling_info((int)src_node, (int)dst_node, len);
+		int ret_copy = starpu_interface_copy(src_ptr[i], src_offset[i] + copied, src_node,
+						     dst_ptr, dst_offset + copied, dst_node,
+						     len, &stripe->async_channel);
+		starpu_interface_data_copy(src_node, dst_node, len);
+
+		stripe->done = ret_copy != -EAGAIN;
+		if (!stripe->done)
+			ret = -EAGAIN;
+		copied += len;
+	}
+	STARPU_ASSERT(copied == size);
+
+	return ret;
+}
+
+/* Test for (or wait for if wait is set) the completion of all the copies of
+ * the stripes of async_channel */
+static unsigned copy_stripes_test(struct _starpu_async_channel *async_channel, int wait)
+{
+	struct _starpu_copy_stripes *stripes = async_channel->stripes;
+	unsigned i, done = 1;
+
+	for (i = 0; i < stripes->nsrc; i++)
+	{
+		struct _starpu_copy_stripe *stripe = &stripes->stripe[i];
+		if (stripe->done)
+			continue;
+		if (wait)
+		{
+			_starpu_driver_wait_request_completion(&stripe->async_channel);
+			stripe->done = 1;
+		}
+		else
+		{
+			stripe->done = _starpu_driver_test_request_completion(&stripe->async_channel);
+			if (!stripe->done)
+				done = 0;
+		}
+	}
+	return done;
+}
+#endif
+
 static int copy_data_1_to_1_generic(starpu_data_handle_t handle,
 				    struct _starpu_data_replicate *src_replicate,
 				    struct _starpu_data_replicate *dst_replicate,
@@ -345,25 +534,47 @@ int STARPU_ATTRIBUTE_WARN_UNUSED_RESULT _starpu_driver_copy_data_1_to_1(starpu_d
 	{
 		unsigned long STARPU_ATTRIBUTE_UNUSED com_id = 0;
 		size_t size = _starpu_data_get_size(handle);
-		_starpu_bus_update_profiling_info((int)src_node, (int)dst_node, size);
 
+		if (
 #ifdef STARPU_USE_FXT
-		if (fut_active)
+		    fut_active ||
+#endif
+		    _starpu_tracebuf_enabled)
 		{
 			com_id = STARPU_ATOMIC_ADDL(&communication_cnt, 1);
 
 			if (req)
 				req->com_id = com_id;
 		}
-#endif
 
 		dst_replicate->initialized = 1;
 
 		_STARPU_TRACE_START_DRIVER_COPY(src_node, dst_node, size, com_id, prefetch, handle);
-		int ret_copy = copy_data_1_to_1_generic(handle, src_replicate, dst_replicate, req);
+		_STARPU_TRACEBUF_START_DRIVER_COPY(src_node, dst_node, size, com_id);
+		int ret_copy = -ENOTSUP;
+#ifndef STARPU_SIMGRID
+		if (req && req->async_channel.stripes)
+		{
+			ret_copy = copy_stripes(handle, req->async_channel.stripes, dst_replicate);
+			if (ret_copy == -ENOTSUP)
+			{
+				/* Not possible after all, do a plain copy */
+				_starpu_copy_stripes_free(handle, req->async_channel.stripes);
+				req->async_channel.stripes = NULL;
+			}
+		}
+#endif
+		if (ret_copy == -ENOTSUP)
+		{
+			_starpu_bus_update_profiling_info((int)src_node, (int)dst_node, size);
+			ret_copy = copy_data_1_to_1_generic(handle, src_replicate, dst_replicate, req);
+		}
 		if (!req)
+		{
 			/* Synchronous, this is already finished */
 			_STARPU_TRACE_END_DRIVER_COPY(src_node, dst_node, size, com_id, prefetch);
+			_STARPU_TRACEBUF_END_DRIVER_COPY(src_node, dst_node, size, com_id);
+		}
 
 		return ret_copy;
 	}
@@ -403,6 +614,220 @@ void starpu_interface_end_driver_copy_async(unsigned src_node, unsigned dst_node
 	_STARPU_TRACE_END_DRIVER_COPY_ASYNC(src_node, dst_node);
 }
 
+/* A batch of small transfers between two nodes, aggregated from several
+ * requests by __starpu_handle_node_data_requests, which the driver performs at
+ * once. The requests keep a reference on it until they notice its completion.
+ */
+struct _starpu_copy_batch
+{
+	struct _starpu_spinlock lock;
+	unsigned src_node;
+	unsigned dst_node;
+	copy_batch_data_t copy;
+
+	struct _starpu_copy_batch_piece *pieces;
+	unsigned npieces;
+	unsigned maxpieces;
+
+	/* Number of requests which joined the batch */
+	unsigned nrequests;
+	/* Requests plus the creator of the batch until it submits it */
+	unsigned refcnt;
+	volatile unsigned submitted;
+	unsigned done;
+
+	struct _starpu_async_channel async_channel;
+};
+
+/* Return the batch copy method from src_node to dst_node, if any */
+static copy_batch_data_t get_copy_batch(unsigned src_node, unsigned dst_node)
+{
+	enum starpu_node_kind src_kind = starpu_node_get_kind(src_node);
+	enum starpu_node_kind dst_kind = starpu_node_get_kind(dst_node);
+	const struct _starpu_node_ops *src_node_ops = _starpu_memory_node_get_node_ops(src_node);
+	const struct _starpu_node_ops *dst_node_ops = _starpu_memory_node_get_node_ops(dst_node);
+
+	if (src_node_ops && src_node_ops->copy_batch_data_to[dst_kind])
+		return src_node_ops->copy_batch_data_to[dst_kind];
+	if (dst_node_ops && dst_node_ops->copy_batch_data_from[src_kind])
+		return dst_node_ops->copy_batch_data_from[src_kind];
+	return NULL;
+}
+
+struct _starpu_copy_batch *_starpu_copy_batch_new(unsigned src_node, unsigned dst_node)
+{
+	struct _starpu_copy_batch *batch;
+	copy_batch_data_t copy = get_copy_batch(src_node, dst_node);
+
+	if (!copy)
+		return NULL;
+
+	_STARPU_CALLOC(batch, 1, sizeof(*batch));
+	_starpu_spin_init(&batch->lock);
+	batch->src_node = src_node;
+	batch->dst_node = dst_node;
+	batch->copy = copy;
+	batch->refcnt = 1;
+	STARPU_HG_DISABLE_CHECKING(batch->submitted);
+	return batch;
+}
+
+static void copy_batch_free(struct _starpu_copy_batch *batch)
+{
+	_starpu_spin_destroy(&batch->lock);
+	free(batch->pieces);
+	free(batch);
+}
+
+int _starpu_copy_batch_match(struct _starpu_copy_batch *batch, unsigned src_node, unsigned dst_node)
+{
+	return batch->src_node == src_node && batch->dst_node == dst_node;
+}
+
+unsigned _starpu_copy_batch_nrequests(struct _starpu_copy_batch *batch)
+{
+	return batch->nrequests;
+}
+
+/* Whether the copies from src_node to dst_node for async_channel are to be
+ * recorded in a batch */
+static int copy_batch_wanted(struct _starpu_async_channel *async_channel, unsigned src_node, unsigned dst_node)
+{
+	return async_channel && async_channel->batch
+		&& _starpu_copy_batch_match(async_channel->batch, src_node, dst_node);
+}
+
+/* Record the copy of size bytes from src + src_offset to dst + dst_offset in
+ * the batch of async_channel */
+static int copy_batch_add(struct _starpu_async_channel *async_channel, uintptr_t src, size_t src_offset, uintptr_t dst, size_t dst_offset, size_t size)
+{
+	struct _starpu_copy_batch *batch = async_channel->batch;
+	struct _starpu_copy_batch_piece *last = batch->npieces ? &batch->pieces[batch->npieces-1] : NULL;
+
+	STARPU_ASSERT(!batch->submitted);
+
+	if (!async_channel->batch_joined)
+	{
+		async_channel->batch_joined = 1;
+		batch->nrequests++;
+		batch->refcnt++;
+	}
+
+	if (last && last->src == src && last->dst == dst &&
+	    last->src_offset + last->size == src_offset &&
+	    last->dst_offset + last->size == dst_offset)
+	{
+		/* Contiguous on both sides, just extend the previous piece */
+		last->size += size;
+		return -EAGAIN;
+	}
+
+	if (batch->npieces == batch->maxpieces)
+	{
+		batch->maxpieces = batch->maxpieces ? 2 * batch->maxpieces : 16;
+		_STARPU_REALLOC(batch->pieces, batch->maxpieces * sizeof(*batch->pieces));
+	}
+	batch->pieces[batch->npieces].src = src;
+	batch->pieces[batch->npieces].src_offset = src_offset;
+	batch->pieces[batch->npieces].dst = dst;
+	batch->pieces[batch->npieces].dst_offset = dst_offset;
+	batch->pieces[batch->npieces].size = size;
+	batch->npieces++;
+
+	return -EAGAIN;
+}
+
+/* Record a non-contiguous copy in the batch of async_channel, block by block */
+static int copy_batch_add_blocks(struct _starpu_async_channel *async_channel,
+				 uintptr_t src, size_t src_offset,
+				 uintptr_t dst, size_t dst_offset,
+				 size_t blocksize,
+				 size_t numblocks_1, size_t ld1_src, size_t ld1_dst,
+				 size_t numblocks_2, size_t ld2_src, size_t ld2_dst,
+				 size_t numblocks_3, size_t ld3_src, size_t ld3_dst)
+{
+	size_t i, j, k;
+
+	for (k = 0; k < numblocks_3; k++)
+		for (j = 0; j < numblocks_2; j++)
+			for (i = 0; i < numblocks_1; i++)
+				copy_batch_add(async_channel,
+					       src, src_offset + k*ld3_src + j*ld2_src + i*ld1_src,
+					       dst, dst_offset + k*ld3_dst + j*ld2_dst + i*ld1_dst,
+					       blocksize);
+	return -EAGAIN;
+}
+
+void _starpu_copy_batch_submit(struct _starpu_copy_batch *batch)
+{
+	unsigned last;
+	int ret = 0;
+
+	if (batch->npieces)
+	{
+		enum starpu_node_kind src_kind = starpu_node_get_kind(batch->src_node);
+		enum starpu_node_kind dst_kind = starpu_node_get_kind(batch->dst_node);
+
+		/* Same as _starpu_copy_interface_any_to_any */
+		if (dst_kind == STARPU_CPU_RAM)
+			batch->async_channel.node_ops = starpu_memory_driver_info[src_kind].ops;
+		else
+			batch->async_channel.node_ops = starpu_memory_driver_info[dst_kind].ops;
+
+		ret = batch->copy(batch->pieces, batch->npieces,
+				  batch->src_node, batch->dst_node,
+				  &batch->async_channel);
+	}
+
+	_starpu_spin_lock(&batch->lock);
+	batch->done = ret != -EAGAIN;
+	batch->submitted = 1;
+	last = --batch->refcnt == 0;
+	_starpu_spin_unlock(&batch->lock);
+
+	if (last)
+		copy_batch_free(batch);
+}
+
+#ifndef STARPU_SIMGRID
+/* Test for (or wait for if wait is set) the completion of the batch that
+ * async_channel joined, and drop its reference once it is completed */
+static unsigned copy_batch_test(struct _starpu_async_channel *async_channel, int wait)
+{
+	struct _starpu_copy_batch *batch = async_channel->batch;
+	unsigned done, last = 0;
+
+	if (wait)
+		/* It is being filled by another thread, which will submit it very soon */
+		while (!batch->submitted)
+			STARPU_UYIELD();
+
+	_starpu_spin_lock(&batch->lock);
+	if (batch->submitted && !batch->done)
+	{
+		if (wait)
+		{
+			_starpu_driver_wait_request_completion(&batch->async_channel);
+			batch->done = 1;
+		}
+		else
+			batch->done = _starpu_driver_test_request_completion(&batch->async_channel);
+	}
+	done = batch->done;
+	if (done)
+	{
+		async_channel->batch = NULL;
+		async_channel->batch_joined = 0;
+		last = --batch->refcnt == 0;
+	}
+	_starpu_spin_unlock(&batch->lock);
+
+	if (last)
+		copy_batch_free(batch);
+	return done;
+}
+#endif
+
 /* This can be used by interfaces to easily transfer a piece of data without
  * caring about the particular transfer methods.  */
 
@@ -413,6 +838,11 @@ void starpu_interface_end_driver_copy_async(unsigned src_node, unsigned dst_node
 int starpu_interface_copy(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, void *async_data)
 {
 	struct _starpu_async_channel *async_channel = async_data;
+
+	if (copy_batch_wanted(async_channel, src_node, dst_node))
+		/* Aggregated with other requests */
+		return copy_batch_add(async_channel, src, src_offset, dst, dst_offset, size);
+
 	enum starpu_node_kind src_kind = starpu_node_get_kind(src_node);
 	enum starpu_node_kind dst_kind = starpu_node_get_kind(dst_node);
 	const struct _starpu_node_ops *src_node_ops = _starpu_memory_node_get_node_ops(src_node);
@@ -439,12 +869,75 @@ int starpu_interface_copy(uintptr_t src, size_t src_offset, unsigned src_node, u
 	}
 }
 
+/* Return the vectored copy method from src_node to dst_node, if any */
+static copyv_data_t get_copyv(unsigned src_node, unsigned dst_node)
+{
+	enum starpu_node_kind src_kind = starpu_node_get_kind(src_node);
+	enum starpu_node_kind dst_kind = starpu_node_get_kind(dst_node);
+	const struct _starpu_node_ops *src_node_ops = _starpu_memory_node_get_node_ops(src_node);
+	const struct _starpu_node_ops *dst_node_ops = _starpu_memory_node_get_node_ops(dst_node);
+
+	if (src_node_ops && src_node_ops->copyv_data_to[dst_kind])
+		return src_node_ops->copyv_data_to[dst_kind];
+	if (dst_node_ops && dst_node_ops->copyv_data_from[src_kind])
+		return dst_node_ops->copyv_data_from[src_kind];
+	return NULL;
+}
+
+/* Non-contiguous copy through a vectored copy method: describe all the blocks
+ * at once, merging those which happen to be contiguous on both sides, so that
+ * the driver can gather those which are contiguous on one side in a single
+ * transfer. */
+static int copy_vec(copyv_data_t copyv,
+		    uintptr_t src, size_t src_offset, unsigned src_node,
+		    uintptr_t dst, size_t dst_offset, unsigned dst_node,
+		    size_t blocksize,
+		    size_t numblocks_1, size_t ld1_src, size_t ld1_dst,
+		    size_t numblocks_2, size_t ld2_src, size_t ld2_dst,
+		    size_t numblocks_3, size_t ld3_src, size_t ld3_dst,
+		    struct _starpu_async_channel *async_channel)
+{
+	struct _starpu_copy_vec *vec;
+	unsigned nvec = 0;
+	size_t i, j, k;
+	int ret;
+
+	_STARPU_MALLOC(vec, numblocks_1 * numblocks_2 * numblocks_3 * sizeof(*vec));
+
+	for (k = 0; k < numblocks_3; k++)
+		for (j = 0; j < numblocks_2; j++)
+			for (i = 0; i < numblocks_1; i++)
+			{
+				size_t src_off = src_offset + k*ld3_src + j*ld2_src + i*ld1_src;
+				size_t dst_off = dst_offset + k*ld3_dst + j*ld2_dst + i*ld1_dst;
+
+				if (nvec &&
+				    vec[nvec-1].src_offset + vec[nvec-1].size == src_off &&
+				    vec[nvec-1].dst_offset + vec[nvec-1].size == dst_off)
+				{
+					/* Contiguous on both sides, just extend the previous piece */
+					vec[nvec-1].size += blocksize;
+					continue;
+				}
+
+				vec[nvec].src_offset = src_off;
+				vec[nvec].dst_offset = dst_off;
+				vec[nvec].size = blocksize;
+				nvec++;
+			}
+
+	ret = copyv(src, src_node, dst, dst_node, vec, nvec, async_channel);
+	free(vec);
+	return ret;
+}
+
 int starpu_interface_copy2d(uintptr_t src, size_t src_offset, unsigned src_node,
 			    uintptr_t dst, size_t dst_offset, unsigned dst_node,
 			    size_t blocksize,
 			    size_t numblocks, size_t ld_src, size_t ld_dst,
 			    void *async_data)
 {
+	copyv_data_t copyv;
 	int ret = 0;
 	unsigned i;
 	struct _starpu_async_channel *async_channel = async_data;
@@ -462,6 +955,14 @@ int starpu_interface_copy2d(uintptr_t src, size_t src_offset, unsigned src_node,
 					     dst, dst_offset, dst_node,
 					     blocksize * numblocks, async_data);
 
+	if (copy_batch_wanted(async_channel, src_node, dst_node))
+		/* Aggregated with other requests */
+		return copy_batch_add_blocks(async_channel, src, src_offset, dst, dst_offset,
+					     blocksize,
+					     numblocks, ld_src, ld_dst,
+					     1, 0, 0,
+					     1, 0, 0);
+
 	if (src_node_ops && src_node_ops->copy2d_data_to[dst_kind])
 		/* Hardware-optimized non-contiguous case */
 		return src_node_ops->copy2d_data_to[dst_kind](src, src_offset, src_node,
@@ -478,6 +979,17 @@ int starpu_interface_copy2d(uintptr_t src, size_t src_offset, unsigned src_node,
 							     numblocks, ld_src, ld_dst,
 							     async_channel);
 
+	copyv = get_copyv(src_node, dst_node);
+	if (copyv)
+		/* Scatter/gather non-contiguous case */
+		return copy_vec(copyv, src, src_offset, src_node,
+				dst, dst_offset, dst_node,
+				blocksize,
+				numblocks, ld_src, ld_dst,
+				1, 0, 0,
+				1, 0, 0,
+				async_channel);
+
 	for (i = 0; i < numblocks; i++)
 	{
 		if (starpu_interface_copy(src, src_offset + i*ld_src, src_node,
@@ -496,6 +1008,7 @@ int starpu_interface_copy3d(uintptr_t src, size_t src_offset, unsigned src_node,
 			    size_t numblocks_2, size_t ld2_src, size_t ld2_dst,
 			    void *async_data)
 {
+	copyv_data_t copyv;
 	int ret = 0;
 	unsigned i;
 	struct _starpu_async_channel *async_channel = async_data;
@@ -518,6 +1031,14 @@ int starpu_interface_copy3d(uintptr_t src, size_t src_offset, unsigned src_node,
 					     blocksize * numblocks_1 * numblocks_2,
 					     async_data);
 
+	if (copy_batch_wanted(async_channel, src_node, dst_node))
+		/* Aggregated with other requests */
+		return copy_batch_add_blocks(async_channel, src, src_offset, dst, dst_offset,
+					     blocksize,
+					     numblocks_1, ld1_src, ld1_dst,
+					     numblocks_2, ld2_src, ld2_dst,
+					     1, 0, 0);
+
 	if (src_node_ops && src_node_ops->copy3d_data_to[dst_kind])
 		/* Hardware-optimized non-contiguous case */
 		return src_node_ops->copy3d_data_to[dst_kind](src, src_offset, src_node,
@@ -536,6 +1057,17 @@ int starpu_interface_copy3d(uintptr_t src, size_t src_offset, unsigned src_node,
 							     numblocks_2, ld2_src, ld2_dst,
 							     async_channel);
 
+	if (!(src_node_ops && src_node_ops->copy2d_data_to[dst_kind]) &&
+	    !(dst_node_ops && dst_node_ops->copy2d_data_from[src_kind]) &&
+	    (copyv = get_copyv(src_node, dst_node)))
+		/* Scatter/gather non-contiguous case */
+		return copy_vec(copyv, src, src_offset, src_node,
+				dst, dst_offset, dst_node,
+				blocksize,
+				numblocks_1, ld1_src, ld1_dst,
+				numblocks_2, ld2_src, ld2_dst,
+				1, 0, 0,
+				async_channel);
 
 	for (i = 0; i < numblocks_2; i++)
 	{
@@ -557,8 +1089,14 @@ int starpu_interface_copy4d(uintptr_t src, size_t src_offset, unsigned src_node,
 			    size_t numblocks_3, size_t ld3_src, size_t ld3_dst,
 			    void *async_data)
 {
+	copyv_data_t copyv;
 	int ret = 0;
 	unsigned i;
+	struct _starpu_async_channel *async_channel = async_data;
+	enum starpu_node_kind src_kind = starpu_node_get_kind(src_node);
+	enum starpu_node_kind dst_kind = starpu_node_get_kind(dst_node);
+	const struct _starpu_node_ops *src_node_ops = _starpu_memory_node_get_node_ops(src_node);
+	const struct _starpu_node_ops *dst_node_ops = _starpu_memory_node_get_node_ops(dst_node);
 
 	STARPU_ASSERT_MSG(ld1_src >= blocksize, "block size %lu is bigger than ld %lu in source", (unsigned long) blocksize, (unsigned long) ld1_src);
 	STARPU_ASSERT_MSG(ld1_dst >= blocksize, "block size %lu is bigger than ld %lu in destination", (unsigned long) blocksize, (unsigned long) ld1_dst);
@@ -577,8 +1115,28 @@ int starpu_interface_copy4d(uintptr_t src, size_t src_offset, unsigned src_node,
 					     blocksize * numblocks_1 * numblocks_2 * numblocks_3,
 					     async_data);
 
+	if (copy_batch_wanted(async_channel, src_node, dst_node))
+		/* Aggregated with other requests */
+		return copy_batch_add_blocks(async_channel, src, src_offset, dst, dst_offset,
+					     blocksize,
+					     numblocks_1, ld1_src, ld1_dst,
+					     numblocks_2, ld2_src, ld2_dst,
+					     numblocks_3, ld3_src, ld3_dst);
+
 	/* Probably won't ever have a 4D interface in drivers :) */
 
+	if (!(src_node_ops && (src_node_ops->copy3d_data_to[dst_kind] || src_node_ops->copy2d_data_to[dst_kind])) &&
+	    !(dst_node_ops && (dst_node_ops->copy3d_data_from[src_kind] || dst_node_ops->copy2d_data_from[src_kind])) &&
+	    (copyv = get_copyv(src_node, dst_node)))
+		/* Scatter/gather non-contiguous case */
+		return copy_vec(copyv, src, src_offset, src_node,
+				dst, dst_offset, dst_node,
+				blocksize,
+				numblocks_1, ld1_src, ld1_dst,
+				numblocks_2, ld2_src, ld2_dst,
+				numblocks_3, ld3_src, ld3_dst,
+				async_channel);
+
 	for (i = 0; i < numblocks_3; i++)
 	{
 		if (starpu_interface_copy3d(src, src_offset + i*ld3_src, src_node,
@@ -745,6 +1303,17 @@ void _starpu_driver_wait_request_completion(struct _starpu_async_channel *async_
 #ifdef STARPU_SIMGRID
 	_starpu_simgrid_wait_transfer_event(&async_channel->event);
 #else /* !SIMGRID */
+	if (async_channel->batch && async_channel->batch_joined)
+	{
+		copy_batch_test(async_channel, 1);
+		return;
+	}
+	if (async_channel->stripes)
+	{
+		copy_stripes_test(async_channel, 1);
+		return;
+	}
+
 	const struct _starpu_node_ops *node_ops = async_channel->node_ops;
 	if (node_ops && node_ops->wait_request_completion != NULL)
 	{
@@ -762,6 +1331,11 @@ unsigned _starpu_driver_test_request_completion(struct _starpu_async_channel *as
 #ifdef STARPU_SIMGRID
 	return _starpu_simgrid_test_transfer_event(&async_channel->event);
 #else /* !SIMGRID */
+	if (async_channel->batch && async_channel->batch_joined)
+		return copy_batch_test(async_channel, 0);
+	if (async_channel->stripes)
+		return copy_stripes_test(async_channel, 0);
+
 	const struct _starpu_node_ops *node_ops = async_channel->node_ops;
 	if (node_ops && node_ops->test_request_completion != NULL)
 	{
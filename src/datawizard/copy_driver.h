@@ -36,6 +36,8 @@ extern "C"
 
 struct _starpu_data_request;
 struct _starpu_data_replicate;
+struct _starpu_copy_batch;
+struct _starpu_copy_stripes;
 
 enum _starpu_may_alloc
 {
@@ -47,6 +49,9 @@ enum _starpu_may_alloc
 
 LIST_TYPE(_starpu_disk_backend_event,
 	void *backend_event;
+	/** Whether this is a job of the disk compression threads rather than
+	 * an event of the backend */
+	int compress;
 );
 
 struct _starpu_disk_event
@@ -77,6 +82,14 @@ struct _starpu_async_channel
 	/** Used to know if the acknowlegdment msg is arrived from sinks */
 	volatile int starpu_mp_common_finished_sender;
 	volatile int starpu_mp_common_finished_receiver;
+	/** Batch that the copies of this transfer are to be aggregated into,
+	 * see _starpu_copy_batch_new */
+	struct _starpu_copy_batch *batch;
+	/** Whether copies were actually aggregated into \p batch */
+	unsigned batch_joined;
+	/** Sources that the transfer is to be striped from, see
+	 * _starpu_copy_stripes_new */
+	struct _starpu_copy_stripes *stripes;
 };
 
 void _starpu_wake_all_blocked_workers_on_node(unsigned nodeid);
@@ -92,6 +105,30 @@ int _starpu_driver_copy_data_1_to_1(starpu_data_handle_t handle,
 int _starpu_copy_interface_any_to_any(starpu_data_handle_t handle, void *src_interface, unsigned src_node, void *dst_interface, unsigned dst_node, struct _starpu_data_request *req);
 
 unsigned _starpu_driver_test_request_completion(struct _starpu_async_channel *async_channel);
+
+/** Return a new batch to aggregate small transfers from \p src_node to
+ * \p dst_node into one driver transfer, or NULL if the drivers can not do so.
+ * The copies of a request whose async_channel has \p batch set are recorded
+ * in the batch instead of being started. The request then completes along with
+ * the batch. */
+struct _starpu_copy_batch *_starpu_copy_batch_new(unsigned src_node, unsigned dst_node);
+/** Whether \p batch transfers data from \p src_node to \p dst_node */
+int _starpu_copy_batch_match(struct _starpu_copy_batch *batch, unsigned src_node, unsigned dst_node);
+/** Return the number of transfers aggregated into \p batch so far */
+unsigned _starpu_copy_batch_nrequests(struct _starpu_copy_batch *batch);
+/** Start the transfer of the whole \p batch, and release our reference on it */
+void _starpu_copy_batch_submit(struct _starpu_copy_batch *batch);
+/** Return a new set of \p nsrc sources to stripe a large transfer of
+ * \p handle from, or NULL if the layout of the handle does not allow it.
+ * \p src_nodes[0] must be the source of the request, the others are
+ * additional valid replicates on which a reference is taken. Each source will
+ * transfer a part of the data proportional to its weight. The copy of a
+ * request whose async_channel has \p stripes set is split accordingly.
+ * The handle header lock must be held. */
+struct _starpu_copy_stripes *_starpu_copy_stripes_new(starpu_data_handle_t handle, const unsigned *src_nodes, const double *weights, unsigned nsrc);
+/** Release the references taken by _starpu_copy_stripes_new and free
+ * \p stripes. The handle header lock must be held. */
+void _starpu_copy_stripes_free(starpu_data_handle_t handle, struct _starpu_copy_stripes *stripes);
 void _starpu_driver_wait_request_completion(struct _starpu_async_channel *async_channel);
 
 #ifdef __cplusplus
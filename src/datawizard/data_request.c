@@ -16,6 +16,7 @@
  * See the GNU Lesser General Public License in COPYING.LGPL for more details.
  */
 
+#include <math.h>
 #include <starpu.h>
 #include <common/config.h>
 #include <common/utils.h>
@@ -23,11 +24,44 @@
 #include <datawizard/memory_nodes.h>
 #include <core/disk.h>
 #include <core/simgrid.h>
+#include <profiling/profiling.h>
+
+/* Requests for data of at most this size are aggregated into batches of
+ * transfers, see __starpu_handle_node_data_requests */
+static size_t aggregate_max_size;
+/* Maximum number of requests aggregated into a batch, 0 to disable
+ * aggregation */
+static unsigned aggregate_max_requests;
+/* Transfers of data of at least this size are striped over several sources,
+ * see stripe_request */
+static size_t stripe_min_size;
+/* Maximum number of sources of a striped transfer, 0 to disable striping */
+static unsigned stripe_max_sources;
+/* Prefetches in flight to a node are limited to what their link can transfer
+ * in this time, in µs, see prefetch_admitted. 0 disables the limitation */
+static unsigned prefetch_inflight_time;
 
 void _starpu_init_data_request_lists(void)
 {
 	unsigned i, j;
 	enum _starpu_data_request_inout k;
+
+#ifdef STARPU_SIMGRID
+	aggregate_max_requests = 0;
+	stripe_max_sources = 0;
+#else
+	aggregate_max_requests = starpu_getenv_number_default("STARPU_TRANSFER_AGGREGATE_MAX_REQUESTS", 32);
+	if (aggregate_max_requests < 2)
+		aggregate_max_requests = 0;
+	stripe_max_sources = starpu_getenv_number_default("STARPU_TRANSFER_STRIPE_MAX_SOURCES", 4);
+	if (stripe_max_sources < 2)
+		stripe_max_sources = 0;
+	if (stripe_max_sources > STARPU_MAXNODES)
+		stripe_max_sources = STARPU_MAXNODES;
+#endif
+	aggregate_max_size = starpu_getenv_number_default("STARPU_TRANSFER_AGGREGATE_MAX_SIZE", 64*1024);
+	stripe_min_size = starpu_getenv_number_default("STARPU_TRANSFER_STRIPE_MIN_SIZE", 4*1024*1024);
+	prefetch_inflight_time = starpu_getenv_number_default("STARPU_PREFETCH_INFLIGHT_TIME", 10000);
 	for (i = 0; i < STARPU_MAXNODES; i++)
 	{
 		struct _starpu_node *node = _starpu_get_node_struct(i);
@@ -54,7 +88,9 @@ void _starpu_init_data_request_lists(void)
 				STARPU_PTHREAD_MUTEX_INIT(&node->data_requests_pending_list_mutex[j][k], NULL);
 			}
 		}
+		node->prefetch_inflight_bytes = 0;
 		STARPU_HG_DISABLE_CHECKING(node->data_requests_npending);
+		STARPU_HG_DISABLE_CHECKING(node->prefetch_inflight_bytes);
 	}
 }
 
@@ -165,6 +201,9 @@ struct _starpu_data_request *_starpu_create_data_request(starpu_data_handle_t ha
 	r->async_channel.starpu_mp_common_finished_receiver = 0;
 	r->async_channel.polling_node_sender = NULL;
 	r->async_channel.polling_node_receiver = NULL;
+	r->async_channel.batch = NULL;
+	r->async_channel.batch_joined = 0;
+	r->async_channel.stripes = NULL;
 	memset(&r->async_channel.event, 0, sizeof(r->async_channel.event));
 	if (handling_node == -1)
 		handling_node = STARPU_MAIN_RAM;
@@ -201,6 +240,8 @@ struct _starpu_data_request *_starpu_create_data_request(starpu_data_handle_t ha
 	r->next_req_count = 0;
 	r->callbacks = NULL;
 	r->com_id = 0;
+	r->queued_bytes = 0;
+	r->inflight_bytes = 0;
 
 	_starpu_spin_lock(&r->lock);
 
@@ -343,6 +384,82 @@ int _starpu_wait_data_request_completion(struct _starpu_data_request *r, enum _s
 	return retval;
 }
 
+/* Account the transfer of r in the queue of its bus, except for idle requests,
+ * which will not delay the others. Requests of other tasks for the same
+ * replicate will just wait for the first transfer, so only one is accounted. */
+static void queue_request_bytes(struct _starpu_data_request *r)
+{
+	unsigned src_node = r->src_replicate->memory_node;
+	unsigned dst_node = r->dst_replicate->memory_node;
+
+	_starpu_spin_checklocked(&r->handle->header_lock);
+	if (src_node != dst_node && r->prefetch < STARPU_IDLEFETCH
+		&& !r->queued_bytes && !r->dst_replicate->queued_request)
+	{
+		r->queued_bytes = _starpu_data_get_size(r->handle);
+		r->dst_replicate->queued_request = r;
+		_starpu_bus_queue_bytes(src_node, dst_node, r->queued_bytes);
+	}
+}
+
+/* Whether prefetch request r may start now: the prefetches in flight to its
+ * destination node are limited to what its link can transfer in
+ * prefetch_inflight_time, and to half of the memory available there. One
+ * prefetch is always let in, whatever its size. */
+static int prefetch_admitted(struct _starpu_data_request *r)
+{
+	unsigned src_node, dst_node;
+	unsigned long inflight;
+	starpu_ssize_t available;
+	double bandwidth, max_bytes = HUGE_VAL;
+
+	if (!prefetch_inflight_time || !(r->mode & STARPU_R) || !r->dst_replicate)
+		return 1;
+
+	src_node = r->src_replicate->memory_node;
+	dst_node = r->dst_replicate->memory_node;
+	if (src_node == dst_node)
+		return 1;
+
+	/* This is racy, but this is only a heuristic */
+	inflight = _starpu_get_node_struct(dst_node)->prefetch_inflight_bytes;
+	if (!inflight)
+		return 1;
+
+	bandwidth = starpu_transfer_bandwidth(src_node, dst_node);
+	if (bandwidth > 0.)
+		/* MB/s is B/µs */
+		max_bytes = bandwidth * prefetch_inflight_time;
+	available = starpu_memory_get_available(dst_node);
+	if (available >= 0 && available / 2 < max_bytes)
+		max_bytes = available / 2;
+
+	return inflight + _starpu_data_get_size(r->handle) <= max_bytes;
+}
+
+/* Account the transfer of r in the prefetches in flight to its destination if
+ * it is a prefetch, until its completion */
+static void prefetch_inflight_start(struct _starpu_data_request *r)
+{
+	unsigned dst_node = r->dst_replicate->memory_node;
+
+	if (r->prefetch > STARPU_FETCH && (r->mode & STARPU_R)
+		&& (unsigned) r->src_replicate->memory_node != dst_node)
+	{
+		r->inflight_bytes = _starpu_data_get_size(r->handle);
+		(void) STARPU_ATOMIC_ADDL(&_starpu_get_node_struct(dst_node)->prefetch_inflight_bytes, (unsigned long) r->inflight_bytes);
+	}
+}
+
+static void prefetch_inflight_end(struct _starpu_data_request *r)
+{
+	if (r->inflight_bytes)
+	{
+		(void) STARPU_ATOMIC_ADDL(&_starpu_get_node_struct(r->dst_replicate->memory_node)->prefetch_inflight_bytes, -(unsigned long) r->inflight_bytes);
+		r->inflight_bytes = 0;
+	}
+}
+
 /* this is non blocking */
 void _starpu_post_data_request(struct _starpu_data_request *r)
 {
@@ -361,6 +478,7 @@ void _starpu_post_data_request(struct _starpu_data_request *r)
 	{
 		STARPU_ASSERT(r->src_replicate->allocated || r->src_replicate->mapped != STARPU_UNMAPPED);
 		STARPU_ASSERT(r->src_replicate->refcnt);
+		queue_request_bytes(r);
 	}
 
 	/* insert the request in the proper list */
@@ -416,6 +534,14 @@ static void starpu_handle_data_request_completion(struct _starpu_data_request *r
 		_starpu_update_data_state(handle, r->dst_replicate, mode);
 		dst_replicate->load_request = NULL;
 
+		if (r->inflight_bytes && r->prefetch > STARPU_FETCH && !r->next_req_count)
+		{
+			/* Nobody needed it yet, see whether it gets used
+			 * before being dropped */
+			dst_replicate->prefetched = 1;
+			dst_replicate->prefetched_from = src_replicate->memory_node;
+		}
+
 #ifdef STARPU_MEMORY_STATS
 		if (src_replicate->state == STARPU_INVALID)
 		{
@@ -446,6 +572,11 @@ static void starpu_handle_data_request_completion(struct _starpu_data_request *r
 		_STARPU_TRACE_END_DRIVER_COPY(src_node, dst_node, size, r->com_id, r->prefetch);
 	}
 #endif
+	if (_starpu_tracebuf_enabled && r->canceled < 2 && r->com_id > 0)
+	{
+		size_t size = _starpu_data_get_size(handle);
+		_STARPU_TRACEBUF_END_DRIVER_COPY(src_replicate->memory_node, dst_replicate->memory_node, size, r->com_id);
+	}
 
 	/* Once the request has been fulfilled, we may submit the requests that
 	 * were chained to that request. */
@@ -466,6 +597,23 @@ static void starpu_handle_data_request_completion(struct _starpu_data_request *r
 		_starpu_wake_all_blocked_workers_on_node(dst_replicate->memory_node);
 #endif
 
+	if (r->queued_bytes)
+	{
+		STARPU_ASSERT(dst_replicate->queued_request == r);
+		dst_replicate->queued_request = NULL;
+		_starpu_bus_dequeue_bytes(src_replicate->memory_node, dst_replicate->memory_node, r->queued_bytes);
+		r->queued_bytes = 0;
+	}
+
+	prefetch_inflight_end(r);
+
+	if (r->async_channel.stripes)
+	{
+		/* Release the additional sources */
+		_starpu_copy_stripes_free(handle, r->async_channel.stripes);
+		r->async_channel.stripes = NULL;
+	}
+
 	/* Remove a reference on the destination replicate for the request */
 	if (dst_replicate)
 	{
@@ -533,6 +681,33 @@ void _starpu_data_request_complete_wait(void *arg)
 	starpu_handle_data_request_completion(r);
 }
 
+/* If request r is a large transfer and other valid replicates can provide
+ * parts of the data in parallel with its source, make its copy striped over
+ * them */
+static void stripe_request(struct _starpu_data_request *r)
+{
+	starpu_data_handle_t handle = r->handle;
+	unsigned src_nodes[STARPU_MAXNODES];
+	double weights[STARPU_MAXNODES];
+	unsigned nsrc;
+
+	if (!stripe_max_sources
+		|| !(r->mode & STARPU_R)
+		|| r->async_channel.batch
+		|| starpu_asynchronous_copy_disabled()
+		|| starpu_asynchronous_copy_disabled_for(starpu_node_get_kind(r->dst_replicate->memory_node))
+		|| r->src_replicate->memory_node == r->dst_replicate->memory_node
+		|| _starpu_data_get_size(handle) < stripe_min_size)
+		return;
+
+	nsrc = _starpu_select_stripe_src_nodes(handle, r->src_replicate->memory_node, r->dst_replicate->memory_node,
+					       r->handling_node, stripe_max_sources, src_nodes, weights);
+	if (nsrc < 2)
+		return;
+
+	r->async_channel.stripes = _starpu_copy_stripes_new(handle, src_nodes, weights, nsrc);
+}
+
 /* TODO : accounting to see how much time was spent working for other people ... */
 static int starpu_handle_data_request(struct _starpu_data_request *r, enum _starpu_may_alloc may_alloc)
 {
@@ -623,8 +798,12 @@ static int starpu_handle_data_request(struct _starpu_data_request *r, enum _star
 
 
 	if (dst_replicate && dst_replicate->state == STARPU_INVALID)
+	{
+		stripe_request(r);
+		prefetch_inflight_start(r);
 		r->retval = _starpu_driver_copy_data_1_to_1(handle, src_replicate,
 						    dst_replicate, !(r_mode & STARPU_R), r, may_alloc, r->prefetch);
+	}
 	else
 		/* Already valid actually, no need to transfer anything */
 		r->retval = 0;
@@ -634,6 +813,15 @@ static int starpu_handle_data_request(struct _starpu_data_request *r, enum _star
 		/* If there was not enough memory, we will try to redo the
 		 * request later. */
 
+		if (r->async_channel.stripes)
+		{
+			/* The sources will be selected again on next try */
+			_starpu_copy_stripes_free(handle, r->async_channel.stripes);
+			r->async_channel.stripes = NULL;
+		}
+
+		prefetch_inflight_end(r);
+
 		if (r->prefetch > STARPU_FETCH)
 		{
 			STARPU_ASSERT(r->added_ref);
@@ -670,9 +858,31 @@ static int starpu_handle_data_request(struct _starpu_data_request *r, enum _star
 	return 0;
 }
 
+/* Whether the transfer of request r may be aggregated with others */
+static int may_aggregate(struct _starpu_data_request *r)
+{
+	return aggregate_max_requests
+		&& (r->mode & STARPU_R)
+		&& r->src_replicate && r->dst_replicate
+		&& r->src_replicate->memory_node != r->dst_replicate->memory_node
+		&& _starpu_data_get_size(r->handle) <= aggregate_max_size;
+}
+
+/* Number of requests of a batch beyond the first one, which do not count in
+ * the limit of pending requests, since the batch is one transfer */
+static unsigned batch_extra(struct _starpu_copy_batch *batch)
+{
+	unsigned nrequests = batch ? _starpu_copy_batch_nrequests(batch) : 0;
+	return nrequests ? nrequests - 1 : 0;
+}
+
 static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_list reqlist[STARPU_MAXNODES][2], unsigned handling_node, unsigned peer_node, enum _starpu_data_request_inout inout, enum _starpu_may_alloc may_alloc, unsigned n, unsigned *pushed, enum starpu_is_prefetch prefetch)
 {
 	struct _starpu_data_request *r;
+	/* Batch being filled with small transfers, and number of extra
+	 * requests in the batches already submitted */
+	struct _starpu_copy_batch *batch = NULL;
+	unsigned batched = 0;
 	unsigned i;
 	int ret = 0;
 
@@ -704,8 +914,9 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 	STARPU_PTHREAD_MUTEX_LOCK(&node_struct->data_requests_list_mutex[peer_node][inout]);
 #endif
 
+	/* Take more requests if we may aggregate them */
 	for (i = node_struct->data_requests_npending[peer_node][inout];
-		i < n && ! _starpu_data_request_prio_list_empty(&reqlist[peer_node][inout]);
+		i < n + aggregate_max_requests && ! _starpu_data_request_prio_list_empty(&reqlist[peer_node][inout]);
 		i++)
 	{
 		r = _starpu_data_request_prio_list_pop_front_highest(&reqlist[peer_node][inout]);
@@ -731,7 +942,7 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 	{
 		int res;
 
-		if (node_struct->data_requests_npending[peer_node][inout] >= n)
+		if (node_struct->data_requests_npending[peer_node][inout] >= n + batched + batch_extra(batch))
 		{
 			/* Too many requests at the same time, skip pushing
 			 * more for now */
@@ -741,6 +952,35 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 
 		r = _starpu_data_request_list_pop_front(&local_list);
 
+		if (prefetch > STARPU_FETCH && r->prefetch > STARPU_FETCH && !prefetch_admitted(r))
+		{
+			/* Enough prefetches are in flight to that node, keep
+			 * this one for later */
+			_starpu_data_request_list_push_back(&remain_list, r);
+			ret = -EBUSY;
+			break;
+		}
+
+		/* Aggregation stage: small transfers between the same nodes
+		 * get recorded in a batch, which is transferred at once */
+		r->async_channel.batch = NULL;
+		r->async_channel.batch_joined = 0;
+		if (may_aggregate(r))
+		{
+			unsigned src_node = r->src_replicate->memory_node;
+			unsigned dst_node = r->dst_replicate->memory_node;
+
+			if (batch && !_starpu_copy_batch_match(batch, src_node, dst_node))
+			{
+				batched += batch_extra(batch);
+				_starpu_copy_batch_submit(batch);
+				batch = NULL;
+			}
+			if (!batch)
+				batch = _starpu_copy_batch_new(src_node, dst_node);
+			r->async_channel.batch = batch;
+		}
+
 		res = starpu_handle_data_request(r, may_alloc);
 		if (res != 0 && res != -EAGAIN)
 		{
@@ -755,6 +995,13 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 		else
 			(*pushed)++;
 
+		if (batch && _starpu_copy_batch_nrequests(batch) >= aggregate_max_requests)
+		{
+			batched += batch_extra(batch);
+			_starpu_copy_batch_submit(batch);
+			batch = NULL;
+		}
+
 		if (starpu_timing_now() - start >= MAX_PUSH_TIME)
 		{
 			/* We have spent a lot of time doing requests, skip pushing more for now */
@@ -763,6 +1010,10 @@ static int __starpu_handle_node_data_requests(struct _starpu_data_request_prio_l
 		}
 	}
 
+	if (batch)
+		/* Start the transfer of the requests which joined the batch */
+		_starpu_copy_batch_submit(batch);
+
 	/* Gather remainder */
 	_starpu_data_request_list_push_list_back(&remain_list, &local_list);
 
@@ -1020,6 +1271,9 @@ void _starpu_update_prefetch_status(struct _starpu_data_request *r, enum starpu_
 
 	if (found)
 	{
+		if (r->mode & STARPU_R)
+			/* Not idle any more */
+			queue_request_bytes(r);
 		if (prefetch > STARPU_FETCH)
 			_starpu_data_request_prio_list_push_back(&node_struct->prefetch_requests[r->peer_node][r->inout],r);
 		else
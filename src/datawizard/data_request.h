@@ -93,7 +93,9 @@ LIST_TYPE(_starpu_data_request,
 	/** Whether we have already added our reference to the dst replicate. */
 	unsigned added_ref:1;
 
-	/** Whether the request was canceled before being handled (because the transfer already happened another way). */
+	/** Whether the request was canceled before being handled (because the
+	 * transfer already happened another way, or the task it was prefetching
+	 * for is executed on another node). */
 	unsigned canceled:2;
 
 	/** Whether this is just a prefetch request */
@@ -128,6 +130,14 @@ LIST_TYPE(_starpu_data_request,
 	struct _starpu_callback_list *callbacks;
 
 	unsigned long com_id;
+
+	/** Number of bytes accounted in the queue of the bus by
+	 * _starpu_post_data_request, until completion */
+	size_t queued_bytes;
+
+	/** Number of bytes accounted in the prefetches in flight to the
+	 * destination node, see prefetch_admitted */
+	size_t inflight_bytes;
 )
 PRIO_LIST_TYPE(_starpu_data_request, prio)
 
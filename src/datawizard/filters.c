@@ -266,6 +266,10 @@ static void _starpu_data_partition(starpu_data_handle_t initial_handle, starpu_d
 		child->active = inherit_state;
 
 		child->home_node = initial_handle->home_node;
+		child->numa_policy = initial_handle->numa_policy;
+		child->numa_node = initial_handle->numa_node;
+		child->numa_home_node = initial_handle->numa_home_node;
+		child->numa_current = initial_handle->numa_current;
 		child->wt_mask = initial_handle->wt_mask;
 
 		child->aliases = initial_handle->aliases;
@@ -21,6 +21,7 @@
 #include <datawizard/memory_nodes.h>
 #include <datawizard/memstats.h>
 #include <datawizard/malloc.h>
+#include <datawizard/numa_migration.h>
 #include <core/dependencies/data_concurrency.h>
 #include <common/knobs.h>
 #include <common/starpu_spinlock.h>
@@ -144,6 +145,9 @@ static void _starpu_register_new_data(starpu_data_handle_t handle, int home_node
 	handle->footprint = _starpu_compute_data_footprint(handle);
 
 	handle->home_node = home_node;
+	handle->numa_node = -1;
+	handle->numa_home_node = -1;
+	handle->numa_current = -1;
 
 	handle->wt_mask = wt_mask;
 
@@ -503,6 +507,8 @@ void _starpu_data_free_interfaces(starpu_data_handle_t handle)
 	if (handle->ops->unregister_data_handle)
 		handle->ops->unregister_data_handle(handle);
 
+	_starpu_numa_migration_free(handle);
+
 	for (node = 0; node < STARPU_MAXNODES; node++)
 		free(handle->per_node[node].data_interface);
 
@@ -969,6 +975,7 @@ static void _starpu_data_invalidate(void *data)
 
 		if (local->state != STARPU_INVALID)
 			_STARPU_TRACE_DATA_STATE_INVALID(handle, node);
+		_starpu_data_replicate_drop_prefetch(handle, local);
 		local->state = STARPU_INVALID;
 		local->initialized = 0;
 	}
@@ -1099,6 +1106,14 @@ int starpu_data_get_home_node(starpu_data_handle_t handle)
 	return handle->home_node;
 }
 
+int starpu_data_get_numa_home_node(starpu_data_handle_t handle)
+{
+	if (handle->home_node == -1)
+		/* Report where the placement policy put the data, if anywhere */
+		return handle->numa_home_node;
+	return handle->home_node;
+}
+
 void starpu_data_set_coordinates_array(starpu_data_handle_t handle, unsigned dimensions, int dims[])
 {
 	unsigned i;
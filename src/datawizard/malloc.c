@@ -58,6 +58,13 @@ static size_t _malloc_align = sizeof(void*);
 static int disable_pinning;
 static int enable_suballocator;
 
+/* Global NUMA placement policy, set by STARPU_NUMA_POLICY */
+static enum starpu_data_numa_policy numa_policy = STARPU_DATA_NUMA_BIND;
+/* NUMA placement of the allocations made by the current thread, set by
+ * _starpu_malloc_set_numa_placement */
+static starpu_pthread_key_t numa_placement_key;
+static int numa_placement_key_created;
+
 /* This file is used for implementing "folded" allocation */
 #ifdef STARPU_SIMGRID
 static int bogusfile = -1;
@@ -83,6 +90,70 @@ void starpu_malloc_set_hooks(starpu_malloc_hook _malloc_hook, starpu_free_hook _
 	free_hook = _free_hook;
 }
 
+void _starpu_malloc_set_numa_placement(enum starpu_data_numa_policy policy, int numa_node)
+{
+	uintptr_t value = 0;
+	if (policy != STARPU_DATA_NUMA_DEFAULT)
+		value = ((uintptr_t) (numa_node + 1) << 8) | policy;
+	STARPU_PTHREAD_SETSPECIFIC(numa_placement_key, (void *) value);
+}
+
+enum starpu_data_numa_policy _starpu_malloc_get_numa_policy(enum starpu_data_numa_policy policy)
+{
+	if (policy == STARPU_DATA_NUMA_DEFAULT)
+		return numa_policy;
+	return policy;
+}
+
+#ifdef STARPU_HAVE_HWLOC
+/* Get the placement of the allocations of the current thread, as a hwloc
+ * nodeset and policy. Returns 0 if they should just follow the memory node. */
+static int get_numa_placement(hwloc_topology_t hwtopology, hwloc_const_nodeset_t *nodeset, hwloc_membind_policy_t *policy)
+{
+	uintptr_t value = (uintptr_t) STARPU_PTHREAD_GETSPECIFIC(numa_placement_key);
+	enum starpu_data_numa_policy placement = value ? (enum starpu_data_numa_policy) (value & 0xff) : numa_policy;
+	int numa_node = value ? (int) (value >> 8) - 1 : -1;
+	hwloc_obj_t obj;
+
+	switch (placement)
+	{
+		case STARPU_DATA_NUMA_INTERLEAVE:
+			*nodeset = hwloc_topology_get_topology_nodeset(hwtopology);
+			*policy = HWLOC_MEMBIND_INTERLEAVE;
+			return 1;
+		case STARPU_DATA_NUMA_FIRST_TOUCH:
+			*nodeset = hwloc_topology_get_topology_nodeset(hwtopology);
+			*policy = HWLOC_MEMBIND_FIRSTTOUCH;
+			return 1;
+		default:
+			if (numa_node < 0)
+				return 0;
+			obj = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, numa_node);
+			if (!obj)
+				return 0;
+			*nodeset = obj->nodeset;
+			*policy = HWLOC_MEMBIND_BIND;
+			return 1;
+	}
+}
+
+#if !defined(STARPU_SIMGRID) && defined(STARPU_HAVE_POSIX_MEMALIGN)
+/* Whether the allocations of the current thread need their pages to be bound
+ * while a single memory node covers several NUMA nodes. First touch is what
+ * malloc already gives. */
+static int single_memnode_numa_placement(hwloc_const_nodeset_t *nodeset, hwloc_membind_policy_t *policy)
+{
+	struct _starpu_machine_config *config = _starpu_get_machine_config();
+	hwloc_topology_t hwtopology = config->topology.hwtopology;
+
+	return starpu_memory_nodes_get_numa_count() == 1
+		&& hwloc_get_nbobjs_by_type(hwtopology, HWLOC_OBJ_NUMANODE) > 1
+		&& get_numa_placement(hwtopology, nodeset, policy)
+		&& *policy != HWLOC_MEMBIND_FIRSTTOUCH;
+}
+#endif
+#endif
+
 void starpu_malloc_set_align(size_t align)
 {
 	STARPU_ASSERT_MSG(!(align & (align - 1)), "Alignment given to starpu_malloc_set_align (%lu) must be a power of two", (unsigned long) align);
@@ -187,6 +258,10 @@ int _starpu_malloc_willpin_on_node(unsigned dst_node)
 int _starpu_malloc_flags_on_node(unsigned dst_node, void **A, size_t dim, int flags)
 {
 	int ret=0;
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID) && defined(STARPU_HAVE_POSIX_MEMALIGN)
+	hwloc_const_nodeset_t bind_nodeset;
+	hwloc_membind_policy_t bind_policy;
+#endif
 
 	STARPU_ASSERT_MSG(A, "starpu_malloc needs to be passed the address of the pointer to be filled");
 	if (!starpu_is_initialized())
@@ -201,7 +276,9 @@ int _starpu_malloc_flags_on_node(unsigned dst_node, void **A, size_t dim, int fl
 				size_t reclaim = 2 * dim;
 				_STARPU_DEBUG("There is not enough memory left, we are going to reclaim %ld\n", (long)reclaim);
 				_STARPU_TRACE_START_MEMRECLAIM(dst_node,0);
+				_STARPU_TRACEBUF_START_MEMRECLAIM(dst_node,0);
 				freed = _starpu_memory_reclaim_generic(dst_node, 0, reclaim, STARPU_FETCH);
+				_STARPU_TRACEBUF_END_MEMRECLAIM(dst_node,0);
 				_STARPU_TRACE_END_MEMRECLAIM(dst_node,0);
 				if (freed < dim && !(flags & STARPU_MEMORY_WAIT))
 				{
@@ -479,17 +556,50 @@ int _starpu_malloc_flags_on_node(unsigned dst_node, void **A, size_t dim, int fl
 	{
 		struct _starpu_machine_config *config = _starpu_get_machine_config();
 		hwloc_topology_t hwtopology = config->topology.hwtopology;
-		hwloc_obj_t numa_node_obj = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, starpu_memory_nodes_numa_id_to_hwloclogid(dst_node));
-		hwloc_bitmap_t nodeset = numa_node_obj->nodeset;
+		hwloc_const_nodeset_t nodeset;
+		hwloc_membind_policy_t policy;
+		if (!get_numa_placement(hwtopology, &nodeset, &policy))
+		{
+			hwloc_obj_t numa_node_obj = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, starpu_memory_nodes_numa_id_to_hwloclogid(dst_node));
+			nodeset = numa_node_obj->nodeset;
+			policy = HWLOC_MEMBIND_BIND;
+		}
 #if HWLOC_API_VERSION >= 0x00020000
-		*A = hwloc_alloc_membind(hwtopology, dim, nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_BYNODESET | HWLOC_MEMBIND_NOCPUBIND);
+		*A = hwloc_alloc_membind(hwtopology, dim, nodeset, policy, HWLOC_MEMBIND_BYNODESET | HWLOC_MEMBIND_NOCPUBIND);
 #else
-		*A = hwloc_alloc_membind_nodeset(hwtopology, dim, nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_NOCPUBIND);
+		*A = hwloc_alloc_membind_nodeset(hwtopology, dim, nodeset, policy, HWLOC_MEMBIND_NOCPUBIND);
 #endif
 		//fprintf(stderr, "Allocation %lu bytes on NUMA node %d [%p]\n", (unsigned long) dim, starpu_memnode_get_numaphysid(dst_node), *A);
 		if (!*A)
 			ret = -ENOMEM;
 	}
+#if !defined(STARPU_SIMGRID) && defined(STARPU_HAVE_POSIX_MEMALIGN)
+	else if (single_memnode_numa_placement(&bind_nodeset, &bind_policy))
+	{
+		/* A single memory node covers all the NUMA nodes, we can only
+		 * apply the placement policy to the pages themselves. Use whole
+		 * pages so as not to rebind the neighbouring allocations, and
+		 * keep the free path a plain free(). */
+		struct _starpu_machine_config *config = _starpu_get_machine_config();
+		hwloc_topology_t hwtopology = config->topology.hwtopology;
+		size_t page_size = sysconf(_SC_PAGESIZE);
+		size_t size = (dim + page_size - 1) & ~(page_size - 1);
+
+		if (posix_memalign(A, page_size > _malloc_align ? page_size : _malloc_align, size))
+		{
+			ret = -ENOMEM;
+			*A = NULL;
+		}
+		/* The pages may have already been touched by a previous
+		 * allocation, thus move them */
+#if HWLOC_API_VERSION >= 0x00020000
+		else if (hwloc_set_area_membind(hwtopology, *A, size, bind_nodeset, bind_policy, HWLOC_MEMBIND_BYNODESET | HWLOC_MEMBIND_NOCPUBIND | HWLOC_MEMBIND_MIGRATE) < 0)
+#else
+		else if (hwloc_set_area_membind_nodeset(hwtopology, *A, size, bind_nodeset, bind_policy, HWLOC_MEMBIND_NOCPUBIND | HWLOC_MEMBIND_MIGRATE) < 0)
+#endif
+			_STARPU_DEBUG("could not apply NUMA placement to %p: %s\n", *A, strerror(errno));
+	}
+#endif
 #endif /* STARPU_HAVE_HWLOC */
 	else
 #ifdef STARPU_HAVE_POSIX_MEMALIGN
@@ -851,6 +961,21 @@ _starpu_malloc_init(unsigned dst_node)
 	STARPU_PTHREAD_MUTEX_INIT(&node_struct->chunk_mutex, NULL);
 	disable_pinning = starpu_getenv_number("STARPU_DISABLE_PINNING");
 	enable_suballocator = starpu_getenv_number_default("STARPU_SUBALLOCATOR", 1);
+
+	if (!numa_placement_key_created)
+	{
+		/* Kept for the whole process */
+		STARPU_PTHREAD_KEY_CREATE(&numa_placement_key, NULL);
+		numa_placement_key_created = 1;
+	}
+	char *policy = starpu_getenv("STARPU_NUMA_POLICY");
+	numa_policy = STARPU_DATA_NUMA_BIND;
+	if (policy && !strcmp(policy, "interleave"))
+		numa_policy = STARPU_DATA_NUMA_INTERLEAVE;
+	else if (policy && !strcmp(policy, "first-touch"))
+		numa_policy = STARPU_DATA_NUMA_FIRST_TOUCH;
+	else if (policy && strcmp(policy, "bind"))
+		_STARPU_DISP("Warning: unknown STARPU_NUMA_POLICY value '%s', using 'bind'\n", policy);
 	node_struct->malloc_on_node_default_flags = STARPU_MALLOC_PINNED | STARPU_MALLOC_COUNT;
 #ifdef STARPU_SIMGRID
 	/* Reasonably "costless" */
@@ -25,6 +25,15 @@ void _starpu_malloc_init(unsigned dst_node);
 void _starpu_malloc_shutdown(unsigned dst_node);
 
 int _starpu_malloc_flags_on_node(unsigned dst_node, void **A, size_t dim, int flags);
+
+/**
+ * Set the NUMA placement to be used by the CPU allocations of the current
+ * thread, until it is reset with STARPU_DATA_NUMA_DEFAULT, which means using
+ * the global policy.
+ */
+void _starpu_malloc_set_numa_placement(enum starpu_data_numa_policy policy, int numa_node);
+/** Resolve STARPU_DATA_NUMA_DEFAULT into the global policy */
+enum starpu_data_numa_policy _starpu_malloc_get_numa_policy(enum starpu_data_numa_policy policy);
 int _starpu_free_flags_on_node(unsigned dst_node, void *A, size_t dim, int flags);
 
 /**
@@ -18,6 +18,7 @@
 #include <datawizard/memory_manager.h>
 #include <datawizard/memory_nodes.h>
 #include <datawizard/memalloc.h>
+#include <datawizard/malloc.h>
 #include <datawizard/footprint.h>
 #include <core/disk.h>
 #include <core/topology.h>
@@ -336,6 +337,7 @@ static int STARPU_ATTRIBUTE_WARN_UNUSED_RESULT transfer_subtree_to_node(starpu_d
 			/* some other node may have the copy */
 			if (src_replicate->state != STARPU_INVALID)
 				_STARPU_TRACE_DATA_STATE_INVALID(handle, src_node);
+			_starpu_data_replicate_drop_prefetch(handle, src_replicate);
 			src_replicate->state = STARPU_INVALID;
 
 			/* count the number of copies */
@@ -1071,6 +1073,11 @@ size_t _starpu_memory_reclaim_generic(unsigned node, unsigned force, size_t recl
 		}
 	}
 
+	/* let the driver release what it keeps aside */
+	const struct _starpu_node_ops *node_ops = _starpu_memory_node_get_node_ops(node);
+	if (node_ops && node_ops->reclaim)
+		freed += node_ops->reclaim(node);
+
 	/* remove all buffers for which there was a removal request */
 	freed += flush_memchunk_cache(node, reclaim);
 
@@ -1078,6 +1085,10 @@ size_t _starpu_memory_reclaim_generic(unsigned node, unsigned force, size_t recl
 	if (force || (reclaim && freed<reclaim))
 		freed += free_potentially_in_use_mc(node, force, reclaim, is_prefetch);
 
+	/* the driver may have kept some of the buffers freed above */
+	if (force && node_ops && node_ops->reclaim)
+		freed += node_ops->reclaim(node);
+
 	return freed;
 
 }
@@ -1332,7 +1343,9 @@ void starpu_memchunk_tidy(unsigned node)
 	}
 
 	_STARPU_TRACE_START_MEMRECLAIM(node,2);
+	_STARPU_TRACEBUF_START_MEMRECLAIM(node,2);
 	free_potentially_in_use_mc(node, 0, amount, STARPU_PREFETCH);
+	_STARPU_TRACEBUF_END_MEMRECLAIM(node,2);
 	_STARPU_TRACE_END_MEMRECLAIM(node,2);
 out:
 	(void) STARPU_ATOMIC_ADD(&node_struct->tidying, -1);
@@ -1501,7 +1514,9 @@ static starpu_ssize_t _starpu_allocate_interface(starpu_data_handle_t handle, st
 #ifdef STARPU_USE_ALLOCATION_CACHE
 	if (!prefetch_oom)
 		_STARPU_TRACE_START_ALLOC_REUSE(dst_node, data_size, handle, is_prefetch);
-	if (try_to_find_reusable_mc(dst_node, handle, replicate, footprint))
+	/* Cached buffers may not follow the NUMA placement of the handle */
+	if ((handle->numa_policy == STARPU_DATA_NUMA_DEFAULT || starpu_node_get_kind(dst_node) != STARPU_CPU_RAM)
+		&& try_to_find_reusable_mc(dst_node, handle, replicate, footprint))
 	{
 		_starpu_allocation_cache_hit(dst_node);
 		if (!prefetch_oom)
@@ -1539,7 +1554,11 @@ static starpu_ssize_t _starpu_allocate_interface(starpu_data_handle_t handle, st
 		if (!prefetch_oom)
 			_STARPU_TRACE_START_ALLOC(dst_node, data_size, handle, is_prefetch);
 
+		if (handle->numa_policy != STARPU_DATA_NUMA_DEFAULT)
+			_starpu_malloc_set_numa_placement(handle->numa_policy, handle->numa_node);
 		allocated_memory = handle->ops->allocate_data_on_node(data_interface, dst_node);
+		if (handle->numa_policy != STARPU_DATA_NUMA_DEFAULT)
+			_starpu_malloc_set_numa_placement(STARPU_DATA_NUMA_DEFAULT, -1);
 		if (!prefetch_oom)
 			_STARPU_TRACE_END_ALLOC(dst_node, handle, allocated_memory);
 
@@ -1587,7 +1606,9 @@ static starpu_ssize_t _starpu_allocate_interface(starpu_data_handle_t handle, st
 			}
 			/* That was not enough, we have to really reclaim */
 			_STARPU_TRACE_START_MEMRECLAIM(dst_node,is_prefetch);
+			_STARPU_TRACEBUF_START_MEMRECLAIM(dst_node,is_prefetch);
 			freed = _starpu_memory_reclaim_generic(dst_node, 0, reclaim, is_prefetch);
+			_STARPU_TRACEBUF_END_MEMRECLAIM(dst_node,is_prefetch);
 			_STARPU_TRACE_END_MEMRECLAIM(dst_node,is_prefetch);
 
 			if (!freed && is_prefetch >= STARPU_FETCH)
@@ -1646,9 +1667,17 @@ static starpu_ssize_t _starpu_allocate_interface(starpu_data_handle_t handle, st
 		allocated_memory = 0;
 	}
 	else
+	{
 		/* Install newly-allocated interface */
 		memcpy(replicate->data_interface, data_interface, handle->ops->interface_size);
 
+		if (handle->home_node == -1 && handle->numa_home_node == -1
+			&& starpu_node_get_kind(dst_node) == STARPU_CPU_RAM
+			&& _starpu_malloc_get_numa_policy(handle->numa_policy) == STARPU_DATA_NUMA_FIRST_TOUCH)
+			/* The first CPU replicate is where the pages will be touched first */
+			handle->numa_home_node = dst_node;
+	}
+
 out:
 	return allocated_memory;
 }
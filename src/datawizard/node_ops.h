@@ -19,6 +19,7 @@
 
 /** @file */
 
+#include <limits.h>
 #include <starpu.h>
 #include <common/config.h>
 #include <datawizard/copy_driver.h>
@@ -76,6 +77,75 @@ typedef int (*copy3d_data_t)(uintptr_t src_ptr, size_t src_offset, unsigned src_
 				size_t numblocks_2, size_t ld2_src, size_t ld2_dst,
 				struct _starpu_async_channel *async_channel);
 
+/** A piece of a vectored copy: \p size bytes at offset \p src_offset from the
+ * source pointer go to offset \p dst_offset from the destination pointer */
+struct _starpu_copy_vec
+{
+	size_t src_offset;
+	size_t dst_offset;
+	size_t size;
+};
+
+/** Maximum number of pieces to pass to a single readv/writev call */
+#ifdef IOV_MAX
+#define _STARPU_IOV_MAX IOV_MAX
+#else
+#define _STARPU_IOV_MAX 1024
+#endif
+
+/** This is like copy_data_t, except that the \p nvec pieces of data described
+ * by \p vec are to be transferred from \p src_ptr in node \p src_node to \p
+ * dst_ptr in node \p dst_node. The pieces which are contiguous on both sides
+ * have already been merged, but runs of pieces may still be contiguous on one
+ * side, typically a strided matrix tile being transferred to a contiguous
+ * buffer, so that they can be transferred with a single scatter/gather
+ * operation. */
+typedef int (*copyv_data_t)(uintptr_t src_ptr, unsigned src_node,
+				uintptr_t dst_ptr, unsigned dst_node,
+				const struct _starpu_copy_vec *vec, unsigned nvec,
+				struct _starpu_async_channel *async_channel);
+
+/** Return the number of pieces, at most \p max, at the beginning of \p vec
+ * which are contiguous on the source */
+static inline unsigned _starpu_copy_vec_src_run(const struct _starpu_copy_vec *vec, unsigned nvec, unsigned max)
+{
+	unsigned n = 1;
+	while (n < nvec && n < max && vec[n].src_offset == vec[n-1].src_offset + vec[n-1].size)
+		n++;
+	return n;
+}
+
+/** Return the number of pieces, at most \p max, at the beginning of \p vec
+ * which are contiguous on the destination */
+static inline unsigned _starpu_copy_vec_dst_run(const struct _starpu_copy_vec *vec, unsigned nvec, unsigned max)
+{
+	unsigned n = 1;
+	while (n < nvec && n < max && vec[n].dst_offset == vec[n-1].dst_offset + vec[n-1].size)
+		n++;
+	return n;
+}
+
+/** A piece of a batch of transfers: \p size bytes at offset \p src_offset
+ * from buffer \p src in the source node go to offset \p dst_offset from buffer
+ * \p dst in the destination node */
+struct _starpu_copy_batch_piece
+{
+	uintptr_t src;
+	size_t src_offset;
+	uintptr_t dst;
+	size_t dst_offset;
+	size_t size;
+};
+
+/** Transfer the \p npieces pieces of data described by \p pieces from node
+ * \p src_node to node \p dst_node. These are typically small pieces of
+ * different data, aggregated from several requests, which the driver can
+ * transfer at once instead of paying the latency of a transfer for each of
+ * them. Pieces which are contiguous on both sides have already been merged. */
+typedef int (*copy_batch_data_t)(const struct _starpu_copy_batch_piece *pieces, unsigned npieces,
+				 unsigned src_node, unsigned dst_node,
+				 struct _starpu_async_channel *async_channel);
+
 /** Map \p size bytes of data from \p src (plus offset \p src_offset) in node \p src_node
  * on node \p dst_node. If successful, return the resulting pointer, otherwise fill *ret */
 typedef uintptr_t (*map_t)(uintptr_t src, size_t src_offset, unsigned src_node, unsigned dst_node, size_t size, int *ret);
@@ -126,6 +196,30 @@ struct _starpu_node_ops
 	 * This method is optional.  */
 	copy3d_data_t copy3d_data_from[STARPU_MAX_RAM+1];
 
+	/** Request copying a list of pieces of data (e.g. the rows of a matrix
+	 * tile with an ld) from this type of node to another type of node,
+	 * when copy2d_data_to or copy3d_data_to are not available.
+	 * This method is optional.  */
+	copyv_data_t copyv_data_to[STARPU_MAX_RAM+1];
+
+	/** Request copying a list of pieces of data (e.g. the rows of a matrix
+	 * tile with an ld) to this type of node from another type of node,
+	 * when copy2d_data_from or copy3d_data_from are not available.
+	 * This method is optional.  */
+	copyv_data_t copyv_data_from[STARPU_MAX_RAM+1];
+
+	/** Request copying a batch of pieces of different data, aggregated
+	 * from several requests, from this type of node to another type of
+	 * node.
+	 * This method is optional.  */
+	copy_batch_data_t copy_batch_data_to[STARPU_MAX_RAM+1];
+
+	/** Request copying a batch of pieces of different data, aggregated
+	 * from several requests, to this type of node from another type of
+	 * node.
+	 * This method is optional.  */
+	copy_batch_data_t copy_batch_data_from[STARPU_MAX_RAM+1];
+
 	/** Wait for the completion of asynchronous request \p async_channel.  */
 	void (*wait_request_completion)(struct _starpu_async_channel *async_channel);
 	/** Test whether asynchronous request \p async_channel has completed.  */
@@ -148,6 +242,10 @@ struct _starpu_node_ops
 	/** Free data \p addr, which was a previous allocation of \p size bytes
 	 * of data on node \p dst_node with flags \p flags*/
 	void (*free_on_node)(unsigned dst_node, uintptr_t addr, size_t size, int flags);
+	/** Release the memory that the driver keeps aside on node \p dst_node
+	 * for its own purpose, and return the amount that was released.
+	 * This method is optional */
+	size_t (*reclaim)(unsigned dst_node);
 
 	/** Map data a piece of data to this type of node from another type of node.
 	 * This method is optional */
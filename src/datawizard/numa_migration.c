@@ -0,0 +1,325 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Background migration of the pages of CPU data between NUMA nodes.
+ *
+ * When a single memory node covers several NUMA nodes (i.e. STARPU_USE_NUMA
+ * is not set), StarPU never copies data between them, and the pages of a
+ * buffer stay where they were first touched. We count the accesses of CPU
+ * workers to each handle per NUMA node, and when the accesses of a window
+ * mostly come from another NUMA node than the one which we last moved the
+ * data to, we let a background thread migrate the pages there.
+ *
+ * With STARPU_USE_NUMA, each NUMA node is a memory node of its own, and the
+ * coherency protocol already moves the data where it is needed.
+ */
+
+#include <common/config.h>
+#include <common/list.h>
+#include <core/workers.h>
+#include <common/knobs.h>
+#include <core/topology.h>
+#include <datawizard/coherency.h>
+#include <datawizard/memory_nodes.h>
+#include <datawizard/malloc.h>
+#include <datawizard/numa_migration.h>
+#include <datawizard/interfaces/data_interface.h>
+
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID)
+#include <hwloc.h>
+#if HWLOC_API_VERSION < 0x00010b00
+#define HWLOC_OBJ_NUMANODE HWLOC_OBJ_NODE
+#endif
+#define NUMA_MIGRATION_SUPPORTED
+#endif
+
+int _starpu_numa_migration_enabled;
+
+/* Number of accesses after which we decide whether to migrate a handle */
+static unsigned threshold;
+/* Fraction of the accesses which a NUMA node has to issue to get the data */
+#define DOMINANT_NUM 3
+#define DOMINANT_DEN 4
+
+static int64_t migrated_bytes;
+static int64_t migrations;
+
+/* global counters */
+static int __g_migrated_bytes;
+static int __g_migrations;
+
+static void global_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context == NULL); /* no context for the global updater */
+	(void)context;
+
+	_starpu_perf_counter_sample_set_int64_value(sample, __g_migrated_bytes, migrated_bytes);
+	_starpu_perf_counter_sample_set_int64_value(sample, __g_migrations, migrations);
+}
+
+void _starpu__numa_migration_c__register_counters(void)
+{
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+		__STARPU_PERF_COUNTER_REG("starpu.numa", scope, g_migrated_bytes, int64, "number of bytes of data pages migrated between NUMA nodes by the page migrator (since StarPU initialization)");
+		__STARPU_PERF_COUNTER_REG("starpu.numa", scope, g_migrations, int64, "number of data migrations between NUMA nodes performed by the page migrator (since StarPU initialization)");
+
+		_starpu_perf_counter_register_updater(scope, global_sample_updater);
+	}
+}
+
+#ifdef NUMA_MIGRATION_SUPPORTED
+LIST_TYPE(_starpu_numa_migration,
+	starpu_data_handle_t handle;
+	unsigned node;
+	int target;
+);
+
+static hwloc_topology_t hwtopology;
+static unsigned nnuma;
+/* NUMA node (hwloc logical index) of each worker, -1 for non-CPU workers */
+static int *worker_numa;
+static size_t page_size;
+
+static starpu_pthread_t migration_thread;
+static starpu_pthread_mutex_t migration_mutex;
+static starpu_pthread_cond_t migration_cond;
+static struct _starpu_numa_migration_list migration_queue;
+static int migration_running;
+
+static void migrate(struct _starpu_numa_migration *m)
+{
+	starpu_data_handle_t handle = m->handle;
+	struct _starpu_data_replicate *replicate = &handle->per_node[m->node];
+	uintptr_t ptr = (uintptr_t) starpu_data_handle_to_pointer(handle, m->node);
+	size_t size = _starpu_data_get_alloc_size(handle);
+	hwloc_obj_t obj = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, m->target);
+
+	if (ptr && obj)
+	{
+		/* We can only move the pages which are entirely ours */
+		uintptr_t start = (ptr + page_size - 1) & ~(page_size - 1);
+		uintptr_t end = (ptr + size) & ~(page_size - 1);
+		if (end > start)
+		{
+#if HWLOC_API_VERSION >= 0x00020000
+			if (hwloc_set_area_membind(hwtopology, (void *) start, end - start, obj->nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_BYNODESET | HWLOC_MEMBIND_MIGRATE | HWLOC_MEMBIND_NOCPUBIND) == 0)
+#else
+			if (hwloc_set_area_membind_nodeset(hwtopology, (void *) start, end - start, obj->nodeset, HWLOC_MEMBIND_BIND, HWLOC_MEMBIND_MIGRATE | HWLOC_MEMBIND_NOCPUBIND) == 0)
+#endif
+			{
+				(void) STARPU_ATOMIC_ADD64(&migrated_bytes, end - start);
+				(void) STARPU_ATOMIC_ADD64(&migrations, 1);
+			}
+			else
+				_STARPU_DEBUG("could not migrate %p to NUMA node %d: %s\n", (void *) start, m->target, strerror(errno));
+		}
+	}
+
+	_starpu_spin_lock(&handle->header_lock);
+	/* Even if we failed, do not retry before the next window */
+	handle->numa_current = m->target;
+	handle->numa_migration_pending = 0;
+	replicate->refcnt--;
+	STARPU_ASSERT(handle->busy_count > 0);
+	handle->busy_count--;
+	if (!_starpu_data_check_not_busy(handle))
+		_starpu_spin_unlock(&handle->header_lock);
+}
+
+static void *migration_func(void *arg)
+{
+	(void) arg;
+	starpu_pthread_setname("numa migrator");
+
+	STARPU_PTHREAD_MUTEX_LOCK(&migration_mutex);
+	while (1)
+	{
+		struct _starpu_numa_migration *m;
+
+		while (migration_running && _starpu_numa_migration_list_empty(&migration_queue))
+			STARPU_PTHREAD_COND_WAIT(&migration_cond, &migration_mutex);
+		if (_starpu_numa_migration_list_empty(&migration_queue))
+			/* Not running any more, and nothing left to release */
+			break;
+
+		m = _starpu_numa_migration_list_pop_front(&migration_queue);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&migration_mutex);
+
+		migrate(m);
+		_starpu_numa_migration_delete(m);
+
+		STARPU_PTHREAD_MUTEX_LOCK(&migration_mutex);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&migration_mutex);
+
+	return NULL;
+}
+#endif /* NUMA_MIGRATION_SUPPORTED */
+
+void _starpu_numa_migration_init(void)
+{
+	migrated_bytes = 0;
+	migrations = 0;
+
+	if (!starpu_getenv_number_default("STARPU_NUMA_MIGRATION", 0))
+		return;
+
+#ifdef NUMA_MIGRATION_SUPPORTED
+	struct _starpu_machine_config *config = _starpu_get_machine_config();
+	unsigned nworkers = starpu_worker_get_count();
+	unsigned workerid;
+	long ps;
+
+	if (starpu_memory_nodes_get_numa_count() > 1)
+	{
+		_STARPU_DEBUG("NUMA nodes are memory nodes, the page migrator is not needed\n");
+		return;
+	}
+
+	hwtopology = config->topology.hwtopology;
+	nnuma = hwloc_get_nbobjs_by_type(hwtopology, HWLOC_OBJ_NUMANODE);
+	if (nnuma <= 1)
+	{
+		_STARPU_DEBUG("only one NUMA node, the page migrator is not needed\n");
+		return;
+	}
+
+	ps = sysconf(_SC_PAGESIZE);
+	page_size = ps > 0 ? ps : 4096;
+
+	threshold = starpu_getenv_number_default("STARPU_NUMA_MIGRATION_THRESHOLD", 16);
+	if (threshold == 0)
+		threshold = 1;
+
+	_STARPU_MALLOC(worker_numa, nworkers * sizeof(*worker_numa));
+	for (workerid = 0; workerid < nworkers; workerid++)
+	{
+		struct _starpu_worker *worker = _starpu_get_worker_struct(workerid);
+		hwloc_obj_t obj = NULL;
+
+		worker_numa[workerid] = -1;
+		if (worker->arch == STARPU_CPU_WORKER && worker->bindid >= 0)
+			obj = hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_PU, worker->bindid);
+		if (obj)
+			obj = _starpu_numa_get_obj(obj);
+		if (obj)
+			worker_numa[workerid] = obj->logical_index;
+	}
+
+	_starpu_numa_migration_list_init(&migration_queue);
+	STARPU_PTHREAD_MUTEX_INIT(&migration_mutex, NULL);
+	STARPU_PTHREAD_COND_INIT(&migration_cond, NULL);
+	migration_running = 1;
+	STARPU_PTHREAD_CREATE(&migration_thread, NULL, migration_func, NULL);
+
+	_starpu_numa_migration_enabled = 1;
+#else
+	_STARPU_DISP("Warning: the NUMA page migrator needs hwloc, STARPU_NUMA_MIGRATION is ignored\n");
+#endif
+}
+
+void _starpu_numa_migration_shutdown(void)
+{
+	if (!_starpu_numa_migration_enabled)
+		return;
+
+#ifdef NUMA_MIGRATION_SUPPORTED
+	_starpu_numa_migration_enabled = 0;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&migration_mutex);
+	migration_running = 0;
+	STARPU_PTHREAD_COND_SIGNAL(&migration_cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&migration_mutex);
+	STARPU_PTHREAD_JOIN(migration_thread, NULL);
+
+	STARPU_PTHREAD_MUTEX_DESTROY(&migration_mutex);
+	STARPU_PTHREAD_COND_DESTROY(&migration_cond);
+	free(worker_numa);
+	worker_numa = NULL;
+#endif
+}
+
+void __starpu_numa_migration_record(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate, unsigned node, int workerid)
+{
+#ifdef NUMA_MIGRATION_SUPPORTED
+	enum starpu_data_numa_policy policy = _starpu_malloc_get_numa_policy(handle->numa_policy);
+	unsigned numa, dominant;
+	int numa_worker;
+
+	if (starpu_node_get_kind(node) != STARPU_CPU_RAM
+		|| replicate != &handle->per_node[node]
+		|| !handle->ops->to_pointer
+		/* The application asked for a given placement, either for the
+		 * handle or with STARPU_NUMA_POLICY. Binding without a NUMA
+		 * node just follows the memory node, which covers them all */
+		|| (policy == STARPU_DATA_NUMA_BIND && handle->numa_node >= 0)
+		|| policy == STARPU_DATA_NUMA_INTERLEAVE)
+		return;
+
+	numa_worker = worker_numa[workerid];
+	if (numa_worker < 0)
+		return;
+
+	if (!handle->numa_accesses)
+		_STARPU_CALLOC(handle->numa_accesses, nnuma, sizeof(*handle->numa_accesses));
+	handle->numa_accesses[numa_worker]++;
+	if (++handle->numa_naccesses < threshold)
+		return;
+
+	/* End of the window, check whether a NUMA node dominates */
+	dominant = 0;
+	for (numa = 1; numa < nnuma; numa++)
+		if (handle->numa_accesses[numa] > handle->numa_accesses[dominant])
+			dominant = numa;
+
+	if (handle->numa_accesses[dominant] * DOMINANT_DEN >= handle->numa_naccesses * DOMINANT_NUM
+		&& (int) dominant != handle->numa_current
+		&& !handle->numa_migration_pending
+		&& replicate->allocated && replicate->initialized)
+	{
+		struct _starpu_numa_migration *m = _starpu_numa_migration_new();
+		m->handle = handle;
+		m->node = node;
+		m->target = dominant;
+
+		/* Keep the replicate and the handle alive until migrated */
+		handle->numa_migration_pending = 1;
+		replicate->refcnt++;
+		handle->busy_count++;
+
+		STARPU_PTHREAD_MUTEX_LOCK(&migration_mutex);
+		_starpu_numa_migration_list_push_back(&migration_queue, m);
+		STARPU_PTHREAD_COND_SIGNAL(&migration_cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&migration_mutex);
+	}
+
+	memset(handle->numa_accesses, 0, nnuma * sizeof(*handle->numa_accesses));
+	handle->numa_naccesses = 0;
+#else
+	(void) handle;
+	(void) replicate;
+	(void) node;
+	(void) workerid;
+#endif
+}
+
+void _starpu_numa_migration_free(starpu_data_handle_t handle)
+{
+	free(handle->numa_accesses);
+	handle->numa_accesses = NULL;
+}
@@ -0,0 +1,51 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __NUMA_MIGRATION_H__
+#define __NUMA_MIGRATION_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <common/config.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_data_replicate;
+
+/** Whether the NUMA page migrator is running, see STARPU_NUMA_MIGRATION */
+extern int _starpu_numa_migration_enabled;
+
+void _starpu_numa_migration_init(void);
+void _starpu_numa_migration_shutdown(void);
+
+/** Account an access by CPU worker \p workerid to \p replicate of \p handle,
+ * and queue the handle for migration if another NUMA node dominates its
+ * accesses. The header lock of the handle must be held. */
+void __starpu_numa_migration_record(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate, unsigned node, int workerid);
+
+static inline void _starpu_numa_migration_record(starpu_data_handle_t handle, struct _starpu_data_replicate *replicate, unsigned node, int workerid)
+{
+	if (STARPU_UNLIKELY(_starpu_numa_migration_enabled))
+		__starpu_numa_migration_record(handle, replicate, node, workerid);
+}
+
+/** Free the access statistics of \p handle */
+void _starpu_numa_migration_free(starpu_data_handle_t handle);
+
+#pragma GCC visibility pop
+
+#endif // __NUMA_MIGRATION_H__
@@ -797,6 +797,17 @@ unsigned starpu_data_get_ooc_flag(starpu_data_handle_t handle)
 	return handle->ooc;
 }
 
+void starpu_data_set_numa_policy(starpu_data_handle_t handle, enum starpu_data_numa_policy policy, int numa_node)
+{
+	handle->numa_policy = policy;
+	handle->numa_node = policy == STARPU_DATA_NUMA_BIND ? numa_node : -1;
+	if (handle->numa_node >= 0)
+		/* This is where the data will be */
+		handle->numa_home_node = starpu_memory_nodes_numa_hwloclogid_to_id(handle->numa_node);
+	else
+		handle->numa_home_node = -1;
+}
+
 /* By default, sequential consistency is enabled */
 static unsigned default_sequential_consistency_flag = 1;
 
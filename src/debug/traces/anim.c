@@ -22,7 +22,7 @@
 #include "starpu_fxt.h"
 
 #ifdef STARPU_USE_FXT
-static struct component
+static _STARPU_FXT_PER_FILE struct component
 {
 	UT_hash_handle hh;
 	char *name;
@@ -35,10 +35,10 @@ static struct component
 	unsigned npriotasks;
 } *components;
 
-static unsigned global_state = 1;
-static unsigned nsubmitted;
-static unsigned curq_size;
-static unsigned nflowing;
+static _STARPU_FXT_PER_FILE unsigned global_state = 1;
+static _STARPU_FXT_PER_FILE unsigned nsubmitted;
+static _STARPU_FXT_PER_FILE unsigned curq_size;
+static _STARPU_FXT_PER_FILE unsigned nflowing;
 
 #define COMPONENT_ADD(head, field, add) HASH_ADD(hh, head, field, sizeof(uint64_t), add);
 #define COMPONENT_FIND(head, find, out) HASH_FIND(hh, head, &find, sizeof(uint64_t), out);
@@ -357,10 +357,15 @@ void _starpu_fxt_component_print_header(FILE *file)
 	fprintf(file, "\t<body>\n");
 }
 
-static void fxt_component_print_step(FILE *file, struct starpu_fxt_options *options, double timestamp, int workerid, unsigned push, struct component *from, struct component *to)
+static void fxt_component_print_state(FILE *file)
 {
 	fprintf(file, "\t\t<div id='et%u' style='display:%s;'><center><!-- Étape %u -->\n",
 			global_state, global_state > 1 ? "none":"block", global_state);
+}
+
+static void fxt_component_print_step(FILE *file, struct starpu_fxt_options *options, double timestamp, int workerid, unsigned push, struct component *from, struct component *to)
+{
+	fxt_component_print_state(file);
 	fprintf(file, "\t\t<p>Time %f, %u submitted %u ready, %s</p>\n", timestamp, nsubmitted, curq_size-nflowing, push?"push":"pull");
 	//fprintf(file, "\t\t\t<tt><pre>\n");
 	//_starpu_fxt_component_dump(file);
@@ -371,6 +376,36 @@ static void fxt_component_print_step(FILE *file, struct starpu_fxt_options *opti
 	global_state++;
 }
 
+/* Exchange the current state number with \p state, to let a trace file write
+ * its own steps */
+void _starpu_fxt_component_swap_state(unsigned *state)
+{
+	unsigned s = global_state;
+
+	global_state = *state;
+	*state = s;
+}
+
+/* Append the steps written by a trace file, renumbering them after ours */
+void _starpu_fxt_component_append(FILE *output, FILE *file)
+{
+	char *line = NULL;
+	size_t size = 0;
+
+	rewind(file);
+	while (getline(&line, &size, file) != -1)
+	{
+		if (!strncmp(line, "\t\t<div id='et", 13))
+		{
+			fxt_component_print_state(output);
+			global_state++;
+		}
+		else
+			fputs(line, output);
+	}
+	free(line);
+}
+
 void _starpu_fxt_component_connect(uint64_t parent, uint64_t child)
 {
 	struct component *parent_p, *child_p;
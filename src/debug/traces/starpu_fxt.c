@@ -31,6 +31,9 @@
 #ifdef STARPU_USE_FXT
 #include "starpu_fxt.h"
 #include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
 #include <starpu_hash.h>
 
 #define CPUS_WORKER_COLORS_NB	8
@@ -42,13 +45,13 @@
 
 static char *cpus_worker_colors[CPUS_WORKER_COLORS_NB] = {"/greens9/7", "/greens9/6", "/greens9/5", "/greens9/4",  "/greens9/9", "/greens9/3",  "/greens9/2",  "/greens9/1"  };
 static char *accel_worker_colors[ACCEL_WORKER_COLORS_NB] = {"/ylorrd9/9", "/ylorrd9/6", "/ylorrd9/3", "/ylorrd9/1", "/ylorrd9/8", "/ylorrd9/7", "/ylorrd9/4", "/ylorrd9/2",  "/ylorrd9/1"};
-static char *worker_colors[STARPU_NMAXWORKERS];
+static _STARPU_FXT_PER_FILE char **worker_colors;
 
-static unsigned cpus_index = 0;
-static unsigned accel_index = 0;
-static uint64_t* number_events = NULL;
+static _STARPU_FXT_PER_FILE unsigned cpus_index;
+static _STARPU_FXT_PER_FILE unsigned accel_index;
+static _STARPU_FXT_PER_FILE uint64_t* number_events;
 
-static unsigned long fut_keymask;
+static _STARPU_FXT_PER_FILE unsigned long fut_keymask;
 
 /* Get pointer to string starting at nth parameter */
 static char *get_fxt_string(struct fxt_ev_64 *ev, int n)
@@ -62,20 +65,89 @@ static char *get_fxt_string(struct fxt_ev_64 *ev, int n)
  * Paje trace file tools
  */
 
-static FILE *out_paje_file;
-static FILE *distrib_time;
-static FILE *activity_file;
-static FILE *anim_file;
-static FILE *tasks_file;
-static FILE *data_file;
+static _STARPU_FXT_PER_FILE FILE *out_paje_file;
+static _STARPU_FXT_PER_FILE FILE *distrib_time;
+static _STARPU_FXT_PER_FILE FILE *activity_file;
+static _STARPU_FXT_PER_FILE FILE *anim_file;
+static _STARPU_FXT_PER_FILE FILE *tasks_file;
+static _STARPU_FXT_PER_FILE FILE *data_file;
 #ifdef STARPU_PAPI
-static FILE *papi_file;
+static _STARPU_FXT_PER_FILE FILE *papi_file;
 #endif
-static FILE *trace_file;
+static _STARPU_FXT_PER_FILE FILE *trace_file;
 static FILE *comms_file;
-static FILE *sched_tasks_file;
+static _STARPU_FXT_PER_FILE FILE *sched_tasks_file;
 static FILE *number_events_file;
 
+/*
+ * Compact binary task output. Each input file gets its own temporary stream,
+ * in which records are appended sorted by date, i.e. the time when the task
+ * terminated, and its own name table. The streams are k-way merged by date
+ * into the final file once all input files are parsed.
+ */
+#define STARPU_FXT_TASKS_BIN_MAGIC	"STPUFXB"
+#define STARPU_FXT_TASKS_BIN_VERSION	1
+
+struct tasks_bin_record
+{
+	double date;
+	double submit_time;
+	double start_time;
+	double end_time;
+	uint64_t job_id;
+	uint64_t footprint;
+	uint64_t kflops;
+	int32_t workerid;
+	int32_t mpi_rank;
+	int32_t node;
+	uint32_t name;
+};
+
+struct tasks_bin_name
+{
+	UT_hash_handle hh;
+	char *name;
+	uint32_t idx;
+};
+
+static _STARPU_FXT_PER_FILE FILE *tasks_bin_stream;
+static _STARPU_FXT_PER_FILE struct tasks_bin_name *tasks_bin_names;
+static _STARPU_FXT_PER_FILE uint32_t tasks_bin_nnames;
+/* Records waiting to be sorted when not streaming tasks */
+static _STARPU_FXT_PER_FILE struct tasks_bin_record *tasks_bin_records;
+static _STARPU_FXT_PER_FILE unsigned long tasks_bin_nrecords;
+
+/*
+ * What the parsing of each trace file produced. When there are several trace
+ * files, they are parsed concurrently, each of them into its own temporary
+ * outputs, which are merged into the final outputs once all files are parsed.
+ */
+struct _starpu_fxt_file_output
+{
+	FILE *out_paje_file;
+	FILE *distrib_time;
+	FILE *activity_file;
+	FILE *anim_file;
+	FILE *tasks_file;
+	FILE *data_file;
+#ifdef STARPU_PAPI
+	FILE *papi_file;
+#endif
+	FILE *trace_file;
+	FILE *sched_tasks_file;
+	FILE *dag_file;
+	unsigned dag_cluster_cnt;
+	unsigned anim_state;
+	uint64_t *number_events;
+	struct starpu_fxt_codelet_event *dumped_codelets;
+	long dumped_codelets_count;
+	int nworkers;
+
+	FILE *tasks_bin_stream;
+	struct tasks_bin_name *tasks_bin_names;
+	uint32_t tasks_bin_nnames;
+};
+
 struct data_parameter_info
 {
 	unsigned long handle;
@@ -104,6 +176,8 @@ struct task_info
 	double submit_time;
 	double start_time;
 	double end_time;
+	/* When the task terminated, -1 until then */
+	double done_time;
 	unsigned long footprint;
 	unsigned long kflops;
 	long iterations[2];
@@ -116,57 +190,175 @@ struct task_info
 	unsigned long ndata;
 	struct data_parameter_info *data;
 	int mpi_rank;
+	/* Stand-in for a task already dumped by handle_task_done */
+	unsigned dumped;
 #ifdef STARPU_BUBBLE
 	unsigned is_bubble;
 	unsigned long bubble_parent;
 #endif
 };
 
-static struct task_info *tasks_info;
+static _STARPU_FXT_PER_FILE struct task_info *tasks_info;
+
+/*
+ * Sets of job ids, stored as sorted intervals, which stay small since job ids
+ * are mostly allocated and terminated in order.
+ */
+struct job_id_interval
+{
+	unsigned long first;
+	unsigned long last;
+};
+
+struct job_id_set
+{
+	struct job_id_interval *intervals;
+	unsigned n;
+	unsigned size;
+};
+
+/* Return the index of the first interval which ends at or after job_id */
+static unsigned job_id_set_find(struct job_id_set *set, unsigned long job_id)
+{
+	unsigned min = 0, max = set->n;
+
+	while (min < max)
+	{
+		unsigned mid = (min + max) / 2;
+		if (set->intervals[mid].last < job_id)
+			min = mid + 1;
+		else
+			max = mid;
+	}
+	return min;
+}
+
+static int job_id_set_contains(struct job_id_set *set, unsigned long job_id)
+{
+	unsigned i = job_id_set_find(set, job_id);
+	return i < set->n && set->intervals[i].first <= job_id;
+}
+
+static void job_id_set_add(struct job_id_set *set, unsigned long job_id)
+{
+	unsigned i = job_id_set_find(set, job_id);
+
+	if (i < set->n && set->intervals[i].first <= job_id)
+		/* Already there */
+		return;
+
+	if (i > 0 && set->intervals[i-1].last + 1 == job_id)
+	{
+		/* Extend the previous interval */
+		set->intervals[i-1].last = job_id;
+		if (i < set->n && set->intervals[i].first == job_id + 1)
+		{
+			/* And merge it with the next one */
+			set->intervals[i-1].last = set->intervals[i].last;
+			memmove(&set->intervals[i], &set->intervals[i+1], (set->n - i - 1) * sizeof(set->intervals[0]));
+			set->n--;
+		}
+		return;
+	}
+
+	if (i < set->n && set->intervals[i].first == job_id + 1)
+	{
+		/* Extend the next interval */
+		set->intervals[i].first = job_id;
+		return;
+	}
+
+	if (set->n == set->size)
+	{
+		set->size = set->size ? set->size * 2 : 16;
+		_STARPU_REALLOC(set->intervals, set->size * sizeof(set->intervals[0]));
+	}
+	memmove(&set->intervals[i+1], &set->intervals[i], (set->n - i) * sizeof(set->intervals[0]));
+	set->intervals[i].first = set->intervals[i].last = job_id;
+	set->n++;
+}
+
+static void job_id_set_clear(struct job_id_set *set)
+{
+	free(set->intervals);
+	set->intervals = NULL;
+	set->n = 0;
+	set->size = 0;
+}
+
+/* Tasks already dumped by handle_task_done, and those of them which were not
+ * shown in the DAG */
+static _STARPU_FXT_PER_FILE struct job_id_set dumped_tasks;
+static _STARPU_FXT_PER_FILE struct job_id_set hidden_tasks;
+/* Stand-in returned by get_task for the dumped tasks */
+static _STARPU_FXT_PER_FILE struct task_info *dumped_task;
+
+static void task_free_fields(struct task_info *task);
+
+static void task_init(struct task_info *task, unsigned long job_id, int mpi_rank)
+{
+	unsigned i;
+
+	task->model_name = NULL;
+	task->name = NULL;
+	task->file = NULL;
+	task->line = -1;
+	task->exclude_from_dag = 0;
+	task->show = 0;
+	task->type = 0;
+	task->job_id = job_id;
+	task->submit_order = 0;
+	task->priority = 0;
+	task->color = 0;
+	task->tag = 0;
+	task->workerid = -1;
+	task->node = -1;
+	task->submit_time = 0.;
+	task->start_time = 0.;
+	task->end_time = 0.;
+	task->done_time = -1.;
+	task->footprint = 0;
+	task->kflops = 0.;
+	for (i = 0; i < sizeof(task->iterations)/sizeof(task->iterations[0]); i++)
+		task->iterations[i] = -1;
+	task->parameters = NULL;
+	task->ndeps = 0;
+	task->dependencies = NULL;
+	task->nend_deps = 0;
+	task->end_dependencies = NULL;
+	task->dep_labels = NULL;
+	task->ndata = 0;
+	task->data = NULL;
+	task->mpi_rank = mpi_rank;
+	task->dumped = 0;
+#ifdef STARPU_BUBBLE
+	task->is_bubble = 0;
+	task->bubble_parent = 0;
+#endif
+}
 
 static struct task_info *get_task(unsigned long job_id, int mpi_rank)
 {
 	struct task_info *task;
 
 	HASH_FIND(hh, tasks_info, &job_id, sizeof(job_id), task);
+	if (!task && job_id_set_contains(&dumped_tasks, job_id))
+	{
+		/* Late reference to a task which was already dumped, only
+		 * remember whether it was shown */
+		if (dumped_task)
+			task_free_fields(dumped_task);
+		else
+			_STARPU_MALLOC(dumped_task, sizeof(*dumped_task));
+		task_init(dumped_task, job_id, mpi_rank);
+		dumped_task->show = !job_id_set_contains(&hidden_tasks, job_id);
+		dumped_task->dumped = 1;
+		return dumped_task;
+	}
 	if (!task)
 	{
-		unsigned i;
 		_STARPU_MALLOC(task, sizeof(*task));
-		task->model_name = NULL;
-		task->name = NULL;
-		task->file = NULL;
-		task->line = -1;
-		task->exclude_from_dag = 0;
-		task->show = 0;
-		task->type = 0;
-		task->job_id = job_id;
-		task->submit_order = 0;
-		task->priority = 0;
-		task->color = 0;
-		task->tag = 0;
-		task->workerid = -1;
-		task->node = -1;
-		task->submit_time = 0.;
-		task->start_time = 0.;
-		task->end_time = 0.;
-		task->footprint = 0;
-		task->kflops = 0.;
-		for (i = 0; i < sizeof(task->iterations)/sizeof(task->iterations[0]); i++)
-			task->iterations[i] = -1;
-		task->parameters = NULL;
-		task->ndeps = 0;
-		task->dependencies = NULL;
-		task->nend_deps = 0;
-		task->end_dependencies = NULL;
-		task->dep_labels = NULL;
-		task->ndata = 0;
-		task->data = NULL;
-		task->mpi_rank = mpi_rank;
-#ifdef STARPU_BUBBLE
-		task->is_bubble = 0;
-		task->bubble_parent = 0;
-#endif
+		task_init(task, job_id, mpi_rank);
 		HASH_ADD(hh, tasks_info, job_id, sizeof(task->job_id), task);
 	}
 	else
@@ -180,6 +372,9 @@ static int show_task(struct task_info *task, struct starpu_fxt_options *options)
 {
 	if (task->show)
 		return 1;
+	if (task->dumped)
+		/* This was decided when dumping it */
+		return 0;
 	if (task->type & STARPU_TASK_TYPE_INTERNAL && !options->internal)
 		return 0;
 	if (task->type & STARPU_TASK_TYPE_DATA_ACQUIRE && options->no_acquire)
@@ -218,15 +413,122 @@ void _starpu_convert_numa_nodes_bitmap_to_str(long bitmap, char* str)
 	}
 }
 
-static void task_dump(struct task_info *task, struct starpu_fxt_options *options)
+static uint32_t tasks_bin_intern(const char *name)
+{
+	struct tasks_bin_name *entry;
+
+	if (!name)
+		return 0;
+
+	HASH_FIND_STR(tasks_bin_names, name, entry);
+	if (!entry)
+	{
+		_STARPU_MALLOC(entry, sizeof(*entry));
+		entry->name = strdup(name);
+		entry->idx = ++tasks_bin_nnames;
+		HASH_ADD_KEYPTR(hh, tasks_bin_names, entry->name, strlen(entry->name), entry);
+	}
+	return entry->idx;
+}
+
+static void tasks_bin_dump(struct task_info *task, struct starpu_fxt_options *options)
+{
+	struct tasks_bin_record record;
+
+	memset(&record, 0, sizeof(record));
+	record.date = task->done_time;
+	record.submit_time = task->submit_time;
+	record.start_time = task->start_time;
+	record.end_time = task->end_time;
+	record.job_id = task->job_id;
+	record.footprint = task->footprint;
+	record.kflops = task->kflops;
+	record.workerid = task->workerid;
+	record.mpi_rank = task->mpi_rank;
+	record.node = task->node;
+	record.name = tasks_bin_intern(task->name);
+
+	if (options->stream_tasks)
+	{
+		/* Tasks are dumped as they terminate, thus already sorted */
+		if (fwrite(&record, sizeof(record), 1, tasks_bin_stream) != 1)
+			STARPU_ABORT_MSG("Failed to write binary task record (err %s)", strerror(errno));
+		return;
+	}
+
+	if (! (tasks_bin_nrecords & (tasks_bin_nrecords - 1)))
+		/* Allocate records array by powers of two */
+		_STARPU_REALLOC(tasks_bin_records, (tasks_bin_nrecords ? tasks_bin_nrecords * 2 : 1) * sizeof(*tasks_bin_records));
+	tasks_bin_records[tasks_bin_nrecords++] = record;
+}
+
+static int tasks_bin_record_cmp(const void *_a, const void *_b)
+{
+	const struct tasks_bin_record *a = _a, *b = _b;
+
+	if (a->date != b->date)
+		return a->date < b->date ? -1 : 1;
+	if (a->job_id != b->job_id)
+		return a->job_id < b->job_id ? -1 : 1;
+	return 0;
+}
+
+/* Write the records kept by tasks_bin_dump, sorted by date */
+static void tasks_bin_flush(void)
+{
+	if (!tasks_bin_nrecords)
+		return;
+
+	qsort(tasks_bin_records, tasks_bin_nrecords, sizeof(*tasks_bin_records), tasks_bin_record_cmp);
+	if (fwrite(tasks_bin_records, sizeof(*tasks_bin_records), tasks_bin_nrecords, tasks_bin_stream) != tasks_bin_nrecords)
+		STARPU_ABORT_MSG("Failed to write binary task record (err %s)", strerror(errno));
+	free(tasks_bin_records);
+	tasks_bin_records = NULL;
+	tasks_bin_nrecords = 0;
+}
+
+/* Release everything but the task_info structure itself */
+static void task_free_fields(struct task_info *task)
+{
+	unsigned i;
+
+	free(task->name);
+	task->name = NULL;
+	free(task->model_name);
+	task->model_name = NULL;
+	free(task->file);
+	task->file = NULL;
+	free(task->dependencies);
+	task->dependencies = NULL;
+	if (task->dep_labels)
+	{
+		for (i = 0; i < task->ndeps; i++)
+			free(task->dep_labels[i]);
+		free(task->dep_labels);
+		task->dep_labels = NULL;
+	}
+	task->ndeps = 0;
+	free(task->end_dependencies);
+	task->end_dependencies = NULL;
+	task->nend_deps = 0;
+	free(task->parameters);
+	task->parameters = NULL;
+	free(task->data);
+	task->data = NULL;
+	task->ndata = 0;
+}
+
+static void task_dump_records(struct task_info *task, struct starpu_fxt_options *options)
 {
 	char *prefix = options->file_prefix;
 	unsigned i;
 
 	if (task->exclude_from_dag)
-		goto out;
+		return;
+	if (tasks_bin_stream)
+		tasks_bin_dump(task, options);
 	if (!tasks_file)
-		goto out;
+		return;
 
 	if (task->name)
 		fprintf(tasks_file, "Name: %s\n", task->name);
@@ -325,20 +627,12 @@ static void task_dump(struct task_info *task, struct starpu_fxt_options *options
 		fprintf(tasks_file, "%lu ", task->end_dependencies[task->nend_deps-1]);
 	}
 	fprintf(tasks_file, "\n");
+}
 
-out:
-	free(task->name);
-	free(task->model_name);
-	free(task->file);
-	free(task->dependencies);
-	if (task->dep_labels)
-	{
-		for (i = 0; i < task->ndeps; i++)
-			free(task->dep_labels[i]);
-		free(task->dep_labels);
-	}
-	free(task->parameters);
-	free(task->data);
+static void task_dump(struct task_info *task, struct starpu_fxt_options *options)
+{
+	task_dump_records(task, options);
+	task_free_fields(task);
 	HASH_DEL(tasks_info, task);
 	free(task);
 }
@@ -359,7 +653,7 @@ struct data_info
 	long mpi_tag;
 };
 
-static struct data_info *data_info;
+static _STARPU_FXT_PER_FILE struct data_info *data_info;
 
 static struct data_info *get_data(unsigned long handle, int mpi_rank)
 {
@@ -500,30 +794,33 @@ static unsigned get_color_symbol_blue(char *name)
 	return (unsigned)starpu_hash_crc32c_string("blue", hash_symbol) % 1024;
 }
 
+/* The per-worker arrays below have STARPU_NMAXWORKERS entries, they are
+ * allocated by parse_state_init to keep the thread-local storage small */
+
 /* Start time of last codelet for this worker */
-static double last_codelet_start[STARPU_NMAXWORKERS];
+static _STARPU_FXT_PER_FILE double *last_codelet_start;
 /* End time of last codelet for this worker */
-static double last_codelet_end[STARPU_NMAXWORKERS];
+static _STARPU_FXT_PER_FILE double *last_codelet_end;
 /* _STARPU_FUT_DO_PROBE5STR records only 3 longs */
-char _starpu_last_codelet_symbol[STARPU_NMAXWORKERS][(FXT_MAX_PARAMS-5)*sizeof(unsigned long)];
-static int last_codelet_parameter[STARPU_NMAXWORKERS];
+_STARPU_FXT_PER_FILE char (*_starpu_last_codelet_symbol)[(FXT_MAX_PARAMS-5)*sizeof(unsigned long)];
+static _STARPU_FXT_PER_FILE int *last_codelet_parameter;
 #define MAX_PARAMETERS 8
-static char last_codelet_parameter_description[STARPU_NMAXWORKERS][MAX_PARAMETERS][FXT_MAX_PARAMS*sizeof(unsigned long)];
+static _STARPU_FXT_PER_FILE char (*last_codelet_parameter_description)[MAX_PARAMETERS][FXT_MAX_PARAMS*sizeof(unsigned long)];
 
 /* If more than a period of time has elapsed, we flush the profiling info,
  * otherwise they are accumulated everytime there is a new relevant event. */
 #define ACTIVITY_PERIOD	75.0
-static double last_activity_flush_timestamp[STARPU_NMAXWORKERS];
-static double accumulated_sleep_time[STARPU_NMAXWORKERS];
-static double accumulated_exec_time[STARPU_NMAXWORKERS];
+static _STARPU_FXT_PER_FILE double *last_activity_flush_timestamp;
+static _STARPU_FXT_PER_FILE double *accumulated_sleep_time;
+static _STARPU_FXT_PER_FILE double *accumulated_exec_time;
 
-static unsigned steal_number = 0;
+static _STARPU_FXT_PER_FILE unsigned steal_number;
 
 LIST_TYPE(_starpu_symbol_name,
 	char *name;
 )
 
-static struct _starpu_symbol_name_list symbol_list;
+static _STARPU_FXT_PER_FILE struct _starpu_symbol_name_list symbol_list;
 
 /* List of on-going communications */
 LIST_TYPE(_starpu_communication,
@@ -538,9 +835,9 @@ LIST_TYPE(_starpu_communication,
 	struct _starpu_communication *peer;
 )
 
-static struct _starpu_communication_list communication_list;
-static double current_bandwidth_in_per_node[STARPU_MAXNODES] = {0.0};
-static double current_bandwidth_out_per_node[STARPU_MAXNODES] = {0.0};
+static _STARPU_FXT_PER_FILE struct _starpu_communication_list communication_list;
+static _STARPU_FXT_PER_FILE double current_bandwidth_in_per_node[STARPU_MAXNODES];
+static _STARPU_FXT_PER_FILE double current_bandwidth_out_per_node[STARPU_MAXNODES];
 
 /* List of on-going computations */
 LIST_TYPE(_starpu_computation,
@@ -550,14 +847,14 @@ LIST_TYPE(_starpu_computation,
 )
 
 /* List of ongoing computations */
-static struct _starpu_computation_list computation_list;
+static _STARPU_FXT_PER_FILE struct _starpu_computation_list computation_list;
 /* Last computation for each worker */
-static struct _starpu_computation *ongoing_computation[STARPU_NMAXWORKERS];
+static _STARPU_FXT_PER_FILE struct _starpu_computation **ongoing_computation;
 
 /* Current total GFlops */
-static double current_computation;
+static _STARPU_FXT_PER_FILE double current_computation;
 /* Time of last update of current total GFlops */
-static double current_computation_time;
+static _STARPU_FXT_PER_FILE double current_computation_time;
 
 /*
  * Generic tools
@@ -725,9 +1022,9 @@ static char *scheduler_container_alias(char *output, int len, const char *prefix
 }
 #endif
 
-static int nworkers = 0;
+static _STARPU_FXT_PER_FILE int nworkers;
 
-static struct worker_entry
+static _STARPU_FXT_PER_FILE struct worker_entry
 {
 	UT_hash_handle hh;
 	unsigned long tid;
@@ -1944,8 +2241,8 @@ static void handle_codelet_details(struct fxt_ev_64 *ev, struct starpu_fxt_optio
 	}
 }
 
-static long dumped_codelets_count;
-static struct starpu_fxt_codelet_event *dumped_codelets;
+static _STARPU_FXT_PER_FILE long dumped_codelets_count;
+static _STARPU_FXT_PER_FILE struct starpu_fxt_codelet_event *dumped_codelets;
 
 static void handle_end_codelet_body(struct fxt_ev_64 *ev, struct starpu_fxt_options *options)
 {
@@ -2148,7 +2445,7 @@ static void handle_worker_status(struct fxt_ev_64 *ev, struct starpu_fxt_options
 	do_worker_set_state(get_event_time_stamp(ev, options), options->file_prefix, ev->param[1], newstatus, "Runtime");
 }
 
-static double last_sleep_start[STARPU_NMAXWORKERS];
+static _STARPU_FXT_PER_FILE double *last_sleep_start;
 
 static void handle_worker_scheduling_start(struct fxt_ev_64 *ev, struct starpu_fxt_options *options)
 {
@@ -2476,7 +2773,7 @@ static void handle_work_stealing(struct fxt_ev_64 *ev, struct starpu_fxt_options
 		char program_container[STARPU_POTI_STR_LEN];
 
 		snprintf(paje_value, sizeof(paje_value), "%u", size);
-		snprintf(paje_key, sizeof(paje_key), "steal_%u", steal_number);
+		snprintf(paje_key, sizeof(paje_key), "%ssteal_%u", prefix, steal_number);
 		program_container_alias(program_container, STARPU_POTI_STR_LEN, prefix);
 		worker_container_alias(src_worker_container, STARPU_POTI_STR_LEN, prefix, src);
 		worker_container_alias(dst_worker_container, STARPU_POTI_STR_LEN, prefix, dst);
@@ -2484,8 +2781,8 @@ static void handle_work_stealing(struct fxt_ev_64 *ev, struct starpu_fxt_options
 		poti_EndLink(time+0.000000001, program_container, "WSL", dst_worker_container, paje_value, paje_key);
 #else
 
-		fprintf(out_paje_file, "18	%.9f	WSL	%sp	%u	%sw%u	steal_%u\n", time, prefix, size, prefix, src, steal_number);
-		fprintf(out_paje_file, "19	%.9f	WSL	%sp	%u	%sw%u	steal_%u\n", time+0.000000001, prefix, size, prefix, dst, steal_number);
+		fprintf(out_paje_file, "18	%.9f	WSL	%sp	%u	%sw%u	%ssteal_%u\n", time, prefix, size, prefix, src, prefix, steal_number);
+		fprintf(out_paje_file, "19	%.9f	WSL	%sp	%u	%sw%u	%ssteal_%u\n", time+0.000000001, prefix, size, prefix, dst, prefix, steal_number);
 #endif
 	}
 
@@ -2708,8 +3005,8 @@ static void handle_task_submit_event(struct fxt_ev_64 *ev, struct starpu_fxt_opt
 /*
  *	Number of task submitted to the scheduler
  */
-static int curq_size = 0;
-static int nsubmitted = 0;
+static _STARPU_FXT_PER_FILE int curq_size;
+static _STARPU_FXT_PER_FILE int nsubmitted;
 
 static void handle_job_push(struct fxt_ev_64 *ev, struct starpu_fxt_options *options)
 {
@@ -3075,21 +3372,25 @@ static void handle_task_line(struct fxt_ev_64 *ev, struct starpu_fxt_options *op
 
 static void handle_task_done(struct fxt_ev_64 *ev, struct starpu_fxt_options *options)
 {
-	/* Ideally, we would be able to dump tasks as they terminate, to save
-	 * memory.
-	 * We however may have to change their state later, e.g. the show field,
-	 * due to dependencies added way later. */
-#if 0
 	unsigned long job_id;
 	job_id = ev->param[0];
 
 	struct task_info *task = get_task(job_id, options->file_rank);
+	if (task->dumped)
+		return;
+	task->done_time = get_event_time_stamp(ev, options);
 
+	/* When asked to, dump tasks as they terminate, to save memory.
+	 * Dependencies added later may only refer to them as predecessors, and
+	 * then only need to know whether they were shown in the DAG, so we
+	 * just keep their job id in compact sets. */
+	if (!options->stream_tasks)
+		return;
+
+	job_id_set_add(&dumped_tasks, job_id);
+	if (!show_task(task, options))
+		job_id_set_add(&hidden_tasks, job_id);
 	task_dump(task, options);
-#else
-	(void) ev;
-	(void) options;
-#endif
 }
 
 static void handle_tag_done(struct fxt_ev_64 *ev, struct starpu_fxt_options *options)
@@ -3231,7 +3532,7 @@ static void handle_mpi_isend_submit_begin(struct fxt_ev_64 *ev, struct starpu_fx
 	do_mpicommthread_set_state(date, options->file_prefix, "SdS");
 }
 
-static int mpi_warned;
+static _STARPU_FXT_PER_FILE int mpi_warned;
 static void handle_mpi_isend_submit_end(struct fxt_ev_64 *ev, struct starpu_fxt_options *options)
 {
 	unsigned type = ev->param[0];
@@ -3589,8 +3890,93 @@ void _starpu_fxt_process_computations(struct starpu_fxt_options *options)
 	}
 }
 
+/* Reset the state of the parsing for a new trace file */
+static void parse_state_init(struct starpu_fxt_options *options)
+{
+	cpus_index = 0;
+	accel_index = 0;
+	_STARPU_CALLOC(worker_colors, STARPU_NMAXWORKERS, sizeof(*worker_colors));
+	fut_keymask = 0;
+
+	_STARPU_CALLOC(last_codelet_start, STARPU_NMAXWORKERS, sizeof(*last_codelet_start));
+	_STARPU_CALLOC(last_codelet_end, STARPU_NMAXWORKERS, sizeof(*last_codelet_end));
+	_STARPU_CALLOC(_starpu_last_codelet_symbol, STARPU_NMAXWORKERS, sizeof(*_starpu_last_codelet_symbol));
+	_STARPU_CALLOC(last_codelet_parameter, STARPU_NMAXWORKERS, sizeof(*last_codelet_parameter));
+	_STARPU_CALLOC(last_codelet_parameter_description, STARPU_NMAXWORKERS, sizeof(*last_codelet_parameter_description));
+	_STARPU_CALLOC(last_activity_flush_timestamp, STARPU_NMAXWORKERS, sizeof(*last_activity_flush_timestamp));
+	_STARPU_CALLOC(accumulated_sleep_time, STARPU_NMAXWORKERS, sizeof(*accumulated_sleep_time));
+	_STARPU_CALLOC(accumulated_exec_time, STARPU_NMAXWORKERS, sizeof(*accumulated_exec_time));
+	_STARPU_CALLOC(last_sleep_start, STARPU_NMAXWORKERS, sizeof(*last_sleep_start));
+	_STARPU_CALLOC(ongoing_computation, STARPU_NMAXWORKERS, sizeof(*ongoing_computation));
+	steal_number = 0;
+	curq_size = 0;
+	nsubmitted = 0;
+	mpi_warned = 0;
+
+	_starpu_communication_list_init(&communication_list);
+	memset(current_bandwidth_in_per_node, 0, sizeof(current_bandwidth_in_per_node));
+	memset(current_bandwidth_out_per_node, 0, sizeof(current_bandwidth_out_per_node));
+	if (!options->no_flops)
+		_starpu_computation_list_init(&computation_list);
+	current_computation = 0.0;
+	current_computation_time = 0.0;
+
+	if (options->tasks_bin_path)
+	{
+		tasks_bin_stream = tmpfile();
+		if (!tasks_bin_stream)
+			STARPU_ABORT_MSG("Failed to create temporary file (err %s)", strerror(errno));
+	}
+	tasks_bin_names = NULL;
+	tasks_bin_nnames = 0;
+}
+
+static void parse_state_deinit(struct _starpu_fxt_file_output *output)
+{
+	free(worker_colors);
+	worker_colors = NULL;
+
+	free(last_codelet_start);
+	last_codelet_start = NULL;
+	free(last_codelet_end);
+	last_codelet_end = NULL;
+	free(_starpu_last_codelet_symbol);
+	_starpu_last_codelet_symbol = NULL;
+	free(last_codelet_parameter);
+	last_codelet_parameter = NULL;
+	free(last_codelet_parameter_description);
+	last_codelet_parameter_description = NULL;
+	free(last_activity_flush_timestamp);
+	last_activity_flush_timestamp = NULL;
+	free(accumulated_sleep_time);
+	accumulated_sleep_time = NULL;
+	free(accumulated_exec_time);
+	accumulated_exec_time = NULL;
+	free(last_sleep_start);
+	last_sleep_start = NULL;
+	free(ongoing_computation);
+	ongoing_computation = NULL;
+
+	if (dumped_task)
+	{
+		task_free_fields(dumped_task);
+		free(dumped_task);
+		dumped_task = NULL;
+	}
+	job_id_set_clear(&dumped_tasks);
+	job_id_set_clear(&hidden_tasks);
+
+	/* Hand the binary task output over to _starpu_fxt_tasks_bin_file_close */
+	output->tasks_bin_stream = tasks_bin_stream;
+	output->tasks_bin_names = tasks_bin_names;
+	output->tasks_bin_nnames = tasks_bin_nnames;
+	tasks_bin_stream = NULL;
+	tasks_bin_names = NULL;
+	tasks_bin_nnames = 0;
+}
+
 static
-void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *options)
+void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *options, struct _starpu_fxt_file_output *output)
 {
 	/* Open the trace file */
 	int fd_in;
@@ -3600,7 +3986,7 @@ void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *op
 		STARPU_ABORT_MSG("Failed to open '%s' (err %s)", filename_in, strerror(errno));
 	}
 
-	static fxt_t fut;
+	fxt_t fut;
 	fut = fxt_fdopen(fd_in);
 	if (!fut)
 	{
@@ -3612,11 +3998,12 @@ void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *op
 	block = fxt_blockev_enter(fut);
 
 	char *prefix = options->file_prefix;
+	uint64_t last_ev_time = 0;
+
+	parse_state_init(options);
 
 	/* TODO starttime ...*/
 	/* create the "program" container */
-	current_computation = 0.0;
-	current_computation_time = 0.0;
 	if (out_paje_file)
 	{
 #ifdef STARPU_HAVE_POTI
@@ -3674,6 +4061,7 @@ void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *op
 		{
 			break;
 		}
+		last_ev_time = ev.time;
 
 		if (number_events_file != NULL)
 		{
@@ -4472,10 +4860,16 @@ void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *op
 
 	{
 		struct task_info *task=NULL, *tmp=NULL;
+		/* Tasks which did not terminate are dumped at the date of the end of the trace */
+		double end_date = compute_time_stamp((double) last_ev_time, options);
 		HASH_ITER(hh, tasks_info, task, tmp)
 		{
+			if (task->done_time < 0.)
+				task->done_time = end_date;
 			task_dump(task, options);
 		}
+		if (tasks_bin_stream)
+			tasks_bin_flush();
 	}
 
 	for (i = 0; i < STARPU_NMAXWORKERS; i++)
@@ -4488,6 +4882,8 @@ void _starpu_fxt_parse_new_file(char *filename_in, struct starpu_fxt_options *op
 
 	free_worker_ids();
 
+	parse_state_deinit(output);
+
 #ifdef HAVE_FXT_BLOCKEV_LEAVE
 	fxt_blockev_leave(block);
 #endif
@@ -4544,6 +4940,7 @@ void _starpu_fxt_options_set_dir(struct starpu_fxt_options *options)
 	_set_dir(options->dir, &options->out_paje_path);
 	_set_dir(options->dir, &options->dag_path);
 	_set_dir(options->dir, &options->tasks_path);
+	_set_dir(options->dir, &options->tasks_bin_path);
 	_set_dir(options->dir, &options->comms_path);
 	_set_dir(options->dir, &options->number_events_path);
 	_set_dir(options->dir, &options->data_path);
@@ -4560,6 +4957,7 @@ void starpu_fxt_options_shutdown(struct starpu_fxt_options *options)
 	free(options->out_paje_path);
 	free(options->dag_path);
 	free(options->tasks_path);
+	free(options->tasks_bin_path);
 	free(options->comms_path);
 	free(options->number_events_path);
 	free(options->data_path);
@@ -4715,6 +5113,100 @@ void _starpu_fxt_papi_file_init(struct starpu_fxt_options *options)
 #endif
 }
 
+/* Merge the per-file streams by date into the final binary file */
+static
+void _starpu_fxt_tasks_bin_file_close(struct starpu_fxt_options *options, struct _starpu_fxt_file_output *outputs, unsigned noutputs)
+{
+	struct tasks_bin_record heads[noutputs];
+	int valid[noutputs];
+	uint32_t *names_map[noutputs];
+	struct tasks_bin_name *names = NULL, *entry, *tmp, *found;
+	uint32_t nnames = 0;
+	char magic[8] = STARPU_FXT_TASKS_BIN_MAGIC;
+	uint32_t version = STARPU_FXT_TASKS_BIN_VERSION;
+	uint32_t record_size = sizeof(struct tasks_bin_record);
+	unsigned i;
+	FILE *f;
+
+	if (!options->tasks_bin_path)
+		return;
+
+	f = fopen(options->tasks_bin_path, "w+");
+	if (f == NULL)
+		STARPU_ABORT_MSG("Failed to open '%s' (err %s)", options->tasks_bin_path, strerror(errno));
+
+	/* Merge the name tables of the files, in file order */
+	for (i = 0; i < noutputs; i++)
+	{
+		_STARPU_CALLOC(names_map[i], outputs[i].tasks_bin_nnames + 1, sizeof(*names_map[i]));
+		HASH_ITER(hh, outputs[i].tasks_bin_names, entry, tmp)
+		{
+			HASH_DEL(outputs[i].tasks_bin_names, entry);
+			HASH_FIND_STR(names, entry->name, found);
+			if (found)
+			{
+				names_map[i][entry->idx] = found->idx;
+				free(entry->name);
+				free(entry);
+			}
+			else
+			{
+				names_map[i][entry->idx] = ++nnames;
+				entry->idx = nnames;
+				HASH_ADD_KEYPTR(hh, names, entry->name, strlen(entry->name), entry);
+			}
+		}
+	}
+
+	/* Header and name table */
+	fwrite(magic, sizeof(magic), 1, f);
+	fwrite(&version, sizeof(version), 1, f);
+	fwrite(&record_size, sizeof(record_size), 1, f);
+	fwrite(&nnames, sizeof(nnames), 1, f);
+	HASH_ITER(hh, names, entry, tmp)
+	{
+		uint32_t len = strlen(entry->name);
+		fwrite(&entry->idx, sizeof(entry->idx), 1, f);
+		fwrite(&len, sizeof(len), 1, f);
+		fwrite(entry->name, len, 1, f);
+		HASH_DEL(names, entry);
+		free(entry->name);
+		free(entry);
+	}
+
+	/* Records, k-way merge of the streams, which are each sorted by date,
+	 * ties are broken by file order. We only ever have one record per
+	 * stream in memory. */
+	for (i = 0; i < noutputs; i++)
+	{
+		rewind(outputs[i].tasks_bin_stream);
+		valid[i] = fread(&heads[i], sizeof(heads[i]), 1, outputs[i].tasks_bin_stream) == 1;
+	}
+
+	while (1)
+	{
+		int min = -1;
+		for (i = 0; i < noutputs; i++)
+			if (valid[i] && (min == -1 || heads[i].date < heads[min].date))
+				min = i;
+		if (min == -1)
+			break;
+
+		heads[min].name = names_map[min][heads[min].name];
+		if (fwrite(&heads[min], sizeof(heads[min]), 1, f) != 1)
+			STARPU_ABORT_MSG("Failed to write to '%s' (err %s)", options->tasks_bin_path, strerror(errno));
+		valid[min] = fread(&heads[min], sizeof(heads[min]), 1, outputs[min].tasks_bin_stream) == 1;
+	}
+
+	for (i = 0; i < noutputs; i++)
+	{
+		fclose(outputs[i].tasks_bin_stream);
+		outputs[i].tasks_bin_stream = NULL;
+		free(names_map[i]);
+	}
+	fclose(f);
+}
+
 static
 void _starpu_fxt_write_trace_header(FILE *f)
 {
@@ -4831,6 +5323,22 @@ void _starpu_fxt_trace_file_close(void)
 		fclose(trace_file);
 }
 
+static
+void _starpu_fxt_symbol_list_free(void)
+{
+	struct _starpu_symbol_name *itor, *next;
+	for (itor = _starpu_symbol_name_list_begin(&symbol_list);
+		itor != _starpu_symbol_name_list_end(&symbol_list);
+		itor = next)
+	{
+		next = _starpu_symbol_name_list_next(itor);
+
+		_starpu_symbol_name_list_erase(&symbol_list, itor);
+		free(itor->name);
+		_starpu_symbol_name_delete(itor);
+	}
+}
+
 static
 void _starpu_fxt_paje_file_init(struct starpu_fxt_options *options)
 {
@@ -4865,27 +5373,14 @@ void _starpu_fxt_paje_file_init(struct starpu_fxt_options *options)
 		out_paje_file = NULL;
 	}
 
-	/* create lists for symbols (kernel states) and communications */
+	/* create list for symbols (kernel states) */
 	_starpu_symbol_name_list_init(&symbol_list);
-	_starpu_communication_list_init(&communication_list);
-	if (!options->no_flops)
-		_starpu_computation_list_init(&computation_list);
 }
 
 static
 void _starpu_fxt_paje_file_close(void)
 {
-	struct _starpu_symbol_name *itor, *next;
-	for (itor = _starpu_symbol_name_list_begin(&symbol_list);
-		itor != _starpu_symbol_name_list_end(&symbol_list);
-		itor = next)
-	{
-		next = _starpu_symbol_name_list_next(itor);
-
-		_starpu_symbol_name_list_erase(&symbol_list, itor);
-		free(itor->name);
-		_starpu_symbol_name_delete(itor);
-	}
+	_starpu_fxt_symbol_list_free();
 	if (out_paje_file)
 		fclose(out_paje_file);
 }
@@ -4901,7 +5396,7 @@ uint64_t _starpu_fxt_find_start_time(char *filename_in)
 		STARPU_ABORT_MSG("Failed to open '%s' (err %s)", filename_in, strerror(errno));
 	}
 
-	static fxt_t fut;
+	fxt_t fut;
 	fut = fxt_fdopen(fd_in);
 	if (!fut)
 	{
@@ -4934,8 +5429,383 @@ uint64_t _starpu_fxt_find_start_time(char *filename_in)
 	return (ev.time);
 }
 
+/* Run func(arg, i) for all i < n on nthreads threads, ourself included. This
+ * is an offline tool, so we use plain system threads, even in simgrid mode. */
+struct _starpu_fxt_run_arg
+{
+	void (*func)(void *arg, unsigned i);
+	void *arg;
+	unsigned n;
+	unsigned next;
+	pthread_mutex_t mutex;
+};
+
+static void *_starpu_fxt_run_thread(void *_arg)
+{
+	struct _starpu_fxt_run_arg *arg = _arg;
+
+	while (1)
+	{
+		unsigned i;
+
+		pthread_mutex_lock(&arg->mutex);
+		i = arg->next++;
+		pthread_mutex_unlock(&arg->mutex);
+
+		if (i >= arg->n)
+			break;
+
+		arg->func(arg->arg, i);
+	}
+	return NULL;
+}
+
+static void _starpu_fxt_run(unsigned nthreads, unsigned n, void (*func)(void *arg, unsigned i), void *arg)
+{
+	struct _starpu_fxt_run_arg run_arg;
+	unsigned i;
+
+	if (nthreads > n)
+		nthreads = n;
+	if (!nthreads)
+		nthreads = 1;
+
+	run_arg.func = func;
+	run_arg.arg = arg;
+	run_arg.n = n;
+	run_arg.next = 0;
+	pthread_mutex_init(&run_arg.mutex, NULL);
+
+	pthread_t threads[nthreads];
+	unsigned nstarted = 1;
+	for (i = 1; i < nthreads; i++)
+	{
+		if (pthread_create(&threads[i], NULL, _starpu_fxt_run_thread, &run_arg))
+			/* Just do with less threads */
+			break;
+		nstarted++;
+	}
+	/* Also work ourself */
+	_starpu_fxt_run_thread(&run_arg);
+	for (i = 1; i < nstarted; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_mutex_destroy(&run_arg.mutex);
+}
+
+static unsigned _starpu_fxt_nthreads(struct starpu_fxt_options *options)
+{
+	unsigned nthreads = options->nthreads;
+
+	if (!nthreads)
+	{
+#ifdef _SC_NPROCESSORS_ONLN
+		long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = ncpus > 0 ? ncpus : 1;
+#else
+		nthreads = 1;
+#endif
+	}
+	return nthreads;
+}
+
+struct _starpu_fxt_scan_files_arg
+{
+	struct starpu_fxt_options *options;
+	uint64_t *start_k;
+	struct starpu_fxt_mpi_offset *sync_barriers;
+	int *unique_keys;
+	int *rank_k;
+};
+
+/* Find the start time and synchronization points of an input file. This
+ * needs to read it entirely when it does not contain synchronization points,
+ * so we scan the files concurrently. */
+static void _starpu_fxt_scan_file(void *_arg, unsigned inputfile)
+{
+	struct _starpu_fxt_scan_files_arg *arg = _arg;
+	char *filename = arg->options->filenames[inputfile];
+
+	arg->start_k[inputfile] = _starpu_fxt_find_start_time(filename);
+	arg->sync_barriers[inputfile] = _starpu_fxt_mpi_find_sync_points(filename,
+									 &arg->unique_keys[inputfile],
+									 &arg->rank_k[inputfile]);
+}
+
+static FILE *_starpu_fxt_tmpfile(const char *path)
+{
+	FILE *file;
+
+	if (!path)
+		return NULL;
+
+	file = tmpfile();
+	if (!file)
+		STARPU_ABORT_MSG("Failed to create temporary file (err %s)", strerror(errno));
+	return file;
+}
+
+/* Create the temporary outputs into which a trace file is parsed */
+static void _starpu_fxt_file_output_init(struct _starpu_fxt_file_output *output, struct starpu_fxt_options *options)
+{
+	memset(output, 0, sizeof(*output));
+	output->out_paje_file = _starpu_fxt_tmpfile(options->out_paje_path);
+	output->distrib_time = _starpu_fxt_tmpfile(options->distrib_time_path);
+	output->activity_file = _starpu_fxt_tmpfile(options->activity_path);
+	output->anim_file = _starpu_fxt_tmpfile(options->anim_path);
+	output->tasks_file = _starpu_fxt_tmpfile(options->tasks_path);
+	output->data_file = _starpu_fxt_tmpfile(options->data_path);
+#ifdef STARPU_PAPI
+	output->papi_file = _starpu_fxt_tmpfile(options->papi_path);
+#endif
+	output->trace_file = _starpu_fxt_tmpfile(options->states_path);
+	output->sched_tasks_file = _starpu_fxt_tmpfile(options->sched_tasks_path);
+	output->dag_file = _starpu_fxt_tmpfile(options->dag_path);
+	output->anim_state = 1;
+	if (options->number_events_path)
+		_STARPU_CALLOC(output->number_events, FUT_SETUP_CODE+1, sizeof(uint64_t));
+}
+
+static void swap_file(FILE **a, FILE **b)
+{
+	FILE *tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+/* Exchange the outputs of the parsing of the current thread with the given
+ * ones */
+static void _starpu_fxt_file_output_swap(struct _starpu_fxt_file_output *output)
+{
+	uint64_t *file_number_events = number_events;
+	struct starpu_fxt_codelet_event *file_dumped_codelets = dumped_codelets;
+	long file_dumped_codelets_count = dumped_codelets_count;
+	int file_nworkers = nworkers;
+
+	swap_file(&out_paje_file, &output->out_paje_file);
+	swap_file(&distrib_time, &output->distrib_time);
+	swap_file(&activity_file, &output->activity_file);
+	swap_file(&anim_file, &output->anim_file);
+	swap_file(&tasks_file, &output->tasks_file);
+	swap_file(&data_file, &output->data_file);
+#ifdef STARPU_PAPI
+	swap_file(&papi_file, &output->papi_file);
+#endif
+	swap_file(&trace_file, &output->trace_file);
+	swap_file(&sched_tasks_file, &output->sched_tasks_file);
+	_starpu_fxt_dag_swap_output(&output->dag_file, &output->dag_cluster_cnt);
+	_starpu_fxt_component_swap_state(&output->anim_state);
+
+	number_events = output->number_events;
+	output->number_events = file_number_events;
+	dumped_codelets = output->dumped_codelets;
+	output->dumped_codelets = file_dumped_codelets;
+	dumped_codelets_count = output->dumped_codelets_count;
+	output->dumped_codelets_count = file_dumped_codelets_count;
+	nworkers = output->nworkers;
+	output->nworkers = file_nworkers;
+}
+
+static void _starpu_fxt_append_file(FILE *output, FILE *file)
+{
+	char buffer[4096];
+	size_t n;
+
+	if (!file)
+		return;
+
+	rewind(file);
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+		fwrite(buffer, 1, n, output);
+	fclose(file);
+}
+
+/* Append what the parsing of a trace file produced to the final outputs,
+ * except the Paje trace, which is merged by _starpu_fxt_paje_merge */
+static void _starpu_fxt_file_output_commit(struct starpu_fxt_options *options, struct starpu_fxt_options *file_options, struct _starpu_fxt_file_output *output)
+{
+	unsigned i;
+
+	_starpu_fxt_append_file(distrib_time, output->distrib_time);
+	_starpu_fxt_append_file(activity_file, output->activity_file);
+	_starpu_fxt_append_file(tasks_file, output->tasks_file);
+	_starpu_fxt_append_file(data_file, output->data_file);
+#ifdef STARPU_PAPI
+	_starpu_fxt_append_file(papi_file, output->papi_file);
+#endif
+	_starpu_fxt_append_file(trace_file, output->trace_file);
+	_starpu_fxt_append_file(sched_tasks_file, output->sched_tasks_file);
+	if (output->dag_file)
+	{
+		_starpu_fxt_dag_append(output->dag_file);
+		fclose(output->dag_file);
+	}
+	if (output->anim_file)
+	{
+		_starpu_fxt_component_append(anim_file, output->anim_file);
+		fclose(output->anim_file);
+	}
+
+	if (output->number_events)
+	{
+		for (i = 0; i <= FUT_SETUP_CODE; i++)
+			number_events[i] += output->number_events[i];
+		free(output->number_events);
+	}
+
+	if (output->dumped_codelets_count)
+	{
+		_STARPU_REALLOC(dumped_codelets, (dumped_codelets_count + output->dumped_codelets_count) * sizeof(*dumped_codelets));
+		memcpy(&dumped_codelets[dumped_codelets_count], output->dumped_codelets, output->dumped_codelets_count * sizeof(*dumped_codelets));
+		dumped_codelets_count += output->dumped_codelets_count;
+	}
+	free(output->dumped_codelets);
+
+	nworkers += output->nworkers;
+
+	for (i = 0; i < STARPU_NMAXWORKERS; i++)
+	{
+		if (file_options->worker_names[i][0])
+		{
+			memcpy(options->worker_names[i], file_options->worker_names[i], sizeof(options->worker_names[i]));
+			options->worker_archtypes[i] = file_options->worker_archtypes[i];
+		}
+	}
+}
+
+/* Read the next line of a Paje stream, and get its time */
+static int _starpu_fxt_paje_next_line(FILE *file, char **line, size_t *size, double *time)
+{
+	char *field;
+
+	if (getline(line, size, file) == -1)
+		return 0;
+
+	/* Entity values definitions do not have a time, and have to come
+	 * first */
+	field = strchr(*line, '\t');
+	if (!strncmp(*line, "6\t", 2) || !field)
+		*time = -HUGE_VAL;
+	else
+		*time = strtod(field+1, NULL);
+	return 1;
+}
+
+struct paje_definition
+{
+	UT_hash_handle hh;
+	char *line;
+};
+
+/* K-way merge the Paje streams of the trace files by event time into the
+ * final Paje trace. Ties are broken by file order. Each file defines the
+ * entity values it uses, we keep only the first definition of each of them. */
+static void _starpu_fxt_paje_merge(struct _starpu_fxt_file_output *outputs, unsigned noutputs)
+{
+	char *lines[noutputs];
+	size_t sizes[noutputs];
+	double times[noutputs];
+	int valid[noutputs];
+	struct paje_definition *definitions = NULL, *definition, *tmp;
+	unsigned i;
+
+	for (i = 0; i < noutputs; i++)
+	{
+		lines[i] = NULL;
+		sizes[i] = 0;
+		rewind(outputs[i].out_paje_file);
+		valid[i] = _starpu_fxt_paje_next_line(outputs[i].out_paje_file, &lines[i], &sizes[i], &times[i]);
+	}
+
+	while (1)
+	{
+		int min = -1;
+		for (i = 0; i < noutputs; i++)
+			if (valid[i] && (min == -1 || times[i] < times[min]))
+				min = i;
+		if (min == -1)
+			break;
+
+		if (times[min] == -HUGE_VAL)
+		{
+			HASH_FIND_STR(definitions, lines[min], definition);
+			if (!definition)
+			{
+				_STARPU_MALLOC(definition, sizeof(*definition));
+				definition->line = strdup(lines[min]);
+				HASH_ADD_KEYPTR(hh, definitions, definition->line, strlen(definition->line), definition);
+				fputs(lines[min], out_paje_file);
+			}
+		}
+		else
+			fputs(lines[min], out_paje_file);
+
+		valid[min] = _starpu_fxt_paje_next_line(outputs[min].out_paje_file, &lines[min], &sizes[min], &times[min]);
+	}
+
+	HASH_ITER(hh, definitions, definition, tmp)
+	{
+		HASH_DEL(definitions, definition);
+		free(definition->line);
+		free(definition);
+	}
+	for (i = 0; i < noutputs; i++)
+	{
+		free(lines[i]);
+		fclose(outputs[i].out_paje_file);
+		outputs[i].out_paje_file = NULL;
+	}
+}
+
+struct _starpu_fxt_parse_files_arg
+{
+	struct starpu_fxt_options *options;
+	struct starpu_fxt_options *file_options;
+	struct _starpu_fxt_file_output *outputs;
+	struct starpu_fxt_mpi_offset *sync_barriers;
+	int *rank_k;
+};
+
+/* Parse a trace file into its own temporary outputs, with its own copy of
+ * the options */
+static void _starpu_fxt_parse_file(void *_arg, unsigned inputfile)
+{
+	struct _starpu_fxt_parse_files_arg *arg = _arg;
+	struct starpu_fxt_options *options = &arg->file_options[inputfile];
+	struct _starpu_fxt_file_output *output = &arg->outputs[inputfile];
+	struct _starpu_symbol_name_list saved_symbol_list;
+	int filerank = arg->rank_k[inputfile];
+	char file_prefix[32];
+
+	_STARPU_DISP("Parsing file %s (rank %d)\n", arg->options->filenames[inputfile], filerank);
+
+	memcpy(options, arg->options, sizeof(*options));
+	memset(options->worker_names, 0, sizeof(options->worker_names));
+	memset(options->worker_archtypes, 0, sizeof(options->worker_archtypes));
+	snprintf(file_prefix, sizeof(file_prefix), "%d_", filerank);
+	options->file_prefix = strdup(file_prefix);
+	options->file_offset = arg->sync_barriers[inputfile];
+	options->file_rank = filerank;
+
+	_starpu_fxt_file_output_init(output, options);
+	_starpu_fxt_file_output_swap(output);
+	/* Each file defines the Paje entity values it uses */
+	saved_symbol_list = symbol_list;
+	_starpu_symbol_name_list_init(&symbol_list);
+
+	_starpu_fxt_parse_new_file(options->filenames[inputfile], options, output);
+
+	_starpu_fxt_symbol_list_free();
+	symbol_list = saved_symbol_list;
+	_starpu_fxt_file_output_swap(output);
+	free(options->file_prefix);
+	options->file_prefix = NULL;
+}
+
 void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 {
+	struct _starpu_fxt_file_output *outputs;
+
 	starpu_drivers_preinit();
 	_starpu_fxt_options_set_dir(options);
 	_starpu_fxt_dag_init(options->dag_path);
@@ -4956,7 +5826,10 @@ void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 	{
 		return;
 	}
-	else if (options->ninputfiles == 1)
+
+	_STARPU_CALLOC(outputs, options->ninputfiles, sizeof(*outputs));
+
+	if (options->ninputfiles == 1)
 	{
 		/* we usually only have a single trace */
 		uint64_t file_start_time = _starpu_fxt_find_start_time(options->filenames[0]);
@@ -4965,7 +5838,7 @@ void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 		options->file_offset.offset_start = -file_start_time;
 		options->file_rank = -1;
 
-		_starpu_fxt_parse_new_file(options->filenames[0], options);
+		_starpu_fxt_parse_new_file(options->filenames[0], options, &outputs[0]);
 	}
 	else
 	{
@@ -4993,20 +5866,25 @@ void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 		uint64_t M_end = 0;
 		int key = -1;
 		unsigned display_mpi = 0;
+		unsigned nthreads = _starpu_fxt_nthreads(options);
 
-		/* Get all trace starts */
+		/* Files without synchronization point do not tell their rank */
 		for (inputfile = 0; inputfile < options->ninputfiles; inputfile++)
+			rank_k[inputfile] = inputfile;
+
+		/* Get all trace starts and synchronization points, if they exist */
+		struct _starpu_fxt_scan_files_arg scan_arg =
 		{
-			uint64_t file_start = _starpu_fxt_find_start_time(options->filenames[inputfile]);
-			start_k[inputfile] = file_start;
-		}
+			.options = options,
+			.start_k = start_k,
+			.sync_barriers = sync_barriers,
+			.unique_keys = unique_keys,
+			.rank_k = rank_k,
+		};
+		_starpu_fxt_run(nthreads, options->ninputfiles, _starpu_fxt_scan_file, &scan_arg);
 
-		/* Look for all synchronization points, if they exist */
 		for (inputfile = 0; inputfile < options->ninputfiles; inputfile++)
 		{
-			sync_barriers[inputfile] = _starpu_fxt_mpi_find_sync_points(options->filenames[inputfile],
-										   &unique_keys[inputfile],
-										   &rank_k[inputfile]);
 			if (sync_barriers[inputfile].nb_barriers > 0)
 			{
 				/* Let's start by making sure all trace files come from the same execution: */
@@ -5074,7 +5952,9 @@ void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 			}
 		}
 
-		/* generate the Paje trace for the different files */
+#ifdef STARPU_HAVE_POTI
+		/* poti writes to its own output, so we have to parse the files
+		 * one after the other, directly into the final outputs */
 		for (inputfile = 0; inputfile < options->ninputfiles; inputfile++)
 		{
 			int filerank = rank_k[inputfile];
@@ -5089,8 +5969,44 @@ void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 			options->file_offset = sync_barriers[inputfile];
 			options->file_rank = filerank;
 
-			_starpu_fxt_parse_new_file(options->filenames[inputfile], options);
+			_starpu_fxt_parse_new_file(options->filenames[inputfile], options, &outputs[inputfile]);
 		}
+#else
+		/* Generate the traces for the different files, each into its
+		 * own temporary outputs, concurrently. The per-file parsing
+		 * state is thread-local, and the MPI transfers are recorded per
+		 * rank, so we can do this only if the ranks are distinct. */
+#ifndef STARPU_HAVE_THREAD_LOCAL
+		nthreads = 1;
+#endif
+		unsigned i;
+		for (inputfile = 0; inputfile < options->ninputfiles && nthreads > 1; inputfile++)
+			for (i = 0; i < inputfile; i++)
+				if (rank_k[i] == rank_k[inputfile])
+				{
+					nthreads = 1;
+					break;
+				}
+
+		struct starpu_fxt_options *file_options;
+		_STARPU_MALLOC(file_options, options->ninputfiles * sizeof(*file_options));
+		struct _starpu_fxt_parse_files_arg parse_arg =
+		{
+			.options = options,
+			.file_options = file_options,
+			.outputs = outputs,
+			.sync_barriers = sync_barriers,
+			.rank_k = rank_k,
+		};
+		_starpu_fxt_run(nthreads, options->ninputfiles, _starpu_fxt_parse_file, &parse_arg);
+
+		/* And gather them in file order */
+		for (inputfile = 0; inputfile < options->ninputfiles; inputfile++)
+			_starpu_fxt_file_output_commit(options, &file_options[inputfile], &outputs[inputfile]);
+		if (out_paje_file)
+			_starpu_fxt_paje_merge(outputs, options->ninputfiles);
+		free(file_options);
+#endif
 
 		/* display the MPI transfers if possible */
 		if (display_mpi)
@@ -5104,6 +6020,7 @@ void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 	_starpu_fxt_distrib_file_close(options);
 	_starpu_fxt_anim_file_close();
 	_starpu_fxt_tasks_file_close();
+	_starpu_fxt_tasks_bin_file_close(options, outputs, options->ninputfiles);
 	_starpu_fxt_data_file_close();
 	_starpu_fxt_papi_file_close();
 	_starpu_fxt_comms_file_close();
@@ -5112,8 +6029,10 @@ void starpu_fxt_generate_trace(struct starpu_fxt_options *options)
 
 	_starpu_fxt_dag_terminate();
 
+	free(outputs);
 	options->nworkers = nworkers;
 	free(options->file_prefix);
+	options->file_prefix = NULL;
 }
 
 #define DATA_STR_MAX_SIZE 15
@@ -49,7 +49,16 @@
 
 #pragma GCC visibility push(hidden)
 
-extern char _starpu_last_codelet_symbol[STARPU_NMAXWORKERS][(FXT_MAX_PARAMS-5)*sizeof(unsigned long)];
+/* State of the parsing of the current trace file. Several trace files can be
+ * parsed concurrently by different threads when thread-local storage is
+ * available. */
+#ifdef STARPU_HAVE_THREAD_LOCAL
+#define _STARPU_FXT_PER_FILE __thread
+#else
+#define _STARPU_FXT_PER_FILE
+#endif
+
+extern _STARPU_FXT_PER_FILE char (*_starpu_last_codelet_symbol)[(FXT_MAX_PARAMS-5)*sizeof(unsigned long)];
 
 void _starpu_fxt_dag_init(char *dag_filename);
 void _starpu_fxt_dag_terminate(void);
@@ -66,6 +75,8 @@ void _starpu_fxt_dag_set_task_line(const char *prefix, unsigned long job_id, con
 void _starpu_fxt_dag_add_send(int src, unsigned long dep_prev, unsigned long tag, unsigned long id);
 void _starpu_fxt_dag_add_receive(int dst, unsigned long dep_prev, unsigned long tag, unsigned long id);
 void _starpu_fxt_dag_add_sync_point(void);
+void _starpu_fxt_dag_swap_output(FILE **file, unsigned *cluster_cnt);
+void _starpu_fxt_dag_append(FILE *file);
 unsigned _starpu_fxt_data_get_coord(unsigned long handle, int mpi_rank, unsigned dim);
 const char * _starpu_fxt_data_get_name(unsigned long handle, int mpi_rank);
 
@@ -102,6 +113,8 @@ void _starpu_fxt_component_pull(FILE *output, struct starpu_fxt_options *options
 void _starpu_fxt_component_dump(FILE *output);
 void _starpu_fxt_component_finish(FILE *output);
 void _starpu_fxt_component_deinit(void);
+void _starpu_fxt_component_swap_state(unsigned *state);
+void _starpu_fxt_component_append(FILE *output, FILE *file);
 
 #pragma GCC visibility pop
 
@@ -16,14 +16,15 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <common/config.h>
 
 #ifdef STARPU_USE_FXT
 
 #include "starpu_fxt.h"
 
-static FILE *out_file;
-static unsigned cluster_cnt;
+static _STARPU_FXT_PER_FILE FILE *out_file;
+static _STARPU_FXT_PER_FILE unsigned cluster_cnt;
 
 void _starpu_fxt_dag_init(char *out_path)
 {
@@ -162,4 +163,38 @@ void _starpu_fxt_dag_add_sync_point(void)
 	fprintf(out_file, "\tcolor=black;\n");
 }
 
+/* Exchange the current output with \p file, to let a trace file write its
+ * own part of the graph, numbering its clusters from \p cluster_cnt */
+void _starpu_fxt_dag_swap_output(FILE **file, unsigned *_cluster_cnt)
+{
+	FILE *f = out_file;
+	unsigned cnt = cluster_cnt;
+
+	out_file = *file;
+	cluster_cnt = *_cluster_cnt;
+	*file = f;
+	*_cluster_cnt = cnt;
+}
+
+/* Append the part of the graph written by a trace file, renumbering its
+ * clusters after ours */
+void _starpu_fxt_dag_append(FILE *file)
+{
+	char *line = NULL;
+	size_t size = 0;
+
+	if (!out_file)
+		return;
+
+	rewind(file);
+	while (getline(&line, &size, file) != -1)
+	{
+		if (!strncmp(line, "subgraph cluster_", 17))
+			fprintf(out_file, "subgraph cluster_%u {\n", ++cluster_cnt);
+		else
+			fputs(line, out_file);
+	}
+	free(line);
+}
+
 #endif /* STARPU_USE_FXT */
@@ -58,7 +58,7 @@ struct starpu_fxt_mpi_offset _starpu_fxt_mpi_find_sync_points(char *filename_in,
 		_exit(EXIT_FAILURE);
 	}
 
-	static fxt_t fut;
+	fxt_t fut;
 	fut = fxt_fdopen(fd_in);
 	if (!fut)
 	{
@@ -30,6 +30,7 @@
 #include <core/drivers.h>
 #include <core/idle_hook.h>
 #include <drivers/cpu/driver_cpu.h>
+#include <drivers/cpu/numa_copy.h>
 #include <drivers/disk/driver_disk.h>
 #include <drivers/opencl/driver_opencl.h>
 #include <drivers/cuda/driver_cuda.h>
@@ -265,7 +266,17 @@ int _starpu_cpu_copy_interface(starpu_data_handle_t handle, void *src_interface,
 	else
 	{
 		STARPU_ASSERT_MSG(copy_methods->any_to_any, "the interface '%s' does define neither ram_to_ram nor any_to_any copy method", handle->ops->name);
-		copy_methods->any_to_any(src_interface, src_node, dst_interface, dst_node, req ? &req->async_channel : NULL);
+		if (req && _starpu_numa_copy_enabled && !starpu_asynchronous_copy_disabled())
+		{
+			/* Let the copy threads perform the copies, and
+			 * avoid polluting the cache with the data if it is
+			 * only prefetched */
+			req->async_channel.node_ops = &_starpu_driver_cpu_node_ops;
+			_starpu_numa_copy_event_init(_starpu_numa_copy_get_event(&req->async_channel.event), req->prefetch >= STARPU_PREFETCH);
+			ret = copy_methods->any_to_any(src_interface, src_node, dst_interface, dst_node, &req->async_channel);
+		}
+		else
+			copy_methods->any_to_any(src_interface, src_node, dst_interface, dst_node, req ? &req->async_channel : NULL);
 	}
 	return ret;
 }
@@ -276,12 +287,23 @@ int _starpu_cpu_copy_data(uintptr_t src, size_t src_offset, unsigned src_node, u
 	int dst_kind = starpu_node_get_kind(dst_node);
 	STARPU_ASSERT(src_kind == STARPU_CPU_RAM && dst_kind == STARPU_CPU_RAM);
 
-	(void) async_channel;
+	if (async_channel && async_channel->node_ops == &_starpu_driver_cpu_node_ops)
+		return _starpu_numa_copy_submit((void *) (dst + dst_offset), (void *) (src + src_offset), size, dst_node, _starpu_numa_copy_get_event(&async_channel->event));
 
 	memcpy((void *) (dst + dst_offset), (void *) (src + src_offset), size);
 	return 0;
 }
 
+unsigned _starpu_cpu_test_request_completion(struct _starpu_async_channel *async_channel)
+{
+	return _starpu_numa_copy_test(_starpu_numa_copy_get_event(&async_channel->event));
+}
+
+void _starpu_cpu_wait_request_completion(struct _starpu_async_channel *async_channel)
+{
+	_starpu_numa_copy_wait(_starpu_numa_copy_get_event(&async_channel->event));
+}
+
 int _starpu_cpu_is_direct_access_supported(unsigned node, unsigned handling_node)
 {
 	(void) node;
@@ -767,4 +789,7 @@ struct _starpu_node_ops _starpu_driver_cpu_node_ops =
 	.map[STARPU_CPU_RAM] = _starpu_cpu_map,
 	.unmap[STARPU_CPU_RAM] = _starpu_cpu_unmap,
 	.update_map[STARPU_CPU_RAM] = _starpu_cpu_update_map,
+
+	.wait_request_completion = _starpu_cpu_wait_request_completion,
+	.test_request_completion = _starpu_cpu_test_request_completion,
 };
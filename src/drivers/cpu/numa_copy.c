@@ -0,0 +1,350 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Asynchronous copies between CPU memory nodes.
+ *
+ * With STARPU_USE_NUMA, each NUMA node is a memory node of its own, and data
+ * requests between them would otherwise be performed by a plain memcpy in
+ * the worker which handles the request, which is then blocked for the whole
+ * copy, and only gets the bandwidth of one core. We instead keep a small pool
+ * of copy threads per NUMA memory node, bound to the cores of that node, which
+ * copy the data towards it chunk by chunk, so that several threads can work
+ * on the same copy. The completion is then tested or waited for through the
+ * async channel of the request, like for the other drivers.
+ */
+
+#include <common/config.h>
+#include <common/list.h>
+#include <common/utils.h>
+#include <core/workers.h>
+#include <core/topology.h>
+#include <datawizard/memory_nodes.h>
+#include <drivers/cpu/numa_copy.h>
+
+#ifdef STARPU_HAVE_HWLOC
+#include <hwloc.h>
+#if HWLOC_API_VERSION < 0x00010b00
+#define HWLOC_OBJ_NUMANODE HWLOC_OBJ_NODE
+#endif
+#endif
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+int _starpu_numa_copy_enabled;
+
+#ifndef STARPU_SIMGRID
+LIST_TYPE(_starpu_numa_copy_job,
+	char *dst;
+	const char *src;
+	size_t size;
+	/* Offset of the next chunk to be copied */
+	size_t next;
+	unsigned nontemporal;
+	int *pending;
+);
+
+struct _starpu_numa_copy_pool
+{
+	unsigned node;
+	unsigned nthreads;
+	starpu_pthread_t *threads;
+	starpu_pthread_mutex_t mutex;
+	/* Signaled when jobs are queued */
+	starpu_pthread_cond_t cond;
+	/* Signaled when the last pending chunk of an event was copied */
+	starpu_pthread_cond_t done_cond;
+	struct _starpu_numa_copy_job_list jobs;
+	int running;
+#ifdef STARPU_HAVE_HWLOC
+	hwloc_bitmap_t cpuset;
+#endif
+};
+
+static struct _starpu_numa_copy_pool pools[STARPU_MAXNUMANODES];
+static unsigned npools;
+/* Copies are split in chunks of that size, smaller copies are synchronous */
+static size_t chunk_size;
+/* Copies bigger than this would not stay in the cache anyway */
+static size_t nontemporal_threshold;
+
+static void copy_chunk(char *dst, const char *src, size_t size, unsigned nontemporal)
+{
+#ifdef __SSE2__
+	if (nontemporal && size >= 64)
+	{
+		/* _mm_stream_si128 needs an aligned destination */
+		size_t head = (16 - ((uintptr_t) dst & 15)) & 15;
+
+		memcpy(dst, src, head);
+		dst += head;
+		src += head;
+		size -= head;
+
+		for ( ; size >= 64; size -= 64, dst += 64, src += 64)
+		{
+			__m128i a = _mm_loadu_si128((const __m128i *) src);
+			__m128i b = _mm_loadu_si128((const __m128i *) (src + 16));
+			__m128i c = _mm_loadu_si128((const __m128i *) (src + 32));
+			__m128i d = _mm_loadu_si128((const __m128i *) (src + 48));
+			_mm_stream_si128((__m128i *) dst, a);
+			_mm_stream_si128((__m128i *) (dst + 16), b);
+			_mm_stream_si128((__m128i *) (dst + 32), c);
+			_mm_stream_si128((__m128i *) (dst + 48), d);
+		}
+		/* Make the streamed data visible before reporting completion */
+		_mm_sfence();
+	}
+#else
+	(void) nontemporal;
+#endif
+	memcpy(dst, src, size);
+}
+
+static void *numa_copy_func(void *arg)
+{
+	struct _starpu_numa_copy_pool *pool = arg;
+	char name[16];
+
+	snprintf(name, sizeof(name), "numa copy %u", pool->node);
+	starpu_pthread_setname(name);
+
+#ifdef STARPU_HAVE_HWLOC
+	if (pool->cpuset)
+	{
+		struct _starpu_machine_config *config = _starpu_get_machine_config();
+		if (hwloc_set_cpubind(config->topology.hwtopology, pool->cpuset, HWLOC_CPUBIND_THREAD))
+			_STARPU_DEBUG("could not bind copy thread to NUMA node %u: %s\n", pool->node, strerror(errno));
+	}
+#endif
+
+	STARPU_PTHREAD_MUTEX_LOCK(&pool->mutex);
+	while (1)
+	{
+		struct _starpu_numa_copy_job *job;
+		char *dst;
+		const char *src;
+		size_t size;
+		unsigned nontemporal;
+		int *pending;
+		int last;
+
+		while (pool->running && _starpu_numa_copy_job_list_empty(&pool->jobs))
+			STARPU_PTHREAD_COND_WAIT(&pool->cond, &pool->mutex);
+		if (_starpu_numa_copy_job_list_empty(&pool->jobs))
+			/* Not running any more, and nothing left to copy */
+			break;
+
+		/* Take the next chunk of the first job */
+		job = _starpu_numa_copy_job_list_front(&pool->jobs);
+		size = STARPU_MIN(chunk_size, job->size - job->next);
+		dst = job->dst + job->next;
+		src = job->src + job->next;
+		nontemporal = job->nontemporal;
+		pending = job->pending;
+		job->next += size;
+		if (job->next == job->size)
+		{
+			_starpu_numa_copy_job_list_erase(&pool->jobs, job);
+			_starpu_numa_copy_job_delete(job);
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&pool->mutex);
+
+		copy_chunk(dst, src, size, nontemporal);
+
+		/* The request may be terminated as soon as we decrement, do not
+		 * touch the event afterwards */
+		last = STARPU_ATOMIC_ADD(pending, -1) == 0;
+
+		STARPU_PTHREAD_MUTEX_LOCK(&pool->mutex);
+		if (last)
+			STARPU_PTHREAD_COND_BROADCAST(&pool->done_cond);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pool->mutex);
+
+	return NULL;
+}
+#endif /* !STARPU_SIMGRID */
+
+void _starpu_numa_copy_init(void)
+{
+#ifndef STARPU_SIMGRID
+	unsigned nnuma = starpu_memory_nodes_get_numa_count();
+	unsigned node, i;
+	int nthreads;
+#ifdef STARPU_HAVE_HWLOC
+	struct _starpu_machine_config *config = _starpu_get_machine_config();
+	int bind = starpu_getenv_number("STARPU_WORKERS_NOBIND") <= 0;
+#endif
+
+	if (nnuma <= 1)
+		/* There is no RAM-to-RAM copy to perform */
+		return;
+
+	nthreads = starpu_getenv_number_default("STARPU_NUMA_COPY_THREADS", 2);
+	if (nthreads <= 0)
+		return;
+
+	chunk_size = starpu_getenv_number_default("STARPU_NUMA_COPY_CHUNK", 512) * 1024;
+	if (chunk_size < 64*1024)
+		chunk_size = 64*1024;
+	nontemporal_threshold = starpu_getenv_number_default("STARPU_NUMA_COPY_NONTEMPORAL_THRESHOLD", 8192) * 1024;
+
+	npools = nnuma;
+	for (node = 0; node < npools; node++)
+	{
+		struct _starpu_numa_copy_pool *pool = &pools[node];
+
+		pool->node = node;
+		pool->nthreads = nthreads;
+		_starpu_numa_copy_job_list_init(&pool->jobs);
+		STARPU_PTHREAD_MUTEX_INIT(&pool->mutex, NULL);
+		STARPU_PTHREAD_COND_INIT(&pool->cond, NULL);
+		STARPU_PTHREAD_COND_INIT(&pool->done_cond, NULL);
+		pool->running = 1;
+
+#ifdef STARPU_HAVE_HWLOC
+		pool->cpuset = NULL;
+		if (bind)
+		{
+			int logid = starpu_memory_nodes_numa_id_to_hwloclogid(node);
+			hwloc_obj_t obj = NULL;
+			if (logid >= 0)
+				obj = hwloc_get_obj_by_type(config->topology.hwtopology, HWLOC_OBJ_NUMANODE, logid);
+			if (obj && obj->cpuset && !hwloc_bitmap_iszero(obj->cpuset))
+				pool->cpuset = hwloc_bitmap_dup(obj->cpuset);
+		}
+#endif
+
+		_STARPU_MALLOC(pool->threads, nthreads * sizeof(*pool->threads));
+		for (i = 0; i < pool->nthreads; i++)
+			STARPU_PTHREAD_CREATE(&pool->threads[i], NULL, numa_copy_func, pool);
+	}
+
+	_starpu_numa_copy_enabled = 1;
+#endif
+}
+
+void _starpu_numa_copy_shutdown(void)
+{
+	if (!_starpu_numa_copy_enabled)
+		return;
+
+#ifndef STARPU_SIMGRID
+	unsigned node, i;
+
+	_starpu_numa_copy_enabled = 0;
+
+	for (node = 0; node < npools; node++)
+	{
+		struct _starpu_numa_copy_pool *pool = &pools[node];
+
+		STARPU_PTHREAD_MUTEX_LOCK(&pool->mutex);
+		pool->running = 0;
+		STARPU_PTHREAD_COND_BROADCAST(&pool->cond);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&pool->mutex);
+		for (i = 0; i < pool->nthreads; i++)
+			STARPU_PTHREAD_JOIN(pool->threads[i], NULL);
+		free(pool->threads);
+		pool->threads = NULL;
+
+		STARPU_PTHREAD_MUTEX_DESTROY(&pool->mutex);
+		STARPU_PTHREAD_COND_DESTROY(&pool->cond);
+		STARPU_PTHREAD_COND_DESTROY(&pool->done_cond);
+#ifdef STARPU_HAVE_HWLOC
+		if (pool->cpuset)
+			hwloc_bitmap_free(pool->cpuset);
+		pool->cpuset = NULL;
+#endif
+	}
+	npools = 0;
+#endif
+}
+
+void _starpu_numa_copy_event_init(struct _starpu_numa_copy_event *event, unsigned nontemporal)
+{
+	event->pending = 0;
+	event->nontemporal = nontemporal;
+	event->pool = NULL;
+}
+
+int _starpu_numa_copy_submit(void *dst, const void *src, size_t size, unsigned dst_node, struct _starpu_numa_copy_event *event)
+{
+#ifndef STARPU_SIMGRID
+	struct _starpu_numa_copy_pool *pool;
+	struct _starpu_numa_copy_job *job;
+	size_t nchunks;
+
+	if (!_starpu_numa_copy_enabled || size < chunk_size || dst_node >= npools)
+#endif
+	{
+		memcpy(dst, src, size);
+		return 0;
+	}
+
+#ifndef STARPU_SIMGRID
+	pool = &pools[dst_node];
+	STARPU_ASSERT(!event->pool || event->pool == pool);
+	event->pool = pool;
+
+	nchunks = (size + chunk_size - 1) / chunk_size;
+
+	job = _starpu_numa_copy_job_new();
+	job->dst = dst;
+	job->src = src;
+	job->size = size;
+	job->next = 0;
+	job->nontemporal = event->nontemporal || size >= nontemporal_threshold;
+	job->pending = &event->pending;
+
+	(void) STARPU_ATOMIC_ADD(&event->pending, (int) nchunks);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&pool->mutex);
+	_starpu_numa_copy_job_list_push_back(&pool->jobs, job);
+	if (nchunks > 1)
+		STARPU_PTHREAD_COND_BROADCAST(&pool->cond);
+	else
+		STARPU_PTHREAD_COND_SIGNAL(&pool->cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pool->mutex);
+
+	return -EAGAIN;
+#endif
+}
+
+unsigned _starpu_numa_copy_test(struct _starpu_numa_copy_event *event)
+{
+	return STARPU_ATOMIC_ADD(&event->pending, 0) == 0;
+}
+
+void _starpu_numa_copy_wait(struct _starpu_numa_copy_event *event)
+{
+#ifndef STARPU_SIMGRID
+	struct _starpu_numa_copy_pool *pool = event->pool;
+
+	if (!pool)
+		/* Everything was copied synchronously */
+		return;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&pool->mutex);
+	while (STARPU_ATOMIC_ADD(&event->pending, 0) != 0)
+		STARPU_PTHREAD_COND_WAIT(&pool->done_cond, &pool->mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&pool->mutex);
+#else
+	(void) event;
+#endif
+}
@@ -0,0 +1,70 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __NUMA_COPY_H__
+#define __NUMA_COPY_H__
+
+/** @file */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <datawizard/copy_driver.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_numa_copy_pool;
+
+/** State of an asynchronous RAM-to-RAM copy, stored in the async channel of
+ * the data request */
+struct _starpu_numa_copy_event
+{
+	/** Number of chunks which have not been copied yet */
+	int pending;
+	/** Whether the destination is not expected to be used soon, so that
+	 * non-temporal stores can be used */
+	unsigned nontemporal;
+	/** Pool which copies the chunks */
+	struct _starpu_numa_copy_pool *pool;
+};
+
+static inline struct _starpu_numa_copy_event *_starpu_numa_copy_get_event(union _starpu_async_channel_event *_event)
+{
+	struct _starpu_numa_copy_event *event;
+	STARPU_STATIC_ASSERT(sizeof(*event) <= sizeof(*_event));
+	event = (struct _starpu_numa_copy_event *) _event;
+	return event;
+}
+
+/** Whether the copy engine is running, see STARPU_NUMA_COPY_THREADS */
+extern int _starpu_numa_copy_enabled;
+
+void _starpu_numa_copy_init(void);
+void _starpu_numa_copy_shutdown(void);
+
+/** Prepare \p event for the copies of a data request */
+void _starpu_numa_copy_event_init(struct _starpu_numa_copy_event *event, unsigned nontemporal);
+
+/** Queue the copy of \p size bytes from \p src to \p dst (on CPU memory node
+ * \p dst_node) to the copy threads. Returns 0 if the copy was rather done
+ * synchronously, and -EAGAIN if \p event has to be tested or waited for. */
+int _starpu_numa_copy_submit(void *dst, const void *src, size_t size, unsigned dst_node, struct _starpu_numa_copy_event *event);
+
+unsigned _starpu_numa_copy_test(struct _starpu_numa_copy_event *event);
+void _starpu_numa_copy_wait(struct _starpu_numa_copy_event *event);
+
+#pragma GCC visibility pop
+
+#endif // __NUMA_COPY_H__
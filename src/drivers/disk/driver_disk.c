@@ -252,6 +252,24 @@ int _starpu_disk_copy_data_from_cpu_to_disk(uintptr_t src, size_t src_offset, un
 					     size, async_channel);
 }
 
+int _starpu_disk_copyv_data_from_disk_to_cpu(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel)
+{
+	int src_kind = starpu_node_get_kind(src_node);
+	int dst_kind = starpu_node_get_kind(dst_node);
+	STARPU_ASSERT(src_kind == STARPU_DISK_RAM && dst_kind == STARPU_CPU_RAM);
+
+	return _starpu_disk_readv(src_node, dst_node, (void*) src, dst, vec, nvec, async_channel);
+}
+
+int _starpu_disk_copyv_data_from_cpu_to_disk(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel)
+{
+	int src_kind = starpu_node_get_kind(src_node);
+	int dst_kind = starpu_node_get_kind(dst_node);
+	STARPU_ASSERT(src_kind == STARPU_CPU_RAM && dst_kind == STARPU_DISK_RAM);
+
+	return _starpu_disk_writev(src_node, dst_node, (void*) dst, src, vec, nvec, async_channel);
+}
+
 int _starpu_disk_is_direct_access_supported(unsigned node, unsigned handling_node)
 {
 	/* Each worker can manage disks but disk <-> disk is not always allowed */
@@ -289,6 +307,9 @@ struct _starpu_node_ops _starpu_driver_disk_node_ops =
 
 	/* TODO: copy2D/3D? */
 
+	.copyv_data_to[STARPU_CPU_RAM] = _starpu_disk_copyv_data_from_disk_to_cpu,
+	.copyv_data_from[STARPU_CPU_RAM] = _starpu_disk_copyv_data_from_cpu_to_disk,
+
 	.wait_request_completion = _starpu_disk_wait_request_completion,
 	.test_request_completion = _starpu_disk_test_request_completion,
 };
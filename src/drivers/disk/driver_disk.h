@@ -43,6 +43,9 @@ int _starpu_disk_copy_data_from_disk_to_cpu(uintptr_t src, size_t src_offset, un
 int _starpu_disk_copy_data_from_disk_to_disk(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel);
 int _starpu_disk_copy_data_from_cpu_to_disk(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel);
 
+int _starpu_disk_copyv_data_from_disk_to_cpu(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel);
+int _starpu_disk_copyv_data_from_cpu_to_disk(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel);
+
 extern struct _starpu_node_ops _starpu_driver_disk_node_ops;
 int _starpu_disk_is_direct_access_supported(unsigned node, unsigned handling_node);
 uintptr_t _starpu_disk_malloc_on_node(unsigned dst_node, size_t size, int flags);
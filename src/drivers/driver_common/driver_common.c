@@ -20,6 +20,7 @@
 #include <starpu.h>
 #include <starpu_profiling.h>
 #include <profiling/profiling.h>
+#include <profiling/analysis.h>
 #include <common/utils.h>
 #include <core/debug.h>
 #include <core/sched_ctx.h>
@@ -149,6 +150,7 @@ void _starpu_driver_start_job(struct _starpu_worker *worker, struct _starpu_job
 		_STARPU_TRACE_TASK_NAME_LINE_COLOR(j);
 		_STARPU_TRACE_START_CODELET_BODY(j, j->nimpl, perf_arch, workerid);
 	}
+	_STARPU_TRACEBUF_START_CODELET_BODY(j, j->nimpl);
 	_starpu_sched_ctx_unlock_read(sched_ctx->id);
 	_STARPU_TASK_BREAK_ON(task, exec);
 }
@@ -175,6 +177,7 @@ void _starpu_driver_end_job(struct _starpu_worker *worker, struct _starpu_job *j
 		_starpu_perfmodel_create_comb_if_needed(perf_arch);
 		_STARPU_TRACE_END_CODELET_BODY(j, j->nimpl, perf_arch, workerid);
 	}
+	_STARPU_TRACEBUF_END_CODELET_BODY(j, j->nimpl);
 
 	if (cl && cl->model && cl->model->benchmarking)
 		calibrate_model = 1;
@@ -232,13 +235,16 @@ void _starpu_driver_update_job_feedback(struct _starpu_job *j, struct _starpu_wo
 		calibrate_model = 1;
 #endif
 
-	if ((profiling && profiling_info) || calibrate_model || !_starpu_perf_counter_paused())
+	if ((profiling && profiling_info) || calibrate_model || !_starpu_perf_counter_paused() || _starpu_analysis_enabled)
 	{
 		starpu_timespec_sub(&worker->cl_end, &worker->cl_start, &measured_ts);
 		double measured = starpu_timing_timespec_to_us(&measured_ts);
 
 		STARPU_ASSERT_MSG(measured >= 0, "measured=%lf\n", measured);
 
+		if (_starpu_analysis_enabled)
+			j->cp_duration = measured;
+
 		if (!_starpu_perf_counter_paused())
 		{
 			worker->__w_total_executed__value++;
@@ -367,6 +373,7 @@ static void _starpu_worker_set_status_sleeping(int workerid)
 	if (!(_starpu_worker_get_status(workerid) & STATUS_SLEEPING))
 	{
 		_STARPU_TRACE_WORKER_SLEEP_START;
+		_STARPU_TRACEBUF_WORKER_SLEEP_START();
 		_starpu_worker_add_status(workerid, STATUS_INDEX_SLEEPING);
 	}
 }
@@ -376,6 +383,7 @@ static void _starpu_worker_set_status_wakeup(int workerid)
 	if ((_starpu_worker_get_status(workerid) & STATUS_SLEEPING))
 	{
 		_STARPU_TRACE_WORKER_SLEEP_END;
+		_STARPU_TRACEBUF_WORKER_SLEEP_END();
 		_starpu_worker_clear_status(workerid, STATUS_INDEX_SLEEPING);
 	}
 }
@@ -783,9 +791,23 @@ void *_starpu_map_allocate(size_t length, unsigned node)
 	if (ret < 0)
 	{
 		perror("fail to allocate room for mapping");
+		shm_unlink(fd_name);
+		close(fd);
+		return NULL;
+	}
+#ifdef HAVE_POSIX_FALLOCATE
+	/* ftruncate only makes a sparse file, reserve the pages now rather
+	 * than getting a SIGBUS when touching them while the shared memory
+	 * filesystem is full */
+	ret = posix_fallocate(fd, 0, length);
+	if (ret != 0)
+	{
+		_STARPU_DISP("Warning: fail to reserve %lu bytes of shared memory: %s\n", (unsigned long) length, strerror(ret));
+		shm_unlink(fd_name);
 		close(fd);
 		return NULL;
 	}
+#endif
 	void* map_addr = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
 	close(fd);
 	if (map_addr == MAP_FAILED)
@@ -55,6 +55,8 @@ const char *_starpu_mp_common_command_to_string(const enum _starpu_mp_command co
 			return "UNMAP";
 		case STARPU_MP_COMMAND_SYNC_WORKERS:
 			return "SYNC_WORKERS";
+		case STARPU_MP_COMMAND_BATCH:
+			return "BATCH";
 
 		/* Note: synchronous send */
 		case STARPU_MP_COMMAND_RECV_FROM_HOST:
@@ -71,6 +73,10 @@ const char *_starpu_mp_common_command_to_string(const enum _starpu_mp_command co
 			return "RECV_FROM_HOST_ASYNC";
 		case STARPU_MP_COMMAND_SEND_TO_HOST_ASYNC:
 			return "SEND_TO_HOST_ASYNC";
+		case STARPU_MP_COMMAND_RECV_FROM_HOST_VEC_ASYNC:
+			return "RECV_FROM_HOST_VEC_ASYNC";
+		case STARPU_MP_COMMAND_SEND_TO_HOST_VEC_ASYNC:
+			return "SEND_TO_HOST_VEC_ASYNC";
 		case STARPU_MP_COMMAND_RECV_FROM_SINK_ASYNC:
 			return "RECV_FROM_SINK_ASYNC";
 		case STARPU_MP_COMMAND_SEND_TO_SINK_ASYNC:
@@ -97,10 +103,6 @@ const char *_starpu_mp_common_command_to_string(const enum _starpu_mp_command co
 			return "ANSWER_TRANSFER_COMPLETE";
 		case STARPU_MP_COMMAND_ANSWER_SINK_NBCORES:
 			return "ANSWER_SINK_NBCORES";
-		case STARPU_MP_COMMAND_ANSWER_EXECUTION_SUBMITTED:
-			return "ANSWER_EXECUTION_SUBMITTED";
-		case STARPU_MP_COMMAND_ANSWER_EXECUTION_DETACHED_SUBMITTED:
-			return "ANSWER_EXECUTION_DETACHED_SUBMITTED";
 
 		/* Asynchronous notifications from slave to master */
 		case STARPU_MP_COMMAND_NOTIF_RECV_FROM_HOST_ASYNC_COMPLETED:
@@ -184,6 +186,8 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->dt_recv = _starpu_mpi_common_recv;
 			node->dt_send_to_device = _starpu_mpi_common_send_to_device;
 			node->dt_recv_from_device = _starpu_mpi_common_recv_from_device;
+			node->dt_sendv = NULL;
+			node->dt_recvv = NULL;
 
 			node->get_kernel_from_job = _starpu_src_common_get_cpu_func_from_job;
 			node->lookup = NULL;
@@ -222,6 +226,8 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->dt_recv = _starpu_mpi_common_recv;
 			node->dt_send_to_device = _starpu_mpi_common_send_to_device;
 			node->dt_recv_from_device = _starpu_mpi_common_recv_from_device;
+			node->dt_sendv = NULL;
+			node->dt_recvv = NULL;
 
 			node->dt_test = _starpu_mpi_common_test_event;
 
@@ -266,6 +272,8 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->dt_recv = _starpu_tcpip_common_recv;
 			node->dt_send_to_device = _starpu_tcpip_common_send_to_device;
 			node->dt_recv_from_device = _starpu_tcpip_common_recv_from_device;
+			node->dt_sendv = _starpu_tcpip_common_sendv;
+			node->dt_recvv = _starpu_tcpip_common_recvv;
 
 			node->get_kernel_from_job = _starpu_src_common_get_cpu_func_from_job;
 			node->lookup = NULL;
@@ -304,6 +312,8 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 			node->dt_recv = _starpu_tcpip_common_recv;
 			node->dt_send_to_device = _starpu_tcpip_common_send_to_device;
 			node->dt_recv_from_device = _starpu_tcpip_common_recv_from_device;
+			node->dt_sendv = _starpu_tcpip_common_sendv;
+			node->dt_recvv = _starpu_tcpip_common_recvv;
 
 			node->dt_test = _starpu_tcpip_common_test_event;
 
@@ -327,6 +337,15 @@ _starpu_mp_common_node_create(enum _starpu_mp_node_kind node_kind,
 	 * a command, an argument and the argument size */
 	_STARPU_MALLOC(node->buffer, BUFFER_SIZE);
 
+	if (node->kind == STARPU_NODE_MPI_SOURCE || node->kind == STARPU_NODE_TCPIP_SOURCE)
+	{
+		_STARPU_MALLOC(node->batch, sizeof(*node->batch));
+		_STARPU_MALLOC(node->batch->buffer, BUFFER_SIZE);
+		node->batch->size = 0;
+	}
+	else
+		node->batch = NULL;
+
 	if (node->init)
 		node->init(node);
 
@@ -389,6 +408,11 @@ void _starpu_mp_common_node_destroy(struct _starpu_mp_node *node)
 		STARPU_PTHREAD_BARRIER_DESTROY(&node->init_completed_barrier);
 	}
 
+	if (node->batch)
+	{
+		free(node->batch->buffer);
+		free(node->batch);
+	}
 	free(node->buffer);
 	free(node);
 }
@@ -400,6 +424,10 @@ static void __starpu_mp_common_send_command(const struct _starpu_mp_node *node,
 
 	//printf("SEND %s: %d/%s - arg_size %d by %lu \n", notif?"NOTIF":"CMD", command, _starpu_mp_common_command_to_string(command), arg_size, starpu_pthread_self());
 
+	if (!notif && node->batch && node->batch->size && command != STARPU_MP_COMMAND_BATCH)
+		/* Keep the commands in order */
+		_starpu_mp_common_flush_commands(node);
+
 	/* MPI sizes are given through a int */
 	int command_size = sizeof(enum _starpu_mp_command);
 	int arg_size_size = sizeof(int);
@@ -434,6 +462,44 @@ void _starpu_nt_common_send_command(const struct _starpu_mp_node *node, const en
 	__starpu_mp_common_send_command(node, command, arg, arg_size, 1);
 }
 
+/* Append COMMAND to the batch of commands of NODE, which will be sent at
+ * once, to save both messages and the latency of sending them one by one */
+void _starpu_mp_common_queue_command(const struct _starpu_mp_node *node, const enum _starpu_mp_command command, void *arg, int arg_size)
+{
+	struct _starpu_mp_command_batch *batch = node->batch;
+	int entry_size = _STARPU_MP_BATCH_ENTRY_SIZE(arg_size);
+	char *entry;
+
+	if (!batch || entry_size > BUFFER_SIZE)
+	{
+		_starpu_mp_common_send_command(node, command, arg, arg_size);
+		return;
+	}
+
+	if (batch->size + entry_size > BUFFER_SIZE)
+		_starpu_mp_common_flush_commands(node);
+
+	entry = batch->buffer + batch->size;
+	memcpy(entry, &command, sizeof(command));
+	memcpy(entry + sizeof(command), &arg_size, sizeof(arg_size));
+	if (arg_size)
+		memcpy(entry + sizeof(command) + sizeof(arg_size), arg, arg_size);
+	batch->size += entry_size;
+}
+
+void _starpu_mp_common_flush_commands(const struct _starpu_mp_node *node)
+{
+	struct _starpu_mp_command_batch *batch = node->batch;
+	int size;
+
+	if (!batch || !batch->size)
+		return;
+
+	size = batch->size;
+	batch->size = 0;
+	__starpu_mp_common_send_command(node, STARPU_MP_COMMAND_BATCH, batch->buffer, size, 0);
+}
+
 /* Return the command received from SENDER. In case SENDER sent an argument
  * beside the command, an address to a copy of this argument is returns in arg.
  * There is no need to free this address as it's not allocated at this time.
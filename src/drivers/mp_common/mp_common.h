@@ -55,6 +55,9 @@ enum _starpu_mp_command
 	STARPU_MP_COMMAND_MAP,
 	STARPU_MP_COMMAND_UNMAP,
 	STARPU_MP_COMMAND_SYNC_WORKERS,
+	/* Several commands which do not need an answer, see
+	 * _starpu_mp_common_queue_command */
+	STARPU_MP_COMMAND_BATCH,
 
 	/* Note: synchronous send */
 	STARPU_MP_COMMAND_RECV_FROM_HOST,
@@ -67,6 +70,9 @@ enum _starpu_mp_command
 	STARPU_MP_COMMAND_SEND_TO_HOST_ASYNC,
 	STARPU_MP_COMMAND_RECV_FROM_SINK_ASYNC,
 	STARPU_MP_COMMAND_SEND_TO_SINK_ASYNC,
+	/* Several pieces of data at once, see _starpu_mp_transfer_vec_command */
+	STARPU_MP_COMMAND_RECV_FROM_HOST_VEC_ASYNC,
+	STARPU_MP_COMMAND_SEND_TO_HOST_VEC_ASYNC,
 
 	/* Synchronous answers from slave to master */
 	STARPU_MP_COMMAND_ERROR_EXECUTE,
@@ -79,8 +85,6 @@ enum _starpu_mp_command
 	STARPU_MP_COMMAND_ERROR_MAP,
 	STARPU_MP_COMMAND_ANSWER_TRANSFER_COMPLETE,
 	STARPU_MP_COMMAND_ANSWER_SINK_NBCORES,
-	STARPU_MP_COMMAND_ANSWER_EXECUTION_SUBMITTED,
-	STARPU_MP_COMMAND_ANSWER_EXECUTION_DETACHED_SUBMITTED,
 
 	/* Asynchronous notifications from slave to master */
 	STARPU_MP_COMMAND_NOTIF_RECV_FROM_HOST_ASYNC_COMPLETED,
@@ -118,6 +122,8 @@ union _starpu_mp_connection
 #endif
 };
 
+struct iovec;
+
 struct _starpu_mp_transfer_command
 {
 	size_t size;
@@ -125,6 +131,25 @@ struct _starpu_mp_transfer_command
 	void *event;
 };
 
+struct _starpu_mp_transfer_piece
+{
+	void *addr;
+	size_t size;
+};
+
+/** Transfer of \c npieces pieces of data on the sink, which are sent one
+ * after the other as a single message */
+struct _starpu_mp_transfer_vec_command
+{
+	void *event;
+	int npieces;
+	struct _starpu_mp_transfer_piece pieces[];
+};
+
+/** Maximum number of pieces of a _starpu_mp_transfer_vec_command */
+#define _STARPU_MP_TRANSFER_VEC_MAX \
+	STARPU_MIN(_STARPU_IOV_MAX, (BUFFER_SIZE - sizeof(struct _starpu_mp_transfer_vec_command)) / sizeof(struct _starpu_mp_transfer_piece))
+
 struct _starpu_mp_transfer_command_to_device
 {
 	size_t size;
@@ -147,6 +172,25 @@ struct _starpu_mp_transfer_unmap_command
 	size_t size;
 };
 
+/** Allocate \c count buffers of \c size bytes, the sink answers with the
+ * array of the buffers it could allocate */
+struct _starpu_mp_allocate_command
+{
+	size_t size;
+	int count;
+};
+
+/** Commands of a STARPU_MP_COMMAND_BATCH are stored one after the other as
+ * [command, argument size, argument], padded so that arguments are aligned */
+#define _STARPU_MP_BATCH_ENTRY_SIZE(arg_size) \
+	((sizeof(enum _starpu_mp_command) + sizeof(int) + (arg_size) + 7) & ~7)
+
+struct _starpu_mp_command_batch
+{
+	char *buffer;
+	int size;
+};
+
 LIST_TYPE(mp_barrier,
 		int id;
 		starpu_pthread_barrier_t before_work_barrier;
@@ -204,6 +248,10 @@ struct _starpu_mp_node
 	 * Size : BUFFER_SIZE */
 	void *buffer;
 
+	/** For source : commands waiting to be sent together.
+	 * Protected by connection_mutex */
+	struct _starpu_mp_command_batch *batch;
+
 	/** For sink : -1.
 	 * For host : index of the sink = devid.
 	 */
@@ -270,6 +318,9 @@ struct _starpu_mp_node
 	void (*dt_recv)		    (const struct _starpu_mp_node *, void *, int, void *);
 	void (*dt_send_to_device)   (const struct _starpu_mp_node *, int, void *, int, void *);
 	void (*dt_recv_from_device) (const struct _starpu_mp_node *, int, void *, int, void *);
+	/** Vectored data transfers, optional */
+	void (*dt_sendv)	    (const struct _starpu_mp_node *, const struct iovec *, int, void *);
+	void (*dt_recvv)	    (const struct _starpu_mp_node *, const struct iovec *, int, void *);
 
 	/** Test async transfers */
 	unsigned int (*dt_test) (struct _starpu_async_channel *);
@@ -296,6 +347,16 @@ void _starpu_nt_common_send_command(const struct _starpu_mp_node *node,
 				    const enum _starpu_mp_command command,
 				    void *arg, int arg_size);
 
+/** Queue a command which does not need an answer, to be sent along with the
+ * next ones, when _starpu_mp_common_flush_commands is called or before any
+ * other command is sent, so that the order of the commands is kept */
+void _starpu_mp_common_queue_command(const struct _starpu_mp_node *node,
+				     const enum _starpu_mp_command command,
+				     void *arg, int arg_size);
+
+/** Send the queued commands */
+void _starpu_mp_common_flush_commands(const struct _starpu_mp_node *node);
+
 enum _starpu_mp_command _starpu_mp_common_recv_command(const struct _starpu_mp_node *node, void **arg, int *arg_size);
 
 enum _starpu_mp_command _starpu_nt_common_recv_command(const struct _starpu_mp_node *node, void **arg, int *arg_size);
@@ -17,6 +17,7 @@
 
 #include <starpu.h>
 #include <dlfcn.h>
+#include <sys/uio.h>
 #include <common/config.h>
 #include <common/utils.h>
 #include <drivers/driver_common/driver_common.h>
@@ -87,19 +88,31 @@ void (*_starpu_sink_common_cpu_lookup(const struct _starpu_mp_node * node STARPU
 #endif
 }
 
-/* Allocate a memory space and send the address of this space to the host
+/* Allocate memory spaces and send the addresses of these spaces to the host
  */
 void _starpu_sink_common_allocate(const struct _starpu_mp_node *mp_node, void *arg, int arg_size)
 {
-	STARPU_ASSERT(arg_size == sizeof(size_t));
+	STARPU_ASSERT(arg_size == sizeof(struct _starpu_mp_allocate_command));
 
-	void *addr;
-	_STARPU_MALLOC(addr, *(size_t *)(arg));
+	struct _starpu_mp_allocate_command *cmd = (struct _starpu_mp_allocate_command *)arg;
+	void *addr[cmd->count];
+	int n;
+
+	STARPU_ASSERT(cmd->count > 0);
+	for (n = 0; n < cmd->count; n++)
+	{
+		/* Not _STARPU_MALLOC, which aborts on failure */
+		addr[n] = malloc(cmd->size);
+		if (!addr[n])
+			break;
+	}
 
 	/* If the allocation fail, let's send an error to the host.
+	 * If only some of them failed, the host will be happy with the
+	 * others.
 	 */
-	if (addr)
-		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ANSWER_ALLOCATE, &addr, sizeof(addr));
+	if (n)
+		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ANSWER_ALLOCATE, addr, n * sizeof(addr[0]));
 	else
 		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ERROR_ALLOCATE, NULL, 0);
 }
@@ -214,6 +227,78 @@ static void _starpu_sink_common_copy_to_host_async(struct _starpu_mp_node *mp_no
 	_starpu_mp_event_list_push_back(&mp_node->event_list, sink_event);
 }
 
+/* Return the array of iovec describing the pieces of the vectored transfer
+ * command ARG */
+static struct iovec *_starpu_sink_common_vec_iov(void *arg, int arg_size, int *npieces)
+{
+	struct _starpu_mp_transfer_vec_command *cmd = (struct _starpu_mp_transfer_vec_command *)arg;
+	struct iovec *iov;
+	int i;
+
+	STARPU_ASSERT(arg_size == (int) (sizeof(*cmd) + cmd->npieces * sizeof(cmd->pieces[0])));
+
+	_STARPU_MALLOC(iov, cmd->npieces * sizeof(*iov));
+	for (i = 0; i < cmd->npieces; i++)
+	{
+		iov[i].iov_base = cmd->pieces[i].addr;
+		iov[i].iov_len = cmd->pieces[i].size;
+	}
+	*npieces = cmd->npieces;
+	return iov;
+}
+
+static void _starpu_sink_common_copy_from_host_vec_async(struct _starpu_mp_node *mp_node, void *arg, int arg_size)
+{
+	struct _starpu_mp_transfer_vec_command *cmd = (struct _starpu_mp_transfer_vec_command *)arg;
+	int npieces;
+	struct iovec *iov = _starpu_sink_common_vec_iov(arg, arg_size, &npieces);
+
+	STARPU_ASSERT(mp_node->dt_recvv);
+
+	/* Same as _starpu_sink_common_copy_from_host_async, but scatter the
+	 * data to the pieces */
+	struct _starpu_mp_event * sink_event = _starpu_mp_event_new();
+	sink_event->answer_cmd = STARPU_MP_COMMAND_NOTIF_RECV_FROM_HOST_ASYNC_COMPLETED;
+	sink_event->remote_event = cmd->event;
+
+	struct _starpu_async_channel * async_channel = &sink_event->event;
+	async_channel->node_ops = NULL;
+	async_channel->starpu_mp_common_finished_sender = -1;
+	async_channel->starpu_mp_common_finished_receiver = 0;
+	async_channel->polling_node_receiver = NULL;
+	async_channel->polling_node_sender = NULL;
+
+	mp_node->dt_recvv(mp_node, iov, npieces, &sink_event->event);
+	free(iov);
+	_starpu_mp_event_list_push_back(&mp_node->event_list, sink_event);
+}
+
+static void _starpu_sink_common_copy_to_host_vec_async(struct _starpu_mp_node *mp_node, void *arg, int arg_size)
+{
+	struct _starpu_mp_transfer_vec_command *cmd = (struct _starpu_mp_transfer_vec_command *)arg;
+	int npieces;
+	struct iovec *iov = _starpu_sink_common_vec_iov(arg, arg_size, &npieces);
+
+	STARPU_ASSERT(mp_node->dt_sendv);
+
+	/* Same as _starpu_sink_common_copy_to_host_async, but gather the
+	 * data from the pieces */
+	struct _starpu_mp_event * sink_event = _starpu_mp_event_new();
+	sink_event->answer_cmd = STARPU_MP_COMMAND_NOTIF_SEND_TO_HOST_ASYNC_COMPLETED;
+	sink_event->remote_event = cmd->event;
+
+	struct _starpu_async_channel * async_channel = &sink_event->event;
+	async_channel->node_ops = NULL;
+	async_channel->starpu_mp_common_finished_sender = 0;
+	async_channel->starpu_mp_common_finished_receiver = -1;
+	async_channel->polling_node_receiver = NULL;
+	async_channel->polling_node_sender = NULL;
+
+	mp_node->dt_sendv(mp_node, iov, npieces, &sink_event->event);
+	free(iov);
+	_starpu_mp_event_list_push_back(&mp_node->event_list, sink_event);
+}
+
 static void _starpu_sink_common_copy_from_sink_sync(const struct _starpu_mp_node *mp_node, void *arg, int arg_size)
 {
 	STARPU_ASSERT(arg_size == offsetof(struct _starpu_mp_transfer_command_to_device, end));
@@ -353,6 +438,47 @@ static void _starpu_sink_common_recv_workers(struct _starpu_mp_node * node, void
 	STARPU_PTHREAD_BARRIER_WAIT(&node->init_completed_barrier);
 }
 
+/* Process the commands of a STARPU_MP_COMMAND_BATCH. These do not send any
+ * answer, which would overwrite the receive buffer holding the batch.
+ */
+static void _starpu_sink_common_batch(struct _starpu_mp_node *node, void *arg, int arg_size)
+{
+	char *entry = arg;
+	char *end = entry + arg_size;
+
+	while (entry < end)
+	{
+		enum _starpu_mp_command command;
+		int size;
+		void *sub_arg;
+
+		memcpy(&command, entry, sizeof(command));
+		memcpy(&size, entry + sizeof(command), sizeof(size));
+		sub_arg = entry + sizeof(command) + sizeof(size);
+
+		switch(command)
+		{
+			case STARPU_MP_COMMAND_EXECUTE_DETACHED:
+			case STARPU_MP_COMMAND_EXECUTE:
+				node->execute(node, sub_arg, size);
+				break;
+
+			case STARPU_MP_COMMAND_FREE:
+				node->free(node, sub_arg, size);
+				break;
+
+			case STARPU_MP_COMMAND_UNMAP:
+				node->unmap(node, sub_arg, size);
+				break;
+
+			default:
+				STARPU_ASSERT_MSG(0, "command %s can not be batched", _starpu_mp_common_command_to_string(command));
+		}
+
+		entry += _STARPU_MP_BATCH_ENTRY_SIZE(size);
+	}
+}
+
 /* Function looping on the sink, waiting for tasks to execute.
  * If the caller is the host, don't do anything.
  */
@@ -440,6 +566,14 @@ void _starpu_sink_common_worker(void)
 					_starpu_sink_common_copy_to_host_async(node, arg, arg_size);
 					break;
 
+				case STARPU_MP_COMMAND_RECV_FROM_HOST_VEC_ASYNC:
+					_starpu_sink_common_copy_from_host_vec_async(node, arg, arg_size);
+					break;
+
+				case STARPU_MP_COMMAND_SEND_TO_HOST_VEC_ASYNC:
+					_starpu_sink_common_copy_to_host_vec_async(node, arg, arg_size);
+					break;
+
 				case STARPU_MP_COMMAND_RECV_FROM_SINK_ASYNC:
 					_starpu_sink_common_copy_from_sink_async(node, arg, arg_size);
 					break;
@@ -451,6 +585,10 @@ void _starpu_sink_common_worker(void)
 				case STARPU_MP_COMMAND_SYNC_WORKERS:
 					_starpu_sink_common_recv_workers(node, arg, arg_size);
 					break;
+
+				case STARPU_MP_COMMAND_BATCH:
+					_starpu_sink_common_batch(node, arg, arg_size);
+					break;
 				default:
 					_STARPU_MSG("Oops, command %x unrecognized\n", command);
 			}
@@ -913,12 +1051,8 @@ void _starpu_sink_common_execute(struct _starpu_mp_node *node, void *arg, int ar
 	else
 		task->cl_arg = NULL;
 
-	//_STARPU_DEBUG("telling host that we have submitted the task %p.\n", task->kernel);
-	if (task->detached)
-		_starpu_mp_common_send_command(node, STARPU_MP_COMMAND_ANSWER_EXECUTION_DETACHED_SUBMITTED, NULL, 0);
-	else
-		_starpu_mp_common_send_command(node, STARPU_MP_COMMAND_ANSWER_EXECUTION_SUBMITTED, NULL, 0);
-
+	/* The host does not wait for an answer, it will get notified of the
+	 * completion */
 	//_STARPU_DEBUG("executing the task %p\n", task->kernel);
 	_starpu_sink_common_execute_thread(node, task);
 }
@@ -17,6 +17,7 @@
  */
 
 #include <string.h>
+#include <sys/uio.h>
 #include <starpu.h>
 #include <core/task.h>
 #include <core/sched_policy.h>
@@ -29,6 +30,7 @@
 #include <drivers/mp_common/mp_common.h>
 #include <drivers/mp_common/source_common.h>
 #include <common/knobs.h>
+#include <common/uthash.h>
 
 struct starpu_save_thread_env
 {
@@ -67,6 +69,32 @@ static struct _starpu_sink_kernel
 	starpu_cpu_func_t func[];
 } *kernels[STARPU_NARCH];
 
+/* Buffers of a given size which were allocated on a sink but are not used,
+ * to serve allocations without a round trip to the sink. They are accounted
+ * in the used memory of the node, so that the memory manager sees them and
+ * gets them back through the reclaim node operation when it runs short */
+struct _starpu_src_alloc_pool
+{
+	UT_hash_handle hh;
+	size_t size;
+	/* Number of buffers to request at the next allocation miss */
+	int batch;
+	unsigned n, nalloc;
+	uintptr_t *addrs;
+};
+
+/* Pools of each memory node, protected by the connection mutex of the node */
+static struct _starpu_src_alloc_pool *alloc_pools[STARPU_MAXNODES];
+/* Amount of memory held in the pools of each memory node */
+static size_t alloc_pools_size[STARPU_MAXNODES];
+/* Maximum amount of memory held in the pools of a memory node */
+static starpu_ssize_t alloc_pools_max = -1;
+
+#define ALLOC_POOL_MAX_BATCH 16
+
+/* Size up to which asynchronous transfers to a sink are sent inline */
+static starpu_ssize_t inline_transfer_max = -1;
+
 static unsigned mp_node_memory_node(struct _starpu_mp_node *node)
 {
 	return starpu_worker_get_memory_node(node->baseworkerid);
@@ -75,6 +103,22 @@ static unsigned mp_node_memory_node(struct _starpu_mp_node *node)
 void _starpu_src_common_deinit(void)
 {
 	enum starpu_worker_archtype arch;
+	unsigned node;
+
+	/* The pooled buffers were given back to the sinks when the drivers
+	 * freed all their buffers, what is left went away with the sinks */
+	for (node = 0; node < STARPU_MAXNODES; node++)
+	{
+		struct _starpu_src_alloc_pool *pool, *tmp;
+
+		HASH_ITER(hh, alloc_pools[node], pool, tmp)
+		{
+			HASH_DEL(alloc_pools[node], pool);
+			free(pool->addrs);
+			free(pool);
+		}
+		alloc_pools_size[node] = 0;
+	}
 
 	for (arch = 0; arch < STARPU_NARCH; arch++)
 	{
@@ -450,9 +494,9 @@ int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
 				      unsigned nb_interfaces,
 				      void *cl_arg, size_t cl_arg_size, int detached)
 {
-	void *buffer, *arg =NULL;
+	void *buffer;
 	uintptr_t buffer_ptr;
-	int buffer_size = 0, arg_size =0;
+	int buffer_size = 0;
 	unsigned i;
 	starpu_ssize_t interface_size[nb_interfaces ? nb_interfaces : 1];
 	void *interface_ptr[nb_interfaces ? nb_interfaces : 1];
@@ -566,23 +610,14 @@ int _starpu_src_common_execute_kernel(struct _starpu_mp_node *node,
 
 	STARPU_PTHREAD_MUTEX_LOCK(&node->connection_mutex);
 
+	/* The sink does not answer, we will just get notified of the
+	 * completion, so the command can be sent along with the next ones,
+	 * see _starpu_src_common_worker_internal_work. The caller of a
+	 * detached execution however directly waits for its completion. */
 	if (detached)
 		_starpu_mp_common_send_command(node, STARPU_MP_COMMAND_EXECUTE_DETACHED, buffer, buffer_size);
 	else
-		_starpu_mp_common_send_command(node, STARPU_MP_COMMAND_EXECUTE, buffer, buffer_size);
-
-	enum _starpu_mp_command answer = _starpu_src_common_wait_command_sync(node, &arg, &arg_size);
-
-	if (answer == STARPU_MP_COMMAND_ERROR_EXECUTE_DETACHED)
-	{
-		STARPU_PTHREAD_MUTEX_UNLOCK(&node->connection_mutex);
-		return -EINVAL;
-	}
-
-	if (detached)
-		STARPU_ASSERT(answer == STARPU_MP_COMMAND_ANSWER_EXECUTION_DETACHED_SUBMITTED);
-	else
-		STARPU_ASSERT(answer == STARPU_MP_COMMAND_ANSWER_EXECUTION_SUBMITTED);
+		_starpu_mp_common_queue_command(node, STARPU_MP_COMMAND_EXECUTE, buffer, buffer_size);
 
 	STARPU_PTHREAD_MUTEX_UNLOCK(&node->connection_mutex);
 
@@ -711,37 +746,144 @@ struct _starpu_mp_node *_starpu_src_common_get_mp_node_from_memory_node(int memo
 	return _starpu_src_nodes[archtype][devid];
 }
 
+/* Keep ADDR in POOL, if the node has room left to account it */
+static int _starpu_src_common_alloc_pool_push(struct _starpu_src_alloc_pool *pool, unsigned dst_node, uintptr_t addr)
+{
+	if (alloc_pools_size[dst_node] + pool->size > (size_t) alloc_pools_max)
+		return -ENOMEM;
+	if (starpu_memory_allocate(dst_node, pool->size, 0) != 0)
+		return -ENOMEM;
+
+	if (pool->n == pool->nalloc)
+	{
+		pool->nalloc = pool->nalloc ? 2 * pool->nalloc : ALLOC_POOL_MAX_BATCH;
+		_STARPU_REALLOC(pool->addrs, pool->nalloc * sizeof(*pool->addrs));
+	}
+	pool->addrs[pool->n++] = addr;
+	alloc_pools_size[dst_node] += pool->size;
+	return 0;
+}
+
+/* Give back all the pooled buffers of DST_NODE to its sink, and return the
+ * amount of memory this released */
+static size_t _starpu_src_common_alloc_pool_flush(struct _starpu_mp_node *mp_node, unsigned dst_node)
+{
+	struct _starpu_src_alloc_pool *pool, *tmp;
+	size_t freed = alloc_pools_size[dst_node];
+
+	HASH_ITER(hh, alloc_pools[dst_node], pool, tmp)
+	{
+		while (pool->n)
+			_starpu_mp_common_queue_command(mp_node, STARPU_MP_COMMAND_FREE, &pool->addrs[--pool->n], sizeof(pool->addrs[0]));
+		/* Allocations of this size are not worth batching any more */
+		pool->batch = 1;
+	}
+	alloc_pools_size[dst_node] = 0;
+	if (freed)
+		starpu_memory_deallocate(dst_node, freed);
+	return freed;
+}
+
+/* Called by the memory manager when it runs short of memory on DST_NODE */
+size_t _starpu_src_common_reclaim(unsigned dst_node)
+{
+	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(dst_node);
+	size_t freed;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
+	freed = _starpu_src_common_alloc_pool_flush(mp_node, dst_node);
+	if (freed)
+		/* Let the sink actually release them now */
+		_starpu_mp_common_flush_commands(mp_node);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+
+	return freed;
+}
+
 /* Send a request to the sink linked to the MP_NODE to allocate SIZE bytes on
  * the sink.
- * In case of success, it returns 0 and *ADDR contains the address of the
- * allocated area ;
- * else it returns 1 if the allocation fail.
+ * In case of success, it returns the address of the allocated area ;
+ * else it returns 0 if the allocation fail.
+ * To save round trips, allocations are served from the buffers kept in the
+ * pool for that size when possible, and when the pool is empty we ask the sink
+ * for several buffers at a time, as more and more allocations of that size are
+ * requested.
  */
 uintptr_t _starpu_src_common_allocate(unsigned dst_node, size_t size, int flags)
 {
 	(void) flags;
 	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(dst_node);
+	struct _starpu_src_alloc_pool *pool;
+	struct _starpu_mp_allocate_command cmd = { .size = size, .count = 1 };
 	enum _starpu_mp_command answer;
 	void *arg;
 	int arg_size;
 	uintptr_t addr;
+	int n, i;
+
+	if (alloc_pools_max < 0)
+		alloc_pools_max = starpu_getenv_number_default("STARPU_MS_ALLOC_POOL", 16) * 1024 * 1024;
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
 
-	_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ALLOCATE, &size,
-			sizeof(size));
+	HASH_FIND(hh, alloc_pools[dst_node], &size, sizeof(size), pool);
+	if (pool && pool->n)
+	{
+		addr = pool->addrs[--pool->n];
+		alloc_pools_size[dst_node] -= size;
+		/* The caller accounts it on its own */
+		starpu_memory_deallocate(dst_node, size);
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+		return addr;
+	}
+
+	if (alloc_pools_max > 0 && (size_t) alloc_pools_max >= size)
+	{
+		if (!pool)
+		{
+			_STARPU_CALLOC(pool, 1, sizeof(*pool));
+			pool->size = size;
+			pool->batch = 1;
+			HASH_ADD(hh, alloc_pools[dst_node], size, sizeof(pool->size), pool);
+		}
+		/* The extra buffers have to fit in the pool */
+		cmd.count = STARPU_MIN((size_t) pool->batch, ((size_t) alloc_pools_max - alloc_pools_size[dst_node]) / size + 1);
+		/* The answer has to fit in the buffer */
+		cmd.count = STARPU_MIN(cmd.count, (int) (BUFFER_SIZE / sizeof(addr)));
+		pool->batch = STARPU_MIN(2 * pool->batch, ALLOC_POOL_MAX_BATCH);
+	}
+
+	_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ALLOCATE, &cmd, sizeof(cmd));
 
 	answer = _starpu_src_common_wait_command_sync(mp_node, &arg, &arg_size);
 
+	if (answer == STARPU_MP_COMMAND_ERROR_ALLOCATE && alloc_pools_size[dst_node])
+	{
+		/* Give the unused buffers back, and retry */
+		_starpu_src_common_alloc_pool_flush(mp_node, dst_node);
+		cmd.count = 1;
+		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_ALLOCATE, &cmd, sizeof(cmd));
+		answer = _starpu_src_common_wait_command_sync(mp_node, &arg, &arg_size);
+	}
+
 	if (answer == STARPU_MP_COMMAND_ERROR_ALLOCATE)
 	{
 		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
 		return 0;
 	}
 
-	STARPU_ASSERT(answer == STARPU_MP_COMMAND_ANSWER_ALLOCATE && arg_size == sizeof(addr));
+	STARPU_ASSERT(answer == STARPU_MP_COMMAND_ANSWER_ALLOCATE && arg_size >= (int) sizeof(addr) && arg_size % sizeof(addr) == 0);
 
-	memcpy(&addr, arg, arg_size);
+	n = arg_size / sizeof(addr);
+	memcpy(&addr, arg, sizeof(addr));
+	for (i = 1; i < n; i++)
+	{
+		uintptr_t extra;
+		memcpy(&extra, (char *) arg + i * sizeof(addr), sizeof(extra));
+		if (_starpu_src_common_alloc_pool_push(pool, dst_node, extra) != 0)
+			/* Other allocations took the room meanwhile */
+			_starpu_mp_common_queue_command(mp_node, STARPU_MP_COMMAND_FREE, &extra, sizeof(extra));
+	}
 
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
 
@@ -749,15 +891,19 @@ uintptr_t _starpu_src_common_allocate(unsigned dst_node, size_t size, int flags)
 }
 
 /* Send a request to the sink linked to the MP_NODE to deallocate the memory
- * area pointed by ADDR.
+ * area pointed by ADDR, or keep it in the pool for next allocations.
  */
 void _starpu_src_common_free(unsigned dst_node, uintptr_t addr, size_t size, int flags)
 {
 	(void) flags;
-	(void) size;
 	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(dst_node);
+	struct _starpu_src_alloc_pool *pool;
+
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
-	_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_FREE, &addr, sizeof(addr));
+	HASH_FIND(hh, alloc_pools[dst_node], &size, sizeof(size), pool);
+	if (!pool || _starpu_src_common_alloc_pool_push(pool, dst_node, addr) != 0)
+		/* No need to wait for the sink, send it along with the next commands */
+		_starpu_mp_common_queue_command(mp_node, STARPU_MP_COMMAND_FREE, &addr, sizeof(addr));
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
 }
 
@@ -794,6 +940,7 @@ uintptr_t _starpu_src_common_map(unsigned dst_node, uintptr_t addr, size_t size)
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
 
 	_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_MAP, map_cmd, map_cmd_size);
+	free(map_cmd);
 
 	answer = _starpu_src_common_wait_command_sync(mp_node, &arg, &arg_size);
 
@@ -809,8 +956,6 @@ uintptr_t _starpu_src_common_map(unsigned dst_node, uintptr_t addr, size_t size)
 
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
 
-	free(map_cmd);
-
 	return map_addr;
 }
 
@@ -825,7 +970,7 @@ void _starpu_src_common_unmap(unsigned dst_node, uintptr_t addr, size_t size)
 	struct _starpu_mp_transfer_unmap_command unmap_cmd = {.addr = addr, .size = size};
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
-	_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_UNMAP, &unmap_cmd, sizeof(unmap_cmd));
+	_starpu_mp_common_queue_command(mp_node, STARPU_MP_COMMAND_UNMAP, &unmap_cmd, sizeof(unmap_cmd));
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
 }
 
@@ -871,12 +1016,22 @@ int _starpu_src_common_copy_host_to_sink_async(struct _starpu_mp_node *mp_node,
 	return -EAGAIN;
 }
 
+/* Whether a transfer of SIZE bytes to a sink is better sent inline: the sink
+ * receives it in order with the commands, so the tasks which use the data
+ * can be sent right away instead of waiting for a completion notification */
+static int _starpu_src_common_inline_transfer(size_t size)
+{
+	if (inline_transfer_max < 0)
+		inline_transfer_max = starpu_getenv_number_default("STARPU_MS_INLINE_TRANSFER", 16384);
+	return size <= (size_t) inline_transfer_max;
+}
+
 int _starpu_src_common_copy_data_host_to_sink(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel)
 {
 	(void) src_node;
 	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(dst_node);
 
-	if (async_channel)
+	if (async_channel && !_starpu_src_common_inline_transfer(size))
 		return _starpu_src_common_copy_host_to_sink_async(mp_node,
 						(void*) (src + src_offset),
 						(void*) (dst + dst_offset),
@@ -954,6 +1109,227 @@ int _starpu_src_common_copy_data_sink_to_host(uintptr_t src, size_t src_offset,
 						size);
 }
 
+/* Send the NVEC pieces described by VEC from SRC to DST on the sink linked to
+ * DST_NODE. The pieces which are contiguous on the sink are gathered with
+ * dt_sendv into one message, so that one command is sent per run of them.
+ */
+int _starpu_src_common_copyv_data_host_to_sink(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel)
+{
+	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(dst_node);
+	struct iovec *iov = NULL;
+	unsigned i, j, n;
+	int ret = 0;
+
+	for (i = 0; i < nvec; i += n)
+	{
+		n = 1;
+		if (mp_node->dt_sendv)
+			n = _starpu_copy_vec_dst_run(vec + i, nvec - i, _STARPU_IOV_MAX);
+		if (n == 1)
+		{
+			if (_starpu_src_common_copy_data_host_to_sink(src, vec[i].src_offset, src_node,
+								      dst, vec[i].dst_offset, dst_node,
+								      vec[i].size, async_channel))
+				ret = -EAGAIN;
+			continue;
+		}
+
+		struct _starpu_mp_transfer_command cmd = {.size = 0, .addr = (void *) (dst + vec[i].dst_offset), .event = async_channel};
+
+		if (!iov)
+			_STARPU_MALLOC(iov, STARPU_MIN(nvec, _STARPU_IOV_MAX) * sizeof(*iov));
+		for (j = 0; j < n; j++)
+		{
+			iov[j].iov_base = (void *) (src + vec[i+j].src_offset);
+			iov[j].iov_len = vec[i+j].size;
+			cmd.size += vec[i+j].size;
+		}
+
+		STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
+		if (async_channel && !_starpu_src_common_inline_transfer(cmd.size))
+		{
+			async_channel->polling_node_receiver = mp_node;
+			_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_RECV_FROM_HOST_ASYNC, &cmd, sizeof(cmd));
+			mp_node->dt_sendv(mp_node, iov, n, async_channel);
+			ret = -EAGAIN;
+		}
+		else
+		{
+			_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_RECV_FROM_HOST, &cmd, sizeof(cmd));
+			mp_node->dt_sendv(mp_node, iov, n, NULL);
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+	}
+
+	free(iov);
+	return ret;
+}
+
+/* Receive the NVEC pieces described by VEC from SRC on the sink linked to
+ * SRC_NODE to DST. The pieces which are contiguous on the sink are requested
+ * with one command and scattered with dt_recvv.
+ */
+int _starpu_src_common_copyv_data_sink_to_host(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel)
+{
+	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(src_node);
+	struct iovec *iov = NULL;
+	unsigned i, j, n;
+	int ret = 0;
+
+	for (i = 0; i < nvec; i += n)
+	{
+		n = 1;
+		if (mp_node->dt_recvv)
+			n = _starpu_copy_vec_src_run(vec + i, nvec - i, _STARPU_IOV_MAX);
+		if (n == 1)
+		{
+			if (_starpu_src_common_copy_data_sink_to_host(src, vec[i].src_offset, src_node,
+								      dst, vec[i].dst_offset, dst_node,
+								      vec[i].size, async_channel))
+				ret = -EAGAIN;
+			continue;
+		}
+
+		struct _starpu_mp_transfer_command cmd = {.size = 0, .addr = (void *) (src + vec[i].src_offset), .event = async_channel};
+
+		if (!iov)
+			_STARPU_MALLOC(iov, STARPU_MIN(nvec, _STARPU_IOV_MAX) * sizeof(*iov));
+		for (j = 0; j < n; j++)
+		{
+			iov[j].iov_base = (void *) (dst + vec[i+j].dst_offset);
+			iov[j].iov_len = vec[i+j].size;
+			cmd.size += vec[i+j].size;
+		}
+
+		STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
+		if (async_channel)
+		{
+			async_channel->polling_node_sender = mp_node;
+			_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_SEND_TO_HOST_ASYNC, &cmd, sizeof(cmd));
+			mp_node->dt_recvv(mp_node, iov, n, async_channel);
+			ret = -EAGAIN;
+		}
+		else
+		{
+			enum _starpu_mp_command answer;
+			void *arg;
+			int arg_size;
+
+			_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_SEND_TO_HOST, &cmd, sizeof(cmd));
+			answer = _starpu_src_common_wait_command_sync(mp_node, &arg, &arg_size);
+			STARPU_ASSERT(answer == STARPU_MP_COMMAND_SEND_TO_HOST);
+			mp_node->dt_recvv(mp_node, iov, n, NULL);
+		}
+		STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+	}
+
+	free(iov);
+	return ret;
+}
+
+/* Fill CMD with up to _STARPU_MP_TRANSFER_VEC_MAX pieces of PIECES, taking
+ * their sink address from SINK_DST or not, and IOV with their host address.
+ * Return the number of pieces. */
+static int _starpu_src_common_fill_vec_command(struct _starpu_mp_transfer_vec_command *cmd, struct iovec *iov, const struct _starpu_copy_batch_piece *pieces, unsigned npieces, int sink_dst)
+{
+	int n = STARPU_MIN(npieces, _STARPU_MP_TRANSFER_VEC_MAX);
+	int j;
+
+	cmd->npieces = n;
+	for (j = 0; j < n; j++)
+	{
+		uintptr_t src = pieces[j].src + pieces[j].src_offset;
+		uintptr_t dst = pieces[j].dst + pieces[j].dst_offset;
+		cmd->pieces[j].addr = (void *) (sink_dst ? dst : src);
+		cmd->pieces[j].size = pieces[j].size;
+		iov[j].iov_base = (void *) (sink_dst ? src : dst);
+		iov[j].iov_len = pieces[j].size;
+	}
+	return n;
+}
+
+/* Send the NPIECES pieces of a batch of transfers to the sink linked to
+ * DST_NODE: one command tells the sink where to scatter them, and they are
+ * gathered with dt_sendv into one message.
+ */
+int _starpu_src_common_copy_batch_data_host_to_sink(const struct _starpu_copy_batch_piece *pieces, unsigned npieces, unsigned src_node, unsigned dst_node, struct _starpu_async_channel *async_channel)
+{
+	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(dst_node);
+	struct _starpu_mp_transfer_vec_command *cmd;
+	struct iovec *iov;
+	unsigned i;
+	int n;
+
+	STARPU_ASSERT(async_channel);
+	if (!mp_node->dt_sendv)
+	{
+		int ret = 0;
+		for (i = 0; i < npieces; i++)
+			if (_starpu_src_common_copy_data_host_to_sink(pieces[i].src, pieces[i].src_offset, src_node, pieces[i].dst, pieces[i].dst_offset, dst_node, pieces[i].size, async_channel))
+				ret = -EAGAIN;
+		return ret;
+	}
+
+	n = STARPU_MIN(npieces, _STARPU_MP_TRANSFER_VEC_MAX);
+	_STARPU_MALLOC(cmd, sizeof(*cmd) + n * sizeof(cmd->pieces[0]));
+	_STARPU_MALLOC(iov, n * sizeof(*iov));
+	cmd->event = async_channel;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
+	async_channel->polling_node_receiver = mp_node;
+	for (i = 0; i < npieces; i += n)
+	{
+		n = _starpu_src_common_fill_vec_command(cmd, iov, pieces + i, npieces - i, 1);
+		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_RECV_FROM_HOST_VEC_ASYNC, cmd, sizeof(*cmd) + n * sizeof(cmd->pieces[0]));
+		mp_node->dt_sendv(mp_node, iov, n, async_channel);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+
+	free(iov);
+	free(cmd);
+	return -EAGAIN;
+}
+
+/* Receive the NPIECES pieces of a batch of transfers from the sink linked to
+ * SRC_NODE: one command tells the sink where to gather them from, and they are
+ * scattered with dt_recvv from one message.
+ */
+int _starpu_src_common_copy_batch_data_sink_to_host(const struct _starpu_copy_batch_piece *pieces, unsigned npieces, unsigned src_node, unsigned dst_node, struct _starpu_async_channel *async_channel)
+{
+	struct _starpu_mp_node *mp_node = _starpu_src_common_get_mp_node_from_memory_node(src_node);
+	struct _starpu_mp_transfer_vec_command *cmd;
+	struct iovec *iov;
+	unsigned i;
+	int n;
+
+	STARPU_ASSERT(async_channel);
+	if (!mp_node->dt_recvv)
+	{
+		for (i = 0; i < npieces; i++)
+			_starpu_src_common_copy_data_sink_to_host(pieces[i].src, pieces[i].src_offset, src_node, pieces[i].dst, pieces[i].dst_offset, dst_node, pieces[i].size, async_channel);
+		return -EAGAIN;
+	}
+
+	n = STARPU_MIN(npieces, _STARPU_MP_TRANSFER_VEC_MAX);
+	_STARPU_MALLOC(cmd, sizeof(*cmd) + n * sizeof(cmd->pieces[0]));
+	_STARPU_MALLOC(iov, n * sizeof(*iov));
+	cmd->event = async_channel;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
+	async_channel->polling_node_sender = mp_node;
+	for (i = 0; i < npieces; i += n)
+	{
+		n = _starpu_src_common_fill_vec_command(cmd, iov, pieces + i, npieces - i, 0);
+		_starpu_mp_common_send_command(mp_node, STARPU_MP_COMMAND_SEND_TO_HOST_VEC_ASYNC, cmd, sizeof(*cmd) + n * sizeof(cmd->pieces[0]));
+		mp_node->dt_recvv(mp_node, iov, n, async_channel);
+	}
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+
+	free(iov);
+	free(cmd);
+	return -EAGAIN;
+}
+
 /* Tell the sink linked to SRC_NODE to send SIZE bytes of data pointed by SRC
  * to the sink linked to DST_NODE. The latter store them in DST with a synchronous
  * mode.
@@ -1175,6 +1551,11 @@ static void _starpu_src_common_worker_internal_work(struct _starpu_worker_set *
 		}
 	}
 
+	/* Send the executions all at once */
+	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
+	_starpu_mp_common_flush_commands(mp_node);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->connection_mutex);
+
 	res |= __starpu_datawizard_progress(_STARPU_DATAWIZARD_DO_ALLOC, 1);
 
 	/* Handle message which have been store */
@@ -1182,6 +1563,9 @@ static void _starpu_src_common_worker_internal_work(struct _starpu_worker_set *
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->connection_mutex);
 
+	/* Send the frees queued by the progression */
+	_starpu_mp_common_flush_commands(mp_node);
+
 	unsigned stopped_progress = 0;
 	/* poll the device for completed jobs.*/
 	while(mp_node->nt_recv_is_ready(mp_node))
@@ -53,6 +53,7 @@ void(* _starpu_src_common_get_cpu_func_from_job(const struct _starpu_mp_node *no
 struct _starpu_mp_node *_starpu_src_common_get_mp_node_from_memory_node(int memory_node);
 uintptr_t _starpu_src_common_allocate(unsigned dst_node, size_t size, int flags);
 void _starpu_src_common_free(unsigned dst_node, uintptr_t addr, size_t size, int flags);
+size_t _starpu_src_common_reclaim(unsigned dst_node);
 
 uintptr_t _starpu_src_common_map(unsigned dst_node, uintptr_t addr, size_t size);
 void _starpu_src_common_unmap(unsigned dst_node, uintptr_t addr, size_t size);
@@ -80,6 +81,10 @@ int _starpu_src_common_copy_sink_to_sink_async(struct _starpu_mp_node *src_node,
 
 int _starpu_src_common_copy_data_host_to_sink(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel);
 int _starpu_src_common_copy_data_sink_to_host(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel);
+int _starpu_src_common_copyv_data_host_to_sink(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel);
+int _starpu_src_common_copyv_data_sink_to_host(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel);
+int _starpu_src_common_copy_batch_data_host_to_sink(const struct _starpu_copy_batch_piece *pieces, unsigned npieces, unsigned src_node, unsigned dst_node, struct _starpu_async_channel *async_channel);
+int _starpu_src_common_copy_batch_data_sink_to_host(const struct _starpu_copy_batch_piece *pieces, unsigned npieces, unsigned src_node, unsigned dst_node, struct _starpu_async_channel *async_channel);
 int _starpu_src_common_copy_data_sink_to_sink(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel);
 
 void _starpu_src_common_init_switch_env(unsigned this);
@@ -365,6 +365,7 @@ struct _starpu_node_ops _starpu_driver_mpi_ms_node_ops =
 
 	.malloc_on_node = _starpu_src_common_allocate,
 	.free_on_node = _starpu_src_common_free,
+	.reclaim = _starpu_src_common_reclaim,
 
 	.is_direct_access_supported = _starpu_mpi_is_direct_access_supported,
 
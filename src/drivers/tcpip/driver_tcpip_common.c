@@ -15,6 +15,7 @@
  */
 
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <sys/un.h>
 #ifdef HAVE_UNISTD_H
@@ -27,8 +28,10 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <poll.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <pthread.h>
-#include <signal.h>
 #include <core/workers.h>
 #include <core/perfmodel/perfmodel.h>
 #include <drivers/mp_common/source_common.h>
@@ -70,9 +73,10 @@ static int is_running;
 static struct _starpu_spinlock ListLock;
 
 static starpu_pthread_t thread_pending;
-static int thread_pipe[2];
-
-static pthread_t master_thread;
+/*wakes the pending thread up when requests are queued*/
+static int thread_efd;
+/*wakes _starpu_tcpip_common_wait up when requests are completed or messages are queued*/
+static int completion_efd;
 
 struct _starpu_tcpip_socket *tcpip_sock;
 
@@ -90,6 +94,11 @@ int _starpu_tcpip_mp_has_local()
 	return 0;
 }
 
+int _starpu_tcpip_common_is_local(const struct _starpu_mp_node *mp_node)
+{
+	return local_flag[mp_node->peer_id] == 1;
+}
+
 MULTILIST_CREATE_TYPE(_starpu_tcpip_ms_request, event); /*_starpu_tcpip_ms_request_multilist_event*/
 MULTILIST_CREATE_TYPE(_starpu_tcpip_ms_request, thread); /*_starpu_tcpip_ms_request_multilist_thread*/
 MULTILIST_CREATE_TYPE(_starpu_tcpip_ms_request, pending); /*_starpu_tcpip_ms_request_multilist_pending*/
@@ -106,6 +115,11 @@ struct _starpu_tcpip_ms_request
 	struct _starpu_tcpip_socket *remote_sock;
 	/*the message to send/receive*/
 	char* buf;
+	/*or the buffers to gather/scatter it from/to, advanced along the transfer*/
+	struct iovec *iov;
+	int iovcnt;
+	/*the allocated array of buffers*/
+	struct iovec *iov_alloc;
 	/*the length of message*/
 	int len;
 	/*a flag to detect wether the operation is completed*/
@@ -146,275 +160,395 @@ static inline struct _starpu_tcpip_ms_async_event *_starpu_tcpip_ms_async_event(
 struct _starpu_tcpip_req_pending
 {
 	int remote_sock;
+	/*the struct of remote socket, for the zerocopy send counters*/
+	struct _starpu_tcpip_socket *sock;
+	/*per-socket queues of requests, processed in order*/
 	struct _starpu_tcpip_ms_request_multilist_thread send_list;
 	struct _starpu_tcpip_ms_request_multilist_thread recv_list;
 	struct _starpu_tcpip_ms_request_multilist_pending pending_list;
+	/*whether the last edge reported by epoll says we can read/write without blocking*/
+	int readable;
+	int writable;
 	UT_hash_handle hh;
 };
 
-//function thread
-static void * _starpu_tcpip_thread_pending()
+/* Gather the buffers of the requests of the list, from the first one, in IOV.
+ * Return the number of buffers. */
+static int _starpu_tcpip_ms_request_gather(struct _starpu_tcpip_ms_request_multilist_thread *list, struct iovec *iov)
 {
-	fd_set reads;
-	fd_set writes;
-	int fdmax=0;
-
-	struct _starpu_tcpip_req_pending *pending_tables = NULL;
-	struct _starpu_tcpip_req_pending *table, *tmp;
+	struct _starpu_tcpip_ms_request *req;
+	int iovcnt = 0;
 
-	FD_ZERO(&reads);
-	FD_ZERO(&writes);
+	for (req = _starpu_tcpip_ms_request_multilist_begin_thread(list);
+	     req != _starpu_tcpip_ms_request_multilist_end_thread(list) && iovcnt < _STARPU_IOV_MAX;
+	     req = _starpu_tcpip_ms_request_multilist_next_thread(req))
+	{
+		if (req->iov)
+		{
+			int n = STARPU_MIN(req->iovcnt, _STARPU_IOV_MAX - iovcnt);
+			memcpy(&iov[iovcnt], req->iov, n * sizeof(*iov));
+			iovcnt += n;
+		}
+		else
+		{
+			iov[iovcnt].iov_base = req->buf + req->offset;
+			iov[iovcnt].iov_len = req->len - req->offset;
+			iovcnt++;
+		}
+	}
+	return iovcnt;
+}
 
-	FD_SET(thread_pipe[0], &reads);
-	fd_set reads2;
-	fd_set writes2;
+static void _starpu_tcpip_ms_request_complete(struct _starpu_tcpip_ms_request *req)
+{
+	req->flag_completed = 1;
+	starpu_sem_post(&req->sem_wait_request);
+}
 
-	fdmax = thread_pipe[0];
+/* Account SIZE bytes transferred for the requests of the list, from the first
+ * one, and complete the requests which are finished. Return the number of
+ * completed requests. */
+static int _starpu_tcpip_ms_request_advance(struct _starpu_tcpip_req_pending *table, struct _starpu_tcpip_ms_request_multilist_thread *list, size_t size, int zerocopy)
+{
+	int ncompleted = 0;
 
-	while(is_running)
+	while (size > 0)
 	{
-		_SELECT_PRINT("in while\n");
-		reads2 = reads;
-		writes2 = writes;
+		struct _starpu_tcpip_ms_request *req = _starpu_tcpip_ms_request_multilist_begin_thread(list);
+		int n = STARPU_MIN(size, (size_t) (req->len - req->offset));
+
+		if (zerocopy && req->offset == 0)
+			/*the buffer has to be kept until the kernel notifies it is done with it*/
+			_starpu_tcpip_ms_request_multilist_push_back_pending(&table->pending_list, req);
+
+		req->offset += n;
+		if (req->iov)
+			_starpu_iovec_advance(&req->iov, &req->iovcnt, n);
+		size -= n;
+
+		_SELECT_PRINT("offset after transfer is %d\n", req->offset);
 
-		int ret;
-		ret=select(fdmax+1, &reads2, &writes2, NULL, NULL);
-		STARPU_ASSERT(ret>=0);
+		if (req->offset == req->len)
+		{
+			_starpu_tcpip_ms_request_multilist_erase_thread(list, req);
+			if (zerocopy)
+			{
+				req->send_end = table->sock->nbsend;
+				_ZC_PRINT("send end after send is %d\n", req->send_end);
+			}
+			else
+			{
+				_starpu_tcpip_ms_request_complete(req);
+				ncompleted++;
+			}
+		}
+	}
+	return ncompleted;
+}
+
+/* Send as much as possible of the queued messages of the socket, gathered in
+ * as few system calls as possible. Return the number of completed requests. */
+static int _starpu_tcpip_send_progress(struct _starpu_tcpip_req_pending *table)
+{
+	struct iovec iov[_STARPU_IOV_MAX];
+	int ncompleted = 0;
+	int zerocopy = 0;
+#ifdef SO_ZEROCOPY
+	zerocopy = table->sock->zerocopy > 0;
+#endif
+
+	while (table->writable && !_starpu_tcpip_ms_request_multilist_empty_thread(&table->send_list))
+	{
+		struct msghdr mh = {};
+		int flags = 0;
+		starpu_ssize_t res;
 
-		if(FD_ISSET(thread_pipe[0], &reads2))
+		mh.msg_iov = iov;
+		mh.msg_iovlen = _starpu_tcpip_ms_request_gather(&table->send_list, iov);
+#ifdef SO_ZEROCOPY
+		if (zerocopy)
+			flags = MSG_ZEROCOPY;
+#endif
+		res = sendmsg(table->remote_sock, &mh, flags);
+		_SELECT_PRINT("send res is %d\n", (int) res);
+		if (res < 0)
 		{
-			char buf[16];
-			int n=read(thread_pipe[0], buf, sizeof(buf));
-			STARPU_ASSERT(n>=0);
-			if(!is_running)
+			if (errno == EINTR)
+				continue;
+			/* With MSG_ZEROCOPY, ENOBUFS means we have to wait for notifications */
+			if (errno == EAGAIN || errno == EWOULDBLOCK || (zerocopy && errno == ENOBUFS))
+			{
+				table->writable = 0;
 				break;
+			}
+			STARPU_ASSERT_MSG(0, "TCP/IP Master/Slave cannot send a msg asynchronous, the error is %s ", strerror(errno));
+		}
+		if (zerocopy)
+			table->sock->nbsend++;
 
-			int i;
-			for(i=0; i<n; i++)
+		ncompleted += _starpu_tcpip_ms_request_advance(table, &table->send_list, res, zerocopy);
+	}
+	return ncompleted;
+}
+
+/* Receive as much as possible of the data expected on the socket, scattered
+ * to the queued requests. Return the number of completed requests. */
+static int _starpu_tcpip_recv_progress(struct _starpu_tcpip_req_pending *table)
+{
+	struct iovec iov[_STARPU_IOV_MAX];
+	int ncompleted = 0;
+
+	while (table->readable && !_starpu_tcpip_ms_request_multilist_empty_thread(&table->recv_list))
+	{
+		int iovcnt = _starpu_tcpip_ms_request_gather(&table->recv_list, iov);
+		starpu_ssize_t res = readv(table->remote_sock, iov, iovcnt);
+		_SELECT_PRINT("read res is %d\n", (int) res);
+		if (res < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
 			{
-				_SELECT_PRINT("pop push loop %d\n", i);
-				_starpu_spin_lock(&ListLock);
-				STARPU_ASSERT(!_starpu_tcpip_ms_request_multilist_empty_thread(&thread_list));
-				struct _starpu_tcpip_ms_request * req_thread = _starpu_tcpip_ms_request_multilist_pop_front_thread(&thread_list);
-				_starpu_spin_unlock(&ListLock);
+				table->readable = 0;
+				break;
+			}
+		}
+		STARPU_ASSERT_MSG(res > 0, "TCP/IP Master/Slave cannot read a msg asynchronous, the result of read is %d, the error is %s ", (int) res, strerror(errno));
 
-				int remote_sock = req_thread->remote_sock->async_sock;
-				int is_sender = req_thread->is_sender;
+		ncompleted += _starpu_tcpip_ms_request_advance(table, &table->recv_list, res, 0);
+	}
+	return ncompleted;
+}
 
-				HASH_FIND_INT(pending_tables, &remote_sock, table);
-				if(table == NULL)
-				{
-					_STARPU_MALLOC(table, sizeof(*table));
-					table->remote_sock = remote_sock;
-					_starpu_tcpip_ms_request_multilist_head_init_thread(&table->send_list);
-					_starpu_tcpip_ms_request_multilist_head_init_thread(&table->recv_list);
-					_starpu_tcpip_ms_request_multilist_head_init_pending(&table->pending_list);
-					HASH_ADD_INT(pending_tables, remote_sock, table);
+#ifdef SO_ZEROCOPY
+/* Process the notifications of the kernel that it is done with the buffers
+ * sent with MSG_ZEROCOPY. Return the number of completed requests. */
+static int _starpu_tcpip_zerocopy_progress(struct _starpu_tcpip_req_pending *table)
+{
+	int ncompleted = 0;
 
-				}
-				if(is_sender)
-				{
-					_starpu_tcpip_ms_request_multilist_push_back_thread(&table->send_list, req_thread);
-					FD_SET(remote_sock, &writes);
-				}
-				else
-				{
-					_starpu_tcpip_ms_request_multilist_push_back_thread(&table->recv_list, req_thread);
-					FD_SET(remote_sock, &reads);
-				}
+	while (1)
+	{
+		struct sock_extended_err *serr;
+		struct msghdr mg = {};
+		struct cmsghdr *cm;
+		uint32_t hi, lo;
+		char control[100];
+
+		mg.msg_control = control;
+		mg.msg_controllen = sizeof(control);
+
+		_ZC_PRINT("before recvmsg\n");
+		int r = recvmsg(table->remote_sock, &mg, MSG_ERRQUEUE);
+		if (r == -1 && errno == EINTR)
+			continue;
+		if (r == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (r == -1)
+			error(1, errno, "recvmsg notification");
+		if (mg.msg_flags & MSG_CTRUNC)
+			error(1, errno, "recvmsg notification: truncated");
 
-				if(remote_sock > fdmax)
-					fdmax=remote_sock;
-			}
+		cm = CMSG_FIRSTHDR(&mg);
+		if (!cm)
+			error(1, 0, "cmsg: no cmsg");
 
-		}
+		serr = (void *) CMSG_DATA(cm);
 
-		HASH_ITER(hh, pending_tables, table, tmp)
-		{
-			int remote_sock = table->remote_sock;
-			_SELECT_PRINT("remote_sock in loop is %d\n", remote_sock);
+		if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+			error(1, 0, "serr: wrong origin: %u", serr->ee_origin);
+		if (serr->ee_errno != 0)
+			error(1, 0, "serr: wrong error code: %u", serr->ee_errno);
 
-			void socket_action(what_t what, const char * whatstr, struct _starpu_tcpip_ms_request_multilist_thread *list, fd_set * fdset)
-			{
-				struct _starpu_tcpip_ms_request * req = _starpu_tcpip_ms_request_multilist_begin_thread(list);
-				char* msg = req->buf;
-				int len = req->len;
+		if (serr->ee_code != SO_EE_CODE_ZEROCOPY_COPIED && !_starpu_tcpip_ms_request_multilist_empty_pending(&table->pending_list))
+			_starpu_tcpip_ms_request_multilist_begin_pending(&table->pending_list)->zerocopy = 0;
 
-				int res = 0;
-				res = what(remote_sock, msg+req->offset, len-req->offset);
-				_SELECT_PRINT("%s res is %d\n", whatstr, res);
-				STARPU_ASSERT_MSG(res > 0, "TCP/IP Master/Slave cannot %s a msg asynchronous with a size of %d Bytes!, the result of %s is %d, the error is %s ", whatstr, len, whatstr, res, strerror(errno));
-				req->offset+=res;
+		hi = serr->ee_data;
+		lo = serr->ee_info;
 
-				_SELECT_PRINT("offset after %s is %d\n", whatstr, req->offset);
+		_ZC_PRINT("h=%u l=%u\n", hi, lo);
 
-				if(req->offset == len)
-				{
-					_starpu_tcpip_ms_request_multilist_erase_thread(list, req);
+		STARPU_ASSERT(lo == table->sock->nback);
+		STARPU_ASSERT(hi < table->sock->nbsend);
 
-					if(_starpu_tcpip_ms_request_multilist_empty_thread(list))
-						FD_CLR(remote_sock, fdset);
+		table->sock->nback = hi+1;
 
-					req->flag_completed = 1;
-					starpu_sem_post(&req->sem_wait_request);
+		while(!_starpu_tcpip_ms_request_multilist_empty_pending(&table->pending_list))
+		{
+			struct _starpu_tcpip_ms_request * req_tmp = _starpu_tcpip_ms_request_multilist_begin_pending(&table->pending_list);
 
-					/*send the signal that message is ready */
-					struct _starpu_mp_node *node = NULL;
-					_starpu_tcpip_common_signal(node);
-				}
+			/* send_end is only set once the request is entirely sent */
+			if(req_tmp->send_end && hi+1 >= req_tmp->send_end)
+			{
+				_starpu_tcpip_ms_request_multilist_erase_pending(&table->pending_list, req_tmp);
+				_starpu_tcpip_ms_request_complete(req_tmp);
+				ncompleted++;
 			}
+			else
+				break;
+		}
+	}
 
-			if(FD_ISSET(remote_sock, &writes2))
-			{
-#ifdef SO_ZEROCOPY
-				struct pollfd pfd;
-				pfd.fd = remote_sock;
-				pfd.events = POLLERR|POLLOUT;
-				pfd.revents = 0;
-				if(poll(&pfd, 1, -1) <= 0)
-					error(1, errno, "poll");
-
-				if(pfd.revents & POLLERR)
-				{
-					struct _starpu_tcpip_ms_request * req_pending = _starpu_tcpip_ms_request_multilist_begin_pending(&table->pending_list);
-					_ZC_PRINT("nbsend is %d\n", req_pending->remote_sock->nbsend);
-					struct sock_extended_err *serr;
-					struct msghdr mg = {};
-					struct cmsghdr *cm;
-					uint32_t hi, lo;
-					char control[100];
+	/* Some room may have been made for more zerocopy sends */
+	table->writable = 1;
 
-					mg.msg_control = control;
-					mg.msg_controllen = sizeof(control);
+	return ncompleted;
+}
+#endif
 
-					_ZC_PRINT("before recvmsg\n");
-					int r = recvmsg(remote_sock, &mg, MSG_ERRQUEUE);
-					// if (r == -1 && errno == EAGAIN)
-					//	   continue;
-					if (r == -1)
-						error(1, errno, "recvmsg notification");
-					if (mg.msg_flags & MSG_CTRUNC)
-						error(1, errno, "recvmsg notification: truncated");
+/* Get the requests queued by _starpu_tcpip_common_action_socket, and start
+ * processing them. Return the number of completed requests. */
+static int _starpu_tcpip_thread_new_requests(int epoll_fd, struct _starpu_tcpip_req_pending **pending_tables)
+{
+	struct _starpu_tcpip_ms_request_multilist_thread new_list;
+	struct _starpu_tcpip_req_pending *table;
+	uint64_t n;
+	int ncompleted = 0;
 
-					cm = CMSG_FIRSTHDR(&mg);
-					if (!cm)
-						error(1, 0, "cmsg: no cmsg");
+	int res = read(thread_efd, &n, sizeof(n));
+	STARPU_ASSERT(res == sizeof(n) || (res == -1 && (errno == EAGAIN || errno == EINTR)));
 
-					serr = (void *) CMSG_DATA(cm);
+	_starpu_tcpip_ms_request_multilist_head_init_thread(&new_list);
+	_starpu_spin_lock(&ListLock);
+	while (!_starpu_tcpip_ms_request_multilist_empty_thread(&thread_list))
+		_starpu_tcpip_ms_request_multilist_push_back_thread(&new_list, _starpu_tcpip_ms_request_multilist_pop_front_thread(&thread_list));
+	_starpu_spin_unlock(&ListLock);
 
-					if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
-						error(1, 0, "serr: wrong origin: %u", serr->ee_origin);
-					if (serr->ee_errno != 0)
-						error(1, 0, "serr: wrong error code: %u", serr->ee_errno);
+	while (!_starpu_tcpip_ms_request_multilist_empty_thread(&new_list))
+	{
+		struct _starpu_tcpip_ms_request * req_thread = _starpu_tcpip_ms_request_multilist_pop_front_thread(&new_list);
 
-					if (serr->ee_code != SO_EE_CODE_ZEROCOPY_COPIED)
-						req_pending->zerocopy = 0;
+		int remote_sock = req_thread->remote_sock->async_sock;
+		int is_sender = req_thread->is_sender;
 
-					hi = serr->ee_data;
-					lo = serr->ee_info;
+		HASH_FIND_INT(*pending_tables, &remote_sock, table);
+		if(table == NULL)
+		{
+			struct epoll_event event;
+
+			_STARPU_MALLOC(table, sizeof(*table));
+			table->remote_sock = remote_sock;
+			table->sock = req_thread->remote_sock;
+			_starpu_tcpip_ms_request_multilist_head_init_thread(&table->send_list);
+			_starpu_tcpip_ms_request_multilist_head_init_thread(&table->recv_list);
+			_starpu_tcpip_ms_request_multilist_head_init_pending(&table->pending_list);
+			table->readable = 1;
+			table->writable = 1;
+			HASH_ADD_INT(*pending_tables, remote_sock, table);
+
+			/* Only this thread uses the asynchronous socket, let it
+			 * never block, and keep it registered until the end */
+			res = fcntl(remote_sock, F_SETFL, fcntl(remote_sock, F_GETFL) | O_NONBLOCK);
+			STARPU_ASSERT(res == 0);
+			event.events = EPOLLIN | EPOLLOUT | EPOLLET;
+			event.data.ptr = table;
+			res = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, remote_sock, &event);
+			STARPU_ASSERT_MSG(res == 0, "Cannot add socket to epoll set: %s", strerror(errno));
+		}
 
-					_ZC_PRINT("h=%u l=%u\n", hi, lo);
+		if(is_sender)
+			_starpu_tcpip_ms_request_multilist_push_back_thread(&table->send_list, req_thread);
+		else
+			_starpu_tcpip_ms_request_multilist_push_back_thread(&table->recv_list, req_thread);
 
-					STARPU_ASSERT(lo == req_pending->remote_sock->nback);
-					STARPU_ASSERT(hi < req_pending->remote_sock->nbsend);
+		/* With edge triggering, we will not be told again that the
+		 * socket is ready, start right away */
+		if(is_sender)
+			ncompleted += _starpu_tcpip_send_progress(table);
+		else
+			ncompleted += _starpu_tcpip_recv_progress(table);
+	}
+	return ncompleted;
+}
 
-					req_pending->remote_sock->nback = hi+1;
+#define EPOLL_MAX_EVENTS 64
 
-					_ZC_PRINT("send end is %d\n", req_pending->send_end);
-					while(!_starpu_tcpip_ms_request_multilist_empty_pending(&table->pending_list))
-					{
-						struct _starpu_tcpip_ms_request * req_tmp = _starpu_tcpip_ms_request_multilist_begin_pending(&table->pending_list);
+//function thread
+static void * _starpu_tcpip_thread_pending(void *arg STARPU_ATTRIBUTE_UNUSED)
+{
+	struct epoll_event events[EPOLL_MAX_EVENTS];
+	struct epoll_event event;
+	int epoll_fd;
+	int res;
 
-						if(hi+1 >= req_tmp->send_end)
-						{
-							_starpu_tcpip_ms_request_multilist_erase_pending(&table->pending_list, req_tmp);
+	struct _starpu_tcpip_req_pending *pending_tables = NULL;
+	struct _starpu_tcpip_req_pending *table, *tmp;
 
-							if(_starpu_tcpip_ms_request_multilist_empty_thread(&table->send_list)&&_starpu_tcpip_ms_request_multilist_empty_pending(&table->pending_list))
-								FD_CLR(remote_sock, &writes);
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	STARPU_ASSERT_MSG(epoll_fd >= 0, "Cannot create epoll set: %s", strerror(errno));
 
-							req_tmp->flag_completed = 1;
-							starpu_sem_post(&req_tmp->sem_wait_request);
+	/* The eventfd is recognized by a NULL table */
+	event.events = EPOLLIN;
+	event.data.ptr = NULL;
+	res = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, thread_efd, &event);
+	STARPU_ASSERT(res == 0);
 
-							/*send the signal that message is ready*/
-							struct _starpu_mp_node *node = NULL;
-							_starpu_tcpip_common_signal(node);
-						}
-						else
-							break;
-					}
+	while(is_running)
+	{
+		int nevents, i;
+		int ncompleted = 0;
 
-				}
-				else
-				{
-					if(!(_starpu_tcpip_ms_request_multilist_empty_thread(&table->send_list)))
-					{
-						struct _starpu_tcpip_ms_request * req = _starpu_tcpip_ms_request_multilist_begin_thread(&table->send_list);
-						char* msg = req->buf;
-						int len = req->len;
-
-						if(req->remote_sock->zerocopy)
-						{
-							_ZC_PRINT("msg len is %d\n", len);
-							_ZC_PRINT("offset before send is %d\n", req->offset);
-
-							if(req->offset == 0)
-							{
-								_starpu_tcpip_ms_request_multilist_push_back_pending(&table->pending_list, req);
-							}
-
-							int res = send(remote_sock, msg+req->offset, len-req->offset, MSG_ZEROCOPY);
-							_ZC_PRINT("send return %d\n", res);
-							STARPU_ASSERT_MSG(res > 0, "TCP/IP Master/Slave cannot send a msg asynchronous with a size of %d Bytes!, the result of send is %d, the error is %s ", len, res, strerror(errno));
-
-							req->remote_sock->nbsend++;
-							req->offset+=res;
-
-							_ZC_PRINT("offset after send is %d\n", req->offset);
-
-							if(req->offset == len)
-							{
-								req->send_end = req->remote_sock->nbsend;
-								_ZC_PRINT("send end after send is %d\n", req->send_end);
-								_starpu_tcpip_ms_request_multilist_erase_thread(&table->send_list, req);
-
-								//if(_starpu_tcpip_ms_request_multilist_empty_thread(&table->send_list))
-									//we need this to check whether the msg are all sent, we would have to remove POLLOUT from poll.events
-									//FD_CLR(remote_sock, &writes);
-							}
-						}
-						else
-#endif
-						{
-							socket_action((what_t)write, "write", &table->send_list, &writes);
-						}
-#ifdef SO_ZEROCOPY
-					}
-				}
-#endif
-			}
+		_SELECT_PRINT("in while\n");
+		nevents = epoll_wait(epoll_fd, events, EPOLL_MAX_EVENTS, -1);
+		if (nevents < 0)
+		{
+			STARPU_ASSERT_MSG(errno == EINTR, "There is an error when doing epoll_wait %s %d\n", strerror(errno), errno);
+			continue;
+		}
 
-			if(FD_ISSET(remote_sock, &reads2))
+		for (i = 0; i < nevents; i++)
+		{
+			table = events[i].data.ptr;
+			if (table == NULL)
 			{
-				socket_action(read, "read", &table->recv_list, &reads);
+				if(!is_running)
+					break;
+				ncompleted += _starpu_tcpip_thread_new_requests(epoll_fd, &pending_tables);
+				continue;
 			}
-			/*if the recv/send_list is empty, delete and free hash table*/
-			if(_starpu_tcpip_ms_request_multilist_empty_thread(&table->send_list)&&_starpu_tcpip_ms_request_multilist_empty_thread(&table->recv_list)&&_starpu_tcpip_ms_request_multilist_empty_pending(&table->pending_list))
+
+			_SELECT_PRINT("remote_sock in loop is %d\n", table->remote_sock);
+			if (events[i].events & EPOLLIN)
+				table->readable = 1;
+			if (events[i].events & EPOLLOUT)
+				table->writable = 1;
+			if (events[i].events & (EPOLLERR | EPOLLHUP))
 			{
-				HASH_DEL(pending_tables, table);
-				free(table);
+#ifdef SO_ZEROCOPY
+				if (table->sock->zerocopy > 0)
+					ncompleted += _starpu_tcpip_zerocopy_progress(table);
+				else
+#endif
+				{
+					/* Let the next send or read report the error */
+					table->readable = 1;
+					table->writable = 1;
+				}
 			}
 
+			ncompleted += _starpu_tcpip_send_progress(table);
+			ncompleted += _starpu_tcpip_recv_progress(table);
 		}
 
+		/*send the signal that messages are ready*/
+		if (ncompleted)
+			_starpu_tcpip_common_signal(NULL);
 	}
-	/*all hash tables should be deleted*/
-	STARPU_ASSERT(pending_tables == NULL);
+
+	/*all requests should be completed*/
+	HASH_ITER(hh, pending_tables, table, tmp)
+	{
+		STARPU_ASSERT(_starpu_tcpip_ms_request_multilist_empty_thread(&table->send_list));
+		STARPU_ASSERT(_starpu_tcpip_ms_request_multilist_empty_thread(&table->recv_list));
+		STARPU_ASSERT(_starpu_tcpip_ms_request_multilist_empty_pending(&table->pending_list));
+		HASH_DEL(pending_tables, table);
+		free(table);
+	}
+	close(epoll_fd);
 
 	return 0;
 }
 
-static void handler(int num STARPU_ATTRIBUTE_UNUSED){}
-
 int _starpu_tcpip_common_mp_init()
 {
 	//Here we supposed the programmer called two times starpu_init.
@@ -433,12 +567,11 @@ int _starpu_tcpip_common_mp_init()
 
 	_starpu_tcpip_common_multiple_thread = starpu_getenv_number_default("STARPU_TCPIP_MS_MULTIPLE_THREAD", 0);
 
-	master_thread = pthread_self();
-	signal(SIGUSR1, handler);
-
-	/*initialize the pipe*/
-	int r=pipe(thread_pipe);
-	STARPU_ASSERT(r==0);
+	/*initialize the eventfds*/
+	thread_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	STARPU_ASSERT_MSG(thread_efd >= 0, "Cannot create eventfd: %s", strerror(errno));
+	completion_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	STARPU_ASSERT_MSG(completion_efd >= 0, "Cannot create eventfd: %s", strerror(errno));
 
 	_starpu_spin_init(&ListLock);
 	/*initialize the thread*/
@@ -881,9 +1014,12 @@ int _starpu_tcpip_common_mp_init()
 void _starpu_tcpip_common_mp_deinit()
 {
 	is_running = 0;
-	char buf = 0;
-	write(thread_pipe[1], &buf, 1);
+	uint64_t one = 1;
+	int res = write(thread_efd, &one, sizeof(one));
+	STARPU_ASSERT(res == sizeof(one));
 	STARPU_PTHREAD_JOIN(thread_pending, NULL);
+	close(thread_efd);
+	close(completion_efd);
 	if (!extern_initialized)
 	{
 		int i;
@@ -932,116 +1068,90 @@ void _starpu_tcpip_common_mp_initialize_src_sink(struct _starpu_mp_node *node)
 		node->nb_cores = ntcpipcores;
 }
 
-int _starpu_tcpip_common_recv_is_ready(const struct _starpu_mp_node *mp_node)
+/* Check without blocking whether EVENTS can be performed on FD */
+static int _starpu_tcpip_common_fd_is_ready(int fd, short events)
 {
-	fd_set set;
-	int fd = mp_node->mp_connection.tcpip_mp_connection->sync_sock;
-	int res;
-
-	struct timeval tv =
+	struct pollfd pfd =
 	{
-		.tv_sec = 0,
-		.tv_usec = 0
+		.fd = fd,
+		.events = events,
+		.revents = 0
 	};
+	int res;
 
-	FD_ZERO(&set);
-	FD_SET(fd, &set);
-
-	while((res = select(fd+1, &set, NULL, NULL, &tv)) == -1 && errno == EINTR);
+	while((res = poll(&pfd, 1, 0)) == -1 && errno == EINTR);
 
-	STARPU_ASSERT_MSG(res >= 0, "There is an error when doing socket select %s %d\n", strerror(errno), errno);
+	STARPU_ASSERT_MSG(res >= 0, "There is an error when doing socket poll %s %d\n", strerror(errno), errno);
 
 	return res;
 }
 
-int _starpu_tcpip_common_notif_recv_is_ready(const struct _starpu_mp_node *mp_node)
+int _starpu_tcpip_common_recv_is_ready(const struct _starpu_mp_node *mp_node)
 {
-	fd_set set;
-	int fd = mp_node->mp_connection.tcpip_mp_connection->notif_sock;
-	int res;
-
-	struct timeval tv =
-	{
-		.tv_sec = 0,
-		.tv_usec = 0
-	};
-
-	FD_ZERO(&set);
-	FD_SET(fd, &set);
-
-	while((res = select(fd+1, &set, NULL, NULL, &tv)) == -1 && errno == EINTR);
-
-	STARPU_ASSERT_MSG(res >= 0, "There is an error when doing socket select %s %d\n", strerror(errno), errno);
+	return _starpu_tcpip_common_fd_is_ready(mp_node->mp_connection.tcpip_mp_connection->sync_sock, POLLIN);
+}
 
-	return res;
+int _starpu_tcpip_common_notif_recv_is_ready(const struct _starpu_mp_node *mp_node)
+{
+	return _starpu_tcpip_common_fd_is_ready(mp_node->mp_connection.tcpip_mp_connection->notif_sock, POLLIN);
 }
 
 int _starpu_tcpip_common_notif_send_is_ready(const struct _starpu_mp_node *mp_node)
 {
-	fd_set set;
-	int fd = mp_node->mp_connection.tcpip_mp_connection->notif_sock;
-	int res;
-
-	struct timeval tv =
-	{
-		.tv_sec = 0,
-		.tv_usec = 0
-	};
-
-	FD_ZERO(&set);
-	FD_SET(fd, &set);
-
-	while((res = select(fd+1, NULL, &set, NULL, &tv)) == -1 && errno == EINTR);
-
-	STARPU_ASSERT_MSG(res >= 0, "There is an error when doing socket select %s %d\n", strerror(errno), errno);
-
-	return res;
+	return _starpu_tcpip_common_fd_is_ready(mp_node->mp_connection.tcpip_mp_connection->notif_sock, POLLOUT);
 }
 
+/* Wait for a command from the peer, for the completion of an asynchronous
+ * request, or for being able to send the queued messages */
 void _starpu_tcpip_common_wait(const struct _starpu_mp_node *mp_node)
 {
-	fd_set reads;
-	fd_set writes;
-	int fd_sync = mp_node->mp_connection.tcpip_mp_connection->sync_sock;
-	int fd_notif = mp_node->mp_connection.tcpip_mp_connection->notif_sock;
-	int fd_max = 0;
+	struct pollfd fds[3];
+	int nfds = 2;
 	int res;
 
-	FD_ZERO(&reads);
-	FD_ZERO(&writes);
-
-	FD_SET(fd_sync, &reads);
-	if(fd_sync > fd_max)
-		fd_max = fd_sync;
-
-	sigset_t sigmask;
-	sigemptyset(&sigmask);
+	fds[0].fd = mp_node->mp_connection.tcpip_mp_connection->sync_sock;
+	fds[0].events = POLLIN;
+	fds[1].fd = completion_efd;
+	fds[1].events = POLLIN;
 
 	STARPU_PTHREAD_MUTEX_LOCK(&mp_node->message_queue_mutex);
 	if(!mp_message_list_empty(&mp_node->message_queue) || !_starpu_mp_event_list_empty(&mp_node->event_queue))
 	{
-		FD_SET(fd_notif, &writes);
-		if(fd_notif > fd_max)
-			fd_max = fd_notif;
+		fds[2].fd = mp_node->mp_connection.tcpip_mp_connection->notif_sock;
+		fds[2].events = POLLOUT;
+		nfds = 3;
 	}
 	STARPU_PTHREAD_MUTEX_UNLOCK(&mp_node->message_queue_mutex);
 
-	res = pselect(fd_max+1, &reads, &writes, NULL, NULL, &sigmask);
+	res = poll(fds, nfds, -1);
 	if(res < 0)
-	STARPU_ASSERT_MSG(errno == EINTR, "There is an error when doing socket pselect %s %d\n", strerror(errno), errno);
+	{
+		STARPU_ASSERT_MSG(errno == EINTR, "There is an error when doing socket poll %s %d\n", strerror(errno), errno);
+		return;
+	}
+
+	if (fds[1].revents & POLLIN)
+	{
+		/* Consume the completion signals, the caller will check everything */
+		uint64_t n;
+		res = read(completion_efd, &n, sizeof(n));
+		STARPU_ASSERT(res == sizeof(n) || (res == -1 && errno == EAGAIN));
+	}
 }
 
 void _starpu_tcpip_common_signal(const struct _starpu_mp_node *mp_node STARPU_ATTRIBUTE_UNUSED)
 {
+	uint64_t one = 1;
 	int res;
-	res = pthread_kill(master_thread, SIGUSR1);
 
-	STARPU_ASSERT(res == 0);
+	while((res = write(completion_efd, &one, sizeof(one))) == -1 && errno == EINTR);
+
+	STARPU_ASSERT(res == sizeof(one));
 }
 
 static void __starpu_tcpip_common_send(const struct _starpu_mp_node *node, void *msg, int len, void * event, int notif);
 static void __starpu_tcpip_common_recv(const struct _starpu_mp_node *node, void *msg, int len, void * event, int notif);
-static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr, int is_sender, const struct _starpu_mp_node *node, struct _starpu_tcpip_socket *remote_sock, void *msg, int len, void * event, int notif);
+static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr, int is_sender, const struct _starpu_mp_node *node, struct _starpu_tcpip_socket *remote_sock, void *msg, const struct iovec *iov, int iovcnt, int len, void * event, int notif);
 static void _starpu_tcpip_common_send_to_socket(const struct _starpu_mp_node *node, struct _starpu_tcpip_socket *dst_sock, void *msg, int len, void * event, int notif);
 static void _starpu_tcpip_common_recv_from_socket(const struct _starpu_mp_node *node, struct _starpu_tcpip_socket *src_sock, void *msg, int len, void * event, int notif);
 
@@ -1076,7 +1186,7 @@ void _starpu_tcpip_common_send_to_device(const struct _starpu_mp_node *node STAR
 
 static void _starpu_tcpip_common_send_to_socket(const struct _starpu_mp_node *node STARPU_ATTRIBUTE_UNUSED, struct _starpu_tcpip_socket *dst_sock, void *msg, int len, void * event, int notif)
 {
-	_starpu_tcpip_common_action_socket((what_t)write, "send", 1, node, dst_sock, msg, len, event, notif);
+	_starpu_tcpip_common_action_socket((what_t)write, "send", 1, node, dst_sock, msg, NULL, 0, len, event, notif);
 }
 
 
@@ -1111,16 +1221,35 @@ void _starpu_tcpip_common_recv_from_device(const struct _starpu_mp_node *node ST
 
 static void _starpu_tcpip_common_recv_from_socket(const struct _starpu_mp_node *node STARPU_ATTRIBUTE_UNUSED, struct _starpu_tcpip_socket *src_sock, void *msg, int len, void * event, int notif)
 {
-	_starpu_tcpip_common_action_socket(read, "recv", 0, node, src_sock, msg, len, event, notif);
+	_starpu_tcpip_common_action_socket(read, "recv", 0, node, src_sock, msg, NULL, 0, len, event, notif);
 }
 
-/*do refactor for SEND to and RECV from socket */
-static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr, int is_sender, const struct _starpu_mp_node *node STARPU_ATTRIBUTE_UNUSED, struct _starpu_tcpip_socket *remote_sock, void *msg, int len, void * event, int notif)
+/* Vectored SEND/RECV, to/from the node itself */
+static int _starpu_tcpip_common_iov_len(const struct iovec *iov, int iovcnt)
+{
+	int i, len = 0;
+	for (i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+	return len;
+}
+
+void _starpu_tcpip_common_sendv(const struct _starpu_mp_node *node, const struct iovec *iov, int iovcnt, void * event)
+{
+	_starpu_tcpip_common_action_socket((what_t)write, "send", 1, node, node->mp_connection.tcpip_mp_connection, NULL, iov, iovcnt, _starpu_tcpip_common_iov_len(iov, iovcnt), event, 0);
+}
+
+void _starpu_tcpip_common_recvv(const struct _starpu_mp_node *node, const struct iovec *iov, int iovcnt, void * event)
+{
+	_starpu_tcpip_common_action_socket(read, "recv", 0, node, node->mp_connection.tcpip_mp_connection, NULL, iov, iovcnt, _starpu_tcpip_common_iov_len(iov, iovcnt), event, 0);
+}
+
+/*do refactor for SEND to and RECV from socket, from/to either msg, or the iovcnt buffers of iov */
+static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr, int is_sender, const struct _starpu_mp_node *node STARPU_ATTRIBUTE_UNUSED, struct _starpu_tcpip_socket *remote_sock, void *msg, const struct iovec *iov, int iovcnt, int len, void * event, int notif)
 {
 	if (event)
 	{
 		_TCPIP_PRINT("async %s\n", whatstr);
-		_TCPIP_PRINT("%s %d bytes to %d message %x\n", whatstr, len, remote_sock->async_sock, *((int *) (uintptr_t)msg));
+		_TCPIP_PRINT("%s %d bytes to %d message %x\n", whatstr, len, remote_sock->async_sock, msg ? *((int *) (uintptr_t)msg) : 0);
 		/* Asynchronous*/
 		struct _starpu_async_channel * channel = event;
 		struct _starpu_tcpip_ms_async_event *tcpip_ms_event = _starpu_tcpip_ms_async_event(&channel->event);
@@ -1146,19 +1275,32 @@ static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr
 #ifdef STARPU_SANITIZE_ADDRESS
 		/* Poke data immediately, to get a good backtrace where bogus
 		 * pointers come from */
-		if (is_sender)
+		if (msg)
 		{
-			char *c = malloc(len);
-			memcpy(c, msg, len);
-			free(c);
+			if (is_sender)
+			{
+				char *c = malloc(len);
+				memcpy(c, msg, len);
+				free(c);
+			}
+			else
+				memset(msg, 0, len);
 		}
-		else
-			memset(msg, 0, len);
 #endif
 		/*complete the fields*/
 		req->remote_sock = remote_sock;
 		req->len = len;
 		req->buf = msg;
+		if (iov)
+		{
+			/* The caller's array may go away, and we advance along it */
+			_STARPU_MALLOC(req->iov_alloc, iovcnt * sizeof(*iov));
+			memcpy(req->iov_alloc, iov, iovcnt * sizeof(*iov));
+		}
+		else
+			req->iov_alloc = NULL;
+		req->iov = req->iov_alloc;
+		req->iovcnt = iovcnt;
 		req->flag_completed = 0;
 		STARPU_HG_DISABLE_CHECKING(req->flag_completed);
 		starpu_sem_init(&req->sem_wait_request, 0, 0);
@@ -1171,10 +1313,11 @@ static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr
 		_starpu_tcpip_ms_request_multilist_push_back_thread(&thread_list, req);
 		_starpu_spin_unlock(&ListLock);
 
-		char buf = 0;
+		uint64_t one = 1;
 		int res;
-		while((res = write(thread_pipe[1], &buf, 1)) == -1 && errno == EINTR)
+		while((res = write(thread_efd, &one, sizeof(one))) == -1 && errno == EINTR)
 		;
+		STARPU_ASSERT(res == sizeof(one));
 
 		channel->starpu_mp_common_finished_receiver++;
 		channel->starpu_mp_common_finished_sender++;
@@ -1185,7 +1328,28 @@ static void _starpu_tcpip_common_action_socket(what_t what, const char * whatstr
 	{
 		_TCPIP_PRINT("sync %s\n", whatstr);
 		/* Synchronous send */
-		if(!notif)
+		if (iov)
+		{
+			_TCPIP_PRINT("dst_sock is %d\n", remote_sock->sync_sock);
+			struct iovec *cur, *iov_alloc;
+			int res;
+
+			/* We advance along the array */
+			_STARPU_MALLOC(iov_alloc, iovcnt * sizeof(*iov));
+			memcpy(iov_alloc, iov, iovcnt * sizeof(*iov));
+			cur = iov_alloc;
+			while (iovcnt > 0)
+			{
+				int cnt = STARPU_MIN(iovcnt, _STARPU_IOV_MAX);
+				while((res = is_sender ? writev(remote_sock->sync_sock, cur, cnt) : readv(remote_sock->sync_sock, cur, cnt)) == -1 && errno == EINTR)
+				;
+				STARPU_ASSERT_MSG(res != 0 && !(res == -1 && errno == ECONNRESET), "TCP/IP Master/Slave noticed that %s (peer %d) has exited unexpectedly", node->kind == STARPU_NODE_TCPIP_SOURCE ? "the master" : "some slave", node->peer_id);
+				STARPU_ASSERT_MSG(res > 0, "TCP/IP Master/Slave cannot %s a msg synchronous with a size of %d Bytes!, the result of %s is %d, the error is %s ", whatstr, len, whatstr, res, strerror(errno));
+				_starpu_iovec_advance(&cur, &iovcnt, res);
+			}
+			free(iov_alloc);
+		}
+		else if(!notif)
 		{
 			_TCPIP_PRINT("dst_sock is %d\n", remote_sock->sync_sock);
 			int res, offset = 0;
@@ -1269,6 +1433,7 @@ static unsigned int _starpu_tcpip_common_action_completion(int wait, struct _sta
 				starpu_sem_wait(&req->sem_wait_request);
 				_starpu_tcpip_ms_request_multilist_erase_event(tcpip_ms_event->requests, req);
 				STARPU_HG_ENABLE_CHECKING(req->flag_completed);
+				free(req->iov_alloc);
 				free(req);
 
 				if (tcpip_ms_event->is_sender)
@@ -46,6 +46,8 @@ struct _starpu_tcpip_socket
 extern struct _starpu_tcpip_socket *tcpip_sock;
 
 int _starpu_tcpip_mp_has_local();
+/** Whether the peer of \p mp_node runs on the same machine, and can thus share memory */
+int _starpu_tcpip_common_is_local(const struct _starpu_mp_node *mp_node);
 
 int _starpu_tcpip_common_mp_init();
 void _starpu_tcpip_common_mp_deinit();
@@ -64,6 +66,9 @@ void _starpu_tcpip_common_mp_initialize_src_sink(struct _starpu_mp_node *node);
 void _starpu_tcpip_common_send(const struct _starpu_mp_node *node, void *msg, int len, void * event);
 void _starpu_tcpip_common_recv(const struct _starpu_mp_node *node, void *msg, int len, void * event);
 
+void _starpu_tcpip_common_sendv(const struct _starpu_mp_node *node, const struct iovec *iov, int iovcnt, void * event);
+void _starpu_tcpip_common_recvv(const struct _starpu_mp_node *node, const struct iovec *iov, int iovcnt, void * event);
+
 void _starpu_tcpip_common_mp_send(const struct _starpu_mp_node *node, void *msg, int len);
 void _starpu_tcpip_common_mp_recv(const struct _starpu_mp_node *node, void *msg, int len);
 
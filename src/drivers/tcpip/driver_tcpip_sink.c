@@ -15,7 +15,6 @@
  */
 
 #include <pthread.h>
-#include <signal.h>
 #include "driver_tcpip_sink.h"
 #include "driver_tcpip_source.h"
 #include "driver_tcpip_common.h"
@@ -25,12 +24,6 @@ void _starpu_tcpip_sink_init(struct _starpu_mp_node *node)
 	_starpu_tcpip_common_mp_initialize_src_sink(node);
 
 	_STARPU_MALLOC(node->thread_table, sizeof(starpu_pthread_t)*node->nb_cores);
-
-	sigset_t set;
-	sigemptyset(&set);
-	sigaddset(&set, SIGUSR1);
-
-	pthread_sigmask(SIG_BLOCK, &set, NULL);
 	//TODO
 }
 
@@ -24,6 +24,7 @@
 
 #include <drivers/driver_common/driver_common.h>
 #include <drivers/mp_common/source_common.h>
+#include <common/uthash.h>
 
 #ifdef STARPU_USE_TCPIP_MASTER_SLAVE
 static unsigned tcpip_bindid_init[STARPU_MAXTCPIPDEVS] = { };
@@ -357,12 +358,252 @@ int _starpu_tcpip_update_map(uintptr_t src, size_t src_offset, unsigned src_node
 	/* Memory mappings are cache-coherent */
 	return 0;
 }
+#ifdef HAVE_MMAP
+/* The buffers of the slaves running on the same machine as the master are
+ * allocated in shared memory, mapped both by the slave and by the master, so
+ * that the master can just memcpy data to and from them instead of sending
+ * it through the sockets. */
+struct _starpu_tcpip_shm_buffer
+{
+	UT_hash_handle hh;
+	/* The address of the buffer in the slave */
+	uintptr_t sink_addr;
+	/* The address of the buffer in the master */
+	void *master_addr;
+	size_t size;
+};
+
+/* Protected by shm_buffers_mutex */
+static struct _starpu_tcpip_shm_buffer *shm_buffers[STARPU_MAXNODES];
+static starpu_pthread_mutex_t shm_buffers_mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static int shm_enabled = -1;
+static int shm_failed[STARPU_MAXNODES];
+
+static int _starpu_tcpip_shm_usable(unsigned node)
+{
+	if (shm_enabled < 0)
+		shm_enabled = starpu_getenv_number_default("STARPU_TCPIP_MS_SHM", 0);
+	return shm_enabled && !shm_failed[node] && _starpu_tcpip_common_is_local(_starpu_src_common_get_mp_node_from_memory_node(node));
+}
+
+/* Whether some buffers of NODE are in shared memory */
+static int _starpu_tcpip_shm_any(unsigned node)
+{
+	int any;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&shm_buffers_mutex);
+	any = shm_buffers[node] != NULL;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&shm_buffers_mutex);
+
+	return any;
+}
+
+/* Return the address in the master of the buffer ADDR of NODE, or NULL if it
+ * is not in shared memory */
+static void *_starpu_tcpip_shm_lookup(unsigned node, uintptr_t addr)
+{
+	struct _starpu_tcpip_shm_buffer *buffer;
+	void *master_addr = NULL;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&shm_buffers_mutex);
+	HASH_FIND(hh, shm_buffers[node], &addr, sizeof(addr), buffer);
+	if (buffer)
+		master_addr = buffer->master_addr;
+	STARPU_PTHREAD_MUTEX_UNLOCK(&shm_buffers_mutex);
+
+	return master_addr;
+}
+#endif
+
+static uintptr_t _starpu_tcpip_allocate(unsigned dst_node, size_t size, int flags)
+{
+#ifdef HAVE_MMAP
+	if (_starpu_tcpip_shm_usable(dst_node))
+	{
+		void *master_addr = _starpu_map_allocate(size, dst_node);
+		if (master_addr)
+		{
+			uintptr_t sink_addr = _starpu_src_common_map(dst_node, (uintptr_t) master_addr, size);
+			if (sink_addr)
+			{
+				struct _starpu_tcpip_shm_buffer *buffer;
+				_STARPU_MALLOC(buffer, sizeof(*buffer));
+				buffer->sink_addr = sink_addr;
+				buffer->master_addr = master_addr;
+				buffer->size = size;
+				STARPU_PTHREAD_MUTEX_LOCK(&shm_buffers_mutex);
+				HASH_ADD(hh, shm_buffers[dst_node], sink_addr, sizeof(buffer->sink_addr), buffer);
+				STARPU_PTHREAD_MUTEX_UNLOCK(&shm_buffers_mutex);
+				return sink_addr;
+			}
+			_starpu_map_deallocate(master_addr, size);
+			/* The slave cannot open our shared memory after all */
+			_STARPU_DISP("Warning: TCP/IP slave %u cannot use shared memory, falling back to sockets\n", dst_node);
+			shm_failed[dst_node] = 1;
+		}
+		/* Otherwise the shared memory is full, use the sockets for
+		 * this buffer */
+	}
+#endif
+	return _starpu_src_common_allocate(dst_node, size, flags);
+}
+
+static void _starpu_tcpip_free(unsigned dst_node, uintptr_t addr, size_t size, int flags)
+{
+#ifdef HAVE_MMAP
+	struct _starpu_tcpip_shm_buffer *buffer;
+
+	STARPU_PTHREAD_MUTEX_LOCK(&shm_buffers_mutex);
+	HASH_FIND(hh, shm_buffers[dst_node], &addr, sizeof(addr), buffer);
+	if (buffer)
+		HASH_DEL(shm_buffers[dst_node], buffer);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&shm_buffers_mutex);
+
+	if (buffer)
+	{
+		STARPU_ASSERT(buffer->size == size);
+		_starpu_src_common_unmap(dst_node, addr, size);
+		_starpu_map_deallocate(buffer->master_addr, size);
+		free(buffer);
+		return;
+	}
+#endif
+	_starpu_src_common_free(dst_node, addr, size, flags);
+}
+
+static int _starpu_tcpip_copy_data_host_to_sink(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel)
+{
+#ifdef HAVE_MMAP
+	void *dst_ptr = _starpu_tcpip_shm_lookup(dst_node, dst);
+	if (dst_ptr)
+	{
+		memcpy((char *) dst_ptr + dst_offset, (void *) (src + src_offset), size);
+		return 0;
+	}
+#endif
+	return _starpu_src_common_copy_data_host_to_sink(src, src_offset, src_node, dst, dst_offset, dst_node, size, async_channel);
+}
+
+static int _starpu_tcpip_copy_data_sink_to_host(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel)
+{
+#ifdef HAVE_MMAP
+	void *src_ptr = _starpu_tcpip_shm_lookup(src_node, src);
+	if (src_ptr)
+	{
+		memcpy((void *) (dst + dst_offset), (char *) src_ptr + src_offset, size);
+		return 0;
+	}
+#endif
+	return _starpu_src_common_copy_data_sink_to_host(src, src_offset, src_node, dst, dst_offset, dst_node, size, async_channel);
+}
+
+static int _starpu_tcpip_copy_data_sink_to_sink(uintptr_t src, size_t src_offset, unsigned src_node, uintptr_t dst, size_t dst_offset, unsigned dst_node, size_t size, struct _starpu_async_channel *async_channel)
+{
+#ifdef HAVE_MMAP
+	void *src_ptr = _starpu_tcpip_shm_lookup(src_node, src);
+	void *dst_ptr = _starpu_tcpip_shm_lookup(dst_node, dst);
+	if (src_ptr && dst_ptr)
+	{
+		memcpy((char *) dst_ptr + dst_offset, (char *) src_ptr + src_offset, size);
+		return 0;
+	}
+#endif
+	return _starpu_src_common_copy_data_sink_to_sink(src, src_offset, src_node, dst, dst_offset, dst_node, size, async_channel);
+}
+
+static int _starpu_tcpip_copyv_data_host_to_sink(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel)
+{
+#ifdef HAVE_MMAP
+	void *dst_ptr = _starpu_tcpip_shm_lookup(dst_node, dst);
+	if (dst_ptr)
+	{
+		unsigned i;
+		for (i = 0; i < nvec; i++)
+			memcpy((char *) dst_ptr + vec[i].dst_offset, (void *) (src + vec[i].src_offset), vec[i].size);
+		return 0;
+	}
+#endif
+	return _starpu_src_common_copyv_data_host_to_sink(src, src_node, dst, dst_node, vec, nvec, async_channel);
+}
+
+static int _starpu_tcpip_copyv_data_sink_to_host(uintptr_t src, unsigned src_node, uintptr_t dst, unsigned dst_node, const struct _starpu_copy_vec *vec, unsigned nvec, struct _starpu_async_channel *async_channel)
+{
+#ifdef HAVE_MMAP
+	void *src_ptr = _starpu_tcpip_shm_lookup(src_node, src);
+	if (src_ptr)
+	{
+		unsigned i;
+		for (i = 0; i < nvec; i++)
+			memcpy((void *) (dst + vec[i].dst_offset), (char *) src_ptr + vec[i].src_offset, vec[i].size);
+		return 0;
+	}
+#endif
+	return _starpu_src_common_copyv_data_sink_to_host(src, src_node, dst, dst_node, vec, nvec, async_channel);
+}
+
+static int _starpu_tcpip_copy_batch_data_host_to_sink(const struct _starpu_copy_batch_piece *pieces, unsigned npieces, unsigned src_node, unsigned dst_node, struct _starpu_async_channel *async_channel)
+{
+#ifdef HAVE_MMAP
+	if (_starpu_tcpip_shm_any(dst_node))
+	{
+		/* Copy the pieces which are in shared memory, and send the others */
+		struct _starpu_copy_batch_piece *remote;
+		unsigned i, nremote = 0;
+		int ret = 0;
+
+		_STARPU_MALLOC(remote, npieces * sizeof(*remote));
+		for (i = 0; i < npieces; i++)
+		{
+			void *dst_ptr = _starpu_tcpip_shm_lookup(dst_node, pieces[i].dst);
+			if (dst_ptr)
+				memcpy((char *) dst_ptr + pieces[i].dst_offset, (void *) (pieces[i].src + pieces[i].src_offset), pieces[i].size);
+			else
+				remote[nremote++] = pieces[i];
+		}
+		if (nremote)
+			ret = _starpu_src_common_copy_batch_data_host_to_sink(remote, nremote, src_node, dst_node, async_channel);
+		free(remote);
+		return ret;
+	}
+#endif
+	return _starpu_src_common_copy_batch_data_host_to_sink(pieces, npieces, src_node, dst_node, async_channel);
+}
+
+static int _starpu_tcpip_copy_batch_data_sink_to_host(const struct _starpu_copy_batch_piece *pieces, unsigned npieces, unsigned src_node, unsigned dst_node, struct _starpu_async_channel *async_channel)
+{
+#ifdef HAVE_MMAP
+	if (_starpu_tcpip_shm_any(src_node))
+	{
+		/* Copy the pieces which are in shared memory, and receive the others */
+		struct _starpu_copy_batch_piece *remote;
+		unsigned i, nremote = 0;
+		int ret = 0;
+
+		_STARPU_MALLOC(remote, npieces * sizeof(*remote));
+		for (i = 0; i < npieces; i++)
+		{
+			void *src_ptr = _starpu_tcpip_shm_lookup(src_node, pieces[i].src);
+			if (src_ptr)
+				memcpy((void *) (pieces[i].dst + pieces[i].dst_offset), (char *) src_ptr + pieces[i].src_offset, pieces[i].size);
+			else
+				remote[nremote++] = pieces[i];
+		}
+		if (nremote)
+			ret = _starpu_src_common_copy_batch_data_sink_to_host(remote, nremote, src_node, dst_node, async_channel);
+		free(remote);
+		return ret;
+	}
+#endif
+	return _starpu_src_common_copy_batch_data_sink_to_host(pieces, npieces, src_node, dst_node, async_channel);
+}
+
 struct _starpu_node_ops _starpu_driver_tcpip_ms_node_ops =
 {
 	.name = "tcpip driver",
 
-	.malloc_on_node = _starpu_src_common_allocate,
-	.free_on_node = _starpu_src_common_free,
+	.malloc_on_node = _starpu_tcpip_allocate,
+	.free_on_node = _starpu_tcpip_free,
+	.reclaim = _starpu_src_common_reclaim,
 
 	.is_direct_access_supported = _starpu_tcpip_is_direct_access_supported,
 
@@ -372,11 +613,17 @@ struct _starpu_node_ops _starpu_driver_tcpip_ms_node_ops =
 	.copy_interface_from[STARPU_CPU_RAM] = _starpu_copy_interface_any_to_any,
 	.copy_interface_from[STARPU_TCPIP_MS_RAM] = _starpu_copy_interface_any_to_any,
 
-	.copy_data_to[STARPU_CPU_RAM] = _starpu_src_common_copy_data_sink_to_host,
-	.copy_data_to[STARPU_TCPIP_MS_RAM] = _starpu_src_common_copy_data_sink_to_sink,
+	.copy_data_to[STARPU_CPU_RAM] = _starpu_tcpip_copy_data_sink_to_host,
+	.copy_data_to[STARPU_TCPIP_MS_RAM] = _starpu_tcpip_copy_data_sink_to_sink,
+
+	.copy_data_from[STARPU_CPU_RAM] = _starpu_tcpip_copy_data_host_to_sink,
+	.copy_data_from[STARPU_TCPIP_MS_RAM] = _starpu_tcpip_copy_data_sink_to_sink,
+
+	.copyv_data_to[STARPU_CPU_RAM] = _starpu_tcpip_copyv_data_sink_to_host,
+	.copyv_data_from[STARPU_CPU_RAM] = _starpu_tcpip_copyv_data_host_to_sink,
 
-	.copy_data_from[STARPU_CPU_RAM] = _starpu_src_common_copy_data_host_to_sink,
-	.copy_data_from[STARPU_TCPIP_MS_RAM] = _starpu_src_common_copy_data_sink_to_sink,
+	.copy_batch_data_to[STARPU_CPU_RAM] = _starpu_tcpip_copy_batch_data_sink_to_host,
+	.copy_batch_data_from[STARPU_CPU_RAM] = _starpu_tcpip_copy_batch_data_host_to_sink,
 
 	.wait_request_completion = _starpu_tcpip_common_wait_request_completion,
 	.test_request_completion = _starpu_tcpip_common_test_event,
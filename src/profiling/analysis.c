@@ -0,0 +1,316 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Online analysis of the execution.
+ *
+ * The critical path is maintained incrementally: when a job terminates, the
+ * length of the longest chain of executed jobs leading to it (cp_start) plus
+ * its own execution time is propagated to its successors, before they get
+ * notified of the termination.  Dependencies added on jobs which were
+ * already terminated are not taken into account.
+ *
+ * The worker time is split by profiling.c into states, we here attribute the
+ * idle time to a cause:
+ * - data: waiting for a data transfer before being able to execute a task
+ * - dependency: no task was ready, but some were submitted, i.e. were waiting
+ *   for their dependencies (or running on other workers)
+ * - no task: no task was submitted at all
+ * - sleeping: some tasks were ready, but not for this worker
+ * Time spent polling the scheduler without getting a task is attributed to no
+ * task or dependency the same way, but when some tasks were ready it is
+ * rather scheduling overhead, which is left out.
+ */
+
+#include <starpu.h>
+#include <core/workers.h>
+#include <core/jobs.h>
+#include <core/dependencies/cg.h>
+#include <common/config.h>
+#include <common/utils.h>
+#include <common/knobs.h>
+#include <profiling/analysis.h>
+
+int _starpu_analysis_enabled;
+static int analysis_period;
+
+/* Length of the critical path of the executed tasks, in us */
+static double critical_path;
+/* Cumulated execution time of the executed tasks, in us */
+static double total_work;
+
+static struct timespec analysis_start_date;
+
+/* Number of workers currently handling a task (fetching its data, executing
+ * it or its callback), which are thus still counted as ready */
+static int nbusy_workers;
+#define BUSY_STATUS (STATUS_EXECUTING | STATUS_CALLBACK | STATUS_WAITING)
+
+static starpu_pthread_t analysis_thread;
+
+/* global counters */
+static int __g_critical_path;
+static int __g_total_work;
+
+/* per-worker counters */
+static int __w_busy_time;
+static int __w_idle_no_task_time;
+static int __w_idle_dependency_time;
+static int __w_idle_data_time;
+static int __w_idle_sleeping_time;
+
+static void global_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context == NULL); /* no context for the global updater */
+	(void)context;
+
+	_starpu_perf_counter_sample_set_double_value(sample, __g_critical_path, critical_path);
+	_starpu_perf_counter_sample_set_double_value(sample, __g_total_work, total_work);
+}
+
+static void per_worker_sample_updater(struct starpu_perf_counter_sample *sample, void *context)
+{
+	STARPU_ASSERT(context != NULL);
+	struct _starpu_worker *worker = context;
+
+	_starpu_perf_counter_sample_set_double_value(sample, __w_busy_time, worker->__w_busy_time__value);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_idle_no_task_time, worker->__w_idle_no_task_time__value);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_idle_dependency_time, worker->__w_idle_dependency_time__value);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_idle_data_time, worker->__w_idle_data_time__value);
+	_starpu_perf_counter_sample_set_double_value(sample, __w_idle_sleeping_time, worker->__w_idle_sleeping_time__value);
+}
+
+void _starpu__analysis_c__register_counters(void)
+{
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+		__STARPU_PERF_COUNTER_REG("starpu.analysis", scope, g_critical_path, double, "length of the critical path of the executed tasks (microseconds, requires STARPU_ANALYSIS)");
+		__STARPU_PERF_COUNTER_REG("starpu.analysis", scope, g_total_work, double, "cumulated execution time of the executed tasks (microseconds, requires STARPU_ANALYSIS)");
+
+		_starpu_perf_counter_register_updater(scope, global_sample_updater);
+	}
+
+	{
+		const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_per_worker;
+		__STARPU_PERF_COUNTER_REG("starpu.analysis", scope, w_busy_time, double, "time spent executing tasks and callbacks on this worker (microseconds, requires STARPU_ANALYSIS)");
+		__STARPU_PERF_COUNTER_REG("starpu.analysis", scope, w_idle_no_task_time, double, "idle time of this worker while no task was submitted (microseconds, requires STARPU_ANALYSIS)");
+		__STARPU_PERF_COUNTER_REG("starpu.analysis", scope, w_idle_dependency_time, double, "idle time of this worker while submitted tasks were waiting for their dependencies (microseconds, requires STARPU_ANALYSIS)");
+		__STARPU_PERF_COUNTER_REG("starpu.analysis", scope, w_idle_data_time, double, "time spent by this worker waiting for data transfers (microseconds, requires STARPU_ANALYSIS)");
+		__STARPU_PERF_COUNTER_REG("starpu.analysis", scope, w_idle_sleeping_time, double, "time spent by this worker sleeping while tasks were ready for other workers (microseconds, requires STARPU_ANALYSIS)");
+
+		_starpu_perf_counter_register_updater(scope, per_worker_sample_updater);
+	}
+}
+
+void _starpu_analysis_init(void)
+{
+	_starpu_analysis_enabled = starpu_getenv_number_default("STARPU_ANALYSIS", 0);
+	analysis_period = starpu_getenv_number_default("STARPU_ANALYSIS_PERIOD", 0);
+	critical_path = 0.;
+	total_work = 0.;
+	nbusy_workers = 0;
+	_starpu_clock_gettime(&analysis_start_date);
+}
+
+void _starpu_analysis_job_terminated(struct _starpu_job *j)
+{
+	struct _starpu_cg_list *successors = &j->job_successors;
+	double cp_end = j->cp_start + j->cp_duration;
+	unsigned succ;
+
+	_starpu_perf_counter_update_max_double(&critical_path, cp_end);
+	if (j->cp_duration)
+		_starpu_perf_counter_update_acc_double(&total_work, j->cp_duration);
+
+	/* Successors can not terminate before we notify them, so they will see
+	 * this before computing their own cp_end. */
+	_starpu_spin_lock(&successors->lock);
+	for (succ = 0; succ < successors->nsuccs; succ++)
+	{
+		struct _starpu_cg *cg = successors->succ[succ];
+		if (cg->cg_type == STARPU_CG_TASK)
+			_starpu_perf_counter_update_max_double(&cg->succ.job->cp_start, cp_end);
+	}
+	_starpu_spin_unlock(&successors->lock);
+
+	if (!_starpu_perf_counter_paused())
+		_starpu_perf_counter_update_global_sample();
+}
+
+void _starpu_analysis_worker_status(enum _starpu_worker_status old_status, enum _starpu_worker_status new_status)
+{
+	int was_busy = !!(old_status & BUSY_STATUS);
+	int is_busy = !!(new_status & BUSY_STATUS);
+
+	if (is_busy && !was_busy)
+		(void) STARPU_ATOMIC_ADD(&nbusy_workers, 1);
+	else if (was_busy && !is_busy)
+		(void) STARPU_ATOMIC_ADD(&nbusy_workers, -1);
+}
+
+void _starpu_analysis_worker_time(struct _starpu_worker *worker, enum _starpu_worker_status status, struct timespec *delta)
+{
+	double time = starpu_timing_timespec_to_us(delta);
+
+	if (status & (STATUS_EXECUTING | STATUS_CALLBACK))
+		worker->__w_busy_time__value += time;
+	else if (status & STATUS_WAITING)
+		worker->__w_idle_data_time__value += time;
+	else
+	{
+		/* Sleeping, or polling the scheduler for a task. We can only
+		 * tell what the situation is at the end of the period, that
+		 * should be representative enough. Tasks being handled by
+		 * workers are still counted as ready. */
+		if (starpu_task_nready() > STARPU_ATOMIC_ADD(&nbusy_workers, 0))
+		{
+			if (status & STATUS_SLEEPING)
+				worker->__w_idle_sleeping_time__value += time;
+			/* And otherwise it is scheduling or uncategorized overhead */
+		}
+		else if (starpu_task_nsubmitted() > 0)
+			worker->__w_idle_dependency_time__value += time;
+		else
+			worker->__w_idle_no_task_time__value += time;
+	}
+}
+
+void _starpu_analysis_display_summary(FILE *stream)
+{
+	struct timespec now, elapsed;
+	unsigned workerid, worker_cnt = starpu_worker_get_count();
+	double tot_busy = 0., tot_no_task = 0., tot_dependency = 0., tot_data = 0., tot_sleeping = 0.;
+
+	_starpu_clock_gettime(&now);
+	starpu_timespec_sub(&now, &analysis_start_date, &elapsed);
+
+	fprintf(stream, "\n#---------------------\n");
+	fprintf(stream, "Analysis after %.3f s:\n", starpu_timing_timespec_to_us(&elapsed) / 1000000.);
+	fprintf(stream, "Critical path: %.3f ms, total work: %.3f ms", critical_path / 1000., total_work / 1000.);
+	if (critical_path > 0.)
+		fprintf(stream, ", average parallelism: %.2f", total_work / critical_path);
+	fprintf(stream, "\n");
+
+	fprintf(stream, "%-32s %9s %9s %9s %9s %9s\n", "Worker", "busy", "no task", "deps", "data", "sleeping");
+	for (workerid = 0; workerid < worker_cnt; workerid++)
+	{
+		struct _starpu_worker *worker = _starpu_get_worker_struct(workerid);
+		char name[64];
+		double busy = worker->__w_busy_time__value;
+		double no_task = worker->__w_idle_no_task_time__value;
+		double dependency = worker->__w_idle_dependency_time__value;
+		double data = worker->__w_idle_data_time__value;
+		double sleeping = worker->__w_idle_sleeping_time__value;
+		double total = busy + no_task + dependency + data + sleeping;
+
+		starpu_worker_get_name(workerid, name, sizeof(name));
+		if (total == 0.)
+			total = 1.;
+		fprintf(stream, "%-32s %8.2f%% %8.2f%% %8.2f%% %8.2f%% %8.2f%%\n", name,
+			100. * busy / total, 100. * no_task / total, 100. * dependency / total,
+			100. * data / total, 100. * sleeping / total);
+
+		tot_busy += busy;
+		tot_no_task += no_task;
+		tot_dependency += dependency;
+		tot_data += data;
+		tot_sleeping += sleeping;
+	}
+
+	double tot_idle = tot_no_task + tot_dependency + tot_data + tot_sleeping;
+	if (tot_idle > 0.)
+	{
+		const char *cause;
+		if (tot_dependency >= tot_no_task && tot_dependency >= tot_data && tot_dependency >= tot_sleeping)
+			cause = "waiting for dependencies, the task graph does not expose enough parallelism";
+		else if (tot_no_task >= tot_data && tot_no_task >= tot_sleeping)
+			cause = "no task submitted, the application does not submit tasks fast enough";
+		else if (tot_data >= tot_sleeping)
+			cause = "waiting for data transfers";
+		else
+			cause = "sleeping while tasks were ready for other workers";
+		fprintf(stream, "Idle time: %.2f%%, mostly %s\n", 100. * tot_idle / (tot_idle + tot_busy), cause);
+	}
+	fprintf(stream, "#---------------------\n");
+}
+
+static FILE *analysis_open_stream(void)
+{
+	const char *filename = starpu_getenv("STARPU_ANALYSIS_FILE");
+	FILE *stream;
+
+	if (!filename)
+		return stderr;
+	stream = fopen(filename, "a");
+	if (!stream)
+	{
+		_STARPU_DISP("Could not open file %s for displaying the analysis (%s), using stderr\n", filename, strerror(errno));
+		return stderr;
+	}
+	return stream;
+}
+
+static void analysis_close_stream(FILE *stream)
+{
+	if (stream != stderr)
+		fclose(stream);
+}
+
+static void *analysis_func(void *arg)
+{
+	(void) arg;
+	starpu_pthread_setname("analysis");
+
+	while (_starpu_machine_is_running())
+	{
+		/* Sleep by steps of at most 100ms to notice termination */
+		int remaining = analysis_period;
+		while (remaining > 0 && _starpu_machine_is_running())
+		{
+			int step = remaining > 100 ? 100 : remaining;
+			starpu_usleep(step * 1000);
+			remaining -= step;
+		}
+		if (!_starpu_machine_is_running())
+			break;
+
+		FILE *stream = analysis_open_stream();
+		_starpu_analysis_display_summary(stream);
+		analysis_close_stream(stream);
+	}
+	return NULL;
+}
+
+void _starpu_analysis_start(void)
+{
+	if (!_starpu_analysis_enabled || analysis_period <= 0)
+		return;
+
+	STARPU_PTHREAD_CREATE(&analysis_thread, NULL, analysis_func, NULL);
+}
+
+void _starpu_analysis_shutdown(void)
+{
+	if (!_starpu_analysis_enabled)
+		return;
+
+	if (analysis_period > 0)
+		STARPU_PTHREAD_JOIN(analysis_thread, NULL);
+
+	FILE *stream = analysis_open_stream();
+	_starpu_analysis_display_summary(stream);
+	analysis_close_stream(stream);
+}
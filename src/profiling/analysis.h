@@ -0,0 +1,60 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#ifndef __ANALYSIS_H__
+#define __ANALYSIS_H__
+
+/** @file */
+
+/*
+ * Online analysis of the execution: critical path of the executed tasks, and
+ * causes of the worker idle time. This is enabled by STARPU_ANALYSIS.
+ */
+
+#include <starpu.h>
+#include <common/config.h>
+#include <core/errorcheck.h>
+
+#pragma GCC visibility push(hidden)
+
+struct _starpu_job;
+struct _starpu_worker;
+
+/** Whether the online analysis is enabled, set by STARPU_ANALYSIS */
+extern int _starpu_analysis_enabled;
+
+/** Read the environment, to be called before _starpu_profiling_start */
+void _starpu_analysis_init(void);
+/** Start the periodic report, if requested */
+void _starpu_analysis_start(void);
+/** Stop the periodic report and display the final one */
+void _starpu_analysis_shutdown(void);
+
+/** Update the critical path with the termination of the job, and propagate it
+ * to its successors. To be called before notifying them. */
+void _starpu_analysis_job_terminated(struct _starpu_job *j);
+
+/** Attribute \p delta, spent by the worker in the \p status state, to
+ * execution or to an idleness cause */
+void _starpu_analysis_worker_time(struct _starpu_worker *worker, enum _starpu_worker_status status, struct timespec *delta);
+/** Keep track of the number of workers which are handling a task */
+void _starpu_analysis_worker_status(enum _starpu_worker_status old_status, enum _starpu_worker_status new_status);
+
+void _starpu_analysis_display_summary(FILE *stream);
+
+#pragma GCC visibility pop
+
+#endif /* __ANALYSIS_H__ */
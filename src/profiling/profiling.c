@@ -18,6 +18,7 @@
 #include <starpu.h>
 #include <starpu_profiling.h>
 #include <profiling/profiling.h>
+#include <profiling/analysis.h>
 #include <core/workers.h>
 #include <common/config.h>
 #include <common/utils.h>
@@ -50,6 +51,9 @@ static struct starpu_profiling_bus_info bus_profiling_info[STARPU_MAXNODES][STAR
 static struct node_pair busid_to_node_pair[STARPU_MAXNODES*STARPU_MAXNODES];
 static char bus_direct[STARPU_MAXNODES*STARPU_MAXNODES];
 static int bus_ngpus[STARPU_MAXNODES*STARPU_MAXNODES];
+/* Bytes of the data requests posted and not completed yet between
+ * (src, dst), not reset by starpu_bus_get_profiling_info */
+static unsigned long bus_queued_bytes[STARPU_MAXNODES][STARPU_MAXNODES];
 static unsigned busid_cnt = 0;
 
 static void _starpu_bus_reset_profiling_info(struct starpu_profiling_bus_info *bus_info);
@@ -247,7 +251,7 @@ void _starpu_profiling_papi_task_stop_counters(struct starpu_task *task)
 void _starpu_profiling_start(void)
 {
 	const char *env;
-	if ((env = starpu_getenv("STARPU_PROFILING")) && atoi(env))
+	if (((env = starpu_getenv("STARPU_PROFILING")) && atoi(env)) || _starpu_analysis_enabled)
 	{
 		starpu_profiling_status_set(STARPU_PROFILING_ENABLE);
 	}
@@ -329,12 +333,14 @@ static void _starpu_worker_reset_profiling_info_with_lock(int workerid)
 		{
 			worker->profiling_registered_start[i] = 0;
 		}
-		worker->profiling_status = status;
-		worker->profiling_status_start_date = now;
 	}
+	if (_starpu_analysis_enabled)
+		_starpu_analysis_worker_status(worker->profiling_status, status);
+	worker->profiling_status = status;
+	worker->profiling_status_start_date = now;
 }
 
-static void _starpu_worker_time_split_accumulate(struct starpu_profiling_worker_info *worker_info, enum _starpu_worker_status status, struct timespec *delta)
+static void _starpu_worker_time_split_accumulate(struct _starpu_worker *worker, struct starpu_profiling_worker_info *worker_info, enum _starpu_worker_status status, struct timespec *delta)
 {
 	/* We here prioritize where we want to attribute the time spent */
 
@@ -354,6 +360,9 @@ static void _starpu_worker_time_split_accumulate(struct starpu_profiling_worker_
 		/* We do have tasks to do, but the scheduler takes time */
 		starpu_timespec_accumulate(&worker_info->scheduling_time, delta);
 	/* And otherwise it's just uncategorized overhead */
+
+	if (_starpu_analysis_enabled)
+		_starpu_analysis_worker_time(worker, status, delta);
 }
 
 void _starpu_worker_start_state(int workerid, enum _starpu_worker_status_index index, struct timespec *start_time)
@@ -380,9 +389,12 @@ void _starpu_worker_start_state(int workerid, enum _starpu_worker_status_index i
 			struct starpu_profiling_worker_info *worker_info = &worker->profiling_info;
 			struct timespec state_time;
 			starpu_timespec_sub(start_time, &worker->profiling_status_start_date, &state_time);
-			_starpu_worker_time_split_accumulate(worker_info, worker->profiling_status, &state_time);
+			_starpu_worker_time_split_accumulate(worker, worker_info, worker->profiling_status, &state_time);
 		}
+		enum _starpu_worker_status old_status = worker->profiling_status;
 		worker->profiling_status = _starpu_worker_get_status(workerid) | (1<<index);
+		if (_starpu_analysis_enabled)
+			_starpu_analysis_worker_status(old_status, worker->profiling_status);
 		worker->profiling_status_start_date = *start_time;
 
 		STARPU_PTHREAD_MUTEX_UNLOCK(&worker->profiling_info_mutex);
@@ -459,9 +471,12 @@ void _starpu_worker_stop_state(int workerid, enum _starpu_worker_status_index in
 		{
 			struct timespec state_time;
 			starpu_timespec_sub(stop_time, &worker->profiling_status_start_date, &state_time);
-			_starpu_worker_time_split_accumulate(worker_info, worker->profiling_status, &state_time);
+			_starpu_worker_time_split_accumulate(worker, worker_info, worker->profiling_status, &state_time);
 		}
+		enum _starpu_worker_status old_status = worker->profiling_status;
 		worker->profiling_status = _starpu_worker_get_status(workerid) & ~(1<<index);
+		if (_starpu_analysis_enabled)
+			_starpu_analysis_worker_status(old_status, worker->profiling_status);
 		worker->profiling_status_start_date = *stop_time;
 
 		STARPU_PTHREAD_MUTEX_UNLOCK(&worker->profiling_info_mutex);
@@ -526,7 +541,7 @@ int starpu_profiling_worker_get_info(int workerid, struct starpu_profiling_worke
 		{
 			struct timespec delta;
 			starpu_timespec_sub(&now, &worker->profiling_status_start_date, &delta);
-			_starpu_worker_time_split_accumulate(worker_info, worker->profiling_status, &delta);
+			_starpu_worker_time_split_accumulate(worker, worker_info, worker->profiling_status, &delta);
 		}
 
 		/* total_time = now - start_time */
@@ -578,7 +593,10 @@ void _starpu_initialize_busid_matrix(void)
 	int i, j;
 	for (j = 0; j < STARPU_MAXNODES; j++)
 	for (i = 0; i < STARPU_MAXNODES; i++)
+	{
 		busid_matrix[i][j] = -1;
+		bus_queued_bytes[i][j] = 0;
+	}
 
 	busid_cnt = 0;
 }
@@ -588,6 +606,7 @@ static void _starpu_bus_reset_profiling_info(struct starpu_profiling_bus_info *b
 	_starpu_clock_gettime(&bus_info->start_time);
 	bus_info->transferred_bytes = 0;
 	bus_info->transfer_count = 0;
+	bus_info->wasted_prefetch_bytes = 0;
 }
 
 int _starpu_register_bus(int src_node, int dst_node)
@@ -669,6 +688,7 @@ int starpu_bus_get_profiling_info(int busid, struct starpu_profiling_bus_info *b
 					  &bus_profiling_info[src_node][dst_node].total_time);
 
 		*bus_info = bus_profiling_info[src_node][dst_node];
+		bus_info->queued_bytes = _starpu_bus_get_queued_bytes(src_node, dst_node);
 	}
 
 	_starpu_bus_reset_profiling_info(&bus_profiling_info[src_node][dst_node]);
@@ -683,6 +703,26 @@ void _starpu_bus_update_profiling_info(int src_node, int dst_node, size_t size)
 //	fprintf(stderr, "PROFILE %d -> %d : %d (cnt %d)\n", src_node, dst_node, size, bus_profiling_info[src_node][dst_node].transfer_count);
 }
 
+void _starpu_bus_waste_prefetch_bytes(int src_node, int dst_node, size_t size)
+{
+	bus_profiling_info[src_node][dst_node].wasted_prefetch_bytes += size;
+}
+
+void _starpu_bus_queue_bytes(unsigned src_node, unsigned dst_node, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&bus_queued_bytes[src_node][dst_node], (unsigned long) size);
+}
+
+void _starpu_bus_dequeue_bytes(unsigned src_node, unsigned dst_node, size_t size)
+{
+	(void) STARPU_ATOMIC_ADDL(&bus_queued_bytes[src_node][dst_node], -(unsigned long) size);
+}
+
+size_t _starpu_bus_get_queued_bytes(unsigned src_node, unsigned dst_node)
+{
+	return bus_queued_bytes[src_node][dst_node];
+}
+
 #undef starpu_profiling_status_get
 int starpu_profiling_status_get(void)
 {
@@ -64,6 +64,19 @@ int _starpu_register_bus(int src_node, int dst_node);
  * memory nodes. */
 void _starpu_bus_update_profiling_info(int src_node, int dst_node, size_t size);
 
+/** Tell StarPU that "size" bytes prefetched between the two specified memory
+ * nodes were dropped before being used. */
+void _starpu_bus_waste_prefetch_bytes(int src_node, int dst_node, size_t size);
+
+/** Tell StarPU that a transfer of "size" bytes between the two specified
+ * memory nodes was queued, or completed, to keep an estimation of how busy
+ * the link is. */
+void _starpu_bus_queue_bytes(unsigned src_node, unsigned dst_node, size_t size);
+void _starpu_bus_dequeue_bytes(unsigned src_node, unsigned dst_node, size_t size);
+/** Return the number of bytes queued for transfer between the two specified
+ * memory nodes. */
+size_t _starpu_bus_get_queued_bytes(unsigned src_node, unsigned dst_node);
+
 void _starpu_profiling_set_task_push_start_time(struct starpu_task *task);
 void _starpu_profiling_set_task_push_end_time(struct starpu_task *task);
 
@@ -28,6 +28,7 @@ static double convert_to_GB(float d)
 void _starpu_profiling_bus_helper_display_summary(FILE *stream)
 {
 	int long long sum_transferred = 0;
+	int long long sum_wasted = 0;
 
 	fprintf(stream, "\n#---------------------\n");
 	fprintf(stream, "Data transfer stats:\n");
@@ -58,13 +59,18 @@ void _starpu_profiling_bus_helper_display_summary(FILE *stream)
 		fprintf(stream, "\t%.4lf %s", d, "GB");
 		fprintf(stream, "\t%.4lf %s/s", (d * 1024) / elapsed_time, "MB");
 		fprintf(stream, "\t(transfers : %lld - avg %.4lf %s)\n", transfer_cnt, (d * 1024) / transfer_cnt, "MB");
+		if (bus_info.wasted_prefetch_bytes)
+			fprintf(stream, "\t\t%.4lf %s prefetched but not used\n", convert_to_GB(bus_info.wasted_prefetch_bytes) * 1024, "MB");
 
 		sum_transferred += transferred;
+		sum_wasted += bus_info.wasted_prefetch_bytes;
 	}
 
 	double d = convert_to_GB(sum_transferred);
 
 	fprintf(stream, "Total transfers: %.4lf %s\n", d, "GB");
+	if (sum_wasted)
+		fprintf(stream, "Total wasted prefetches: %.4lf %s\n", convert_to_GB(sum_wasted), "GB");
 	fprintf(stream, "#---------------------\n");
 }
 
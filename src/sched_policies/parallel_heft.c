@@ -56,6 +56,9 @@ struct _starpu_pheft_data
 	double beta;
 	double _gamma;
 	double idle_power;
+	/* Predict the length of parallel tasks on uncalibrated widths from
+	 * the calibrated ones, see STARPU_PHEFT_SPEEDUP_MODEL */
+	int speedup_model;
 /* When we push a task on a combined worker we need all the cpu workers it contains
  * to be locked at once */
 	starpu_pthread_mutex_t global_push_mutex;
@@ -149,9 +152,10 @@ static int push_task_on_best_worker(struct starpu_task *task, int best_workerid,
 	else
 	{
 		/* This task doesn't belong to an actual worker, it belongs
-		 * to a combined worker and thus the scheduler doesn't care
-		 * of its predicted values which are insignificant */
-		task->predicted = 0;
+		 * to a combined worker, only its aliases account for the
+		 * expected work of the workers, the task itself just records
+		 * the predicted length */
+		task->predicted = exp_end_predicted - exp_start_predicted;
 		task->predicted_transfer = 0;
 
 		starpu_parallel_task_barrier_init(task, best_workerid);
@@ -264,6 +268,169 @@ static double compute_ntasks_end(int workerid, unsigned sched_ctx_id)
 	}
 }
 
+/* Amdahl speedup model of a task: its length on p cores is serial + parallel/p */
+struct _starpu_pheft_speedup
+{
+	int computed;
+	int valid;
+	double serial;
+	double parallel;
+};
+
+static int worker_get_cpu_width(int workerid, unsigned sched_ctx_id)
+{
+	struct starpu_perfmodel_arch* perf_arch = starpu_worker_get_perf_archtype(workerid, sched_ctx_id);
+
+	if (perf_arch->ndevices != 1 || perf_arch->devices[0].type != STARPU_CPU_WORKER)
+		return 0;
+	if (!starpu_worker_is_combined_worker(workerid))
+		return 1;
+	return perf_arch->devices[0].ncores;
+}
+
+/* Fit the speedup model by least squares over the CPU widths for which the
+ * performance model of the task is calibrated. With only one width, assume a
+ * perfect speedup, so that wider teams get tried, and thus calibrated. */
+static void fit_speedup(struct starpu_task *task, unsigned nimpl, struct starpu_worker_collection *workers, unsigned sched_ctx_id, struct _starpu_pheft_speedup *speedup)
+{
+	char seen[STARPU_NMAXWORKERS+1];
+	double sx = 0., sy = 0., sxx = 0., sxy = 0.;
+	unsigned n = 0;
+	struct starpu_sched_ctx_iterator it;
+
+	speedup->computed = 1;
+	speedup->valid = 0;
+	memset(seen, 0, sizeof(seen));
+
+	workers->init_iterator(workers, &it);
+	while(workers->has_next(workers, &it))
+	{
+		unsigned workerid = workers->get_next(workers, &it);
+		int width = worker_get_cpu_width(workerid, sched_ctx_id);
+		if (!width || seen[width])
+			continue;
+		if (!starpu_combined_worker_can_execute_task(workerid, task, nimpl))
+			/* Another worker of the same width may still be able to */
+			continue;
+		seen[width] = 1;
+
+		double length = starpu_task_expected_length(task, starpu_worker_get_perf_archtype(workerid, sched_ctx_id), nimpl);
+		if (isnan(length) || _STARPU_IS_ZERO(length))
+			continue;
+
+		double x = 1. / width;
+		sx += x;
+		sy += length;
+		sxx += x * x;
+		sxy += x * length;
+		n++;
+	}
+
+	if (!n)
+		return;
+
+	speedup->valid = 1;
+	double det = n * sxx - sx * sx;
+	if (n == 1 || _STARPU_IS_ZERO(det))
+	{
+		speedup->serial = 0.;
+		speedup->parallel = sxy / sxx;
+		return;
+	}
+
+	speedup->parallel = (n * sxy - sx * sy) / det;
+	speedup->serial = (sy - speedup->parallel * sx) / n;
+	if (speedup->parallel < 0.)
+	{
+		/* Slower with more cores, no parallelism at all */
+		speedup->parallel = 0.;
+		speedup->serial = sy / n;
+	}
+	else if (speedup->serial < 0.)
+	{
+		/* Superlinear speedup, keep it linear */
+		speedup->serial = 0.;
+		speedup->parallel = sxy / sxx;
+	}
+}
+
+static double predict_from_speedup(struct starpu_task *task, unsigned nimpl, int workerid, struct starpu_worker_collection *workers, unsigned sched_ctx_id, struct _starpu_pheft_speedup *speedup)
+{
+	int width = worker_get_cpu_width(workerid, sched_ctx_id);
+	if (!width)
+		return NAN;
+
+	if (!speedup->computed)
+		fit_speedup(task, nimpl, workers, sched_ctx_id, speedup);
+	if (!speedup->valid)
+		return NAN;
+
+	return speedup->serial + speedup->parallel / width;
+}
+
+/* Whether the workers of team are already combined, as a worker of its own */
+static int team_is_combined(int *team, int size)
+{
+	unsigned nbasic = starpu_worker_get_count();
+	unsigned ncombined = starpu_combined_worker_get_count();
+	unsigned i;
+
+	for (i = 0; i < ncombined; i++)
+	{
+		int combined_size;
+		int *combined_workerid;
+		starpu_combined_worker_get_description(nbasic + i, &combined_size, &combined_workerid);
+		if (combined_size == size && !memcmp(combined_workerid, team, size * sizeof(*team)))
+			return 1;
+	}
+	return 0;
+}
+
+/* The combined workers built from the hwloc hierarchy only cover whole cache
+ * groups and a few chunks of them. Also combine every run of consecutive workers
+ * within each of them, so that a parallel task can be given the cores of a
+ * group which are idle whatever their number: pheft then picks among them the
+ * team with the earliest expected end, using the speedup model to predict
+ * the length of the task on it. Worker ids can only be given to combined
+ * workers at initialization, so the teams are registered along them. */
+static void add_teams(unsigned sched_ctx_id)
+{
+	struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
+	unsigned nbasic = starpu_worker_get_count();
+	unsigned ngroups = starpu_combined_worker_get_count();
+	unsigned i;
+	int min, size, first;
+
+	min = starpu_getenv_number("STARPU_MIN_WORKERSIZE");
+	if (min < 2)
+		min = 2;
+
+	for (i = 0; i < ngroups; i++)
+	{
+		int group_size;
+		int *group;
+		starpu_combined_worker_get_description(nbasic + i, &group_size, &group);
+
+		for (size = min; size < group_size; size++)
+			for (first = 0; first + size <= group_size; first++)
+			{
+				int team[size];
+
+				if (starpu_combined_worker_get_count() >= STARPU_NMAX_COMBINEDWORKERS
+				    || nbasic + starpu_combined_worker_get_count() >= STARPU_NMAXWORKERS)
+					/* No room for more */
+					return;
+				if (team_is_combined(&group[first], size))
+					continue;
+
+				memcpy(team, &group[first], size * sizeof(*team));
+				int newworkerid = starpu_combined_worker_assign_workerid(size, team);
+				STARPU_ASSERT(newworkerid >= 0);
+				workers->add(workers, newworkerid);
+			}
+	}
+}
+
 static int _parallel_heft_push_task(struct starpu_task *task, unsigned prio, unsigned sched_ctx_id)
 {
 	struct _starpu_pheft_data *hd = (struct _starpu_pheft_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
@@ -283,6 +450,7 @@ static int _parallel_heft_push_task(struct starpu_task *task, unsigned prio, uns
 	double local_energy[nworkers_ctx][STARPU_MAXIMPLEMENTATIONS];
 	double local_exp_end[nworkers_ctx][STARPU_MAXIMPLEMENTATIONS];
 	double fitness[nworkers_ctx][STARPU_MAXIMPLEMENTATIONS];
+	struct _starpu_pheft_speedup speedup[STARPU_MAXIMPLEMENTATIONS];
 
 	double max_exp_end = 0.0;
 
@@ -304,6 +472,7 @@ static int _parallel_heft_push_task(struct starpu_task *task, unsigned prio, uns
 	double _worker_exp_end[nworkers_ctx];
 
 	memset(skip_worker, 0, nworkers_ctx*STARPU_MAXIMPLEMENTATIONS*sizeof(int));
+	memset(speedup, 0, sizeof(speedup));
 
 	workers->init_iterator(workers, &it);
 	while(workers->has_next(workers, &it))
@@ -347,6 +516,11 @@ static int _parallel_heft_push_task(struct starpu_task *task, unsigned prio, uns
 
 			local_task_length[worker_ctx][nimpl] = starpu_task_expected_length(task, perf_arch,nimpl);
 
+			if (hd->speedup_model && task->cl->type != STARPU_SEQ
+				&& (isnan(local_task_length[worker_ctx][nimpl]) || _STARPU_IS_ZERO(local_task_length[worker_ctx][nimpl])))
+				/* Not calibrated for this width, predict from the other widths */
+				local_task_length[worker_ctx][nimpl] = predict_from_speedup(task, nimpl, workerid, workers, sched_ctx_id, &speedup[nimpl]);
+
 			local_data_penalty[worker_ctx][nimpl] = starpu_task_expected_data_transfer_time_for(task, workerid);
 
 			double ntasks_end = compute_ntasks_end(workerid, sched_ctx_id);
@@ -478,7 +652,7 @@ static int _parallel_heft_push_task(struct starpu_task *task, unsigned prio, uns
 		STARPU_ASSERT(nimpl_best != -1);
 		best_exp_end = local_exp_end[best_id_ctx][nimpl_best];
 	}
-	best_exp_start = _worker_exp_end[best];
+	best_exp_start = compute_expected_end(_worker_exp_end, best, 0);
 
 	//_STARPU_DEBUG("Scheduler parallel heft: kernel (%u)\n", nimpl_best);
 	starpu_task_set_implementation(task, nimpl_best);
@@ -502,8 +676,9 @@ static int parallel_heft_push_task(struct starpu_task *task)
 	return ret_val;
 }
 
-static void parallel_heft_add_workers(__attribute__((unused)) unsigned sched_ctx_id, int *workerids, unsigned nworkers)
+static void parallel_heft_add_workers(unsigned sched_ctx_id, int *workerids, unsigned nworkers)
 {
+	struct _starpu_pheft_data *hd = (struct _starpu_pheft_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
 	unsigned i;
 	double now = starpu_timing_now();
 	for (i = 0; i < nworkers; i++)
@@ -520,7 +695,12 @@ static void parallel_heft_add_workers(__attribute__((unused)) unsigned sched_ctx
 			workerarg->has_prev_init = 1;
 		}
 	}
+	int combined = _starpu_initialized_combined_workers;
 	_starpu_sched_find_worker_combinations(workerids, nworkers);
+	if (!combined && hd->speedup_model)
+		/* We can predict the length of tasks on any width, so let
+		 * teams of any width run them */
+		add_teams(sched_ctx_id);
 
 // start_unclear_part: not very clear where this is used
 /* 	struct _starpu_machine_config *config = _starpu_get_machine_config(); */
@@ -576,6 +756,7 @@ static void initialize_parallel_heft_policy(unsigned sched_ctx_id)
 #endif
 	hd->_gamma = starpu_getenv_float_default("STARPU_SCHED_GAMMA", _STARPU_SCHED_GAMMA_DEFAULT);
 	hd->idle_power = starpu_getenv_float_default("STARPU_IDLE_POWER", 0.0);
+	hd->speedup_model = starpu_getenv_number_default("STARPU_PHEFT_SPEEDUP_MODEL", 1);
 
 	STARPU_PTHREAD_MUTEX_INIT(&hd->global_push_mutex, NULL);
 
@@ -33,43 +33,28 @@
 /* #define USE_OVERLOAD */
 
 /*
- * Experimental code for improving data cache locality:
+ * Data cache locality, used by the lws-locality policy:
  *
- * USE_LOCALITY:
- * - for each data, we record on which worker it was last accessed with the
- *   locality flag.
+ * - for each data, we record which worker last popped a task accessing it, and
+ *   for each worker, the data accessed by the last tasks it popped (i.e. a
+ *   rough estimation of what is contained in its innermost caches).
  *
- * - when pushing a ready task, we choose the worker which has last accessed the
- *   most data of the task with the locality flag.
+ * - when pushing a ready task from a thread which is not a worker, we choose
+ *   the worker which has last accessed the most data of the task.
  *
- * USE_LOCALITY_TASKS:
- * - for each worker, we record the locality data that the task used last (i.e. a rough
- *   estimation of what is contained in the innermost caches).
+ * - when stealing, among the first tasks of the victim queue, we pick the one
+ *   whose data is most probably in the caches of the thief, or else of the
+ *   workers which share a cache or a NUMA node with it.
  *
- * - for each worker, we have a hash table associating from a data handle to
- *   all the ready tasks pushed to it that will use it with the locality flag.
- *
- * - When fetching a task from a queue, pick a task which has the biggest number
- *   of data estimated to be contained in the cache.
+ * The bookkeeping is bounded to MAX_LOCALITY data per task and per worker, and
+ * to examining locality_scan tasks per steal.
  */
 
-//#define USE_LOCALITY
-
-
-//#define USE_LOCALITY_TASKS
-
-/* Maximum number of recorded locality data per task */
-#define MAX_LOCALITY 8
+/* Maximum number of recorded locality data per task and per worker */
+#define MAX_LOCALITY 16
 
-/* Entry for queued_tasks_per_data: records that a queued task is accessing the data with locality flag */
-#ifdef USE_LOCALITY_TASKS
-struct locality_entry
-{
-	UT_hash_handle hh;
-	starpu_data_handle_t data;
-	struct starpu_task *task;
-};
-#endif
+/* Default number of tasks examined in the victim queue when stealing */
+#define LOCALITY_SCAN_DEFAULT 8
 
 struct _starpu_work_stealing_data_per_worker
 {
@@ -89,16 +74,14 @@ struct _starpu_work_stealing_data_per_worker
 	 */
 	unsigned last_pop_worker;
 
-#ifdef USE_LOCALITY_TASKS
-	/* This records the same as queue, but hashed by data accessed with locality flag.  */
-	/* FIXME: we record only one task per data, assuming that the access is
-	 * RW, and thus only one task is ready to write to it. Do we really need to handle the R case too? */
-	struct locality_entry *queued_tasks_per_data;
-
-	/* This records the last data accessed by the worker */
+	/* This records the last data accessed by the worker, only the
+	 * worker itself accesses it */
 	starpu_data_handle_t last_locality[MAX_LOCALITY];
-	int nlast_locality;
-#endif
+	unsigned last_locality_pos;
+
+	/* For each worker, how close it is to this worker, i.e. the level of
+	 * their deepest common hwloc object */
+	unsigned char *closeness;
 };
 
 struct _starpu_work_stealing_data
@@ -109,6 +92,13 @@ struct _starpu_work_stealing_data
 	 * better decisions about which queue to select when deferring work
 	 */
 	unsigned last_push_worker;
+
+	/* Whether to take data cache locality into account */
+	int locality;
+	/* Maximum number of tasks examined when stealing by locality */
+	unsigned locality_scan;
+	/* Closeness given to the data recently accessed by the thief itself */
+	unsigned self_closeness;
 };
 
 #ifdef USE_OVERLOAD
@@ -195,34 +185,32 @@ static unsigned select_worker_round_robin(struct _starpu_work_stealing_data *ws,
 	return workerids[worker];
 }
 
-#ifdef USE_LOCALITY
 /* Select a worker according to the locality of the data of the task to be scheduled */
-static unsigned select_worker_locality(struct _starpu_work_stealing_data *ws, struct starpu_task *task, unsigned sched_ctx_id)
+static int select_worker_locality(struct _starpu_work_stealing_data *ws, struct starpu_task *task, unsigned sched_ctx_id)
 {
 	unsigned nbuffers = STARPU_TASK_GET_NBUFFERS(task);
 	if (nbuffers == 0)
 		return -1;
 
-	unsigned i, n;
+	unsigned i;
 	unsigned ndata[STARPU_NMAXWORKERS] = { 0 };
 	int best_worker = -1;
+	unsigned n = 0;
 
-	n = 0;
-	for (i = 0; i < nbuffers; i++)
+	for (i = 0; i < nbuffers && i < MAX_LOCALITY; i++)
 	{
-		if (STARPU_TASK_GET_MODE(task, i) & STARPU_LOCALITY)
+		starpu_data_handle_t data = STARPU_TASK_GET_HANDLE(task, i);
+		int locality = data->last_locality;
+		if (locality >= 0)
 		{
-			starpu_data_handle_t data = STARPU_TASK_GET_HANDLE(task, i);
-			int locality = data->last_locality;
-			if (locality >= 0)
-				ndata[locality]++;
+			ndata[locality]++;
 			n++;
 		}
 	}
 
 	if (n)
 	{
-		/* Some locality buffers, choose worker which has most of them */
+		/* Some data were already accessed, choose worker which has most of them */
 		struct starpu_worker_collection *workers = starpu_sched_ctx_get_worker_collection(sched_ctx_id);
 		struct starpu_sched_ctx_iterator it;
 		unsigned best_ndata = 0;
@@ -231,7 +219,8 @@ static unsigned select_worker_locality(struct _starpu_work_stealing_data *ws, st
 		while(workers->has_next(workers, &it))
 		{
 			int workerid = workers->get_next(workers, &it);
-			if (ndata[workerid] > best_ndata && ws->per_worker[workerid].running && ws->per_worker[workerid].busy)
+			if (ndata[workerid] > best_ndata && ws->per_worker[workerid].running
+			    && starpu_worker_can_execute_task_first_impl(workerid, task, NULL))
 			{
 				best_worker = workerid;
 				best_ndata = ndata[workerid];
@@ -241,170 +230,97 @@ static unsigned select_worker_locality(struct _starpu_work_stealing_data *ws, st
 	return best_worker;
 }
 
-/* Record in the data which worker will handle the task with the locality flag */
-static void record_data_locality(struct starpu_task *task, int workerid)
+/* Record in the data and in the worker that the worker is accessing the data of the task */
+static void record_worker_locality(struct _starpu_work_stealing_data *ws, struct starpu_task *task, int workerid)
 {
-	/* Record where in locality data where the task went */
+	struct _starpu_work_stealing_data_per_worker *data = &ws->per_worker[workerid];
 	unsigned i;
-	for (i = 0; i < STARPU_TASK_GET_NBUFFERS(task); i++)
-		if (STARPU_TASK_GET_MODE(task, i) & STARPU_LOCALITY)
-		{
-			STARPU_TASK_GET_HANDLE(task, i)->last_locality = workerid;
-		}
-}
-#else
-static void record_data_locality(struct starpu_task *task STARPU_ATTRIBUTE_UNUSED, int workerid STARPU_ATTRIBUTE_UNUSED)
-{
+
+	if (!ws->locality)
+		return;
+
+	for (i = 0; i < STARPU_TASK_GET_NBUFFERS(task) && i < MAX_LOCALITY; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		handle->last_locality = workerid;
+		data->last_locality[data->last_locality_pos] = handle;
+		data->last_locality_pos = (data->last_locality_pos + 1) % MAX_LOCALITY;
+	}
 }
-#endif
 
-#ifdef USE_LOCALITY_TASKS
-/* Record in the worker which data it used last with the locality flag */
-static void record_worker_locality(struct _starpu_work_stealing_data *ws, struct starpu_task *task, int workerid, unsigned sched_ctx_id)
+/* Estimate how much of the data of the task is in the caches of target */
+static unsigned locality_score(struct _starpu_work_stealing_data *ws, struct starpu_task *task, int target)
 {
-	/* Record where in locality data where the task went */
-	unsigned i;
-	struct _starpu_work_stealing_data_per_worker *data = &ws->per_worker[workerid];
+	struct _starpu_work_stealing_data_per_worker *data = &ws->per_worker[target];
+	unsigned i, j, score = 0;
 
-	data->nlast_locality = 0;
-	for (i = 0; i < STARPU_TASK_GET_NBUFFERS(task); i++)
-		if (STARPU_TASK_GET_MODE(task, i) & STARPU_LOCALITY)
-		{
-			data->last_locality[data->nlast_locality] = STARPU_TASK_GET_HANDLE(task, i);
-			data->nlast_locality++;
-			if (data->nlast_locality == MAX_LOCALITY)
+	for (i = 0; i < STARPU_TASK_GET_NBUFFERS(task) && i < MAX_LOCALITY; i++)
+	{
+		starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
+		for (j = 0; j < MAX_LOCALITY; j++)
+			if (data->last_locality[j] == handle)
 				break;
-		}
-}
-/* Called when pushing a task to a queue */
-static void locality_pushed_task(struct _starpu_work_stealing_data *ws, struct starpu_task *task, int workerid, unsigned sched_ctx_id)
-{
-	struct _starpu_work_stealing_data_per_worker *data = &ws->per_worker[workerid];
-	unsigned i;
-	for (i = 0; i < STARPU_TASK_GET_NBUFFERS(task); i++)
-		if (STARPU_TASK_GET_MODE(task, i) & STARPU_LOCALITY)
+
+		if (j < MAX_LOCALITY)
+			/* We accessed it very recently */
+			score += ws->self_closeness;
+		else
 		{
-			starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
-			struct locality_entry *entry;
-			HASH_FIND_PTR(data->queued_tasks_per_data, &handle, entry);
-			if (STARPU_LIKELY(!entry))
-			{
-				_STARPU_MALLOC(entry, sizeof(*entry));
-				entry->data = handle;
-				entry->task = task;
-				HASH_ADD_PTR(data->queued_tasks_per_data, data, entry);
-			}
+			/* Here helgrind would shout that this is unprotected, but we
+			 * are fine with getting outdated values, this is just an
+			 * estimation */
+			int last = handle->last_locality;
+			if (last >= 0 && data->closeness)
+				score += data->closeness[last];
 		}
+	}
+	return score;
 }
 
-/* Pick a task from workerid's queue, for execution on target */
-static struct starpu_task *ws_pick_task(struct _starpu_work_stealing_data *ws, int source, int target)
+/* Pick from the first tasks of source's queue the one with the best locality for target */
+static struct starpu_task *ws_pick_task_locality(struct _starpu_work_stealing_data *ws, int source, int target)
 {
-	struct _starpu_work_stealing_data_per_worker *data_source = &ws->per_worker[source];
-	struct _starpu_work_stealing_data_per_worker *data_target = &ws->per_worker[target];
-	unsigned i, j, n = data_target->nlast_locality;
-	struct starpu_task *(tasks[MAX_LOCALITY]) = { NULL }, *best_task = NULL;
-	int ntasks[MAX_LOCALITY] = { 0 }, best_n; /* Number of locality data for this worker used by this task */
-	/* Look at the last data accessed by this worker */
-	STARPU_ASSERT(n < MAX_LOCALITY);
-	for (i = 0; i < n; i++)
-	{
-		starpu_data_handle_t handle = data_target->last_locality[i];
-		struct locality_entry *entry;
-		HASH_FIND_PTR(data_source->queued_tasks_per_data, &handle, entry);
-		if (entry)
-		{
-			/* Record task */
-			tasks[i] = entry->task;
-			ntasks[i] = 1;
+	struct starpu_st_prio_deque *queue = &ws->per_worker[source].queue;
+	struct starpu_task *task, *best_task = NULL;
+	unsigned n = 0, best_score = 0;
+	int priority;
 
-			/* And increment counter of the same task */
-			for (j = 0; j < i; j++)
-			{
-				if (tasks[j] == tasks[i])
-				{
-					ntasks[j]++;
-					break;
-				}
-			}
-		}
-	}
-	/* Now find the task with most locality data for this worker */
-	best_n = 0;
-	for (i = 0; i < n; i++)
-	{
-		if (ntasks[i] > best_n)
-		{
-			best_task = tasks[i];
-			best_n = ntasks[i];
-		}
-	}
+	task = starpu_task_prio_list_back_highest(&queue->list);
+	if (!task)
+		return NULL;
+	priority = task->priority;
 
-	if (best_n > 0)
+	for ( ;
+	     task != starpu_task_prio_list_end(&queue->list) && task->priority == priority && n < ws->locality_scan;
+	     task = starpu_task_prio_list_prev_highest(&queue->list, task), n++)
 	{
-		/* found an interesting task, try to pick it! */
-		if (starpu_st_prio_deque_pop_this_task(&data_source->queue, target, best_task))
+		unsigned score = locality_score(ws, task, target);
+		if (score > best_score)
 		{
-			if (!data_source->queue.ntasks)
-			{
-				STARPU_ASSERT(ws->per_worker[source].notask == 0);
-				ws->per_worker[source].notask = 1;
-			}
-			return best_task;
+			best_task = task;
+			best_score = score;
 		}
 	}
 
-	/* Didn't find an interesting task, or couldn't run it */
-	struct starpu_task *task;
-
-	if (source != target)
-		task = starpu_st_prio_deque_deque_task_for_worker(&data_source->queue, target, NULL);
-	else
-		task = starpu_st_prio_deque_pop_task_for_worker(&data_source->queue, target, NULL);
+	if (best_task && starpu_st_prio_deque_pop_this_task(queue, target, best_task))
+		return best_task;
 
-	if (task && !data_source->queue.ntasks)
-	{
-		STARPU_ASSERT(ws->per_worker[source].notask == 0);
-		ws->per_worker[source].notask = 1;
-	}
-	return task;
+	/* Didn't find an interesting task, or couldn't run it */
+	return NULL;
 }
 
-/* Called when popping a task from a queue */
-static void locality_popped_task(struct _starpu_work_stealing_data *ws, struct starpu_task *task, int workerid, unsigned sched_ctx_id)
-{
-	struct _starpu_work_stealing_data_per_worker *data = &ws->per_worker[workerid];
-	unsigned i;
-	for (i = 0; i < STARPU_TASK_GET_NBUFFERS(task); i++)
-		if (STARPU_TASK_GET_MODE(task, i) & STARPU_LOCALITY)
-		{
-			starpu_data_handle_t handle = STARPU_TASK_GET_HANDLE(task, i);
-			struct locality_entry *entry;
-			HASH_FIND_PTR(data->queued_tasks_per_data, &handle, entry);
-			if (STARPU_LIKELY(entry))
-			{
-				if (entry->task == task)
-				{
-					HASH_DEL(data->queued_tasks_per_data, entry);
-					free(entry);
-				}
-			}
-		}
-}
-#else
-static void record_worker_locality(struct _starpu_work_stealing_data *ws STARPU_ATTRIBUTE_UNUSED, struct starpu_task *task STARPU_ATTRIBUTE_UNUSED, int workerid STARPU_ATTRIBUTE_UNUSED, unsigned sched_ctx_id STARPU_ATTRIBUTE_UNUSED)
-{
-}
-/* Called when pushing a task to a queue */
-static void locality_pushed_task(struct _starpu_work_stealing_data *ws STARPU_ATTRIBUTE_UNUSED, struct starpu_task *task STARPU_ATTRIBUTE_UNUSED, int workerid STARPU_ATTRIBUTE_UNUSED, unsigned sched_ctx_id STARPU_ATTRIBUTE_UNUSED)
-{
-}
 /* Pick a task from workerid's queue, for execution on target */
 static struct starpu_task *ws_pick_task(struct _starpu_work_stealing_data *ws, int source, int target)
 {
-	struct starpu_task *task;
+	struct starpu_task *task = NULL;
+
 	if (source != target)
-		task = starpu_st_prio_deque_deque_task_for_worker(&ws->per_worker[source].queue, target, NULL);
+	{
+		if (ws->locality)
+			task = ws_pick_task_locality(ws, source, target);
+		if (!task)
+			task = starpu_st_prio_deque_deque_task_for_worker(&ws->per_worker[source].queue, target, NULL);
+	}
 	else
 		task = starpu_st_prio_deque_pop_task_for_worker(&ws->per_worker[source].queue, target, NULL);
 
@@ -415,11 +331,6 @@ static struct starpu_task *ws_pick_task(struct _starpu_work_stealing_data *ws, i
 	}
 	return task;
 }
-/* Called when popping a task from a queue */
-static void locality_popped_task(struct _starpu_work_stealing_data *ws STARPU_ATTRIBUTE_UNUSED, struct starpu_task *task STARPU_ATTRIBUTE_UNUSED, int workerid STARPU_ATTRIBUTE_UNUSED, unsigned sched_ctx_id STARPU_ATTRIBUTE_UNUSED)
-{
-}
-#endif
 
 #ifdef USE_OVERLOAD
 
@@ -577,7 +488,7 @@ static struct starpu_task *ws_pop_task(unsigned sched_ctx_id)
 	{
 		task = ws_pick_task(ws, workerid, workerid);
 		if (task)
-			locality_popped_task(ws, task, workerid, sched_ctx_id);
+			record_worker_locality(ws, task, workerid);
 	}
 
 	if(task)
@@ -626,9 +537,7 @@ static struct starpu_task *ws_pop_task(unsigned sched_ctx_id)
 		_STARPU_TRACE_WORK_STEALING(workerid, victim);
 		starpu_sched_task_break(task);
 		starpu_sched_ctx_list_task_counters_decrement(sched_ctx_id, victim);
-		record_data_locality(task, workerid);
-		record_worker_locality(ws, task, workerid, sched_ctx_id);
-		locality_popped_task(ws, task, victim, sched_ctx_id);
+		record_worker_locality(ws, task, workerid);
 	}
 	starpu_worker_unlock(victim);
 
@@ -644,7 +553,7 @@ static struct starpu_task *ws_pop_task(unsigned sched_ctx_id)
 			{
 				/* keep_awake notice taken into account here, clear flag */
 				worker->state_keep_awake = 0;
-				locality_popped_task(ws, task, workerid, sched_ctx_id);
+				record_worker_locality(ws, task, workerid);
 			}
 		}
 	}
@@ -673,13 +582,10 @@ int ws_push_task(struct starpu_task *task)
 	struct _starpu_work_stealing_data *ws = (struct _starpu_work_stealing_data*)starpu_sched_ctx_get_policy_data(sched_ctx_id);
 	int workerid;
 
-#ifdef USE_LOCALITY
-	workerid = select_worker_locality(ws, task, sched_ctx_id);
-#else
-	workerid = -1;
-#endif
-	if (workerid == -1)
-		workerid = starpu_worker_get_id();
+	workerid = starpu_worker_get_id();
+	if (workerid == -1 && ws->locality)
+		/* Not released by a worker, look for a worker which accessed its data */
+		workerid = select_worker_locality(ws, task, sched_ctx_id);
 
 	/* If the current thread is not a worker but
 	 * the main thread (-1) or the current worker is not in the target
@@ -690,7 +596,6 @@ int ws_push_task(struct starpu_task *task)
 	starpu_worker_lock(workerid);
 	STARPU_AYU_ADDTOTASKQUEUE(starpu_task_get_job_id(task), workerid);
 	starpu_sched_task_break(task);
-	record_data_locality(task, workerid);
 	STARPU_ASSERT_MSG(ws->per_worker[workerid].running, "workerid=%d, ws=%p\n", workerid, ws);
 	starpu_st_prio_deque_push_back_task(&ws->per_worker[workerid].queue, task);
 	if (ws->per_worker[workerid].queue.ntasks == 1)
@@ -698,7 +603,6 @@ int ws_push_task(struct starpu_task *task)
 		STARPU_ASSERT(ws->per_worker[workerid].notask == 1);
 		ws->per_worker[workerid].notask = 0;
 	}
-	locality_pushed_task(ws, task, workerid, sched_ctx_id);
 
 	starpu_push_task_end(task);
 	starpu_worker_unlock(workerid);
@@ -760,6 +664,8 @@ static void ws_remove_workers(unsigned sched_ctx_id, int *workerids, unsigned nw
 		ws->per_worker[workerid].running = 0;
 		free(ws->per_worker[workerid].proxlist);
 		ws->per_worker[workerid].proxlist = NULL;
+		free(ws->per_worker[workerid].closeness);
+		ws->per_worker[workerid].closeness = NULL;
 	}
 }
 
@@ -772,6 +678,9 @@ static void initialize_ws_policy(unsigned sched_ctx_id)
 	ws->last_push_worker = 0;
 	STARPU_HG_DISABLE_CHECKING(ws->last_push_worker);
 	ws->select_victim = select_victim;
+	ws->locality = 0;
+	ws->locality_scan = 0;
+	ws->self_closeness = 1;
 
 	unsigned nw = starpu_worker_get_count();
 	_STARPU_CALLOC(ws->per_worker, nw, sizeof(struct _starpu_work_stealing_data_per_worker));
@@ -812,6 +721,21 @@ struct starpu_sched_policy _starpu_sched_ws_policy =
  * the proximity list built using the info on te architecture provided by hwloc
  */
 #ifdef STARPU_HAVE_HWLOC
+/* Return the level of the deepest common ancestor of a and b */
+static int tree_common_level(struct starpu_tree *a, struct starpu_tree *b)
+{
+	while (a->level > b->level)
+		a = a->father;
+	while (b->level > a->level)
+		b = b->father;
+	while (a != b)
+	{
+		a = a->father;
+		b = b->father;
+	}
+	return a->level;
+}
+
 static int lws_select_victim(struct _starpu_work_stealing_data *ws, unsigned sched_ctx_id, int workerid)
 {
 	int nworkers = starpu_sched_ctx_get_nworkers(sched_ctx_id);
@@ -881,6 +805,37 @@ static void lws_add_workers(unsigned sched_ctx_id, int *workerids,
 			it.possible_value = NULL;
 		}
 	}
+
+	if (ws->locality)
+	{
+		/* Compute how close workers are, to estimate which caches they
+		 * share. Workers may join the context at any time, so refresh
+		 * the closeness between every pair of workers of the context,
+		 * not only between the ones being added. */
+		unsigned nw = starpu_worker_get_count();
+		unsigned w, j;
+		for (w = 0; w < nw; w++)
+		{
+			if (!workers->present[w])
+				continue;
+			struct starpu_tree *node = starpu_tree_get(tree, starpu_worker_get_bindid(w));
+			if (ws->per_worker[w].closeness == NULL)
+				_STARPU_CALLOC(ws->per_worker[w].closeness, nw, sizeof(unsigned char));
+			if (!node)
+				continue;
+			/* Data in our own caches is closer than anything shared */
+			if ((unsigned) node->level + 1 > ws->self_closeness)
+				ws->self_closeness = node->level + 1;
+			for (j = 0; j < nw; j++)
+			{
+				if (!workers->present[j])
+					continue;
+				struct starpu_tree *neighbour = starpu_tree_get(tree, starpu_worker_get_bindid(j));
+				if (neighbour)
+					ws->per_worker[w].closeness[j] = tree_common_level(node, neighbour);
+			}
+		}
+	}
 #endif
 }
 
@@ -902,6 +857,15 @@ static void initialize_lws_policy(unsigned sched_ctx_id)
 #endif
 }
 
+static void initialize_lws_locality_policy(unsigned sched_ctx_id)
+{
+	initialize_lws_policy(sched_ctx_id);
+
+	struct _starpu_work_stealing_data *ws = (struct _starpu_work_stealing_data *)starpu_sched_ctx_get_policy_data(sched_ctx_id);
+	ws->locality = 1;
+	ws->locality_scan = starpu_getenv_number_default("STARPU_LWS_LOCALITY_SCAN", LOCALITY_SCAN_DEFAULT);
+}
+
 struct starpu_sched_policy _starpu_sched_lws_policy =
 {
 	.init_sched = initialize_lws_policy,
@@ -921,3 +885,23 @@ struct starpu_sched_policy _starpu_sched_lws_policy =
 	.worker_type = STARPU_WORKER_LIST,
 #endif
 };
+
+struct starpu_sched_policy _starpu_sched_lws_locality_policy =
+{
+	.init_sched = initialize_lws_locality_policy,
+	.deinit_sched = deinit_ws_policy,
+	.add_workers = lws_add_workers,
+	.remove_workers = ws_remove_workers,
+	.push_task = ws_push_task,
+	.pop_task = ws_pop_task,
+	.push_task_notify = ws_push_task_notify,
+	.pre_exec_hook = NULL,
+	.post_exec_hook = NULL,
+	.policy_name = "lws-locality",
+	.policy_description = "data cache locality work stealing",
+#ifdef STARPU_HAVE_HWLOC
+	.worker_type = STARPU_WORKER_TREE,
+#else
+	.worker_type = STARPU_WORKER_LIST,
+#endif
+};
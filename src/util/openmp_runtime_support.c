@@ -359,8 +359,9 @@ static void destroy_omp_region_struct(struct starpu_omp_region *region)
 	free(region);
 }
 
-static void omp_initial_thread_func(void)
+static void omp_initial_thread_func(void *arg)
 {
+	(void) arg;
 	struct starpu_omp_thread *initial_thread = _global_state.initial_thread;
 	struct starpu_omp_task *initial_task = _global_state.initial_task;
 	while (1)
@@ -376,7 +377,7 @@ static void omp_initial_thread_func(void)
 		{
 			initial_task->nested_region->continuation_starpu_task = NULL;
 			_starpu_omp_set_task(initial_task);
-			swapcontext(&initial_thread->ctx, &initial_task->ctx);
+			_starpu_omp_context_swap(&initial_thread->ctx, &initial_task->ctx);
 		}
 	}
 }
@@ -608,8 +609,9 @@ starpu_data_handle_t starpu_omp_data_lookup(const void *ptr)
 	return result;
 }
 
-static void starpu_omp_explicit_task_entry(struct starpu_omp_task *task)
+static void starpu_omp_explicit_task_entry(void *arg)
 {
+	struct starpu_omp_task *task = arg;
 	STARPU_ASSERT(!(task->flags & STARPU_OMP_TASK_FLAGS_IMPLICIT));
 	struct _starpu_worker *starpu_worker = _starpu_get_local_worker_key();
 	/* XXX on work */
@@ -647,12 +649,12 @@ static void starpu_omp_explicit_task_entry(struct starpu_omp_task *task)
 	 *
 	 * about to run on the worker stack...
 	 */
-	setcontext(&thread->ctx);
-	STARPU_ASSERT(0); /* unreachable code */
+	_starpu_omp_context_set(&thread->ctx);
 }
 
-static void starpu_omp_implicit_task_entry(struct starpu_omp_task *task)
+static void starpu_omp_implicit_task_entry(void *arg)
 {
+	struct starpu_omp_task *task = arg;
 	struct starpu_omp_thread *thread = _starpu_omp_get_thread();
 	STARPU_ASSERT(task->flags & STARPU_OMP_TASK_FLAGS_IMPLICIT);
 	task->cpu_f(task->starpu_buffers, task->starpu_cl_arg);
@@ -667,8 +669,7 @@ static void starpu_omp_implicit_task_entry(struct starpu_omp_task *task)
 	 *
 	 * about to run on the worker stack...
 	 */
-	setcontext(&thread->ctx);
-	STARPU_ASSERT(0); /* unreachable code */
+	_starpu_omp_context_set(&thread->ctx);
 }
 
 /*
@@ -686,7 +687,7 @@ static void starpu_omp_task_preempt(void)
 	 *
 	 * about to run on the worker stack...
 	 */
-	swapcontext(&task->ctx, &thread->ctx);
+	_starpu_omp_context_swap(&task->ctx, &thread->ctx);
 	/* now running on the task stack again */
 }
 
@@ -709,17 +710,10 @@ static void starpu_omp_implicit_task_exec(void *buffers[], void *cl_arg)
 		task->starpu_cl_arg = cl_arg;
 		STARPU_ASSERT(task->stack == NULL);
 		STARPU_ASSERT(task->stacksize > 0);
-		_STARPU_MALLOC(task->stack, task->stacksize);
-		getcontext(&task->ctx);
-		/*
-		 * we do not use uc_link, starpu_omp_task_entry will handle
-		 * the end of the task
-		 */
-		task->ctx.uc_link                 = NULL;
-		task->ctx.uc_stack.ss_sp          = task->stack;
-		task->ctx.uc_stack.ss_size        = task->stacksize;
-		task->stack_vg_id                 = VALGRIND_STACK_REGISTER(task->stack, task->stack+task->stacksize);
-		makecontext(&task->ctx, (void (*) ()) starpu_omp_implicit_task_entry, 1, task);
+		task->stack = _starpu_omp_stack_get(task->stacksize);
+		task->stack_vg_id = VALGRIND_STACK_REGISTER(task->stack, task->stack+task->stacksize);
+		/* starpu_omp_implicit_task_entry will handle the end of the task */
+		_starpu_omp_context_make(&task->ctx, task->stack, task->stacksize, starpu_omp_implicit_task_entry, task);
 	}
 
 	task->state = starpu_omp_task_state_clear;
@@ -728,7 +722,7 @@ static void starpu_omp_implicit_task_exec(void *buffers[], void *cl_arg)
 	 * start the task execution, or restore a previously preempted task.
 	 * about to run on the task stack...
 	 * */
-	swapcontext(&thread->ctx, &task->ctx);
+	_starpu_omp_context_swap(&thread->ctx, &task->ctx);
 	/* now running on the worker stack again */
 
 	STARPU_ASSERT(task->state == starpu_omp_task_state_preempted
@@ -742,9 +736,9 @@ static void starpu_omp_implicit_task_exec(void *buffers[], void *cl_arg)
 		task->starpu_task = NULL;
 		VALGRIND_STACK_DEREGISTER(task->stack_vg_id);
 		task->stack_vg_id = 0;
-		free(task->stack);
+		_starpu_omp_stack_put(task->stack, task->stacksize);
 		task->stack = NULL;
-		memset(&task->ctx, 0, sizeof(task->ctx));
+		_starpu_omp_context_clear(&task->ctx);
 	}
 	else if (task->state != starpu_omp_task_state_preempted)
 		_STARPU_ERROR("invalid omp task state");
@@ -883,16 +877,9 @@ static void starpu_omp_explicit_task_exec(void *buffers[], void *cl_arg)
 		task->starpu_cl_arg = cl_arg;
 		STARPU_ASSERT(task->stack == NULL);
 		STARPU_ASSERT(task->stacksize > 0);
-		_STARPU_MALLOC(task->stack, task->stacksize);
-		getcontext(&task->ctx);
-		/*
-		 * we do not use uc_link, starpu_omp_task_entry will handle
-		 * the end of the task
-		 */
-		task->ctx.uc_link                 = NULL;
-		task->ctx.uc_stack.ss_sp          = task->stack;
-		task->ctx.uc_stack.ss_size        = task->stacksize;
-		makecontext(&task->ctx, (void (*) ()) starpu_omp_explicit_task_entry, 1, task);
+		task->stack = _starpu_omp_stack_get(task->stacksize);
+		/* starpu_omp_explicit_task_entry will handle the end of the task */
+		_starpu_omp_context_make(&task->ctx, task->stack, task->stacksize, starpu_omp_explicit_task_entry, task);
 	}
 	task->state = starpu_omp_task_state_clear;
 
@@ -900,7 +887,7 @@ static void starpu_omp_explicit_task_exec(void *buffers[], void *cl_arg)
 	 * start the task execution, or restore a previously preempted task.
 	 * about to run on the task stack...
 	 * */
-	swapcontext(&thread->ctx, &task->ctx);
+	_starpu_omp_context_swap(&thread->ctx, &task->ctx);
 	/* now running on the worker stack again */
 
 	STARPU_ASSERT(task->state == starpu_omp_task_state_preempted
@@ -909,9 +896,9 @@ static void starpu_omp_explicit_task_exec(void *buffers[], void *cl_arg)
 	/* TODO: analyse the cause of the return and take appropriate steps */
 	if (task->state == starpu_omp_task_state_terminated)
 	{
-		free(task->stack);
+		_starpu_omp_stack_put(task->stack, task->stacksize);
 		task->stack = NULL;
-		memset(&task->ctx, 0, sizeof(task->ctx));
+		_starpu_omp_context_clear(&task->ctx);
 
 		starpu_omp_task_completion_accounting(task);
 	}
@@ -982,15 +969,9 @@ static int omp_initial_thread_setup(void)
 	if (initial_thread->initial_thread_stack == NULL)
 		_STARPU_ERROR("memory allocation failed");
 	/* .ctx */
-	getcontext(&initial_thread->ctx);
-	/*
-	 * we do not use uc_link, the initial thread always should give hand back to the initial task
-	 */
-	initial_thread->ctx.uc_link          = NULL;
-	initial_thread->ctx.uc_stack.ss_sp   = initial_thread->initial_thread_stack;
-	initial_thread->ctx.uc_stack.ss_size = _STARPU_INITIAL_THREAD_STACKSIZE;
 	initial_thread->initial_thread_stack_vg_id = VALGRIND_STACK_REGISTER(initial_thread->initial_thread_stack, initial_thread->initial_thread_stack+_STARPU_INITIAL_THREAD_STACKSIZE);
-	makecontext(&initial_thread->ctx, omp_initial_thread_func, 0);
+	/* the initial thread always should give hand back to the initial task */
+	_starpu_omp_context_make(&initial_thread->ctx, initial_thread->initial_thread_stack, _STARPU_INITIAL_THREAD_STACKSIZE, omp_initial_thread_func, NULL);
 	/* .starpu_driver */
 	/*
 	 * we configure starpu to not launch CPU worker 0
@@ -1048,7 +1029,7 @@ static void omp_initial_thread_exit()
 	VALGRIND_STACK_DEREGISTER(initial_thread->initial_thread_stack_vg_id);
 	free(initial_thread->initial_thread_stack);
 	initial_thread->initial_thread_stack = NULL;
-	memset(&initial_thread->ctx, 0, sizeof (initial_thread->ctx));
+	_starpu_omp_context_clear(&initial_thread->ctx);
 	initial_thread->current_task = NULL;
 }
 
@@ -1211,6 +1192,7 @@ int starpu_omp_init(void)
 	_starpu_spin_init(&_global_state.hash_workers_lock);
 
 	_starpu_omp_environment_init();
+	_starpu_omp_stack_pool_init();
 	_global_state.icvs.cancel_var = _starpu_omp_initial_icv_values->cancel_var;
 	_global_state.environment_valid = -EINVAL; /* in case starpu_init exits (e.g. on a slave) */
 	_global_state.environment_valid = omp_initial_region_setup();
@@ -1227,6 +1209,7 @@ void starpu_omp_shutdown(void)
 	if (_global_state.environment_valid != 0) return;
 
 	omp_initial_region_exit();
+	_starpu_omp_stack_pool_exit();
 	/* TODO: free ICV variables */
 	/* TODO: free task/thread/region/device structures */
 	destroy_omp_task_struct(_global_state.initial_task);
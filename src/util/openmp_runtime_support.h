@@ -38,6 +38,27 @@
 
 #pragma GCC visibility push(hidden)
 
+/**
+ * Switch contexts by hand rather than with swapcontext, which saves and
+ * restores the signal mask with system calls.
+ */
+#if (defined(__x86_64__) || defined(__aarch64__)) && defined(__ELF__) && !defined(STARPU_OMP_UCONTEXT)
+#define STARPU_OMP_ASM_CONTEXT 1
+#endif
+
+/**
+ * Execution context of an OpenMP task or thread
+ */
+struct starpu_omp_context
+{
+#ifdef STARPU_OMP_ASM_CONTEXT
+	/** Stack pointer, the registers are saved on the stack */
+	void *sp;
+#else
+	ucontext_t uctx;
+#endif
+};
+
 extern starpu_pthread_key_t omp_thread_key;
 extern starpu_pthread_key_t omp_task_key;
 
@@ -254,7 +275,7 @@ LIST_TYPE(starpu_omp_task,
 	 * context to store the processing state of the task
 	 * in case of blocking/recursive task operation
 	 */
-	ucontext_t ctx;
+	struct starpu_omp_context ctx;
 
 	/*
 	 * stack to execute the task over, to be able to switch
@@ -302,7 +323,7 @@ LIST_TYPE(starpu_omp_thread,
 	 * to which the execution of thread comes back upon a
 	 * blocking/recursive task operation
 	 */
-	ucontext_t ctx;
+	struct starpu_omp_context ctx;
 
 	struct starpu_driver starpu_driver;
 	struct _starpu_worker *worker;
@@ -416,6 +437,23 @@ struct starpu_omp_task *_starpu_omp_get_task(void);
 int _starpu_omp_get_region_thread_num(const struct starpu_omp_region *const region) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 void _starpu_omp_dummy_init(void);
 void _starpu_omp_dummy_shutdown(void);
+
+/** Prepare \p ctx to run \p func(\p arg) over the given stack */
+void _starpu_omp_context_make(struct starpu_omp_context *ctx, void *stack, size_t stacksize, void (*func)(void *), void *arg);
+/** Save the current context in \p from and resume \p to */
+void _starpu_omp_context_swap(struct starpu_omp_context *from, struct starpu_omp_context *to);
+/** Abandon the current context and resume \p to */
+void _starpu_omp_context_set(struct starpu_omp_context *to) STARPU_ATTRIBUTE_NORETURN;
+void _starpu_omp_context_clear(struct starpu_omp_context *ctx);
+
+/** Read STARPU_OMP_STACK_POOL */
+void _starpu_omp_stack_pool_init(void);
+/** Free the stacks kept in the pools */
+void _starpu_omp_stack_pool_exit(void);
+/** Get a task stack, from the pool of the current worker if possible */
+void *_starpu_omp_stack_get(size_t stacksize);
+/** Give back a task stack, to the pool of the current worker if possible */
+void _starpu_omp_stack_put(void *stack, size_t stacksize);
 #endif // STARPU_OPENMP
 
 #pragma GCC visibility pop
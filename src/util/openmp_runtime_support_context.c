@@ -0,0 +1,357 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+/*
+ * Execution contexts and stacks of the OpenMP tasks.
+ *
+ * Stacks are kept in small per-worker pools, to avoid allocating a fresh one
+ * for each task, and are protected by a guard page to catch overflows.
+ *
+ * On x86-64 and aarch64, contexts are switched by hand: only the
+ * callee-saved registers have to be saved since the switch is a function
+ * call, and the signal mask is not saved, which avoids the sigprocmask system
+ * calls of swapcontext. Other architectures keep using ucontexts.
+ */
+
+#include <starpu.h>
+#ifdef STARPU_OPENMP
+/*
+ * locally disable -Wdeprecated-declarations to avoid
+ * lots of deprecated warnings for ucontext related functions
+ */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#include <util/openmp_runtime_support.h>
+#include <core/workers.h>
+#include <common/utils.h>
+#include <stdlib.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#include <unistd.h>
+
+/** Default number of stacks kept by each worker */
+#define _STARPU_OMP_STACK_POOL_SIZE 16
+
+struct _starpu_omp_stack_pool
+{
+	/** Size of the stacks kept in the pool */
+	size_t stacksize;
+	unsigned nstacks;
+	void **stacks;
+};
+
+static struct _starpu_omp_stack_pool _starpu_omp_stack_pools[STARPU_NMAXWORKERS];
+static unsigned _starpu_omp_stack_pool_size;
+static size_t _starpu_omp_page_size;
+
+#ifdef STARPU_OMP_ASM_CONTEXT
+/*
+ * Save the callee-saved registers on the current stack, store the stack
+ * pointer in *from_sp, switch to to_sp, and restore the registers saved there.
+ */
+void _starpu_omp_context_switch(void **from_sp, void *to_sp);
+/*
+ * First code run on a new context, which gets the function and its argument
+ * from the registers restored by _starpu_omp_context_switch
+ */
+void _starpu_omp_context_trampoline(void);
+
+#if defined(__x86_64__)
+/* Saved frame, from the stack pointer: x87 control word, mxcsr, r15, r14, r13, r12, rbx, rbp, return address */
+#define _STARPU_OMP_CONTEXT_FRAME (9*8)
+__asm__(
+	".text\n"
+	".p2align 4\n"
+	".globl _starpu_omp_context_switch\n"
+	".hidden _starpu_omp_context_switch\n"
+	".type _starpu_omp_context_switch,@function\n"
+	"_starpu_omp_context_switch:\n"
+	"	pushq %rbp\n"
+	"	pushq %rbx\n"
+	"	pushq %r12\n"
+	"	pushq %r13\n"
+	"	pushq %r14\n"
+	"	pushq %r15\n"
+	"	subq $16, %rsp\n"
+	"	stmxcsr 8(%rsp)\n"
+	"	fnstcw (%rsp)\n"
+	"	movq %rsp, (%rdi)\n"
+	"	movq %rsi, %rsp\n"
+	"	fldcw (%rsp)\n"
+	"	ldmxcsr 8(%rsp)\n"
+	"	addq $16, %rsp\n"
+	"	popq %r15\n"
+	"	popq %r14\n"
+	"	popq %r13\n"
+	"	popq %r12\n"
+	"	popq %rbx\n"
+	"	popq %rbp\n"
+	"	ret\n"
+	".size _starpu_omp_context_switch,.-_starpu_omp_context_switch\n"
+	".p2align 4\n"
+	".globl _starpu_omp_context_trampoline\n"
+	".hidden _starpu_omp_context_trampoline\n"
+	".type _starpu_omp_context_trampoline,@function\n"
+	"_starpu_omp_context_trampoline:\n"
+	"	movq %r12, %rdi\n"
+	"	callq *%r13\n"
+	"	ud2\n"
+	".size _starpu_omp_context_trampoline,.-_starpu_omp_context_trampoline\n"
+);
+
+static void *_starpu_omp_context_init_frame(void *top, void (*func)(void *), void *arg)
+{
+	uint64_t *frame = (uint64_t *) ((char *) top - _STARPU_OMP_CONTEXT_FRAME);
+	uint32_t mxcsr;
+	uint16_t fpucw;
+
+	__asm__ __volatile__ ("stmxcsr %0" : "=m" (mxcsr));
+	__asm__ __volatile__ ("fnstcw %0" : "=m" (fpucw));
+
+	memset(frame, 0, _STARPU_OMP_CONTEXT_FRAME);
+	memcpy(&frame[0], &fpucw, sizeof(fpucw));
+	memcpy(&frame[1], &mxcsr, sizeof(mxcsr));
+	frame[4] = (uintptr_t) func;	/* r13 */
+	frame[5] = (uintptr_t) arg;	/* r12 */
+	frame[8] = (uintptr_t) _starpu_omp_context_trampoline;
+	return frame;
+}
+#elif defined(__aarch64__)
+/* Saved frame, from the stack pointer: x19-x30, d8-d15, fpcr, padding */
+#define _STARPU_OMP_CONTEXT_FRAME 176
+__asm__(
+	".text\n"
+	".p2align 4\n"
+	".globl _starpu_omp_context_switch\n"
+	".hidden _starpu_omp_context_switch\n"
+	".type _starpu_omp_context_switch,%function\n"
+	"_starpu_omp_context_switch:\n"
+	"	sub sp, sp, #176\n"
+	"	stp x19, x20, [sp, #0]\n"
+	"	stp x21, x22, [sp, #16]\n"
+	"	stp x23, x24, [sp, #32]\n"
+	"	stp x25, x26, [sp, #48]\n"
+	"	stp x27, x28, [sp, #64]\n"
+	"	stp x29, x30, [sp, #80]\n"
+	"	stp d8, d9, [sp, #96]\n"
+	"	stp d10, d11, [sp, #112]\n"
+	"	stp d12, d13, [sp, #128]\n"
+	"	stp d14, d15, [sp, #144]\n"
+	"	mrs x9, fpcr\n"
+	"	str x9, [sp, #160]\n"
+	"	mov x9, sp\n"
+	"	str x9, [x0]\n"
+	"	mov sp, x1\n"
+	"	ldp x19, x20, [sp, #0]\n"
+	"	ldp x21, x22, [sp, #16]\n"
+	"	ldp x23, x24, [sp, #32]\n"
+	"	ldp x25, x26, [sp, #48]\n"
+	"	ldp x27, x28, [sp, #64]\n"
+	"	ldp x29, x30, [sp, #80]\n"
+	"	ldp d8, d9, [sp, #96]\n"
+	"	ldp d10, d11, [sp, #112]\n"
+	"	ldp d12, d13, [sp, #128]\n"
+	"	ldp d14, d15, [sp, #144]\n"
+	"	ldr x9, [sp, #160]\n"
+	"	msr fpcr, x9\n"
+	"	add sp, sp, #176\n"
+	"	ret\n"
+	".size _starpu_omp_context_switch,.-_starpu_omp_context_switch\n"
+	".p2align 4\n"
+	".globl _starpu_omp_context_trampoline\n"
+	".hidden _starpu_omp_context_trampoline\n"
+	".type _starpu_omp_context_trampoline,%function\n"
+	"_starpu_omp_context_trampoline:\n"
+	"	mov x0, x19\n"
+	"	blr x20\n"
+	"	brk #0\n"
+	".size _starpu_omp_context_trampoline,.-_starpu_omp_context_trampoline\n"
+);
+
+static void *_starpu_omp_context_init_frame(void *top, void (*func)(void *), void *arg)
+{
+	uint64_t *frame = (uint64_t *) ((char *) top - _STARPU_OMP_CONTEXT_FRAME);
+	uint64_t fpcr;
+
+	__asm__ __volatile__ ("mrs %0, fpcr" : "=r" (fpcr));
+
+	memset(frame, 0, _STARPU_OMP_CONTEXT_FRAME);
+	frame[0] = (uintptr_t) arg;	/* x19 */
+	frame[1] = (uintptr_t) func;	/* x20 */
+	frame[11] = (uintptr_t) _starpu_omp_context_trampoline;	/* x30 */
+	frame[20] = fpcr;
+	return frame;
+}
+#endif
+
+void _starpu_omp_context_make(struct starpu_omp_context *ctx, void *stack, size_t stacksize, void (*func)(void *), void *arg)
+{
+	/* The ABIs require a 16-byte aligned stack */
+	uintptr_t top = ((uintptr_t) stack + stacksize) & ~(uintptr_t) 15;
+	ctx->sp = _starpu_omp_context_init_frame((void *) top, func, arg);
+}
+
+void _starpu_omp_context_swap(struct starpu_omp_context *from, struct starpu_omp_context *to)
+{
+	_starpu_omp_context_switch(&from->sp, to->sp);
+}
+
+void _starpu_omp_context_set(struct starpu_omp_context *to)
+{
+	/* The current context is abandoned */
+	void *sp;
+	_starpu_omp_context_switch(&sp, to->sp);
+	STARPU_ASSERT(0); /* unreachable code */
+	abort();
+}
+
+void _starpu_omp_context_clear(struct starpu_omp_context *ctx)
+{
+	ctx->sp = NULL;
+}
+#else /* !STARPU_OMP_ASM_CONTEXT */
+void _starpu_omp_context_make(struct starpu_omp_context *ctx, void *stack, size_t stacksize, void (*func)(void *), void *arg)
+{
+	getcontext(&ctx->uctx);
+	/*
+	 * we do not use uc_link, the function will handle its end by
+	 * switching to another context
+	 */
+	ctx->uctx.uc_link          = NULL;
+	ctx->uctx.uc_stack.ss_sp   = stack;
+	ctx->uctx.uc_stack.ss_size = stacksize;
+	makecontext(&ctx->uctx, (void (*) ()) func, 1, arg);
+}
+
+void _starpu_omp_context_swap(struct starpu_omp_context *from, struct starpu_omp_context *to)
+{
+	swapcontext(&from->uctx, &to->uctx);
+}
+
+void _starpu_omp_context_set(struct starpu_omp_context *to)
+{
+	setcontext(&to->uctx);
+	STARPU_ASSERT(0); /* unreachable code */
+	abort();
+}
+
+void _starpu_omp_context_clear(struct starpu_omp_context *ctx)
+{
+	memset(&ctx->uctx, 0, sizeof(ctx->uctx));
+}
+#endif /* !STARPU_OMP_ASM_CONTEXT */
+
+void _starpu_omp_stack_pool_init(void)
+{
+	_starpu_omp_stack_pool_size = starpu_getenv_number_default("STARPU_OMP_STACK_POOL", _STARPU_OMP_STACK_POOL_SIZE);
+#ifdef HAVE_MMAP
+	_starpu_omp_page_size = sysconf(_SC_PAGESIZE);
+#endif
+}
+
+/* Allocate a stack, preceded by a guard page */
+static void *_starpu_omp_stack_map(size_t stacksize)
+{
+	void *stack;
+#ifdef HAVE_MMAP
+	void *base = mmap(NULL, _starpu_omp_page_size + stacksize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if (base == MAP_FAILED)
+		_STARPU_ERROR("could not allocate an OpenMP task stack of %lu bytes: %s\n", (unsigned long) stacksize, strerror(errno));
+	/* The stack grows downwards */
+	if (mprotect(base, _starpu_omp_page_size, PROT_NONE) != 0)
+		_STARPU_DISP("could not protect the guard page of an OpenMP task stack: %s\n", strerror(errno));
+	stack = (char *) base + _starpu_omp_page_size;
+#else
+	_STARPU_MALLOC(stack, stacksize);
+#endif
+	return stack;
+}
+
+static void _starpu_omp_stack_unmap(void *stack, size_t stacksize)
+{
+#ifdef HAVE_MMAP
+	munmap((char *) stack - _starpu_omp_page_size, _starpu_omp_page_size + stacksize);
+#else
+	(void) stacksize;
+	free(stack);
+#endif
+}
+
+static size_t _starpu_omp_stack_round(size_t stacksize)
+{
+#ifdef HAVE_MMAP
+	return (stacksize + _starpu_omp_page_size - 1) & ~(_starpu_omp_page_size - 1);
+#else
+	return stacksize;
+#endif
+}
+
+/*
+ * Stacks are only taken and given back by the workers which execute the
+ * tasks, so each pool is only accessed by its worker and needs no lock.
+ */
+void *_starpu_omp_stack_get(size_t stacksize)
+{
+	int workerid = starpu_worker_get_id();
+	stacksize = _starpu_omp_stack_round(stacksize);
+
+	if (workerid >= 0)
+	{
+		struct _starpu_omp_stack_pool *pool = &_starpu_omp_stack_pools[workerid];
+		if (pool->nstacks > 0 && pool->stacksize == stacksize)
+			return pool->stacks[--pool->nstacks];
+	}
+	return _starpu_omp_stack_map(stacksize);
+}
+
+void _starpu_omp_stack_put(void *stack, size_t stacksize)
+{
+	int workerid = starpu_worker_get_id();
+	stacksize = _starpu_omp_stack_round(stacksize);
+
+	if (workerid >= 0 && _starpu_omp_stack_pool_size > 0)
+	{
+		struct _starpu_omp_stack_pool *pool = &_starpu_omp_stack_pools[workerid];
+		if (pool->nstacks == 0)
+			pool->stacksize = stacksize;
+		if (pool->stacksize == stacksize && pool->nstacks < _starpu_omp_stack_pool_size)
+		{
+			if (!pool->stacks)
+				_STARPU_MALLOC(pool->stacks, _starpu_omp_stack_pool_size * sizeof(*pool->stacks));
+			pool->stacks[pool->nstacks++] = stack;
+			return;
+		}
+	}
+	_starpu_omp_stack_unmap(stack, stacksize);
+}
+
+void _starpu_omp_stack_pool_exit(void)
+{
+	unsigned workerid;
+
+	for (workerid = 0; workerid < STARPU_NMAXWORKERS; workerid++)
+	{
+		struct _starpu_omp_stack_pool *pool = &_starpu_omp_stack_pools[workerid];
+		while (pool->nstacks > 0)
+			_starpu_omp_stack_unmap(pool->stacks[--pool->nstacks], pool->stacksize);
+		free(pool->stacks);
+		pool->stacks = NULL;
+	}
+}
+
+#pragma GCC diagnostic pop
+#endif /* STARPU_OPENMP */
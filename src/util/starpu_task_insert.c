@@ -224,3 +224,60 @@ struct starpu_task *starpu_task_build(struct starpu_codelet *cl, ...)
 
 	return task;
 }
+
+#undef starpu_task_insert_compile
+struct starpu_task_insert_desc *starpu_task_insert_compile(struct starpu_codelet *cl, ...)
+{
+	struct starpu_task_insert_desc *desc;
+	va_list varg_list;
+
+	va_start(varg_list, cl);
+	desc = _starpu_task_insert_compile(cl, varg_list);
+	va_end(varg_list);
+
+	return desc;
+}
+
+void starpu_task_insert_desc_free(struct starpu_task_insert_desc *desc)
+{
+	if (!desc)
+		return;
+	free(desc->modes);
+	free(desc->value_sizes);
+	free(desc->value_offsets);
+	free(desc);
+}
+
+int starpu_task_set_compiled(struct starpu_task *task, struct starpu_task_insert_desc *desc, ...)
+{
+	va_list varg_list;
+	int ret;
+
+	va_start(varg_list, desc);
+	ret = _starpu_task_insert_compiled_fill(desc, task, varg_list);
+	va_end(varg_list);
+
+	return ret;
+}
+
+int starpu_task_insert_compiled(struct starpu_task_insert_desc *desc, ...)
+{
+	struct starpu_task *task;
+	va_list varg_list;
+	int ret;
+
+	task = starpu_task_create();
+
+	va_start(varg_list, desc);
+	ret = _starpu_task_insert_compiled_fill(desc, task, varg_list);
+	va_end(varg_list);
+	STARPU_ASSERT(ret == 0);
+
+	ret = starpu_task_submit(task);
+	if (STARPU_UNLIKELY(ret == -ENODEV))
+	{
+		task->destroy = 0;
+		starpu_task_destroy(task);
+	}
+	return ret;
+}
@@ -586,6 +586,282 @@ int _starpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *ta
 	return 0;
 }
 
+struct starpu_task_insert_desc *_starpu_task_insert_compile(struct starpu_codelet *cl, va_list varg_list)
+{
+	struct starpu_task_insert_desc *desc;
+	struct starpu_task *proto;
+	int arg_type;
+	int allocated_buffers = 0;
+	int allocated_values = 0;
+
+	STARPU_ASSERT_MSG(cl != NULL, "starpu_task_insert_compile needs a codelet");
+
+	_STARPU_CALLOC(desc, 1, sizeof(*desc));
+	desc->cl = cl;
+	desc->set_modes = cl->nbuffers == STARPU_VARIABLE_NBUFFERS || (cl->nbuffers > STARPU_NMAXBUFS && !cl->dyn_modes);
+	desc->cl_arg_size = sizeof(int);
+	proto = &desc->proto;
+	starpu_task_init(proto);
+
+	while((arg_type = va_arg(varg_list, int)) != 0)
+	{
+		if (arg_type & STARPU_R || arg_type & STARPU_W || arg_type & STARPU_SCRATCH || arg_type & STARPU_REDUX || arg_type & STARPU_MPI_REDUX)
+		{
+			/* Only the access mode, the handle will be given to starpu_task_insert_compiled */
+			enum starpu_data_access_mode arg_mode = (enum starpu_data_access_mode) arg_type & ~STARPU_SSEND & ~STARPU_NOFOOTPRINT;
+			int current_buffer = desc->nbuffers;
+
+			STARPU_ASSERT_MSG(cl->nbuffers == STARPU_VARIABLE_NBUFFERS || current_buffer < cl->nbuffers, "Too many data passed to starpu_task_insert_compile");
+
+			/* MPI_REDUX should be interpreted as RW|COMMUTE by the "ground" StarPU layer.*/
+			if (arg_mode & STARPU_MPI_REDUX)
+			{
+				arg_mode = STARPU_RW|STARPU_COMMUTE;
+			}
+
+			if (current_buffer == allocated_buffers)
+			{
+				allocated_buffers = allocated_buffers ? 2 * allocated_buffers : STARPU_NMAXBUFS;
+				_STARPU_REALLOC(desc->modes, allocated_buffers * sizeof(*desc->modes));
+			}
+			desc->modes[current_buffer] = arg_mode;
+
+			if (desc->set_modes)
+			{
+				/* Will be set in each task */
+			}
+			else if (STARPU_CODELET_GET_MODE(cl, current_buffer))
+			{
+				STARPU_ASSERT_MSG((STARPU_CODELET_GET_MODE(cl, current_buffer) & ~STARPU_NOFOOTPRINT) == arg_mode,
+						  "The codelet <%s> defines the access mode %d for the buffer %d which is different from the mode %d given to starpu_task_insert_compile\n",
+						  _starpu_codelet_get_name(cl), STARPU_CODELET_GET_MODE(cl, current_buffer),
+						  current_buffer, arg_mode);
+			}
+			else
+			{
+				STARPU_CODELET_SET_MODE(cl, arg_mode, current_buffer);
+			}
+			desc->nbuffers++;
+		}
+		else if (arg_type==STARPU_VALUE)
+		{
+			/* Only the size, the pointer to the value will be given to starpu_task_insert_compiled */
+			size_t ptr_size = va_arg(varg_list, size_t);
+
+			if (desc->nvalues == allocated_values)
+			{
+				allocated_values = allocated_values ? 2 * allocated_values : 8;
+				_STARPU_REALLOC(desc->value_sizes, allocated_values * sizeof(*desc->value_sizes));
+				_STARPU_REALLOC(desc->value_offsets, allocated_values * sizeof(*desc->value_offsets));
+			}
+			/* Same layout as starpu_codelet_pack_arg() */
+			desc->value_sizes[desc->nvalues] = ptr_size;
+			desc->value_offsets[desc->nvalues] = desc->cl_arg_size + sizeof(ptr_size);
+			desc->cl_arg_size += sizeof(ptr_size) + ptr_size;
+			desc->nvalues++;
+		}
+		else if (arg_type==STARPU_CALLBACK)
+		{
+			proto->callback_func = va_arg(varg_list, _starpu_callback_func_t);
+		}
+		else if (arg_type==STARPU_CALLBACK_WITH_ARG_NFREE)
+		{
+			proto->callback_func = va_arg(varg_list, _starpu_callback_func_t);
+			proto->callback_arg = va_arg(varg_list, void *);
+		}
+		else if (arg_type==STARPU_CALLBACK_ARG_NFREE)
+		{
+			proto->callback_arg = va_arg(varg_list, void *);
+		}
+		else if (arg_type==STARPU_PROLOGUE_CALLBACK)
+		{
+			proto->prologue_callback_func = va_arg(varg_list, _starpu_callback_func_t);
+		}
+		else if (arg_type==STARPU_PROLOGUE_CALLBACK_ARG_NFREE)
+		{
+			proto->prologue_callback_arg = va_arg(varg_list, void *);
+		}
+		else if (arg_type==STARPU_PRIORITY)
+		{
+			proto->priority = va_arg(varg_list, int);
+		}
+		else if (arg_type==STARPU_EXECUTE_WHERE)
+		{
+			proto->where = va_arg(varg_list, unsigned long long);
+		}
+		else if (arg_type==STARPU_EXECUTE_ON_WORKER)
+		{
+			int worker = va_arg(varg_list, int);
+			if (worker != -1)
+			{
+				proto->workerid = worker;
+				proto->execute_on_a_specific_worker = 1;
+			}
+		}
+		else if (arg_type==STARPU_WORKER_ORDER)
+		{
+			unsigned order = va_arg(varg_list, unsigned);
+			if (order != 0)
+			{
+				STARPU_ASSERT_MSG(proto->execute_on_a_specific_worker, "worker order only makes sense if a workerid is provided");
+				proto->workerorder = order;
+			}
+		}
+		else if (arg_type==STARPU_SCHED_CTX)
+		{
+			proto->sched_ctx = va_arg(varg_list, unsigned);
+		}
+		else if (arg_type==STARPU_HYPERVISOR_TAG)
+		{
+			proto->hypervisor_tag = va_arg(varg_list, int);
+		}
+		else if (arg_type==STARPU_POSSIBLY_PARALLEL)
+		{
+			proto->possibly_parallel = va_arg(varg_list, unsigned);
+		}
+		else if (arg_type==STARPU_FLOPS)
+		{
+			proto->flops = va_arg(varg_list, double);
+		}
+		else if (arg_type==STARPU_NAME)
+		{
+			proto->name = va_arg(varg_list, const char *);
+		}
+		else if (arg_type==STARPU_TASK_COLOR)
+		{
+			proto->color = va_arg(varg_list, int);
+		}
+		else if (arg_type==STARPU_TASK_SYNCHRONOUS)
+		{
+			proto->synchronous = va_arg(varg_list, int);
+		}
+		else if (arg_type==STARPU_SEQUENTIAL_CONSISTENCY)
+		{
+			proto->sequential_consistency = va_arg(varg_list, unsigned);
+		}
+		else if (arg_type==STARPU_TASK_NO_SUBMITORDER)
+		{
+			proto->no_submitorder = va_arg(varg_list, unsigned);
+		}
+		else if (arg_type==STARPU_TASK_FILE)
+		{
+			proto->file = va_arg(varg_list, const char *);
+		}
+		else if (arg_type==STARPU_TASK_LINE)
+		{
+			proto->line = va_arg(varg_list, int);
+		}
+		else
+		{
+			/* Arguments which carry per-task objects (tags, dependencies,
+			 * freed callback arguments, ...) cannot be shared by all tasks */
+			STARPU_ABORT_MSG("Argument %d is not supported by starpu_task_insert_compile, use starpu_task_insert instead. Did you perhaps forget to end arguments with 0?\n", arg_type);
+		}
+	}
+
+	STARPU_ASSERT_MSG(cl->nbuffers == STARPU_VARIABLE_NBUFFERS || desc->nbuffers == cl->nbuffers, "Incoherent number of buffers between cl (%d) and number of parameters (%d)", cl->nbuffers, desc->nbuffers);
+
+	return desc;
+}
+
+int _starpu_task_insert_compiled_fill(struct starpu_task_insert_desc *desc, struct starpu_task *task, va_list varg_list)
+{
+	struct starpu_codelet *cl = desc->cl;
+	struct starpu_task *proto = &desc->proto;
+	int i;
+
+	_STARPU_TRACE_TASK_BUILD_START();
+
+	/* Handles, stored directly at their place */
+	if (STARPU_UNLIKELY(task->dyn_handles))
+	{
+		/* From a previous use of the task */
+		free(task->dyn_handles);
+		task->dyn_handles = NULL;
+		free(task->dyn_interfaces);
+		task->dyn_interfaces = NULL;
+		free(task->dyn_modes);
+		task->dyn_modes = NULL;
+	}
+	if (STARPU_UNLIKELY(desc->nbuffers > STARPU_NMAXBUFS))
+	{
+		_STARPU_MALLOC(task->dyn_handles, desc->nbuffers * sizeof(starpu_data_handle_t));
+		if (cl->nbuffers == STARPU_VARIABLE_NBUFFERS || !cl->dyn_modes)
+			_STARPU_MALLOC(task->dyn_modes, desc->nbuffers * sizeof(enum starpu_data_access_mode));
+	}
+	task->cl = cl;
+	if (cl->nbuffers == STARPU_VARIABLE_NBUFFERS)
+		task->nbuffers = desc->nbuffers;
+	if (task->dyn_handles)
+	{
+		for (i = 0; i < desc->nbuffers; i++)
+			task->dyn_handles[i] = va_arg(varg_list, starpu_data_handle_t);
+	}
+	else
+	{
+		for (i = 0; i < desc->nbuffers; i++)
+			task->handles[i] = va_arg(varg_list, starpu_data_handle_t);
+	}
+	if (desc->set_modes)
+	{
+		if (task->dyn_modes)
+			memcpy(task->dyn_modes, desc->modes, desc->nbuffers * sizeof(*desc->modes));
+		else
+			memcpy(task->modes, desc->modes, desc->nbuffers * sizeof(*desc->modes));
+	}
+
+	/* Values, copied at their precomputed offset, in a buffer which is
+	 * reused if it was allocated by StarPU and has the right size already.
+	 * A buffer owned by the application is left untouched. */
+	if (desc->nvalues)
+	{
+		char *arg_buffer = task->cl_arg;
+		if (!arg_buffer || !task->cl_arg_free || task->cl_arg_size != desc->cl_arg_size)
+		{
+			if (task->cl_arg_free)
+				free(arg_buffer);
+			_STARPU_MALLOC(arg_buffer, desc->cl_arg_size);
+			task->cl_arg = arg_buffer;
+			task->cl_arg_size = desc->cl_arg_size;
+			task->cl_arg_free = 1;
+		}
+		memcpy(arg_buffer, &desc->nvalues, sizeof(desc->nvalues));
+		for (i = 0; i < desc->nvalues; i++)
+		{
+			size_t ptr_size = desc->value_sizes[i];
+			memcpy(arg_buffer + desc->value_offsets[i] - sizeof(ptr_size), &ptr_size, sizeof(ptr_size));
+			memcpy(arg_buffer + desc->value_offsets[i], va_arg(varg_list, void *), ptr_size);
+		}
+	}
+
+	/* Constant fields */
+	task->callback_func = proto->callback_func;
+	task->callback_arg = proto->callback_arg;
+	task->callback_arg_free = 0;
+	task->prologue_callback_func = proto->prologue_callback_func;
+	task->prologue_callback_arg = proto->prologue_callback_arg;
+	task->prologue_callback_arg_free = 0;
+	task->priority = proto->priority;
+	task->where = proto->where;
+	task->workerid = proto->workerid;
+	task->execute_on_a_specific_worker = proto->execute_on_a_specific_worker;
+	task->workerorder = proto->workerorder;
+	task->sched_ctx = proto->sched_ctx;
+	task->hypervisor_tag = proto->hypervisor_tag;
+	task->possibly_parallel = proto->possibly_parallel;
+	task->flops = proto->flops;
+	task->name = proto->name;
+	task->color = proto->color;
+	task->synchronous = proto->synchronous;
+	task->sequential_consistency = proto->sequential_consistency;
+	task->no_submitorder = proto->no_submitorder;
+	task->file = proto->file;
+	task->line = proto->line;
+
+	_STARPU_TRACE_TASK_BUILD_END();
+	return 0;
+}
+
 int _fstarpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *task, void **arglist)
 {
 	int arg_i = 0;
@@ -27,6 +27,33 @@
 
 typedef void (*_starpu_callback_func_t)(void *);
 
+/** Result of starpu_task_insert_compile(): everything which does not depend
+ * on the actual handles and values of the tasks */
+struct starpu_task_insert_desc
+{
+	struct starpu_codelet *cl;
+
+	/** Number of handles, and their access mode when they have to be set in
+	 * the task itself */
+	int nbuffers;
+	enum starpu_data_access_mode *modes;
+	unsigned set_modes;
+
+	/** Number of STARPU_VALUE arguments, their size and the offset of
+	 * their contents within cl_arg */
+	int nvalues;
+	size_t *value_sizes;
+	size_t *value_offsets;
+	size_t cl_arg_size;
+
+	/** Task fields which were given constant values in the signature,
+	 * starting from the starpu_task_init() defaults */
+	struct starpu_task proto;
+};
+
+struct starpu_task_insert_desc *_starpu_task_insert_compile(struct starpu_codelet *cl, va_list varg_list);
+int _starpu_task_insert_compiled_fill(struct starpu_task_insert_desc *desc, struct starpu_task *task, va_list varg_list);
+
 int _starpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *task, va_list varg_list) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 int _fstarpu_task_insert_create(struct starpu_codelet *cl, struct starpu_task *task, void **arglist) STARPU_ATTRIBUTE_VISIBILITY_DEFAULT;
 
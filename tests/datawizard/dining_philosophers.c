@@ -18,11 +18,10 @@
 #include "../helper.h"
 
 /*
- * Test Dijkstra's Dining Philosophers problem
+ * Test Dijkstra's Dining Philosophers problem, without and with an arbiter
+ * (which may be sharded with STARPU_ARBITER_SHARDS), and report the time taken
  */
 
-/* TODO: try to use an arbiter and check improved concurrency */
-
 /* number of philosophers */
 #define N	16
 
@@ -62,13 +61,11 @@ int submit_one_task(unsigned p)
 	return ret;
 }
 
-int main(int argc, char **argv)
+static
+int dine(starpu_arbiter_t arbiter)
 {
-	int ret;
-
-	ret = starpu_initialize(NULL, &argc, &argv);
-	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
-	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+	int ret = 0;
+	double start, end;
 
 	/* initialize the forks */
 	unsigned f;
@@ -78,38 +75,62 @@ int main(int argc, char **argv)
 
 		starpu_vector_data_register(&fork_handles[f], STARPU_MAIN_RAM, (uintptr_t)&forks[f], 1, sizeof(unsigned));
 		starpu_data_set_sequential_consistency_flag(fork_handles[f], 0);
+		if (arbiter)
+			starpu_data_assign_arbiter(fork_handles[f], arbiter);
 	}
 
 	unsigned ntasks = 1024;
 
+	start = starpu_timing_now();
 	unsigned t;
 	for (t = 0; t < ntasks; t++)
 	{
 		/* select one philosopher randomly */
 		unsigned philosopher = rand() % N;
 		ret = submit_one_task(philosopher);
-		if (ret == -ENODEV) goto enodev;
+		if (ret == -ENODEV) break;
 		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
 	}
 
-	ret = starpu_task_wait_for_all();
-	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+	if (ret != -ENODEV)
+	{
+		ret = starpu_task_wait_for_all();
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait_for_all");
+		end = starpu_timing_now();
+
+		FPRINTF(stderr, "waiting done %s arbiter: %f ms\n", arbiter ? "with" : "without", (end - start) / 1000.);
+	}
 
-	FPRINTF(stderr, "waiting done\n");
 	for (f = 0; f < N; f++)
 	{
 		starpu_data_unregister(fork_handles[f]);
 	}
 
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	starpu_arbiter_t arbiter;
+	int ret;
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	ret = dine(NULL);
+	if (ret == -ENODEV) goto enodev;
+
+	arbiter = starpu_arbiter_create();
+	ret = dine(arbiter);
+	starpu_arbiter_destroy(arbiter);
+	if (ret == -ENODEV) goto enodev;
+
 	starpu_shutdown();
 
 	return EXIT_SUCCESS;
 
 enodev:
-	for (f = 0; f < N; f++)
-	{
-		starpu_data_unregister(fork_handles[f]);
-	}
 	fprintf(stderr, "WARNING: No one can execute this task\n");
 	/* yes, we do not perform the computation but we did detect that no one
  	 * could perform the kernel, so this is not an error from StarPU */
@@ -0,0 +1,69 @@
+#!/bin/sh -x
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2017-2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+# Check that starpu_fxt_tool produces the same result when streaming tasks,
+# and whatever the number of threads parsing the trace files
+
+# Testing another specific scheduler, no need to run this
+[ -z "$STARPU_SCHED" -o "$STARPU_SCHED" = modular-eager ] || exit 77
+
+set -e
+
+PREFIX=$(dirname $0)
+TRACES=$PREFIX/locality_stream.traces
+rm -rf $TRACES
+mkdir -p $TRACES
+
+test -x $PREFIX/../../tools/starpu_fxt_tool || exit 77
+
+export STARPU_FXT_PREFIX=$TRACES
+for i in 0 1
+do
+	STARPU_FXT_TRACE=1 STARPU_FXT_SUFFIX=prof_file_$i STARPU_SCHED=modular-eager $MS_LAUNCHER $STARPU_LAUNCH $PREFIX/locality
+done
+
+fxt_tool()
+{
+	dir=$TRACES/$1
+	shift
+	mkdir -p $dir
+	$STARPU_LAUNCH $PREFIX/../../tools/starpu_fxt_tool -d $dir -binary "$@"
+}
+
+# Records of tasks.rec, one per line, sorted
+records()
+{
+	awk 'BEGIN { RS = ""; FS = "\n"; OFS = "|" } { $1 = $1; print }' $1 | sort
+}
+
+# Streaming tasks only changes the order of the records in tasks.rec
+fxt_tool normal -i $TRACES/prof_file_0_0
+fxt_tool stream -stream -i $TRACES/prof_file_0_0
+for file in paje.trace dag.dot tasks.bin
+do
+	cmp $TRACES/normal/$file $TRACES/stream/$file
+done
+records $TRACES/normal/tasks.rec > $TRACES/normal/tasks.sorted
+records $TRACES/stream/tasks.rec > $TRACES/stream/tasks.sorted
+cmp $TRACES/normal/tasks.sorted $TRACES/stream/tasks.sorted
+
+# The number of threads does not change anything
+fxt_tool sequential -j 1 -i $TRACES/prof_file_0_0 $TRACES/prof_file_1_0
+fxt_tool parallel -j 2 -i $TRACES/prof_file_0_0 $TRACES/prof_file_1_0
+for file in paje.trace dag.dot tasks.rec tasks.bin trace.html
+do
+	cmp $TRACES/sequential/$file $TRACES/parallel/$file
+done
@@ -0,0 +1,232 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID)
+#include <hwloc.h>
+#if HWLOC_API_VERSION < 0x00010b00
+#define HWLOC_OBJ_NUMANODE HWLOC_OBJ_NODE
+#endif
+#endif
+#include "../helper.h"
+
+/*
+ * Access a set of first-touch vectors from each CPU worker in turn with the
+ * NUMA page migrator enabled, and check that it migrated them when the CPU
+ * workers span several NUMA nodes. Otherwise, the migrator is not started and
+ * the test is skipped.
+ */
+
+#define NVECTORS 8
+#define NX (256*1024)
+
+#ifdef STARPU_QUICK_CHECK
+#define NACCESSES 8
+#else
+#define NACCESSES 64
+#endif
+
+static int id_g_migrated_bytes;
+static int id_g_migrations;
+static int64_t migrated_bytes;
+static int64_t migrations;
+
+static void g_listener_cb(struct starpu_perf_counter_listener *listener, struct starpu_perf_counter_sample *sample, void *context)
+{
+	(void) listener;
+	(void) context;
+	migrated_bytes = starpu_perf_counter_sample_get_int64_value(sample, id_g_migrated_bytes);
+	migrations = starpu_perf_counter_sample_get_int64_value(sample, id_g_migrations);
+}
+
+/* Whether the CPU workers span several NUMA nodes which are not separate
+ * memory nodes, i.e. whether the migrator has something to do */
+static int migrations_expected(int *workers, unsigned nworkers)
+{
+#if defined(STARPU_HAVE_HWLOC) && !defined(STARPU_SIMGRID)
+	hwloc_topology_t hwtopology = starpu_get_hwloc_topology();
+	int first_numa = -1;
+	unsigned w;
+
+	if (starpu_memory_nodes_get_numa_count() > 1)
+		return 0;
+
+	for (w = 0; w < nworkers; w++)
+	{
+		int bindid = starpu_worker_get_bindid(workers[w]);
+		hwloc_obj_t pu = bindid >= 0 ? hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_PU, bindid) : NULL;
+		int n, numa = -1;
+
+		if (!pu)
+			continue;
+		for (n = 0; n < hwloc_get_nbobjs_by_type(hwtopology, HWLOC_OBJ_NUMANODE); n++)
+			if (hwloc_bitmap_intersects(hwloc_get_obj_by_type(hwtopology, HWLOC_OBJ_NUMANODE, n)->cpuset, pu->cpuset))
+			{
+				numa = n;
+				break;
+			}
+		if (numa < 0)
+			continue;
+		if (first_numa < 0)
+			first_numa = numa;
+		else if (numa != first_numa)
+			return 1;
+	}
+#else
+	(void) workers;
+	(void) nworkers;
+#endif
+	return 0;
+}
+
+static void scale_cpu(void *descr[], void *arg)
+{
+	float *v = (float *) STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+	(void) arg;
+
+	for (i = 0; i < n; i++)
+		v[i] *= 1.0001f;
+}
+
+static void init_cpu(void *descr[], void *arg)
+{
+	float *v = (float *) STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+	(void) arg;
+
+	for (i = 0; i < n; i++)
+		v[i] = i;
+}
+
+static struct starpu_codelet init_cl =
+{
+	.cpu_funcs = {init_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_W},
+	.name = "init",
+};
+
+static struct starpu_codelet scale_cl =
+{
+	.cpu_funcs = {scale_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.name = "scale",
+};
+
+int main(void)
+{
+	const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+	struct starpu_conf conf;
+	starpu_data_handle_t handles[NVECTORS];
+	int workers[STARPU_NMAXWORKERS];
+	unsigned nworkers, w, i, j;
+	int expected;
+	int ret;
+
+	setenv("STARPU_NUMA_MIGRATION", "1", 1);
+	setenv("STARPU_NUMA_MIGRATION_THRESHOLD", "4", 1);
+
+	starpu_conf_init(&conf);
+	conf.start_perf_counter_collection = 1;
+	ret = starpu_initialize(&conf, NULL, NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	nworkers = starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, workers, STARPU_NMAXWORKERS);
+	if (nworkers == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	expected = migrations_expected(workers, nworkers);
+
+	struct starpu_perf_counter_set *set = starpu_perf_counter_set_alloc(scope);
+	id_g_migrated_bytes = starpu_perf_counter_name_to_id(scope, "starpu.numa.g_migrated_bytes");
+	id_g_migrations = starpu_perf_counter_name_to_id(scope, "starpu.numa.g_migrations");
+	STARPU_ASSERT(id_g_migrated_bytes != -1 && id_g_migrations != -1);
+	starpu_perf_counter_set_enable_id(set, id_g_migrated_bytes);
+	starpu_perf_counter_set_enable_id(set, id_g_migrations);
+	struct starpu_perf_counter_listener *listener = starpu_perf_counter_listener_init(set, g_listener_cb, NULL);
+	starpu_perf_counter_set_global_listener(listener);
+
+	for (i = 0; i < NVECTORS; i++)
+	{
+		starpu_vector_data_register(&handles[i], -1, 0, NX, sizeof(float));
+		starpu_data_set_numa_policy(handles[i], STARPU_DATA_NUMA_FIRST_TOUCH, -1);
+	}
+
+	for (i = 0; i < NVECTORS; i++)
+	{
+		ret = starpu_task_insert(&init_cl,
+					 STARPU_EXECUTE_ON_WORKER, workers[0],
+					 STARPU_W, handles[i], 0);
+		if (ret == -ENODEV)
+			goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+
+	/* Move the consumers of the data from one worker to the other */
+	for (w = 0; w < nworkers; w++)
+	{
+		for (j = 0; j < NACCESSES; j++)
+			for (i = 0; i < NVECTORS; i++)
+			{
+				ret = starpu_task_insert(&scale_cl,
+							 STARPU_EXECUTE_ON_WORKER, workers[w],
+							 STARPU_RW, handles[i], 0);
+				if (ret == -ENODEV)
+					goto enodev;
+				STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+			}
+		starpu_task_wait_for_all();
+	}
+
+	/* Unregistration waits for the pending migrations, then refresh the
+	 * counters */
+	for (i = 0; i < NVECTORS; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_task_wait_for_all();
+
+	FPRINTF(stderr, "%lld migrations, %lld bytes migrated\n", (long long) migrations, (long long) migrated_bytes);
+
+	starpu_perf_counter_unset_global_listener();
+	starpu_perf_counter_listener_exit(listener);
+	starpu_perf_counter_set_free(set);
+	starpu_shutdown();
+
+	if (!expected)
+		return STARPU_TEST_SKIPPED;
+	if (migrations == 0 || migrated_bytes == 0)
+	{
+		FPRINTF(stderr, "The CPU workers span several NUMA nodes, but nothing was migrated\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+
+enodev:
+	for (i = 0; i < NVECTORS; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_perf_counter_unset_global_listener();
+	starpu_perf_counter_listener_exit(listener);
+	starpu_perf_counter_set_free(set);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
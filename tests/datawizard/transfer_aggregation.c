@@ -0,0 +1,164 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdlib.h>
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Move many small pieces of data at the same time between the main memory
+ * and a device, which lets the drivers aggregate them into batches of
+ * transfers, check that the data is preserved, and print the time it takes.
+ * Run with STARPU_TRANSFER_AGGREGATE_MAX_REQUESTS=0 to compare with separate
+ * transfers.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define	NDATA	64
+#else
+#  define	NDATA	512
+#endif
+#define	NX	64
+#define	NITER	4
+
+static float *A[NDATA];
+static starpu_data_handle_t handles[NDATA];
+
+static unsigned nacquired;
+static starpu_pthread_mutex_t mutex = STARPU_PTHREAD_MUTEX_INITIALIZER;
+static starpu_pthread_cond_t cond = STARPU_PTHREAD_COND_INITIALIZER;
+
+struct acquired
+{
+	starpu_data_handle_t handle;
+	float *v;
+	unsigned node;
+	unsigned modify;
+};
+static struct acquired acquired[NDATA];
+
+static void callback(void *arg)
+{
+	struct acquired *a = arg;
+
+	if (a->modify)
+	{
+		/* Only touch the data when it is in main memory. Note: this
+		 * may be called from a driver thread, whose local memory node
+		 * is not the main memory. */
+		unsigned i;
+		for (i = 0; i < NX; i++)
+			a->v[i] += 1.f;
+	}
+	starpu_data_release_on_node(a->handle, a->node);
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
+	nacquired++;
+	STARPU_PTHREAD_COND_SIGNAL(&cond);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+}
+
+/* Make NODE own all the data at the same time, and wait for it */
+static void move_all(unsigned node, unsigned modify)
+{
+	unsigned d;
+	int ret;
+
+	nacquired = 0;
+	for (d = 0; d < NDATA; d++)
+	{
+		acquired[d].handle = handles[d];
+		acquired[d].v = A[d];
+		acquired[d].node = node;
+		acquired[d].modify = modify;
+		ret = starpu_data_acquire_on_node_cb(handles[d], node, STARPU_RW, callback, &acquired[d]);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node_cb");
+	}
+
+	STARPU_PTHREAD_MUTEX_LOCK(&mutex);
+	while (nacquired < NDATA)
+		STARPU_PTHREAD_COND_WAIT(&cond, &mutex);
+	STARPU_PTHREAD_MUTEX_UNLOCK(&mutex);
+}
+
+/* Return the first memory node which is not main memory or a disk, or -1 */
+static int find_device_node(void)
+{
+	unsigned node;
+
+	for (node = 0; node < starpu_memory_nodes_get_count(); node++)
+	{
+		enum starpu_node_kind kind = starpu_node_get_kind(node);
+		if (kind != STARPU_CPU_RAM && kind != STARPU_DISK_RAM)
+			return node;
+	}
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned d, i, iter;
+	double start, timing;
+	int ret, node, try = 1;
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	node = find_device_node();
+	if (node < 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	for (d = 0; d < NDATA; d++)
+	{
+		starpu_malloc((void **)&A[d], NX*sizeof(float));
+		for (i = 0; i < NX; i++)
+			A[d][i] = d*NX + i;
+		starpu_vector_data_register(&handles[d], STARPU_MAIN_RAM, (uintptr_t)A[d], NX, sizeof(float));
+	}
+
+	start = starpu_timing_now();
+	for (iter = 0; iter < NITER; iter++)
+	{
+		move_all(node, 0);
+		move_all(STARPU_MAIN_RAM, 1);
+	}
+	timing = starpu_timing_now() - start;
+
+	FPRINTF(stdout, "%d round trips of %d pieces of %d bytes: %f ms\n",
+		NITER, NDATA, (int) (NX*sizeof(float)), timing / 1000.);
+
+	for (d = 0; d < NDATA; d++)
+	{
+		starpu_data_unregister(handles[d]);
+		for (i = 0; i < NX; i++)
+			if (A[d][i] != d*NX + i + NITER)
+			{
+				FPRINTF(stderr, "Fail A[%u][%u] %f != %f\n", d, i, A[d][i], (float) (d*NX + i + NITER));
+				try = 0;
+				break;
+			}
+		starpu_free_noflag(A[d], NX*sizeof(float));
+	}
+
+	starpu_shutdown();
+
+	return try ? EXIT_SUCCESS : EXIT_FAILURE;
+}
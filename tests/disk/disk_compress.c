@@ -0,0 +1,277 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Store a sparse vector on a disk with compression enabled, move it back,
+ * modify parts of it on the disk through a partitioning, which needs to
+ * patch the compressed data, and check that the data is preserved and was
+ * actually compressed. Also check that a file opened with starpu_disk_open
+ * is left uncompressed, and can thus be read back after being closed.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define	NX	(256*1024)
+#else
+#  define	NX	(4*1024*1024)
+#endif
+#define	NPARTS	4
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static float value(unsigned i, unsigned modified)
+{
+	/* Only one value out of 16 is non-zero */
+	if (i % 16)
+		return 0.f;
+	return (float) (i + 1) + (modified ? 1.f : 0.f);
+}
+
+static int check(float *A, unsigned modified)
+{
+	unsigned i;
+
+	for (i = 0; i < NX; i++)
+		if (A[i] != value(i, modified))
+		{
+			FPRINTF(stderr, "Fail A[%u] %f != %f\n", i, A[i], value(i, modified));
+			return 0;
+		}
+	return 1;
+}
+
+/* Make the disk node own the only valid copy of the data */
+static void move_to(starpu_data_handle_t handle, unsigned node)
+{
+	int ret = starpu_data_acquire_on_node(handle, node, STARPU_RW);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	starpu_data_release_on_node(handle, node);
+}
+
+/* Modify the content of a file through StarPU, and check it after closing */
+static int test_open(unsigned dd, const char *dir)
+{
+	const char *name = "compress_open";
+	char path[256];
+	starpu_data_handle_t handle;
+	float *A;
+	void *obj;
+	FILE *f;
+	unsigned i;
+	int ret, try = 1;
+
+	A = malloc(NX*sizeof(float));
+	for (i = 0; i < NX; i++)
+		A[i] = value(i, 0);
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+	f = fopen(path, "wb+");
+	if (f == NULL)
+	{
+		free(A);
+		return 1;
+	}
+	fwrite(A, sizeof(float), NX, f);
+	fclose(f);
+
+	/* Modify it in main memory, it gets written back as a whole */
+	obj = starpu_disk_open(dd, (void *) name, NX*sizeof(float));
+	starpu_vector_data_register(&handle, dd, (uintptr_t) obj, NX, sizeof(float));
+	ret = starpu_data_acquire_on_node(handle, STARPU_MAIN_RAM, STARPU_RW);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	float *B = (float *) starpu_vector_get_local_ptr(handle);
+	for (i = 0; i < NX; i++)
+		B[i] = value(i, 1);
+	starpu_data_release_on_node(handle, STARPU_MAIN_RAM);
+	starpu_data_unregister(handle);
+	starpu_disk_close(dd, obj, NX*sizeof(float));
+
+	/* The file has to contain the raw data */
+	f = fopen(path, "rb");
+	STARPU_ASSERT(f);
+	memset(A, 0, NX*sizeof(float));
+	size_t read = fread(A, sizeof(float), NX, f);
+	fclose(f);
+	try = try && read == NX && check(A, 1);
+
+	/* And be usable when opened again */
+	obj = starpu_disk_open(dd, (void *) name, NX*sizeof(float));
+	starpu_vector_data_register(&handle, dd, (uintptr_t) obj, NX, sizeof(float));
+	ret = starpu_data_acquire_on_node(handle, STARPU_MAIN_RAM, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	try = try && check((float *) starpu_vector_get_local_ptr(handle), 1);
+	starpu_data_release_on_node(handle, STARPU_MAIN_RAM);
+	starpu_data_unregister(handle);
+	starpu_disk_close(dd, obj, NX*sizeof(float));
+
+	unlink(path);
+	free(A);
+	return try;
+}
+
+int dotest(struct starpu_disk_ops *ops, void *param)
+{
+	float *A;
+	starpu_data_handle_t handle;
+	size_t raw, stored;
+	double bw_write, bw_read;
+	unsigned i, part;
+	int ret, try = 1;
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) goto enodev;
+
+	/* register a disk */
+	int new_dd = starpu_disk_register(ops, param, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT) goto enoent;
+
+	starpu_malloc_flags((void **)&A, NX*sizeof(float), STARPU_MALLOC_COUNT);
+	for (i = 0; i < NX; i++)
+		A[i] = value(i, 0);
+
+	starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)A, NX, sizeof(float));
+
+	/* Store it compressed, and get it back */
+	move_to(handle, new_dd);
+	move_to(handle, STARPU_MAIN_RAM);
+	try = try && check(A, 0);
+
+	/* Modify it part by part, so the parts are read from and written to
+	 * the compressed object */
+	move_to(handle, new_dd);
+
+	struct starpu_data_filter f =
+	{
+		.filter_func = starpu_vector_filter_block,
+		.nchildren = NPARTS
+	};
+	starpu_data_partition(handle, &f);
+
+	for (part = 0; part < NPARTS; part++)
+	{
+		starpu_data_handle_t sub = starpu_data_get_sub_data(handle, 1, part);
+		float *sub_A;
+		unsigned offset = part * (NX / NPARTS);
+
+		ret = starpu_data_acquire_on_node(sub, STARPU_MAIN_RAM, STARPU_RW);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		sub_A = (float *) starpu_vector_get_local_ptr(sub);
+		for (i = 0; i < NX / NPARTS; i++)
+			if (sub_A[i] != 0.f)
+				sub_A[i] = value(offset + i, 1);
+		starpu_data_release_on_node(sub, STARPU_MAIN_RAM);
+
+		move_to(sub, new_dd);
+	}
+
+	starpu_data_unpartition(handle, STARPU_MAIN_RAM);
+	try = try && check(A, 1);
+
+	/* And store it compressed again */
+	move_to(handle, new_dd);
+	move_to(handle, STARPU_MAIN_RAM);
+	try = try && check(A, 1);
+
+	ret = starpu_disk_get_compression_stats(new_dd, &raw, &stored, &bw_write, &bw_read);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_disk_get_compression_stats");
+	FPRINTF(stdout, "%s: wrote %zu bytes as %zu bytes, effective bandwidth %f MB/s write, %f MB/s read\n",
+		ops == &starpu_disk_unistd_ops ? "unistd" : "stdio",
+		raw, stored, bw_write, bw_read);
+	if (stored >= raw)
+	{
+		FPRINTF(stderr, "Data was not compressed\n");
+		try = 0;
+	}
+
+	starpu_data_unregister(handle);
+	starpu_free_flags(A, NX*sizeof(float), STARPU_MALLOC_COUNT);
+
+	try = try && test_open(new_dd, param);
+
+	starpu_shutdown();
+
+	return try ? EXIT_SUCCESS : EXIT_FAILURE;
+
+enodev:
+	return STARPU_TEST_SKIPPED;
+enoent:
+	FPRINTF(stderr, "Couldn't write data: ENOENT\n");
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+static int merge_result(int old, int new)
+{
+	if (new == EXIT_FAILURE)
+		return EXIT_FAILURE;
+	if (old == 0)
+		return 0;
+	return new;
+}
+
+int main(void)
+{
+	int ret = 0;
+	int ret2;
+	char s[128];
+	char *ptr;
+
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+	setenv("STARPU_DISK_COMPRESS", "zero", 1);
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = merge_result(ret, dotest(&starpu_disk_stdio_ops, s));
+	ret = merge_result(ret, dotest(&starpu_disk_unistd_ops, s));
+
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
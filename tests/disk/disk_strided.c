@@ -0,0 +1,198 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Move a matrix tile back and forth between main memory and a disk, once
+ * stored contiguously (ld == nx) and once as a tile of a bigger matrix
+ * (ld > nx), check that the data is preserved, and print the bandwidth of
+ * both, to measure the benefit of vectored disk I/O.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#  define	NX	64
+#  define	NY	64
+#  define	NITER	2
+#else
+#  define	NX	512
+#  define	NY	512
+#  define	NITER	10
+#endif
+#define	LD	(4*NX)
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+/* Move the tile to the disk and back NITER times, return the time */
+static double move(starpu_data_handle_t handle, int disk)
+{
+	double start, end;
+	unsigned iter;
+	int ret;
+
+	start = starpu_timing_now();
+	for (iter = 0; iter < NITER; iter++)
+	{
+		/* Write to the disk and invalidate main memory */
+		ret = starpu_data_acquire_on_node(handle, disk, STARPU_RW);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handle, disk);
+
+		/* Read it back */
+		ret = starpu_data_acquire_on_node(handle, STARPU_MAIN_RAM, STARPU_RW);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handle, STARPU_MAIN_RAM);
+	}
+	end = starpu_timing_now();
+
+	return end - start;
+}
+
+static int check(float *A, unsigned ld)
+{
+	unsigned i, j;
+
+	for (j = 0; j < NY; j++)
+		for (i = 0; i < ld; i++)
+		{
+			float expected = i < NX ? (float) (j*NX + i) : -1.f;
+			if (A[j*ld + i] != expected)
+			{
+				FPRINTF(stderr, "Fail A[%u][%u] %f != %f\n", j, i, A[j*ld + i], expected);
+				return 0;
+			}
+		}
+	return 1;
+}
+
+int dotest(struct starpu_disk_ops *ops, void *param)
+{
+	float *A, *B;
+	starpu_data_handle_t handleA, handleB;
+	double contiguous, strided;
+	unsigned i, j;
+	int ret, try;
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return EXIT_FAILURE;
+	conf.precedence_over_environment_variables = 1;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV) goto enodev;
+
+	/* register a disk */
+	int new_dd = starpu_disk_register(ops, param, STARPU_DISK_SIZE_MIN);
+	/* can't write on /tmp/ */
+	if (new_dd == -ENOENT) goto enoent;
+
+	starpu_malloc_flags((void **)&A, NY*NX*sizeof(float), STARPU_MALLOC_COUNT);
+	starpu_malloc_flags((void **)&B, NY*LD*sizeof(float), STARPU_MALLOC_COUNT);
+
+	for (j = 0; j < NY; j++)
+	{
+		for (i = 0; i < NX; i++)
+			A[j*NX + i] = B[j*LD + i] = j*NX + i;
+		/* Make sure the rest of the rows is not touched */
+		for (i = NX; i < LD; i++)
+			B[j*LD + i] = -1.f;
+	}
+
+	starpu_matrix_data_register(&handleA, STARPU_MAIN_RAM, (uintptr_t)A, NX, NX, NY, sizeof(float));
+	starpu_matrix_data_register(&handleB, STARPU_MAIN_RAM, (uintptr_t)B, LD, NX, NY, sizeof(float));
+
+	contiguous = move(handleA, new_dd);
+	strided = move(handleB, new_dd);
+
+	FPRINTF(stdout, "%s: contiguous tile %f MB/s, strided tile %f MB/s\n",
+		ops == &starpu_disk_unistd_ops ? "unistd" : "stdio",
+		2. * NX * NY * sizeof(float) * NITER / contiguous,
+		2. * NX * NY * sizeof(float) * NITER / strided);
+
+	starpu_data_unregister(handleA);
+	starpu_data_unregister(handleB);
+
+	try = check(A, NX) && check(B, LD);
+
+	starpu_free_flags(A, NY*NX*sizeof(float), STARPU_MALLOC_COUNT);
+	starpu_free_flags(B, NY*LD*sizeof(float), STARPU_MALLOC_COUNT);
+
+	starpu_shutdown();
+
+	return try ? EXIT_SUCCESS : EXIT_FAILURE;
+
+enodev:
+	return STARPU_TEST_SKIPPED;
+enoent:
+	FPRINTF(stderr, "Couldn't write data: ENOENT\n");
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
+
+static int merge_result(int old, int new)
+{
+	if (new == EXIT_FAILURE)
+		return EXIT_FAILURE;
+	if (old == 0)
+		return 0;
+	return new;
+}
+
+int main(void)
+{
+	int ret = 0;
+	int ret2;
+	char s[128];
+	char *ptr;
+
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	/* stdio does not have vectored I/O, for comparison */
+	ret = merge_result(ret, dotest(&starpu_disk_stdio_ops, s));
+	ret = merge_result(ret, dotest(&starpu_disk_unistd_ops, s));
+
+	ret2 = rmdir(s);
+	if (ret2 < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+	return ret;
+}
+#endif
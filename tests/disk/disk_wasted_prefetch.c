@@ -0,0 +1,141 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Prefetch a vector to a disk and invalidate it before it gets used, then
+ * prefetch it again and use it, and check that only the first prefetch is
+ * reported as wasted in the profiling of the bus.
+ */
+
+#define NX (16*1024)
+
+#if STARPU_MAXNODES == 1
+/* Cannot register a disk */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+/* Return the number of bytes wasted on the bus since the previous call */
+static long long wasted(int busid)
+{
+	struct starpu_profiling_bus_info bus_info;
+
+	starpu_bus_get_profiling_info(busid, &bus_info);
+	return bus_info.wasted_prefetch_bytes;
+}
+
+/* Overwrite the vector in the main memory */
+static void overwrite(starpu_data_handle_t handle)
+{
+	int ret;
+
+	ret = starpu_data_acquire(handle, STARPU_W);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire");
+	starpu_data_release(handle);
+}
+
+static int dotest(const char *dir)
+{
+	starpu_data_handle_t handle;
+	float *A;
+	long long waste;
+	int ret, disk, busid, try = 1;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return ret;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	disk = starpu_disk_register(&starpu_disk_unistd_ops, (void *) dir, STARPU_DISK_SIZE_MIN);
+	if (disk == -ENOENT)
+	{
+		starpu_shutdown();
+		return disk;
+	}
+	STARPU_ASSERT(disk >= 0);
+	busid = starpu_bus_get_id(STARPU_MAIN_RAM, disk);
+	STARPU_ASSERT(busid >= 0);
+
+	starpu_malloc((void **)&A, NX*sizeof(float));
+	memset(A, 0, NX*sizeof(float));
+	starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)A, NX, sizeof(float));
+
+	/* Forget about what happened so far */
+	(void) wasted(busid);
+
+	/* Prefetch, but overwrite before using */
+	ret = starpu_data_prefetch_on_node(handle, disk, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_prefetch_on_node");
+	overwrite(handle);
+	waste = wasted(busid);
+	if (waste != NX*sizeof(float))
+	{
+		FPRINTF(stderr, "unused prefetch: %lld bytes wasted instead of %u\n", waste, (unsigned) (NX*sizeof(float)));
+		try = 0;
+	}
+
+	/* Prefetch, and use it before overwriting */
+	ret = starpu_data_prefetch_on_node(handle, disk, 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_prefetch_on_node");
+	ret = starpu_data_acquire_on_node(handle, disk, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	starpu_data_release_on_node(handle, disk);
+	overwrite(handle);
+	waste = wasted(busid);
+	if (waste != 0)
+	{
+		FPRINTF(stderr, "used prefetch: %lld bytes wasted instead of 0\n", waste);
+		try = 0;
+	}
+
+	starpu_data_unregister(handle);
+	starpu_free_noflag(A, NX*sizeof(float));
+	starpu_shutdown();
+
+	return try ? 0 : -EINVAL;
+}
+
+int main(void)
+{
+	int ret;
+	char s[128];
+	char *ptr;
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = dotest(s);
+
+	if (rmdir(s) < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+
+	if (ret == -ENODEV || ret == -ENOENT)
+		return STARPU_TEST_SKIPPED;
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif
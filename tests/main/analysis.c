@@ -0,0 +1,213 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <unistd.h>
+#include "../helper.h"
+
+#ifdef STARPU_HAVE_WINDOWS
+#include <io.h>
+#endif
+
+/*
+ * Run a chain of tasks along with independent tasks, with the online analysis
+ * enabled, and check that the reported critical path covers the chain.
+ *
+ * Then run a chain of tasks alone: the other workers can only wait for the
+ * dependencies of the chain, check that the analysis summary tells so.
+ */
+
+#define NCHAIN 16
+#define NINDEP 32
+#define NSTALL 64
+#define DURATION 2000.
+
+static int id_g_critical_path;
+static int id_g_total_work;
+static double critical_path;
+static double total_work;
+
+static void g_listener_cb(struct starpu_perf_counter_listener *listener, struct starpu_perf_counter_sample *sample, void *context)
+{
+	(void) listener;
+	(void) context;
+	critical_path = starpu_perf_counter_sample_get_double_value(sample, id_g_critical_path);
+	total_work = starpu_perf_counter_sample_get_double_value(sample, id_g_total_work);
+}
+
+void busy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+	starpu_sleep(DURATION / 1000000.);
+}
+
+static struct starpu_codelet chain_codelet =
+{
+	.cpu_funcs = {busy_func},
+	.cpu_funcs_name = {"busy_func"},
+	.model = NULL,
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+	.name = "analysis_chain",
+};
+
+static struct starpu_codelet indep_codelet =
+{
+	.cpu_funcs = {busy_func},
+	.cpu_funcs_name = {"busy_func"},
+	.model = NULL,
+	.nbuffers = 0,
+	.name = "analysis_indep",
+};
+
+/* Return 1 if the idle time was mostly attributed to dependencies, 0 if not,
+ * or -ENODEV */
+static int check_dependency_stall(void)
+{
+	char filename[] = "starpu_analysis_XXXXXX";
+	char line[256];
+	starpu_data_handle_t handle;
+	int var = 0;
+	int ret, i, found = 0;
+	FILE *f;
+
+#ifdef STARPU_HAVE_WINDOWS
+	_mktemp(filename);
+#else
+	{
+		int fd = mkstemp(filename);
+		if (fd < 0)
+		{
+			FPRINTF(stderr, "Error when creating temp file\n");
+			return -ENODEV;
+		}
+		close(fd);
+	}
+#endif
+	setenv("STARPU_ANALYSIS_FILE", filename, 1);
+
+	ret = starpu_initialize(NULL, NULL, NULL);
+	if (ret == -ENODEV || starpu_cpu_worker_get_count() < 2)
+	{
+		if (ret != -ENODEV)
+			starpu_shutdown();
+		unlink(filename);
+		return -ENODEV;
+	}
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	starpu_variable_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)&var, sizeof(var));
+	for (i = 0; i < NSTALL; i++)
+	{
+		ret = starpu_task_insert(&chain_codelet, STARPU_RW, handle, 0);
+		if (ret == -ENODEV)
+			break;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+	starpu_data_unregister(handle);
+	starpu_shutdown();
+
+	if (ret == -ENODEV)
+	{
+		unlink(filename);
+		return -ENODEV;
+	}
+
+	f = fopen(filename, "r");
+	STARPU_ASSERT(f);
+	while (fgets(line, sizeof(line), f))
+	{
+		FPRINTF(stderr, "%s", line);
+		if (strstr(line, "Idle time:") && strstr(line, "mostly waiting for dependencies"))
+			found = 1;
+	}
+	fclose(f);
+	unlink(filename);
+	return found;
+}
+
+int main(void)
+{
+	const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+	struct starpu_conf conf;
+	starpu_data_handle_t handle;
+	int var = 0;
+	int ret, i;
+
+	setenv("STARPU_ANALYSIS", "1", 1);
+
+	starpu_conf_init(&conf);
+	conf.start_perf_counter_collection = 1;
+	ret = starpu_initialize(&conf, NULL, NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	struct starpu_perf_counter_set *set = starpu_perf_counter_set_alloc(scope);
+	id_g_critical_path = starpu_perf_counter_name_to_id(scope, "starpu.analysis.g_critical_path");
+	STARPU_ASSERT(id_g_critical_path != -1);
+	id_g_total_work = starpu_perf_counter_name_to_id(scope, "starpu.analysis.g_total_work");
+	STARPU_ASSERT(id_g_total_work != -1);
+	starpu_perf_counter_set_enable_id(set, id_g_critical_path);
+	starpu_perf_counter_set_enable_id(set, id_g_total_work);
+	struct starpu_perf_counter_listener *listener = starpu_perf_counter_listener_init(set, g_listener_cb, NULL);
+	starpu_perf_counter_set_global_listener(listener);
+
+	starpu_variable_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)&var, sizeof(var));
+
+	for (i = 0; i < NCHAIN; i++)
+	{
+		ret = starpu_task_insert(&chain_codelet, STARPU_RW, handle, 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	for (i = 0; i < NINDEP; i++)
+	{
+		ret = starpu_task_insert(&indep_codelet, 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+	starpu_data_unregister(handle);
+
+	starpu_perf_counter_unset_global_listener();
+	starpu_perf_counter_listener_exit(listener);
+	starpu_perf_counter_set_free(set);
+	starpu_shutdown();
+
+	FPRINTF(stderr, "critical path %f us, total work %f us\n", critical_path, total_work);
+	if (critical_path < NCHAIN * DURATION * 0.9)
+		return EXIT_FAILURE;
+	if (total_work < critical_path || total_work < (NCHAIN + NINDEP) * DURATION * 0.9)
+		return EXIT_FAILURE;
+
+	ret = check_dependency_stall();
+	if (ret == 0)
+	{
+		FPRINTF(stderr, "the idle time of the chain was not attributed to dependencies\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_data_unregister(handle);
+	starpu_perf_counter_unset_global_listener();
+	starpu_perf_counter_listener_exit(listener);
+	starpu_perf_counter_set_free(set);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,174 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include <starpu.h>
+#include <common/tracebuf.h>
+#include "../helper.h"
+
+/*
+ * Run a few tasks with the in-memory tracing enabled, and check that the
+ * dumped binary trace contains their execution.
+ */
+
+#define NTASKS 64
+/* Small rings, to also exercise wrapping */
+#define NEVENTS "32"
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.model = NULL,
+	.nbuffers = 0,
+	.name = "tracebuf_dummy",
+};
+
+static int check_trace(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char magic[8];
+	uint32_t version, evsize, nbufs, i;
+	unsigned long found = 0;
+
+	if (!f)
+	{
+		FPRINTF(stderr, "could not open %s\n", path);
+		return 1;
+	}
+
+	if (fread(magic, sizeof(magic), 1, f) != 1 || strcmp(magic, _STARPU_TRACEBUF_MAGIC)
+	 || fread(&version, sizeof(version), 1, f) != 1 || version != _STARPU_TRACEBUF_VERSION
+	 || fread(&evsize, sizeof(evsize), 1, f) != 1 || evsize != sizeof(struct _starpu_tracebuf_event)
+	 || fread(&nbufs, sizeof(nbufs), 1, f) != 1)
+	{
+		FPRINTF(stderr, "bogus header\n");
+		goto err;
+	}
+
+	for (i = 0; i < nbufs; i++)
+	{
+		int32_t workerid;
+		int64_t tid;
+		char name[64];
+		uint64_t nevents, lost, j;
+		uint32_t nnames, n;
+		uint32_t dummy_idx = 0;
+
+		if (fread(&workerid, sizeof(workerid), 1, f) != 1
+		 || fread(&tid, sizeof(tid), 1, f) != 1
+		 || fread(name, sizeof(name), 1, f) != 1
+		 || fread(&nevents, sizeof(nevents), 1, f) != 1
+		 || fread(&lost, sizeof(lost), 1, f) != 1
+		 || fread(&nnames, sizeof(nnames), 1, f) != 1)
+			goto err;
+		if (nevents > (uint64_t) atoi(NEVENTS))
+		{
+			FPRINTF(stderr, "too many events %llu\n", (unsigned long long) nevents);
+			goto err;
+		}
+
+		for (n = 0; n < nnames; n++)
+		{
+			uint32_t idx, len;
+			char str[256];
+			if (fread(&idx, sizeof(idx), 1, f) != 1
+			 || fread(&len, sizeof(len), 1, f) != 1
+			 || len >= sizeof(str)
+			 || fread(str, len, 1, f) != 1)
+				goto err;
+			str[len] = 0;
+			if (!strcmp(str, "tracebuf_dummy"))
+				dummy_idx = idx;
+		}
+
+		uint64_t last = 0;
+		for (j = 0; j < nevents; j++)
+		{
+			struct _starpu_tracebuf_event ev;
+			if (fread(&ev, sizeof(ev), 1, f) != 1)
+				goto err;
+			if (ev.date < last)
+			{
+				FPRINTF(stderr, "events are not ordered\n");
+				goto err;
+			}
+			last = ev.date;
+			if (ev.type == _STARPU_TRACEBUF_CODELET_END && dummy_idx && ev.arg32 == dummy_idx)
+				found++;
+		}
+	}
+	fclose(f);
+
+	FPRINTF(stderr, "found %lu task executions\n", found);
+	return found == 0;
+
+err:
+	fclose(f);
+	return 1;
+}
+
+int main(void)
+{
+	char dir[] = "/tmp/starpu_tracebuf_XXXXXX";
+	char path[512];
+	char *user;
+	int ret, i;
+
+	if (!_starpu_mkdtemp(dir))
+		return STARPU_TEST_SKIPPED;
+
+	setenv("STARPU_TRACEBUF", "1", 1);
+	setenv("STARPU_TRACEBUF_NEVENTS", NEVENTS, 1);
+	setenv("STARPU_TRACEBUF_FORMAT", "binary", 1);
+	setenv("STARPU_TRACEBUF_PREFIX", dir, 1);
+
+	ret = starpu_initialize(NULL, NULL, NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&dummy_codelet, 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+	starpu_shutdown();
+
+	user = getenv("USER");
+	snprintf(path, sizeof(path), "%s/starpu_tracebuf_%s_%d.bin", dir, user ? user : "", (int) getpid());
+	ret = check_trace(path);
+	unlink(path);
+	rmdir(dir);
+
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+
+enodev:
+	starpu_shutdown();
+	rmdir(dir);
+	return STARPU_TEST_SKIPPED;
+}
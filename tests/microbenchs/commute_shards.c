@@ -0,0 +1,130 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include "../helper.h"
+
+/*
+ * Scale the access pattern of datawizard/commute2 up: many short tasks access
+ * pairs of data in STARPU_RW|STARPU_COMMUTE mode, all the data being managed
+ * by an arbiter. Print the task throughput with the arbiter split into an
+ * increasing number of shards, to be run with many workers.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS	2000
+#else
+#define NTASKS	20000
+#endif
+#define NDATA	256
+/* Duration of a task, in µs */
+#define TASK_LENGTH	10
+
+static unsigned nshards[] = { 1, 2, 4, 8, 16 };
+
+void commute_func(void *descr[], void *arg)
+{
+	double start = starpu_timing_now();
+
+	(void)descr;
+	(void)arg;
+	while (starpu_timing_now() - start < TASK_LENGTH)
+		;
+}
+
+static struct starpu_codelet commute_codelet =
+{
+	.cpu_funcs = {commute_func},
+	.cpu_funcs_name = {"commute_func"},
+	.nbuffers = 2,
+	.modes = {STARPU_RW|STARPU_COMMUTE, STARPU_RW|STARPU_COMMUTE},
+};
+
+static int run(unsigned n, double *timing)
+{
+	starpu_data_handle_t handles[NDATA];
+	unsigned values[NDATA];
+	starpu_arbiter_t arbiter;
+	double start;
+	unsigned i;
+	int ret = 0;
+
+	arbiter = starpu_arbiter_create_sharded(n);
+	for (i = 0; i < NDATA; i++)
+	{
+		values[i] = 0;
+		starpu_variable_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)&values[i], sizeof(values[i]));
+		starpu_data_assign_arbiter(handles[i], arbiter);
+	}
+
+	starpu_pause();
+	for (i = 0; i < NTASKS; i++)
+	{
+		unsigned a = rand() % NDATA;
+		unsigned b = (a + 1 + rand() % (NDATA - 1)) % NDATA;
+
+		ret = starpu_task_insert(&commute_codelet,
+					 STARPU_RW|STARPU_COMMUTE, handles[a],
+					 STARPU_RW|STARPU_COMMUTE, handles[b],
+					 0);
+		if (ret == -ENODEV)
+			break;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	start = starpu_timing_now();
+	starpu_resume();
+	starpu_task_wait_for_all();
+	*timing = starpu_timing_now() - start;
+
+	for (i = 0; i < NDATA; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_arbiter_destroy(arbiter);
+
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	double timing;
+	unsigned i;
+	int ret;
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	FPRINTF(stdout, "# %u CPU workers, %u tasks of %u us\n", starpu_cpu_worker_get_count(), NTASKS, TASK_LENGTH);
+	FPRINTF(stdout, "# shards\ttasks/s\n");
+	for (i = 0; i < sizeof(nshards)/sizeof(nshards[0]); i++)
+	{
+		ret = run(nshards[i], &timing);
+		if (ret == -ENODEV)
+			break;
+		FPRINTF(stdout, "%u\t%f\n", nshards[i], NTASKS / (timing / 1000000.));
+	}
+
+	starpu_shutdown();
+
+	return ret == -ENODEV ? STARPU_TEST_SKIPPED : EXIT_SUCCESS;
+}
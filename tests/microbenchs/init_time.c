@@ -0,0 +1,97 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <sys/time.h>
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the time taken by starpu_init, without and with the machine cache
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned niter = 3;
+#else
+static unsigned niter = 20;
+#endif
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000. + tv.tv_usec / 1000.;
+}
+
+static int measure(const char *cache, double *init_time)
+{
+	double start, end, total = 0.;
+	unsigned i;
+	int ret;
+
+	setenv("STARPU_MACHINE_CACHE", cache, 1);
+
+	for (i = 0; i < niter; i++)
+	{
+		start = now();
+		ret = starpu_init(NULL);
+		end = now();
+		if (ret == -ENODEV)
+			return ret;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+		starpu_shutdown();
+
+		/* The first iteration may have to fill the cache */
+		if (i > 0 || niter == 1)
+			total += end - start;
+	}
+
+	*init_time = total / (niter > 1 ? niter - 1 : 1);
+	return 0;
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "i:h")) != -1)
+	switch(c)
+	{
+		case 'i':
+			niter = atoi(optarg);
+			break;
+		case 'h':
+			fprintf(stderr, "Usage: %s [-i niter]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	double without, with;
+	int ret;
+
+	parse_args(argc, argv);
+
+	ret = measure("0", &without);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	ret = measure("1", &with);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+
+	FPRINTF(stdout, "starpu_init without machine cache: %f ms\n", without);
+	FPRINTF(stdout, "starpu_init with machine cache: %f ms\n", with);
+
+	return EXIT_SUCCESS;
+}
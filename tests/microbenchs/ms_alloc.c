@@ -0,0 +1,156 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the throughput of tasks on a slave when each of them works on a
+ * new small piece of data, which thus has to be allocated on the slave,
+ * transferred, and freed, compared to tasks which all work on the same piece
+ * of data.
+ * ms_alloc.sh runs it with and without the allocation pool and the inline
+ * transfers.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned ntasks = 64;
+#else
+static unsigned ntasks = 10000;
+#endif
+
+#define VECTORSIZE 16
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.where = STARPU_MPI_MS | STARPU_TCPIP_MS,
+	.model = NULL,
+	.nbuffers = 1,
+	.modes = {STARPU_RW},
+};
+
+static int submit(int workerid, starpu_data_handle_t handle)
+{
+	return starpu_task_insert(&dummy_codelet,
+				  STARPU_EXECUTE_ON_WORKER, workerid,
+				  STARPU_RW, handle,
+				  0);
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "n:h")) != -1)
+	switch(c)
+	{
+		case 'n':
+			ntasks = atoi(optarg);
+			break;
+		case 'h':
+			fprintf(stderr, "Usage: %s [-n ntasks] [-h]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+	unsigned i;
+	int workerid = -1;
+	double start, same, fresh;
+	float *v;
+	starpu_data_handle_t handle;
+
+	parse_args(argc, argv);
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < starpu_worker_get_count(); i++)
+	{
+		enum starpu_worker_archtype type = starpu_worker_get_type(i);
+		if (type == STARPU_MPI_MS_WORKER || type == STARPU_TCPIP_MS_WORKER)
+		{
+			workerid = i;
+			break;
+		}
+	}
+
+	if (workerid == -1)
+	{
+		FPRINTF(stderr, "This test needs master-slave workers\n");
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	starpu_malloc((void**)&v, ntasks * VECTORSIZE * sizeof(*v));
+	memset(v, 0, ntasks * VECTORSIZE * sizeof(*v));
+
+	/* Tasks on the same data, which thus stays on the slave */
+	starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)v, VECTORSIZE, sizeof(*v));
+	ret = submit(workerid, handle);
+	if (ret == -ENODEV) goto enodev;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	starpu_task_wait_for_all();
+
+	start = starpu_timing_now();
+	for (i = 0; i < ntasks; i++)
+	{
+		ret = submit(workerid, handle);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+	same = starpu_timing_now() - start;
+	starpu_data_unregister(handle);
+
+	/* Tasks on a new piece of data each */
+	start = starpu_timing_now();
+	for (i = 0; i < ntasks; i++)
+	{
+		starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)&v[i * VECTORSIZE], VECTORSIZE, sizeof(*v));
+		ret = submit(workerid, handle);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		starpu_data_unregister_submit(handle);
+	}
+	starpu_task_wait_for_all();
+	fresh = starpu_timing_now() - start;
+
+	FPRINTF(stdout, "# same data (tasks/s)\tnew data (tasks/s)\n");
+	FPRINTF(stdout, "%f\t%f\n", ntasks / same * 1000000., ntasks / fresh * 1000000.);
+
+	starpu_shutdown();
+	starpu_free_noflag(v, ntasks * VECTORSIZE * sizeof(*v));
+
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_data_unregister(handle);
+	starpu_shutdown();
+	starpu_free_noflag(v, ntasks * VECTORSIZE * sizeof(*v));
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,42 @@
+#!/bin/sh
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+
+# Measure the throughput of tasks on new data with a local TCP/IP slave,
+# without and with the allocation pool and the inline transfers, and gather
+# the results in ms_alloc.dat
+
+if test -n "$STARPU_MICROBENCHS_DISABLED" ; then exit 77 ; fi
+
+set -e
+
+ROOT=${0%.sh}
+TCPIPEXEC=$(dirname $0)/../../tools/starpu_tcpipexec
+
+rm -f ms_alloc.dat
+for config in "0 0" "16 0" "0 16384" "16 16384"
+do
+	set -- $config
+	STARPU_MS_ALLOC_POOL=$1 STARPU_MS_INLINE_TRANSFER=$2 $TCPIPEXEC -np 1 -nobind -ncpus 1 $STARPU_LAUNCH $ROOT > ms_alloc.out
+	if [ ! -f ms_alloc.dat ]
+	then
+		echo "# pool (MiB)	inline (B)	$(grep '^#' ms_alloc.out | cut -c3-)" >> ms_alloc.dat
+	fi
+	echo "$1	$2	$(grep -v '^#' ms_alloc.out)" >> ms_alloc.dat
+done
+rm -f ms_alloc.out
+
+cat ms_alloc.dat
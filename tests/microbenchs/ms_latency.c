@@ -0,0 +1,211 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the latency of small messages between the master and its slaves:
+ * ping-pong of a small piece of data with each slave, synchronous empty tasks
+ * on each slave, and then empty tasks on all slaves at the same time. Also
+ * measure the bandwidth with each slave with a big piece of data.
+ * ms_latency.sh runs it with an increasing number of slaves, and
+ * ms_transport.sh with the various transports for local slaves.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned niter = 32;
+#define BIGSIZE (1024*1024)
+#else
+static unsigned niter = 1000;
+#define BIGSIZE (16*1024*1024)
+#endif
+#define NBIGITER 10
+
+#define VECTORSIZE 4
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	(void)arg;
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.where = STARPU_MPI_MS | STARPU_TCPIP_MS,
+	.model = NULL,
+	.nbuffers = 0,
+};
+
+static int submit(int workerid, int synchronous)
+{
+	struct starpu_task *task = starpu_task_create();
+
+	task->cl = &dummy_codelet;
+	task->execute_on_a_specific_worker = 1;
+	task->workerid = workerid;
+	task->synchronous = synchronous;
+
+	return starpu_task_submit(task);
+}
+
+/* Move the data to the main memory and back to NODE, N times, return the time */
+static double pingpong(starpu_data_handle_t handle, unsigned node, unsigned n)
+{
+	double start;
+	unsigned iter;
+	int ret;
+
+	start = starpu_timing_now();
+	for (iter = 0; iter < n; iter++)
+	{
+		ret = starpu_data_acquire_on_node(handle, STARPU_MAIN_RAM, STARPU_RW);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handle, STARPU_MAIN_RAM);
+
+		ret = starpu_data_acquire_on_node(handle, node, STARPU_RW);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handle, node);
+	}
+	return starpu_timing_now() - start;
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "i:h")) != -1)
+	switch(c)
+	{
+		case 'i':
+			niter = atoi(optarg);
+			break;
+		case 'h':
+			fprintf(stderr, "Usage: %s [-i niter] [-h]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+	unsigned i, iter;
+	double start, transfer = 0., task = 0., concurrent, bandwidth = 0.;
+	float *v, *big;
+	starpu_data_handle_t handle, big_handle;
+	int workers[STARPU_NMAXWORKERS];
+	unsigned nodes[STARPU_NMAXWORKERS];
+	unsigned nworkers;
+
+	parse_args(argc, argv);
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	/* Take one worker per slave */
+	nworkers = 0;
+	for (i = 0; i < starpu_worker_get_count(); i++)
+	{
+		enum starpu_worker_archtype type = starpu_worker_get_type(i);
+		unsigned node = starpu_worker_get_memory_node(i);
+		unsigned j;
+
+		if (type != STARPU_MPI_MS_WORKER && type != STARPU_TCPIP_MS_WORKER)
+			continue;
+		for (j = 0; j < nworkers; j++)
+			if (nodes[j] == node)
+				break;
+		if (j < nworkers)
+			continue;
+		workers[nworkers] = i;
+		nodes[nworkers] = node;
+		nworkers++;
+	}
+
+	if (!nworkers)
+	{
+		FPRINTF(stderr, "This test needs master-slave workers\n");
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	starpu_malloc((void**)&v, VECTORSIZE*sizeof(*v));
+	memset(v, 0, VECTORSIZE*sizeof(*v));
+	starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t)v, VECTORSIZE, sizeof(*v));
+	starpu_malloc((void**)&big, BIGSIZE);
+	memset(big, 0, BIGSIZE);
+	starpu_vector_data_register(&big_handle, STARPU_MAIN_RAM, (uintptr_t)big, BIGSIZE/sizeof(*big), sizeof(*big));
+
+	for (i = 0; i < nworkers; i++)
+	{
+		/* Warm up, to get the data allocated */
+		ret = submit(workers[i], 1);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		ret = starpu_data_acquire_on_node(handle, nodes[i], STARPU_RW);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handle, nodes[i]);
+		ret = starpu_data_acquire_on_node(big_handle, nodes[i], STARPU_RW);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(big_handle, nodes[i]);
+
+		transfer += pingpong(handle, nodes[i], niter) / (2*niter);
+		bandwidth += 2. * BIGSIZE * NBIGITER / pingpong(big_handle, nodes[i], NBIGITER);
+
+		start = starpu_timing_now();
+		for (iter = 0; iter < niter; iter++)
+		{
+			ret = submit(workers[i], 1);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		}
+		task += (starpu_timing_now() - start) / niter;
+	}
+
+	/* All slaves at the same time */
+	start = starpu_timing_now();
+	for (iter = 0; iter < niter; iter++)
+		for (i = 0; i < nworkers; i++)
+		{
+			ret = submit(workers[i], 0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+		}
+	starpu_task_wait_for_all();
+	concurrent = (starpu_timing_now() - start) / (niter * nworkers);
+
+	FPRINTF(stdout, "# nslaves\ttransfer (us)\tsync task (us)\tconcurrent tasks (us)\tbandwidth (MB/s)\n");
+	FPRINTF(stdout, "%u\t%f\t%f\t%f\t%f\n", nworkers, transfer / nworkers, task / nworkers, concurrent, bandwidth / nworkers);
+
+	starpu_data_unregister(handle);
+	starpu_free_noflag(v, VECTORSIZE*sizeof(*v));
+	starpu_data_unregister(big_handle);
+	starpu_free_noflag(big, BIGSIZE);
+	starpu_shutdown();
+
+	return EXIT_SUCCESS;
+
+enodev:
+	starpu_data_unregister(handle);
+	starpu_free_noflag(v, VECTORSIZE*sizeof(*v));
+	starpu_data_unregister(big_handle);
+	starpu_free_noflag(big, BIGSIZE);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
@@ -0,0 +1,45 @@
+#!/bin/sh
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+
+# Measure the latency of small messages with an increasing number of local
+# TCP/IP slaves, up to $STARPU_MS_LATENCY_NSLAVES (default 4), and gather the
+# results in ms_latency.dat
+
+if test -n "$STARPU_MICROBENCHS_DISABLED" ; then exit 77 ; fi
+
+set -e
+
+ROOT=${0%.sh}
+TCPIPEXEC=$(dirname $0)/../../tools/starpu_tcpipexec
+MAX=${STARPU_MS_LATENCY_NSLAVES:-4}
+
+rm -f ms_latency.dat
+n=1
+while [ $n -le $MAX ]
+do
+	$TCPIPEXEC -np $n -nobind -ncpus 1 $STARPU_LAUNCH $ROOT "$@" > ms_latency.out
+	if [ $n = 1 ]
+	then
+		cat ms_latency.out >> ms_latency.dat
+	else
+		grep -v '^#' ms_latency.out >> ms_latency.dat
+	fi
+	n=$((n * 2))
+done
+rm -f ms_latency.out
+
+cat ms_latency.dat
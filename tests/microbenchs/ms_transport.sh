@@ -0,0 +1,40 @@
+#!/bin/sh
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+
+# Compare the latency and bandwidth with a local TCP/IP slave, when data goes
+# through shared memory, through a local socket, and through loopback TCP
+
+if test -n "$STARPU_MICROBENCHS_DISABLED" ; then exit 77 ; fi
+
+set -e
+
+ROOT=$(echo ${0%.sh} | sed 's/ms_transport/ms_latency/')
+TCPIPEXEC=$(dirname $0)/../../tools/starpu_tcpipexec
+
+run()
+{
+	name=$1
+	shift
+	echo "# $name"
+	"$@" $TCPIPEXEC -np 1 -nobind -ncpus 1 $STARPU_LAUNCH $ROOT $ARGS | grep -v '^#'
+}
+
+ARGS="$@"
+echo "# nslaves	transfer (us)	sync task (us)	concurrent tasks (us)	bandwidth (MB/s)"
+run "shared memory" env STARPU_TCPIP_MS_SHM=1
+run "local socket" env STARPU_TCPIP_MS_SHM=0
+run "loopback TCP" env STARPU_TCPIP_MS_SHM=0 STARPU_TCPIP_USE_LOCAL_SOCKET=0
@@ -0,0 +1,165 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the bandwidth of data transfers between the first two NUMA memory
+ * nodes, one transfer at a time and with several concurrent transfers,
+ * without (STARPU_NUMA_COPY_THREADS=0) and with the asynchronous copy
+ * engine. This needs STARPU_USE_NUMA=1 on a machine with several NUMA nodes.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned nhandles = 4;
+static unsigned size = 1024*1024;
+static unsigned niter = 2;
+#else
+static unsigned nhandles = 16;
+static unsigned size = 16*1024*1024;
+static unsigned niter = 10;
+#endif
+static unsigned nthreads = 2;
+
+/* Make the copies on the source node the only valid ones */
+static void invalidate(starpu_data_handle_t *handles, unsigned n, unsigned src)
+{
+	unsigned i;
+	int ret;
+
+	for (i = 0; i < n; i++)
+	{
+		ret = starpu_data_acquire_on_node(handles[i], src, STARPU_W);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handles[i], src);
+	}
+}
+
+/* Transfer n handles at the same time from src to dst, return the time */
+static double transfer(starpu_data_handle_t *handles, unsigned n, unsigned src, unsigned dst)
+{
+	double start, end;
+	unsigned i;
+	int ret;
+
+	invalidate(handles, n, src);
+
+	start = starpu_timing_now();
+	for (i = 0; i < n; i++)
+	{
+		ret = starpu_data_fetch_on_node(handles[i], dst, 1);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_fetch_on_node");
+	}
+	for (i = 0; i < n; i++)
+	{
+		ret = starpu_data_acquire_on_node(handles[i], dst, STARPU_R);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handles[i], dst);
+	}
+	end = starpu_timing_now();
+
+	return end - start;
+}
+
+static int run(unsigned threads)
+{
+	starpu_data_handle_t handles[nhandles];
+	double single = 0., concurrent = 0.;
+	char s[16];
+	unsigned i, iter;
+	int ret;
+
+	snprintf(s, sizeof(s), "%u", threads);
+	setenv("STARPU_NUMA_COPY_THREADS", s, 1);
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV)
+		return ret;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_memory_nodes_get_numa_count() < 2)
+	{
+		starpu_shutdown();
+		return -ENODEV;
+	}
+
+	for (i = 0; i < nhandles; i++)
+	{
+		starpu_vector_data_register(&handles[i], -1, 0, size, 1);
+		/* Allocate and initialize the data on the first NUMA node */
+		ret = starpu_data_acquire_on_node(handles[i], 0, STARPU_W);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		memset(starpu_data_handle_to_pointer(handles[i], 0), i, size);
+		starpu_data_release_on_node(handles[i], 0);
+	}
+
+	for (iter = 0; iter < niter; iter++)
+	{
+		single += transfer(handles, 1, iter % 2, (iter + 1) % 2);
+		concurrent += transfer(handles, nhandles, iter % 2, (iter + 1) % 2);
+	}
+
+	FPRINTF(stdout, "%u copy threads: single transfer %f MB/s, %u concurrent transfers %f MB/s\n",
+		threads, (double) size * niter / single,
+		nhandles, (double) size * nhandles * niter / concurrent);
+
+	for (i = 0; i < nhandles; i++)
+		starpu_data_unregister(handles[i]);
+	starpu_shutdown();
+	return 0;
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "n:s:i:t:h")) != -1)
+	switch(c)
+	{
+		case 'n':
+			nhandles = atoi(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'i':
+			niter = atoi(optarg);
+			break;
+		case 't':
+			nthreads = atoi(optarg);
+			break;
+		case 'h':
+			fprintf(stderr, "Usage: %s [-n number of concurrent transfers] [-s size] [-i iterations] [-t copy threads per NUMA node]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	parse_args(argc, argv);
+
+	ret = run(0);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	ret = run(nthreads);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * STREAM-like triad (a = b + s*c) over vectors split in chunks which StarPU
+ * allocates itself, to measure the bandwidth obtained with the various NUMA
+ * placement policies.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned nchunks = 4;
+static unsigned chunk_size = 16*1024;
+static unsigned niter = 2;
+#else
+static unsigned nchunks = 64;
+static unsigned chunk_size = 1024*1024;
+static unsigned niter = 10;
+#endif
+
+static void init_cpu(void *descr[], void *arg)
+{
+	double *v = (double *) STARPU_VECTOR_GET_PTR(descr[0]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+	(void) arg;
+
+	for (i = 0; i < n; i++)
+		v[i] = i;
+}
+
+static struct starpu_codelet init_cl =
+{
+	.cpu_funcs = {init_cpu},
+	.nbuffers = 1,
+	.modes = {STARPU_W},
+	.name = "init",
+};
+
+static void triad_cpu(void *descr[], void *arg)
+{
+	double *a = (double *) STARPU_VECTOR_GET_PTR(descr[0]);
+	double *b = (double *) STARPU_VECTOR_GET_PTR(descr[1]);
+	double *c = (double *) STARPU_VECTOR_GET_PTR(descr[2]);
+	unsigned n = STARPU_VECTOR_GET_NX(descr[0]);
+	unsigned i;
+	(void) arg;
+
+	for (i = 0; i < n; i++)
+		a[i] = b[i] + 3. * c[i];
+}
+
+static struct starpu_codelet triad_cl =
+{
+	.cpu_funcs = {triad_cpu},
+	.nbuffers = 3,
+	.modes = {STARPU_W, STARPU_R, STARPU_R},
+	.name = "triad",
+};
+
+static int run(enum starpu_data_numa_policy policy, const char *name)
+{
+	starpu_data_handle_t handles[3][nchunks];
+	double start, end;
+	unsigned i, j, iter;
+	int ret = 0;
+
+	for (j = 0; j < 3; j++)
+		for (i = 0; i < nchunks; i++)
+		{
+			starpu_vector_data_register(&handles[j][i], -1, 0, chunk_size, sizeof(double));
+			starpu_data_set_numa_policy(handles[j][i], policy, -1);
+		}
+
+	/* Let the workers touch the data first */
+	for (j = 0; j < 3 && !ret; j++)
+		for (i = 0; i < nchunks && !ret; i++)
+			ret = starpu_task_insert(&init_cl, STARPU_W, handles[j][i], 0);
+	if (ret == -ENODEV)
+		goto out;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	starpu_task_wait_for_all();
+
+	start = starpu_timing_now();
+	for (iter = 0; iter < niter; iter++)
+		for (i = 0; i < nchunks; i++)
+		{
+			ret = starpu_task_insert(&triad_cl, STARPU_W, handles[0][i], STARPU_R, handles[1][i], STARPU_R, handles[2][i], 0);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		}
+	starpu_task_wait_for_all();
+	end = starpu_timing_now();
+
+	FPRINTF(stdout, "%-12s home node %2d: %f GB/s\n", name, starpu_data_get_numa_home_node(handles[0][0]),
+		3. * sizeof(double) * chunk_size * nchunks * niter / ((end - start) * 1000.));
+
+out:
+	for (j = 0; j < 3; j++)
+		for (i = 0; i < nchunks; i++)
+			starpu_data_unregister(handles[j][i]);
+	return ret;
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "n:s:i:h")) != -1)
+	switch(c)
+	{
+		case 'n':
+			nchunks = atoi(optarg);
+			break;
+		case 's':
+			chunk_size = atoi(optarg);
+			break;
+		case 'i':
+			niter = atoi(optarg);
+			break;
+		case 'h':
+			fprintf(stderr, "Usage: %s [-n nchunks] [-s chunk_size] [-i niter]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	parse_args(argc, argv);
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = run(STARPU_DATA_NUMA_BIND, "bind");
+	if (!ret)
+		ret = run(STARPU_DATA_NUMA_INTERLEAVE, "interleave");
+	if (!ret)
+		ret = run(STARPU_DATA_NUMA_FIRST_TOUCH, "first-touch");
+
+	starpu_shutdown();
+
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <sys/time.h>
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Two contexts get half of the CPU workers each, but the first one has much
+ * more work than the second one. Measure the makespan without and with
+ * elastic resizing of the contexts, which moves the workers of the second
+ * context to the first one once it runs out of work. Check that at least one
+ * worker did move, when the second context has a worker to spare.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned ntasks = 64;
+static unsigned task_duration = 2000;
+#else
+static unsigned ntasks = 512;
+static unsigned task_duration = 2000;
+#endif
+/* The second context gets that many times less tasks */
+static unsigned ratio = 8;
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000. + tv.tv_usec / 1000.;
+}
+
+static void work_cpu(void *descr[], void *arg)
+{
+	(void) descr;
+	(void) arg;
+	starpu_usleep(task_duration);
+}
+
+static struct starpu_codelet work_cl =
+{
+	.cpu_funcs = {work_cpu},
+	.nbuffers = 0,
+	.name = "work",
+};
+
+static int run(int elastic, double *makespan, unsigned *final_nworkers)
+{
+	int workers[STARPU_NMAXWORKERS];
+	unsigned nworkers = starpu_worker_get_ids_by_type(STARPU_CPU_WORKER, workers, STARPU_NMAXWORKERS);
+	unsigned half = nworkers / 2;
+	unsigned ctx[2];
+	double start, end;
+	unsigned i;
+	int ret = 0;
+
+	ctx[0] = starpu_sched_ctx_create(workers, half, "big",
+					 STARPU_SCHED_CTX_POLICY_NAME, "eager",
+					 elastic ? STARPU_SCHED_CTX_ELASTIC : 0, 0);
+	ctx[1] = starpu_sched_ctx_create(workers + half, nworkers - half, "small",
+					 STARPU_SCHED_CTX_POLICY_NAME, "eager",
+					 elastic ? STARPU_SCHED_CTX_ELASTIC : 0, 0);
+
+	start = now();
+	for (i = 0; i < ntasks && !ret; i++)
+	{
+		ret = starpu_task_insert(&work_cl, STARPU_SCHED_CTX, ctx[0], 0);
+		if (!ret && i % ratio == 0)
+			ret = starpu_task_insert(&work_cl, STARPU_SCHED_CTX, ctx[1], 0);
+	}
+	if (ret != -ENODEV)
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	starpu_task_wait_for_all();
+	end = now();
+
+	*makespan = end - start;
+	*final_nworkers = starpu_sched_ctx_get_nworkers(ctx[0]);
+
+	starpu_sched_ctx_delete(ctx[0]);
+	starpu_sched_ctx_delete(ctx[1]);
+	return ret;
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "n:d:r:h")) != -1)
+	switch(c)
+	{
+		case 'n':
+			ntasks = atoi(optarg);
+			break;
+		case 'd':
+			task_duration = atoi(optarg);
+			break;
+		case 'r':
+			ratio = atoi(optarg);
+			break;
+		case 'h':
+			fprintf(stderr, "Usage: %s [-n ntasks] [-d task duration in us] [-r ratio of tasks between the contexts]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	double without, with;
+	unsigned nworkers_without, nworkers_with;
+	unsigned ncpus;
+	int ret;
+
+	parse_args(argc, argv);
+
+	/* React quickly for the benchmark */
+	setenv("STARPU_SCHED_CTX_ELASTIC_PERIOD", "10", 0);
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	ncpus = starpu_cpu_worker_get_count();
+	if (ncpus < 2)
+	{
+		starpu_shutdown();
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = run(0, &without, &nworkers_without);
+	if (!ret)
+		ret = run(1, &with, &nworkers_with);
+
+	starpu_shutdown();
+
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	FPRINTF(stdout, "static contexts: %f ms (%u workers in the big context at the end)\n", without, nworkers_without);
+	FPRINTF(stdout, "elastic contexts: %f ms (%u workers in the big context at the end)\n", with, nworkers_with);
+
+	/* A context keeps at least one CPU worker */
+	if (ncpus - ncpus / 2 >= 2 && nworkers_with <= ncpus / 2)
+	{
+		FPRINTF(stderr, "no worker was moved to the big context\n");
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
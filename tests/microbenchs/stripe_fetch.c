@@ -0,0 +1,184 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "../helper.h"
+
+/*
+ * Measure the time to fetch into the main memory a large vector which is
+ * replicated on two disks and on the other NUMA nodes, from a single source
+ * (STARPU_TRANSFER_STRIPE_MAX_SOURCES=1) and striped over all of them, and
+ * check that the data is preserved.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned size = 8*1024*1024;
+static unsigned niter = 2;
+#else
+static unsigned size = 64*1024*1024;
+static unsigned niter = 10;
+#endif
+#define NDISKS	2
+
+#if !defined(STARPU_HAVE_SETENV)
+#warning setenv is not defined. Skipping test
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#elif STARPU_MAXNODES <= NDISKS
+/* Cannot register the disks */
+int main(int argc, char **argv)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+static int check(float *A)
+{
+	unsigned i;
+
+	for (i = 0; i < size / sizeof(float); i++)
+		if (A[i] != (float) i)
+		{
+			FPRINTF(stderr, "Fail A[%u] %f != %f\n", i, A[i], (float) i);
+			return 0;
+		}
+	return 1;
+}
+
+/* Make the data valid on all the sources but not on the main memory, and
+ * return the time to fetch it there */
+static double fetch(starpu_data_handle_t handle, unsigned *sources, unsigned nsources, int *try)
+{
+	double start, end;
+	unsigned i;
+	int ret;
+
+	ret = starpu_data_acquire_on_node(handle, sources[0], STARPU_RW);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	starpu_data_release_on_node(handle, sources[0]);
+	for (i = 1; i < nsources; i++)
+	{
+		ret = starpu_data_acquire_on_node(handle, sources[i], STARPU_R);
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+		starpu_data_release_on_node(handle, sources[i]);
+	}
+	ret = starpu_data_evict_from_node(handle, STARPU_MAIN_RAM);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_evict_from_node");
+
+	start = starpu_timing_now();
+	ret = starpu_data_acquire_on_node(handle, STARPU_MAIN_RAM, STARPU_R);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	end = starpu_timing_now();
+
+	*try = *try && check(starpu_data_handle_to_pointer(handle, STARPU_MAIN_RAM));
+	starpu_data_release_on_node(handle, STARPU_MAIN_RAM);
+
+	return end - start;
+}
+
+static int run(const char *dir, const char *max_sources, int *try)
+{
+	starpu_data_handle_t handle;
+	unsigned sources[STARPU_MAXNODES];
+	unsigned nsources = 0;
+	double timing = 0.;
+	unsigned i, node, iter;
+	float *A;
+	int ret;
+
+	setenv("STARPU_TRANSFER_STRIPE_MAX_SOURCES", max_sources, 1);
+
+	struct starpu_conf conf;
+	ret = starpu_conf_init(&conf);
+	if (ret == -EINVAL)
+		return ret;
+	starpu_conf_noworker(&conf);
+	conf.ncpus = 1;
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return ret;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < NDISKS; i++)
+	{
+		ret = starpu_disk_register(&starpu_disk_unistd_ops, (void *) dir, 2*size);
+		if (ret == -ENOENT)
+		{
+			starpu_shutdown();
+			return ret;
+		}
+		STARPU_ASSERT(ret >= 0);
+	}
+
+	for (node = 0; node < starpu_memory_nodes_get_count(); node++)
+	{
+		enum starpu_node_kind kind = starpu_node_get_kind(node);
+		if (node != STARPU_MAIN_RAM && (kind == STARPU_CPU_RAM || kind == STARPU_DISK_RAM))
+			sources[nsources++] = node;
+	}
+
+	starpu_vector_data_register(&handle, -1, 0, size / sizeof(float), sizeof(float));
+	/* Initialize the data in the main memory */
+	ret = starpu_data_acquire_on_node(handle, STARPU_MAIN_RAM, STARPU_W);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node");
+	A = starpu_data_handle_to_pointer(handle, STARPU_MAIN_RAM);
+	for (i = 0; i < size / sizeof(float); i++)
+		A[i] = (float) i;
+	starpu_data_release_on_node(handle, STARPU_MAIN_RAM);
+
+	for (iter = 0; iter < niter; iter++)
+		timing += fetch(handle, sources, nsources, try);
+
+	FPRINTF(stdout, "at most %s sources out of %u: %f MB/s\n",
+		max_sources, nsources, (double) size * niter / timing);
+
+	starpu_data_unregister(handle);
+	starpu_shutdown();
+	return 0;
+}
+
+int main(void)
+{
+	int ret, try = 1;
+	char s[128];
+	char *ptr;
+
+	setenv("STARPU_CALIBRATE_MINIMUM", "1", 1);
+
+	snprintf(s, sizeof(s), "/tmp/%s-disk-XXXXXX", getenv("USER"));
+	ptr = _starpu_mkdtemp(s);
+	if (!ptr)
+	{
+		FPRINTF(stderr, "Cannot make directory <%s>\n", s);
+		return STARPU_TEST_SKIPPED;
+	}
+
+	ret = run(s, "1", &try);
+	if (ret == 0)
+		ret = run(s, "4", &try);
+
+	if (rmdir(s) < 0)
+		STARPU_CHECK_RETURN_VALUE(-errno, "rmdir '%s'\n", s);
+
+	if (ret == -ENODEV || ret == -ENOENT)
+		return STARPU_TEST_SKIPPED;
+	return try ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
@@ -0,0 +1,202 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure the submission rate of starpu_task_insert(), compared to
+ * starpu_task_insert_compiled() and to starpu_task_set_compiled() on
+ * preallocated tasks, and check that the values reach the codelet.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned ntasks = 128;
+#else
+static unsigned ntasks = 65536;
+#endif
+
+#define NBUFFERS 3
+
+static starpu_data_handle_t data_handles[NBUFFERS];
+static int vars[NBUFFERS];
+static unsigned long expected_sum;
+static unsigned long sum;
+
+void dummy_func(void *descr[], void *arg)
+{
+	(void)descr;
+	int value;
+	double factor;
+
+	starpu_codelet_unpack_args(arg, &value, &factor);
+	(void) STARPU_ATOMIC_ADDL(&sum, (unsigned long) (value * factor));
+}
+
+static struct starpu_codelet dummy_codelet =
+{
+	.cpu_funcs = {dummy_func},
+	.cpu_funcs_name = {"dummy_func"},
+	.model = NULL,
+	.nbuffers = NBUFFERS,
+	.modes = {STARPU_R, STARPU_R, STARPU_R}
+};
+
+static void usage(char **argv)
+{
+	fprintf(stderr, "Usage: %s [-i ntasks] [-p sched_policy] [-h]\n", argv[0]);
+	exit(EXIT_FAILURE);
+}
+
+static void parse_args(int argc, char **argv, struct starpu_conf *conf)
+{
+	int c;
+	while ((c = getopt(argc, argv, "i:p:h")) != -1)
+	switch(c)
+	{
+		case 'i':
+			ntasks = atoi(optarg);
+			break;
+		case 'p':
+			conf->sched_policy_name = optarg;
+			break;
+		case 'h':
+			usage(argv);
+			break;
+	}
+}
+
+static void report(const char *name, double submission, double total)
+{
+	fprintf(stderr, "%s: submission %f usecs per task (%f Mtasks/s), total %f usecs per task\n",
+		name, submission/ntasks, ntasks/submission, total/ntasks);
+}
+
+int main(int argc, char **argv)
+{
+	struct starpu_task_insert_desc *desc;
+	struct starpu_task *tasks;
+	double start, submitted, end;
+	double factor = 1.;
+	int ret;
+	unsigned i, round;
+
+	struct starpu_conf conf;
+	starpu_conf_init(&conf);
+	conf.ncpus = 2;
+
+	parse_args(argc, argv, &conf);
+
+	ret = starpu_initialize(&conf, &argc, &argv);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < NBUFFERS; i++)
+		starpu_variable_data_register(&data_handles[i], STARPU_MAIN_RAM, (uintptr_t)&vars[i], sizeof(vars[i]));
+
+	fprintf(stderr, "#tasks : %u\n#buffers : %d\n", ntasks, NBUFFERS);
+
+	/* Parsed at each submission */
+	start = starpu_timing_now();
+	for (i = 0; i < ntasks; i++)
+	{
+		int value = i;
+		ret = starpu_task_insert(&dummy_codelet,
+					 STARPU_R, data_handles[0], STARPU_R, data_handles[1], STARPU_R, data_handles[2],
+					 STARPU_VALUE, &value, sizeof(value),
+					 STARPU_VALUE, &factor, sizeof(factor),
+					 0);
+		if (ret == -ENODEV) goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+		expected_sum += i;
+	}
+	submitted = starpu_timing_now();
+	starpu_task_wait_for_all();
+	end = starpu_timing_now();
+	report("starpu_task_insert", submitted - start, end - start);
+
+	/* Compiled once */
+	desc = starpu_task_insert_compile(&dummy_codelet,
+					  STARPU_R, STARPU_R, STARPU_R,
+					  STARPU_VALUE, sizeof(int),
+					  STARPU_VALUE, sizeof(double),
+					  0);
+	start = starpu_timing_now();
+	for (i = 0; i < ntasks; i++)
+	{
+		int value = i;
+		ret = starpu_task_insert_compiled(desc, data_handles[0], data_handles[1], data_handles[2], &value, &factor);
+		if (ret == -ENODEV) goto enodev_desc;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert_compiled");
+		expected_sum += i;
+	}
+	submitted = starpu_timing_now();
+	starpu_task_wait_for_all();
+	end = starpu_timing_now();
+	report("starpu_task_insert_compiled", submitted - start, end - start);
+
+	/* Preallocated tasks, the second round does not allocate anything */
+	tasks = malloc(ntasks * sizeof(*tasks));
+	for (i = 0; i < ntasks; i++)
+		starpu_task_init(&tasks[i]);
+	for (round = 0; round < 2; round++)
+	{
+		start = starpu_timing_now();
+		for (i = 0; i < ntasks; i++)
+		{
+			int value = i;
+			starpu_task_set_compiled(&tasks[i], desc, data_handles[0], data_handles[1], data_handles[2], &value, &factor);
+			ret = starpu_task_submit(&tasks[i]);
+			STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+			expected_sum += i;
+		}
+		submitted = starpu_timing_now();
+		starpu_task_wait_for_all();
+		end = starpu_timing_now();
+		report(round ? "starpu_task_set_compiled (reused)" : "starpu_task_set_compiled", submitted - start, end - start);
+	}
+	for (i = 0; i < ntasks; i++)
+	{
+		free(tasks[i].cl_arg);
+		starpu_task_clean(&tasks[i]);
+	}
+	free(tasks);
+
+	starpu_task_insert_desc_free(desc);
+	for (i = 0; i < NBUFFERS; i++)
+		starpu_data_unregister(data_handles[i]);
+	starpu_shutdown();
+
+	if (sum != expected_sum)
+	{
+		fprintf(stderr, "sum %lu instead of %lu\n", sum, expected_sum);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+
+enodev_desc:
+	starpu_task_insert_desc_free(desc);
+enodev:
+	fprintf(stderr, "WARNING: No one can execute this task\n");
+	/* yes, we do not perform the computation but we did detect that no one
+	 * could perform the kernel, so this is not an error from StarPU */
+	for (i = 0; i < NBUFFERS; i++)
+		starpu_data_unregister(data_handles[i]);
+	starpu_shutdown();
+	return STARPU_TEST_SKIPPED;
+}
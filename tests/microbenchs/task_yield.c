@@ -0,0 +1,225 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <sys/time.h>
+#include <starpu.h>
+#include "../helper.h"
+
+/*
+ * Measure how long a transfer driven by the CPU workers (here towards a disk
+ * memory node) is delayed when all CPU workers are running long codelets,
+ * without and with the codelets calling starpu_task_yield(). Also measure
+ * the cost of a starpu_task_yield() call which has nothing to do.
+ */
+
+#if defined(STARPU_SIMGRID) || STARPU_MAXNODES == 1
+/* Codelets are not run in simgrid, and we need a disk node */
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#ifdef STARPU_QUICK_CHECK
+static unsigned busy_time = 50000;
+static unsigned size = 64*1024;
+static unsigned nyields = 1000;
+#else
+static unsigned busy_time = 500000;
+static unsigned size = 4*1024*1024;
+static unsigned nyields = 100000;
+#endif
+static unsigned yield_period = 100;
+
+static unsigned nstarted;
+static volatile double transfer_end;
+
+static double now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec * 1000000. + tv.tv_usec;
+}
+
+static void busy_cpu(void *descr[], void *arg)
+{
+	int yield = (intptr_t) arg;
+	double start = now(), last = start, cur;
+	(void) descr;
+
+	STARPU_ATOMIC_ADD(&nstarted, 1);
+	while ((cur = now()) < start + busy_time)
+	{
+		if (yield && cur >= last + yield_period)
+		{
+			starpu_task_yield();
+			last = cur;
+		}
+	}
+}
+
+static struct starpu_codelet busy_cl =
+{
+	.cpu_funcs = {busy_cpu},
+	.nbuffers = 0,
+	.name = "busy",
+};
+
+static void overhead_cpu(void *descr[], void *arg)
+{
+	double *overhead = arg;
+	double start;
+	unsigned i;
+	(void) descr;
+
+	start = now();
+	for (i = 0; i < nyields; i++)
+		starpu_task_yield();
+	*overhead = (now() - start) / nyields;
+}
+
+static struct starpu_codelet overhead_cl =
+{
+	.cpu_funcs = {overhead_cpu},
+	.nbuffers = 0,
+	.name = "overhead",
+};
+
+static void acquired(void *arg)
+{
+	(void) arg;
+	transfer_end = now();
+}
+
+static int run(unsigned disk_node, int yield, double *latency)
+{
+	unsigned ncpus = starpu_cpu_worker_get_count();
+	starpu_data_handle_t handle;
+	double start;
+	char *buffer;
+	unsigned i;
+	int ret = 0;
+
+	buffer = calloc(size, 1);
+	starpu_vector_data_register(&handle, STARPU_MAIN_RAM, (uintptr_t) buffer, size, 1);
+
+	nstarted = 0;
+	transfer_end = 0.;
+	for (i = 0; i < ncpus && !ret; i++)
+		ret = starpu_task_insert(&busy_cl, STARPU_CL_ARGS_NFREE, (void*) (intptr_t) yield, 0, 0);
+	if (ret == -ENODEV)
+		goto out;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+
+	/* Wait for all CPU workers to be busy */
+	while (STARPU_ATOMIC_ADD(&nstarted, 0) < ncpus)
+		starpu_usleep(100);
+
+	start = now();
+	ret = starpu_data_acquire_on_node_cb(handle, disk_node, STARPU_R, acquired, NULL);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_data_acquire_on_node_cb");
+
+	starpu_task_wait_for_all();
+	while (!transfer_end)
+		starpu_usleep(100);
+	*latency = transfer_end - start;
+	starpu_data_release_on_node(handle, disk_node);
+
+out:
+	starpu_data_unregister(handle);
+	free(buffer);
+	return ret;
+}
+
+static void parse_args(int argc, char **argv)
+{
+	int c;
+	while ((c = getopt(argc, argv, "b:s:p:n:h")) != -1)
+	switch(c)
+	{
+		case 'b':
+			busy_time = atoi(optarg);
+			break;
+		case 's':
+			size = atoi(optarg);
+			break;
+		case 'p':
+			yield_period = atoi(optarg);
+			break;
+		case 'n':
+			nyields = atoi(optarg);
+			break;
+		case 'h':
+			fprintf(stderr, "Usage: %s [-b busy time (us)] [-s size] [-p yield period (us)] [-n number of yields]\n", argv[0]);
+			exit(EXIT_SUCCESS);
+			break;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	double without, with, overhead;
+	char s[128];
+	char *path;
+	int disk_node;
+	int ret;
+
+	parse_args(argc, argv);
+
+	snprintf(s, sizeof(s), "/tmp/%s-task-yield-XXXXXX", getenv("USER"));
+	path = _starpu_mkdtemp(s);
+	if (!path)
+		return STARPU_TEST_SKIPPED;
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV)
+	{
+		rmdir(path);
+		return STARPU_TEST_SKIPPED;
+	}
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() == 0)
+		goto skip;
+
+	disk_node = starpu_disk_register(&starpu_disk_unistd_ops, path, STARPU_DISK_SIZE_MIN);
+	if (disk_node < 0)
+		goto skip;
+
+	ret = run(disk_node, 0, &without);
+	if (!ret)
+		ret = run(disk_node, 1, &with);
+	if (ret == -ENODEV)
+		goto skip;
+
+	ret = starpu_task_insert(&overhead_cl, STARPU_CL_ARGS_NFREE, &overhead, sizeof(overhead), 0);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	starpu_task_wait_for_all();
+
+	FPRINTF(stdout, "transfer latency without yield: %f us\n", without);
+	FPRINTF(stdout, "transfer latency with yield every %u us: %f us\n", yield_period, with);
+	FPRINTF(stdout, "starpu_task_yield overhead: %f us\n", overhead);
+
+	starpu_shutdown();
+	rmdir(path);
+	return EXIT_SUCCESS;
+
+skip:
+	starpu_shutdown();
+	rmdir(path);
+	return STARPU_TEST_SKIPPED;
+}
+#endif
@@ -0,0 +1,128 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <stdlib.h>
+#include "../helper.h"
+
+/*
+ * Submit many short tasks which each read a big piece of data from the main
+ * memory, so that the transfers queue up on the links to the other memory
+ * nodes, print the makespan and the bytes still queued on the busses when all
+ * tasks were submitted. transfer_queue.sh runs it with the dmda scheduler,
+ * with and without taking the queued transfers into account in the transfer
+ * time predictions (STARPU_EXPECTED_TRANSFER_TIME_QUEUE).
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define NDATA	16
+#define NTASKS	256
+#define SIZE	(256*1024)
+#else
+#define NDATA	32
+#define NTASKS	1024
+#define SIZE	(4*1024*1024)
+#endif
+/* Duration of a task, in µs */
+#define TASK_LENGTH	200
+
+void spin_func(void *descr[], void *arg)
+{
+	double start = starpu_timing_now();
+
+	(void)descr;
+	(void)arg;
+	while (starpu_timing_now() - start < TASK_LENGTH)
+		;
+}
+
+static double spin_cost(struct starpu_task *task, unsigned nimpl)
+{
+	(void)task;
+	(void)nimpl;
+	return TASK_LENGTH;
+}
+
+static struct starpu_perfmodel spin_model =
+{
+	.type = STARPU_COMMON,
+	.cost_function = spin_cost,
+};
+
+static struct starpu_codelet spin_codelet =
+{
+	.cpu_funcs = {spin_func},
+	.cpu_funcs_name = {"spin_func"},
+	.nbuffers = 1,
+	.modes = {STARPU_R},
+	.model = &spin_model,
+};
+
+int main(int argc, char **argv)
+{
+	starpu_data_handle_t handles[NDATA];
+	float *A[NDATA];
+	long long queued = 0;
+	double start, end;
+	unsigned i;
+	int ret, busid;
+
+	ret = starpu_initialize(NULL, &argc, &argv);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_malloc((void **)&A[i], SIZE);
+		memset(A[i], i, SIZE);
+		starpu_vector_data_register(&handles[i], STARPU_MAIN_RAM, (uintptr_t)A[i], SIZE / sizeof(float), sizeof(float));
+	}
+
+	start = starpu_timing_now();
+	for (i = 0; i < NTASKS; i++)
+	{
+		ret = starpu_task_insert(&spin_codelet, STARPU_R, handles[i % NDATA], 0);
+		if (ret == -ENODEV)
+			goto enodev;
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+
+	for (busid = 0; busid < starpu_bus_get_count(); busid++)
+	{
+		struct starpu_profiling_bus_info bus_info;
+		starpu_bus_get_profiling_info(busid, &bus_info);
+		queued += bus_info.queued_bytes;
+	}
+
+	starpu_task_wait_for_all();
+	end = starpu_timing_now();
+
+	FPRINTF(stdout, "%s: makespan %f ms, %lld bytes queued after submission\n",
+		starpu_getenv("STARPU_SCHED") ? starpu_getenv("STARPU_SCHED") : "default",
+		(end - start) / 1000., queued);
+
+enodev:
+	starpu_task_wait_for_all();
+	for (i = 0; i < NDATA; i++)
+	{
+		starpu_data_unregister(handles[i]);
+		starpu_free_noflag(A[i], SIZE);
+	}
+	starpu_shutdown();
+
+	return ret == -ENODEV ? STARPU_TEST_SKIPPED : EXIT_SUCCESS;
+}
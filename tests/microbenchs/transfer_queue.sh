@@ -0,0 +1,36 @@
+#!/bin/sh
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+
+# Compare the makespan of the dmda scheduler when the transfer time
+# predictions ignore or take into account the transfers already queued on the
+# busses
+
+if test -n "$STARPU_MICROBENCHS_DISABLED" ; then exit 77 ; fi
+
+set -e
+
+ROOT=${0%.sh}
+
+run()
+{
+	echo "# $1"
+	STARPU_SCHED=${STARPU_SCHED:-dmda} STARPU_EXPECTED_TRANSFER_TIME_QUEUE=$2 $STARPU_LAUNCH $ROOT $ARGS
+}
+
+ARGS="$@"
+run "static bandwidth only" 0
+run "with queued transfers" 1
@@ -0,0 +1,133 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include "../helper.h"
+#include <stdio.h>
+
+/*
+ * Measure the cost of spawning many small OpenMP tasks, each of which waits
+ * for a child task and is thus preempted, which exercises the allocation of
+ * the task stacks and the context switches.
+ */
+
+#if !defined(STARPU_OPENMP)
+int main(void)
+{
+	return STARPU_TEST_SKIPPED;
+}
+#else
+
+#ifdef STARPU_QUICK_CHECK
+#define NTASKS 64
+#else
+#define NTASKS 4096
+#endif
+
+static int ntasks_done;
+
+__attribute__((constructor))
+static void omp_constructor(void)
+{
+	int ret = starpu_omp_init();
+	if (ret == -EINVAL) exit(STARPU_TEST_SKIPPED);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_omp_init");
+}
+
+__attribute__((destructor))
+static void omp_destructor(void)
+{
+	starpu_omp_shutdown();
+}
+
+static void init_task_attr(struct starpu_omp_task_region_attr *attr, void (*f)(void **, void *))
+{
+	memset(attr, 0, sizeof(*attr));
+#ifdef STARPU_SIMGRID
+	attr->cl.model         = &starpu_perfmodel_nop;
+#endif
+	attr->cl.flags         = STARPU_CODELET_SIMGRID_EXECUTE;
+	attr->cl.cpu_funcs[0]  = f;
+	attr->cl.where         = STARPU_CPU;
+	attr->if_clause        = 1;
+	attr->final_clause     = 0;
+	attr->untied_clause    = 1;
+	attr->mergeable_clause = 0;
+}
+
+void child_task(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	(void) STARPU_ATOMIC_ADD(&ntasks_done, 1);
+}
+
+void parent_task(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	struct starpu_omp_task_region_attr attr;
+
+	init_task_attr(&attr, child_task);
+	starpu_omp_task_region(&attr);
+	starpu_omp_taskwait();
+	(void) STARPU_ATOMIC_ADD(&ntasks_done, 1);
+}
+
+void parallel_region_f(void *buffers[], void *args)
+{
+	(void) buffers;
+	(void) args;
+	struct starpu_omp_task_region_attr attr;
+	int i;
+
+	if (starpu_omp_master_inline())
+	{
+		init_task_attr(&attr, parent_task);
+		for (i = 0; i < NTASKS; i++)
+			starpu_omp_task_region(&attr);
+		starpu_omp_taskwait();
+	}
+}
+
+int main(void)
+{
+	struct starpu_omp_parallel_region_attr attr;
+	double start, end;
+
+	memset(&attr, 0, sizeof(attr));
+#ifdef STARPU_SIMGRID
+	attr.cl.model        = &starpu_perfmodel_nop;
+#endif
+	attr.cl.flags        = STARPU_CODELET_SIMGRID_EXECUTE;
+	attr.cl.cpu_funcs[0] = parallel_region_f;
+	attr.cl.where        = STARPU_CPU;
+	attr.if_clause       = 1;
+
+	start = starpu_timing_now();
+	starpu_omp_parallel_region(&attr);
+	end = starpu_timing_now();
+
+	fprintf(stderr, "%d tasks: %f usecs per task\n", 2 * NTASKS, (end - start) / (2 * NTASKS));
+
+	if (ntasks_done != 2 * NTASKS)
+	{
+		fprintf(stderr, "%d tasks were executed instead of %d\n", ntasks_done, 2 * NTASKS);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+#endif
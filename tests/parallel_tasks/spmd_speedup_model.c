@@ -0,0 +1,248 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <limits.h>
+#include <math.h>
+#include "../helper.h"
+
+/*
+ * Submit spmd tasks following Amdahl's law to pheft, starting from empty
+ * performance models, without and with the speedup model which predicts the
+ * length of the tasks on the widths which are not calibrated yet.
+ *
+ * Then feed the performance model with the Amdahl lengths for widths 1 and 2
+ * only, and check that the length predicted for a task scheduled on a wider
+ * team is the Amdahl length for that width.
+ */
+
+#ifdef STARPU_QUICK_CHECK
+#define N	100
+#else
+#define N	1000
+#endif
+
+#define SERIAL	100.
+#define PARALLEL	2000.
+
+/* Relative tolerance on the predicted length */
+#define TOLERANCE	0.05
+
+static unsigned widths[STARPU_NMAXWORKERS+1];
+
+void codelet_amdahl(void *descr[], void *_args)
+{
+	(void)descr;
+	(void)_args;
+
+	STARPU_SKIP_IF_VALGRIND;
+
+	int worker_size = starpu_combined_worker_get_size();
+	STARPU_ASSERT(worker_size > 0);
+
+	if (starpu_combined_worker_get_rank() == 0)
+		STARPU_ATOMIC_ADD(&widths[worker_size], 1);
+
+	starpu_usleep(SERIAL + PARALLEL/worker_size);
+}
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_HISTORY_BASED,
+};
+
+static struct starpu_codelet cl =
+{
+	.type = STARPU_SPMD,
+	.max_parallelism = INT_MAX,
+	.cpu_funcs = {codelet_amdahl},
+	.cpu_funcs_name = {"codelet_amdahl"},
+	.model = &model,
+	.nbuffers = 0,
+};
+
+static int init(void)
+{
+	struct starpu_conf conf;
+	int ret;
+
+	starpu_conf_init(&conf);
+	conf.sched_policy_name = "pheft";
+	/* Start from empty performance models */
+	conf.calibrate = 2;
+	conf.ncuda = 0;
+	conf.nopencl = 0;
+	conf.nhip = 0;
+	conf.nmax_fpga = 0;
+
+	ret = starpu_init(&conf);
+	if (ret == -ENODEV)
+		return ret;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	if (starpu_cpu_worker_get_count() < 2)
+	{
+		starpu_shutdown();
+		return -ENODEV;
+	}
+
+	return 0;
+}
+
+static int run(int speedup_model, double *makespan)
+{
+	double start;
+	unsigned i;
+	int ret;
+
+	setenv("STARPU_PHEFT_SPEEDUP_MODEL", speedup_model ? "1" : "0", 1);
+	model.symbol = speedup_model ? "spmd_speedup_model" : "spmd_no_speedup_model";
+	memset(widths, 0, sizeof(widths));
+
+	ret = init();
+	if (ret)
+		return ret;
+
+	start = starpu_timing_now();
+	for (i = 0; i < N; i++)
+	{
+		ret = starpu_task_insert(&cl, 0);
+		if (ret == -ENODEV)
+		{
+			starpu_shutdown();
+			return ret;
+		}
+		STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_insert");
+	}
+	starpu_task_wait_for_all();
+	*makespan = (starpu_timing_now() - start) / 1000.;
+
+	FPRINTF(stdout, "%s speedup model: %f ms, widths:", speedup_model ? "with" : "without", *makespan);
+	for (i = 1; i <= starpu_cpu_worker_get_count(); i++)
+		if (widths[i])
+			FPRINTF(stdout, " %u:%u", i, widths[i]);
+	FPRINTF(stdout, "\n");
+
+	starpu_shutdown();
+	return 0;
+}
+
+/* Return the id of a combined worker of the given width, or -1 */
+static int get_combined_worker(int width)
+{
+	unsigned nbasic = starpu_worker_get_count();
+	unsigned i;
+
+	for (i = 0; i < starpu_combined_worker_get_count(); i++)
+	{
+		int size;
+		starpu_combined_worker_get_description(nbasic + i, &size, NULL);
+		if (size == width)
+			return nbasic + i;
+	}
+	return -1;
+}
+
+static void feed(struct starpu_task *task, int workerid, int width)
+{
+	struct starpu_perfmodel_arch *arch = starpu_worker_get_perf_archtype(workerid, STARPU_NMAX_SCHED_CTXS);
+
+	/* As if we had measured it enough times */
+	starpu_perfmodel_update_history_n(&model, task, arch, 0, 0, SERIAL + PARALLEL / width, 10);
+}
+
+static int check_prediction(void)
+{
+	struct starpu_task *task;
+	unsigned i;
+	int width, maxwidth = 0, ret;
+
+	setenv("STARPU_PHEFT_SPEEDUP_MODEL", "1", 1);
+	model.symbol = "spmd_speedup_model_check";
+	memset(widths, 0, sizeof(widths));
+
+	ret = init();
+	if (ret)
+		return ret;
+
+	for (i = 0; i < starpu_combined_worker_get_count(); i++)
+	{
+		int size;
+		starpu_combined_worker_get_description(starpu_worker_get_count() + i, &size, NULL);
+		maxwidth = STARPU_MAX(maxwidth, size);
+	}
+	if (maxwidth <= 2 || get_combined_worker(2) < 0)
+	{
+		/* Nothing wider than what we feed */
+		starpu_shutdown();
+		return -ENODEV;
+	}
+
+	task = starpu_task_create();
+	task->cl = &cl;
+	task->detach = 0;
+	task->destroy = 0;
+
+	feed(task, starpu_worker_get_by_type(STARPU_CPU_WORKER, 0), 1);
+	feed(task, get_combined_worker(2), 2);
+
+	/* All workers are idle, the widest team thus finishes first */
+	ret = starpu_task_submit(task);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_submit");
+	ret = starpu_task_wait(task);
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_task_wait");
+
+	for (width = 1; width <= maxwidth; width++)
+		if (widths[width])
+			break;
+
+	double expected = SERIAL + PARALLEL / width;
+	FPRINTF(stdout, "width %d: predicted %f, Amdahl %f\n", width, task->predicted, expected);
+	ret = 0;
+	if (width != maxwidth)
+	{
+		FPRINTF(stderr, "task ran on width %d instead of %d\n", width, maxwidth);
+		ret = 1;
+	}
+	else if (fabs(task->predicted - expected) > TOLERANCE * expected)
+	{
+		FPRINTF(stderr, "predicted length %f for width %d, expected %f\n", task->predicted, width, expected);
+		ret = 1;
+	}
+
+	starpu_task_destroy(task);
+	starpu_shutdown();
+	return ret;
+}
+
+int main(void)
+{
+	double without, with;
+	int ret;
+
+	ret = run(0, &without);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+	ret = run(1, &with);
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	ret = check_prediction();
+	if (ret == -ENODEV)
+		return STARPU_TEST_SKIPPED;
+
+	return ret ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <math.h>
+#include "../helper.h"
+
+/*
+ * Feed an adaptive history-based model with measurements which suddenly
+ * double, and check that the model follows, reporting a drift event.
+ */
+
+#define NSAMPLES 100
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_HISTORY_BASED,
+	.symbol = "adaptive",
+	.adaptive_window = 16,
+};
+
+static struct starpu_codelet cl =
+{
+	.model = &model,
+	.nbuffers = 1,
+	.modes = {STARPU_W}
+};
+
+static int id_g_drift_events;
+static int64_t drift_events;
+
+static void g_listener_cb(struct starpu_perf_counter_listener *listener, struct starpu_perf_counter_sample *sample, void *context)
+{
+	(void) listener;
+	(void) context;
+	drift_events = starpu_perf_counter_sample_get_int64_value(sample, id_g_drift_events);
+}
+
+static int feed(struct starpu_task *task, struct starpu_perfmodel_arch *arch, uint32_t footprint, double duration)
+{
+	double expected;
+	int i;
+
+	for (i = 0; i < NSAMPLES; i++)
+	{
+		/* Some deterministic noise */
+		double measured = duration * (1. + 0.02 * ((i % 5) - 2));
+		starpu_perfmodel_update_history(&model, task, arch, 0, 0, measured);
+	}
+
+	expected = starpu_perfmodel_history_based_expected_perf(&model, arch, footprint);
+	FPRINTF(stderr, "measured %f, expected %f\n", duration, expected);
+	return isnan(expected) || fabs(expected - duration) > duration * 0.05;
+}
+
+int main(void)
+{
+	const enum starpu_perf_counter_scope scope = starpu_perf_counter_scope_global;
+	struct starpu_conf conf;
+	struct starpu_task task;
+	struct starpu_perfmodel_device device = { .type = STARPU_CPU_WORKER, .devid = 0, .ncores = 1 };
+	struct starpu_perfmodel_arch arch = { .ndevices = 1, .devices = &device };
+	starpu_data_handle_t handle;
+	uint32_t footprint;
+	int ret;
+
+	starpu_conf_init(&conf);
+	conf.start_perf_counter_collection = 1;
+	ret = starpu_initialize(&conf, NULL, NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	struct starpu_perf_counter_set *set = starpu_perf_counter_set_alloc(scope);
+	id_g_drift_events = starpu_perf_counter_name_to_id(scope, "starpu.perfmodel.g_drift_events");
+	STARPU_ASSERT(id_g_drift_events != -1);
+	starpu_perf_counter_set_enable_id(set, id_g_drift_events);
+	struct starpu_perf_counter_listener *listener = starpu_perf_counter_listener_init(set, g_listener_cb, NULL);
+	starpu_perf_counter_set_global_listener(listener);
+
+	starpu_vector_data_register(&handle, -1, 0, 1024, sizeof(float));
+	starpu_task_init(&task);
+	task.cl = &cl;
+	task.handles[0] = handle;
+	footprint = starpu_task_footprint(&model, &task, &arch, 0);
+
+	ret = feed(&task, &arch, footprint, 100.);
+	if (!ret)
+		ret = feed(&task, &arch, footprint, 200.);
+
+	starpu_task_clean(&task);
+	starpu_data_unregister(handle);
+
+	starpu_perf_counter_unset_global_listener();
+	starpu_perf_counter_listener_exit(listener);
+	starpu_perf_counter_set_free(set);
+	starpu_shutdown();
+
+	FPRINTF(stderr, "%lld drift events\n", (long long) drift_events);
+	if (ret || drift_events == 0)
+		return EXIT_FAILURE;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+/* StarPU --- Runtime system for heterogeneous multicore architectures.
+ *
+ * Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+ *
+ * StarPU is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or (at
+ * your option) any later version.
+ *
+ * StarPU is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ *
+ * See the GNU Lesser General Public License in COPYING.LGPL for more details.
+ */
+
+#include <starpu.h>
+#include <math.h>
+#include "../helper.h"
+
+/*
+ * Calibrate a history-based model with the size fallback on a few sizes, and
+ * check that it predicts sizes which were never measured.
+ */
+
+#define NSAMPLES 20
+
+static struct starpu_perfmodel model =
+{
+	.type = STARPU_HISTORY_BASED,
+	.symbol = "size_fallback",
+	.size_fallback = 1,
+};
+
+static struct starpu_codelet cl =
+{
+	.model = &model,
+	.nbuffers = 1,
+	.modes = {STARPU_W}
+};
+
+static double duration(unsigned n)
+{
+	return 10. + 0.01 * n * sizeof(float);
+}
+
+int main(void)
+{
+	struct starpu_task task;
+	struct starpu_perfmodel_device device = { .type = STARPU_CPU_WORKER, .devid = 0, .ncores = 1 };
+	struct starpu_perfmodel_arch arch = { .ndevices = 1, .devices = &device };
+	starpu_data_handle_t handle;
+	unsigned n;
+	int ret, i;
+
+	ret = starpu_init(NULL);
+	if (ret == -ENODEV) return STARPU_TEST_SKIPPED;
+	STARPU_CHECK_RETURN_VALUE(ret, "starpu_init");
+
+	for (n = 1024; n <= 65536; n *= 2)
+	{
+		starpu_vector_data_register(&handle, -1, 0, n, sizeof(float));
+		starpu_task_init(&task);
+		task.cl = &cl;
+		task.handles[0] = handle;
+		for (i = 0; i < NSAMPLES; i++)
+			starpu_perfmodel_update_history(&model, &task, &arch, 0, 0, duration(n));
+		starpu_task_clean(&task);
+		starpu_data_unregister(handle);
+	}
+
+	ret = EXIT_SUCCESS;
+	for (n = 1500; n <= 100000; n = n * 3)
+	{
+		double expected;
+		starpu_vector_data_register(&handle, -1, 0, n, sizeof(float));
+		starpu_task_init(&task);
+		task.cl = &cl;
+		task.handles[0] = handle;
+		expected = starpu_task_expected_length(&task, &arch, 0);
+		starpu_task_clean(&task);
+		starpu_data_unregister(handle);
+
+		FPRINTF(stderr, "size %u: expected %f, actual %f\n", n, expected, duration(n));
+		if (isnan(expected) || fabs(expected - duration(n)) > duration(n) * 0.1)
+			ret = EXIT_FAILURE;
+	}
+
+	starpu_shutdown();
+
+	return ret;
+}
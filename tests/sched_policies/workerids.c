@@ -115,6 +115,7 @@ int main(void)
 		 ||  strcmp((*policy)->policy_name, "pheft") == 0
 		 ||  strcmp((*policy)->policy_name, "heteroprio") == 0
 		 ||  strcmp((*policy)->policy_name, "lws") == 0
+		 ||  strcmp((*policy)->policy_name, "lws-locality") == 0
 		 ||  strcmp((*policy)->policy_name, "ws") == 0)
 #ifdef STARPU_DEVEL
 #warning FIXME for modular-*, pheft and heteroprio
@@ -0,0 +1,74 @@
+#!/bin/bash
+# StarPU --- Runtime system for heterogeneous multicore architectures.
+#
+# Copyright (C) 2023  Université de Bordeaux, CNRS (LaBRI UMR 5800), Inria
+#
+# StarPU is free software; you can redistribute it and/or modify
+# it under the terms of the GNU Lesser General Public License as published by
+# the Free Software Foundation; either version 2.1 of the License, or (at
+# your option) any later version.
+#
+# StarPU is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# See the GNU Lesser General Public License in COPYING.LGPL for more details.
+#
+
+# Generate a big synthetic multi-file FxT trace by running tasks_overhead
+# several times, and report the time and memory taken by starpu_fxt_tool to
+# convert it with various options.
+#
+# Usage: bench_fxt_tool.sh [nfiles [ntasks]]
+# STARPU_BUILDDIR can be set to point to the StarPU build tree.
+
+NFILES=${1:-4}
+NTASKS=${2:-200000}
+BUILDDIR=${STARPU_BUILDDIR:-$(dirname $0)/../..}
+BENCH=$BUILDDIR/tests/microbenchs/tasks_overhead
+FXT_TOOL=$BUILDDIR/tools/starpu_fxt_tool
+WORKDIR=$(mktemp -d /tmp/starpu_bench_fxt_tool.XXXXXX)
+
+if [ ! -x $BENCH -o ! -x $FXT_TOOL ]
+then
+	echo "$BENCH or $FXT_TOOL not found, is StarPU built with FxT support?" >&2
+	exit 77
+fi
+
+trap "rm -rf $WORKDIR" EXIT
+
+echo "Generating $NFILES trace files of $NTASKS tasks each in $WORKDIR"
+FILES=""
+for i in $(seq 0 $(($NFILES - 1)))
+do
+	STARPU_FXT_TRACE=1 STARPU_FXT_PREFIX=$WORKDIR/ STARPU_FXT_SUFFIX=prof_file_$i \
+		$STARPU_LAUNCH $BENCH -i $NTASKS > /dev/null 2>&1 || exit 1
+	FILES="$FILES $WORKDIR/prof_file_$i"
+done
+du -sh $WORKDIR
+
+TIME=$(which time 2> /dev/null)
+
+run()
+{
+	local name=$1
+	shift
+	mkdir -p $WORKDIR/out_$name
+	local start=$(date +%s.%N)
+	if [ -n "$TIME" ]
+	then
+		$TIME -f "%M" -o $WORKDIR/mem_$name $FXT_TOOL -d $WORKDIR/out_$name "$@" -i $FILES > /dev/null 2>&1
+	else
+		$FXT_TOOL -d $WORKDIR/out_$name "$@" -i $FILES > /dev/null 2>&1
+	fi
+	local end=$(date +%s.%N)
+	local mem=$([ -f $WORKDIR/mem_$name ] && tail -1 $WORKDIR/mem_$name || echo "?")
+	printf "%-16s %10.3f s %12s KiB\n" $name $(echo "$end - $start" | bc) $mem
+	rm -rf $WORKDIR/out_$name
+}
+
+printf "%-16s %12s %16s\n" "options" "time" "max RSS"
+run sequential -j 1
+run parallel
+run binary -binary
+run binary-stream -binary -stream
@@ -47,6 +47,9 @@ static void usage()
 	fprintf(stderr, "   -memory-states	show detailed memory states of handles\n");
 	fprintf(stderr, "   -internal		show StarPU-internal tasks in DAG\n");
 	fprintf(stderr, "   -number-events	generate a file counting FxT events by type\n");
+	fprintf(stderr, "   -binary		also generate a compact binary task file (tasks.bin)\n");
+	fprintf(stderr, "   -stream		dump tasks as soon as they terminate, to bound memory usage\n");
+	fprintf(stderr, "   -j <n>		use <n> threads to parse the input files (default: number of CPUs)\n");
 	fprintf(stderr, "   -h, --help		display this help and exit\n");
 	fprintf(stderr, "   -v, --version	output version information and exit\n\n");
 	fprintf(stderr, "Report bugs to <%s>.", PACKAGE_BUGREPORT);
@@ -77,6 +80,11 @@ static int parse_args(int argc, char **argv)
 			options.out_paje_path = strdup(argv[++i]);
 			reading_input_filenames = 0;
 		}
+		else if (strcmp(argv[i], "-j") == 0)
+		{
+			options.nthreads = atoi(argv[++i]);
+			reading_input_filenames = 0;
+		}
 		else if (strcmp(argv[i], "-d") == 0)
 		{
 			options.dir = argv[++i];